@@ -85,6 +85,11 @@ class _IosApiWrapper implements android.TtsNativeApi {
     await _iosApi.cancelSynthesis(requestId);
   }
 
+  @override
+  Future<void> warmUpVoice(android.NativeEngineType engineType, String voiceId) async {
+    // iOS engines have no separate warmup step; CoreML compiles in initEngine
+  }
+
   @override
   Future<void> unloadVoice(android.NativeEngineType engineType, String voiceId) async {
     await _iosApi.unloadVoice(_toIosEngineType(engineType), voiceId);
@@ -0,0 +1,1100 @@
+/*
+ * supertonic_bench.cpp - End-to-end benchmark for the Supertonic engine core
+ *
+ * Runs a text corpus through supertonic_synthesize_with_stats() for every
+ * combination of a thread/steps/speaker matrix and reports p50/p95/p99
+ * latency per pipeline stage and per diffusion step, RTF, peak RSS and
+ * allocation counts. Results can also be written as JSON to compare runs.
+ *
+ * Usage:
+ *   supertonic_bench --model-dir <core path> --corpus test/segmentation_1000_words.json
+ *                    [--threads 1,2,4] [--steps 5] [--speakers 0,5] [--speed 1.0]
+ *                    [--warmup 2] [--repeat 1] [--limit N] [--json out.json]
+ *                    [--profile DIR] [--warmup-buckets 16,64,160,320]
+ *                    [--length-buckets on|off] [--max-chunk-tokens 192]
+ *                    [--fp16 on|off] [--model-variants auto|off] [--xnnpack on|off]
+ *                    [--thread-budget N] [--thread-pool global|session] [--spin on|off]
+ *                    [--pin on|off] [--shared-arena on|off] [--arena-limit-mb N]
+ *                    [--early-exit 0.05] [--early-exit-min-steps 3] [--scheduled on|off]
+ *                    [--preempt on|off] [--prefetch-class background|foreground]
+ *                    [--cancel-every N] [--share-weights on|off] [--session-pool N]
+ *                    [--perf-counters on|off] [--trace FILE]
+ *
+ * A corpus is either a JSON file (every "text" string value is one
+ * utterance) or a plain text file with one utterance per line.
+ *
+ * --profile writes one Chrome trace per configuration into DIR (ORT
+ * operator events merged with the engine stages). Profiling slows the
+ * run down, so do not compare its latencies against unprofiled runs.
+ *
+ * --warmup-buckets runs supertonic_warmup() with those token counts (0 for
+ * the engine defaults) before the corpus warmup and prints each bucket's
+ * time. Set --warmup 0 alongside it to see whether shape warmup alone
+ * removes the first-request outlier.
+ *
+ * --length-buckets off runs exact token/latent lengths instead of padding
+ * them to the engine's default buckets, to measure what bucketing saves.
+ *
+ * --max-chunk-tokens sets the length above which inputs are split into
+ * parallel sub-utterances (0 = never split), to compare long-sentence
+ * latency and peak RSS with and without splitting.
+ *
+ * --fp16 on loads the onnx/<model>_fp16.onnx variants present in the model
+ * directory and keeps styles and latents in half precision between them.
+ *
+ * --model-variants off ignores onnx/variants.txt and loads <model>.onnx,
+ * to compare against the variants picked for this CPU (printed per run).
+ *
+ * --xnnpack on offers every model to the XNNPACK execution provider; the
+ * per-run "models" line shows which ones passed its accuracy and speed
+ * check against the CPU provider.
+ *
+ * --thread-budget caps the engine's inference threads in total (default:
+ * the big cores, which also clamps --threads); --thread-pool, --spin and
+ * --pin select a global or per-session ORT pool, busy-waiting pool threads
+ * and pinning them to big cores, to measure each against CPU time.
+ *
+ * --shared-arena off gives every session its own CPU arena again, to compare
+ * peak RSS; --arena-limit-mb caps the shared one.
+ *
+ * --early-exit sets the diffusion convergence threshold (0 = off) and
+ * prints how many steps the corpus actually ran; compare the audio against
+ * a full-step run to calibrate it.
+ *
+ * --scheduled on also submits the corpus as prefetch jobs due in a minute,
+ * every second text twice, followed by one job due now. It prints how many
+ * submissions were merged and how long the urgent job queued compared with
+ * the prefetch jobs. --preempt off lets running prefetch jobs finish
+ * before the urgent one starts instead of pausing them between steps.
+ * --prefetch-class foreground submits the prefetch jobs in the foreground
+ * class instead of the background one (one niced little-core thread), to
+ * compare the urgent job's latency and the CPU time of the whole batch.
+ * Prefetch jobs go through supertonic_submit_async(); --cancel-every N
+ * cancels every Nth of them once all are queued, and the run prints how
+ * many completion callbacks arrived.
+ *
+ * The cores the engine found in sysfs and the classes' CPU sets are
+ * printed first; each configuration prints where its last call's thread
+ * and intra-op pool ran, so placement can be checked on a Linux host.
+ *
+ * --share-weights off gives every session its own copy of the weights, and
+ * --session-pool N fixes the sessions per model (0 = engine's choice); the
+ * memory report shows the shared bytes and instances per model, so the cost
+ * of another parallel session can be read off session MB.
+ *
+ * --perf-counters on reads perf_event_open counters around every model run
+ * and prints cycles, instructions, IPC, cache and branch misses per 1000
+ * instructions and context switches per stage and diffusion step (means
+ * per utterance, summed over the counted threads). Counters the kernel
+ * refuses are left out; see perf_event_paranoid.
+ *
+ * --trace FILE streams the engine's trace markers (tokenize, model runs,
+ * diffusion steps, output conversion) of the whole run to FILE as a Chrome
+ * trace, with each request's spans linked by a flow. Unlike --profile it
+ * has no ORT events and hardly changes the timings.
+ *
+ * Each configuration also runs supertonic_estimate_durations() over the
+ * whole corpus and prints its time and total next to the synthesized one.
+ */
+
+#include "supertonic.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Allocation counting
+//
+// Replacing the global operator new in the executable also interposes it for
+// libsupertonic.so and the C++ parts of ONNX Runtime. Arena allocations made
+// with malloc directly are not counted; peak RSS covers those.
+// ---------------------------------------------------------------------------
+
+static std::atomic<bool> g_countAllocations{false};
+static std::atomic<uint64_t> g_allocationCount{0};
+static std::atomic<uint64_t> g_allocationBytes{0};
+
+static void* countedAlloc(size_t size, size_t alignment = 0) {
+    if (g_countAllocations.load(std::memory_order_relaxed)) {
+        g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+        g_allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    if (size == 0) {
+        size = 1;
+    }
+    void* p = nullptr;
+    if (alignment > alignof(std::max_align_t)) {
+        if (posix_memalign(&p, alignment, size) != 0) {
+            p = nullptr;
+        }
+    } else {
+        p = std::malloc(size);
+    }
+    return p;
+}
+
+void* operator new(size_t size) {
+    void* p = countedAlloc(size);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t size) {
+    void* p = countedAlloc(size);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new(size_t size, std::align_val_t al) {
+    void* p = countedAlloc(size, (size_t)al);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t size, std::align_val_t al) {
+    void* p = countedAlloc(size, (size_t)al);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+
+// ---------------------------------------------------------------------------
+// Process memory
+// ---------------------------------------------------------------------------
+
+/** Reset the kernel's peak RSS (VmHWM) counter; Linux 4.0+. */
+static void resetPeakRss() {
+    FILE* f = std::fopen("/proc/self/clear_refs", "w");
+    if (f != nullptr) {
+        std::fputs("5", f);
+        std::fclose(f);
+    }
+}
+
+/** Read a "Key:   123 kB" line from /proc/self/status, in kB. */
+static long readProcStatusKb(const char* key) {
+    FILE* f = std::fopen("/proc/self/status", "r");
+    if (f == nullptr) {
+        return -1;
+    }
+    char line[256];
+    long value = -1;
+    size_t keyLen = std::strlen(key);
+    while (std::fgets(line, sizeof(line), f) != nullptr) {
+        if (std::strncmp(line, key, keyLen) == 0 && line[keyLen] == ':') {
+            value = std::strtol(line + keyLen + 1, nullptr, 10);
+            break;
+        }
+    }
+    std::fclose(f);
+    return value;
+}
+
+// ---------------------------------------------------------------------------
+// Corpus loading
+// ---------------------------------------------------------------------------
+
+static void appendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += (char)cp;
+    } else if (cp < 0x800) {
+        out += (char)(0xC0 | (cp >> 6));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += (char)(0xE0 | (cp >> 12));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else {
+        out += (char)(0xF0 | (cp >> 18));
+        out += (char)(0x80 | ((cp >> 12) & 0x3F));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    }
+}
+
+/** Parse a JSON string literal starting at the opening quote. */
+static bool parseJsonString(const std::string& json, size_t& pos, std::string& out) {
+    if (pos >= json.size() || json[pos] != '"') {
+        return false;
+    }
+    pos++;
+    out.clear();
+    while (pos < json.size()) {
+        char c = json[pos++];
+        if (c == '"') {
+            return true;
+        }
+        if (c != '\\') {
+            out += c;
+            continue;
+        }
+        if (pos >= json.size()) {
+            return false;
+        }
+        char e = json[pos++];
+        switch (e) {
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'r': out += '\r'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'u': {
+                if (pos + 4 > json.size()) return false;
+                uint32_t cp = (uint32_t)std::strtoul(json.substr(pos, 4).c_str(), nullptr, 16);
+                pos += 4;
+                // Surrogate pair
+                if (cp >= 0xD800 && cp <= 0xDBFF && pos + 6 <= json.size() &&
+                    json[pos] == '\\' && json[pos + 1] == 'u') {
+                    uint32_t lo = (uint32_t)std::strtoul(json.substr(pos + 2, 4).c_str(), nullptr, 16);
+                    pos += 6;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                }
+                appendUtf8(out, cp);
+                break;
+            }
+            default: out += e; break;
+        }
+    }
+    return false;
+}
+
+static std::vector<std::string> loadCorpus(const std::string& path) {
+    std::vector<std::string> utterances;
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return utterances;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string content = buffer.str();
+
+    bool isJson = path.size() > 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+    if (isJson) {
+        const std::string key = "\"text\"";
+        size_t pos = 0;
+        while ((pos = content.find(key, pos)) != std::string::npos) {
+            pos += key.size();
+            while (pos < content.size() && (content[pos] == ' ' || content[pos] == ':' ||
+                   content[pos] == '\n' || content[pos] == '\t' || content[pos] == '\r')) {
+                pos++;
+            }
+            std::string text;
+            if (parseJsonString(content, pos, text) && !text.empty()) {
+                utterances.push_back(text);
+            }
+        }
+    } else {
+        std::istringstream lines(content);
+        std::string line;
+        while (std::getline(lines, line)) {
+            if (!line.empty()) {
+                utterances.push_back(line);
+            }
+        }
+    }
+    return utterances;
+}
+
+// ---------------------------------------------------------------------------
+// Statistics
+// ---------------------------------------------------------------------------
+
+struct Summary {
+    double mean = 0, p50 = 0, p95 = 0, p99 = 0, max = 0;
+    size_t n = 0;
+};
+
+/** Nearest-rank percentiles. */
+static Summary summarize(std::vector<double> values) {
+    Summary s;
+    s.n = values.size();
+    if (values.empty()) {
+        return s;
+    }
+    std::sort(values.begin(), values.end());
+    auto rank = [&](double p) {
+        size_t idx = (size_t)std::max(0.0, std::ceil(p * values.size()) - 1);
+        return values[std::min(idx, values.size() - 1)];
+    };
+    double sum = 0;
+    for (double v : values) sum += v;
+    s.mean = sum / values.size();
+    s.p50 = rank(0.50);
+    s.p95 = rank(0.95);
+    s.p99 = rank(0.99);
+    s.max = values.back();
+    return s;
+}
+
+struct RunConfig {
+    int threads;
+    int steps;
+    int speaker;
+};
+
+struct RunResult {
+    RunConfig config;
+    std::vector<SupertonicSynthesisStats> stats;
+    int failures = 0;
+    long peakRssKb = -1;
+    uint64_t allocationCount = 0;
+    uint64_t allocationBytes = 0;
+};
+
+static const char* kStageNames[] = {
+    "tokenize", "text_encoder", "duration_predictor", "noise",
+    "vector_estimator", "vocoder", "total",
+};
+
+static double stageValue(const SupertonicSynthesisStats& s, int stage) {
+    switch (stage) {
+        case 0: return s.tokenize_ms;
+        case 1: return s.text_encoder_ms;
+        case 2: return s.duration_predictor_ms;
+        case 3: return s.noise_ms;
+        case 4: return s.vector_estimator_ms;
+        case 5: return s.vocoder_ms;
+        default: return s.total_ms;
+    }
+}
+
+static const int kNumStages = sizeof(kStageNames) / sizeof(kStageNames[0]);
+
+static const char* variantName(int32_t variant) {
+    switch (variant) {
+        case SUPERTONIC_VARIANT_FP32: return "fp32";
+        case SUPERTONIC_VARIANT_FP16: return "fp16";
+        case SUPERTONIC_VARIANT_INT8_DYNAMIC: return "int8_dynamic";
+        case SUPERTONIC_VARIANT_INT8_QDQ: return "int8_qdq";
+        default: return "default";
+    }
+}
+
+// Variants are fixed per engine and XNNPACK settles on the first calls,
+// so the last call reports what the run ended up using
+static const SupertonicSynthesisStats* lastStats(const RunResult& r) {
+    return r.stats.empty() ? nullptr : &r.stats.back();
+}
+
+static const char* kPerfStageNames[] = {"text_encoder", "duration_predictor", "vector_estimator", "vocoder"};
+static const int kNumPerfStages = sizeof(kPerfStageNames) / sizeof(kPerfStageNames[0]);
+
+/** Counts of one perf stage (the vector estimator summed over its steps), or of step >= 0 alone. */
+static SupertonicPerfCounts perfCounts(const SupertonicSynthesisStats& s, int stage, int step = -1) {
+    if (step >= 0) {
+        return s.perf_step[step];
+    }
+    switch (stage) {
+        case 0: return s.perf_text_encoder;
+        case 1: return s.perf_duration_predictor;
+        case 3: return s.perf_vocoder;
+        default: break;
+    }
+    SupertonicPerfCounts sum = {};
+    for (int i = 0; i < SUPERTONIC_MAX_DIFFUSION_STEPS; i++) {
+        for (int c = 0; c < SUPERTONIC_NUM_PERF_COUNTERS; c++) {
+            sum.count[c] += s.perf_step[i].count[c];
+        }
+    }
+    return sum;
+}
+
+/** Mean counts per utterance, and the counters that any utterance had. */
+static SupertonicPerfCounts meanPerfCounts(const RunResult& r, int stage, int step, uint32_t& mask) {
+    double sum[SUPERTONIC_NUM_PERF_COUNTERS] = {};
+    mask = 0;
+    for (const auto& s : r.stats) {
+        const SupertonicPerfCounts counts = perfCounts(s, stage, step);
+        for (int c = 0; c < SUPERTONIC_NUM_PERF_COUNTERS; c++) {
+            sum[c] += (double)counts.count[c];
+        }
+        mask |= s.perf_counters;
+    }
+    SupertonicPerfCounts mean = {};
+    const size_t n = std::max<size_t>(1, r.stats.size());
+    for (int c = 0; c < SUPERTONIC_NUM_PERF_COUNTERS; c++) {
+        mean.count[c] = (uint64_t)(sum[c] / n);
+    }
+    return mean;
+}
+
+/** Events per 1000 instructions, or -1 when either was not counted. */
+static double perKiloInstructions(const SupertonicPerfCounts& counts, uint32_t mask, int counter) {
+    const bool counted = (mask & (1u << counter)) != 0 && (mask & (1u << SUPERTONIC_PERF_INSTRUCTIONS)) != 0;
+    const uint64_t instructions = counts.count[SUPERTONIC_PERF_INSTRUCTIONS];
+    return counted && instructions > 0 ? counts.count[counter] * 1000.0 / instructions : -1.0;
+}
+
+static double instructionsPerCycle(const SupertonicPerfCounts& counts, uint32_t mask) {
+    const uint64_t cycles = counts.count[SUPERTONIC_PERF_CYCLES];
+    const bool counted = (mask & (1u << SUPERTONIC_PERF_INSTRUCTIONS)) != 0;
+    return counted && cycles > 0 ? (double)counts.count[SUPERTONIC_PERF_INSTRUCTIONS] / cycles : -1.0;
+}
+
+// ---------------------------------------------------------------------------
+// Output
+// ---------------------------------------------------------------------------
+
+static void printPerfRow(const char* label, const SupertonicPerfCounts& counts, uint32_t mask) {
+    auto value = [&](int counter, double v, const char* format) {
+        char cell[32];
+        if ((mask & (1u << counter)) == 0 || v < 0) {
+            std::snprintf(cell, sizeof(cell), "-");
+        } else {
+            std::snprintf(cell, sizeof(cell), format, v);
+        }
+        std::printf(" %10s", cell);
+    };
+    std::printf("%-22s", label);
+    value(SUPERTONIC_PERF_CYCLES, counts.count[SUPERTONIC_PERF_CYCLES] / 1e6, "%.1f");
+    value(SUPERTONIC_PERF_INSTRUCTIONS, counts.count[SUPERTONIC_PERF_INSTRUCTIONS] / 1e6, "%.1f");
+    value(SUPERTONIC_PERF_CYCLES, instructionsPerCycle(counts, mask), "%.2f");
+    value(SUPERTONIC_PERF_CACHE_MISSES, perKiloInstructions(counts, mask, SUPERTONIC_PERF_CACHE_MISSES), "%.2f");
+    value(SUPERTONIC_PERF_BRANCH_MISSES, perKiloInstructions(counts, mask, SUPERTONIC_PERF_BRANCH_MISSES), "%.2f");
+    value(SUPERTONIC_PERF_CONTEXT_SWITCHES, (double)counts.count[SUPERTONIC_PERF_CONTEXT_SWITCHES], "%.0f");
+    std::printf("\n");
+}
+
+/** Counter table of a run made with --perf-counters on; nothing if none could be opened. */
+static void printPerf(const RunResult& r) {
+    uint32_t mask = 0;
+    int threads = 0;
+    for (const auto& s : r.stats) {
+        mask |= s.perf_counters;
+        threads = std::max(threads, s.perf_threads);
+    }
+    if (mask == 0) {
+        return;
+    }
+    char title[32];
+    std::snprintf(title, sizeof(title), "perf (%d threads)", threads);
+    std::printf("%-22s %10s %10s %10s %10s %10s %10s\n", title, "Mcycles", "Minstr", "IPC", "cache MPKI",
+                "br MPKI", "switches");
+    for (int stage = 0; stage < kNumPerfStages; stage++) {
+        uint32_t stageMask = 0;
+        printPerfRow(kPerfStageNames[stage], meanPerfCounts(r, stage, -1, stageMask), stageMask);
+        if (stage == 2) {
+            for (int step = 0; step < r.config.steps; step++) {
+                char label[32];
+                std::snprintf(label, sizeof(label), "  step[%d]", step);
+                printPerfRow(label, meanPerfCounts(r, stage, step, stageMask), stageMask);
+            }
+        }
+    }
+}
+
+static void printResult(const RunResult& r) {
+    // The engine clamps intra-op threads to its thread budget
+    const SupertonicSynthesisStats* last = lastStats(r);
+    std::printf("\n== threads=%d steps=%d speaker=%d  (%zu utterances, %d failed)\n",
+                last != nullptr ? last->intra_op_threads : r.config.threads, r.config.steps, r.config.speaker,
+                r.stats.size(), r.failures);
+    std::printf("%-22s %10s %10s %10s %10s\n", "stage (ms)", "mean", "p50", "p95", "p99");
+
+    for (int stage = 0; stage < kNumStages; stage++) {
+        std::vector<double> values;
+        for (const auto& s : r.stats) values.push_back(stageValue(s, stage));
+        Summary sum = summarize(values);
+        std::printf("%-22s %10.2f %10.2f %10.2f %10.2f\n", kStageNames[stage], sum.mean, sum.p50, sum.p95, sum.p99);
+        if (stage == 4) {
+            for (int step = 0; step < r.config.steps; step++) {
+                std::vector<double> stepValues;
+                for (const auto& s : r.stats) stepValues.push_back(s.step_ms[step]);
+                Summary ss = summarize(stepValues);
+                char label[32];
+                std::snprintf(label, sizeof(label), "  step[%d]", step);
+                std::printf("%-22s %10.2f %10.2f %10.2f %10.2f\n", label, ss.mean, ss.p50, ss.p95, ss.p99);
+            }
+        }
+    }
+
+    double totalMs = 0, audioSec = 0;
+    std::vector<double> rtfs;
+    for (const auto& s : r.stats) {
+        totalMs += s.total_ms;
+        audioSec += s.audio_seconds;
+        rtfs.push_back(s.rtf);
+    }
+    Summary rtf = summarize(rtfs);
+    size_t n = std::max<size_t>(1, r.stats.size());
+    std::printf("RTF aggregate %.3f  p50 %.3f  p95 %.3f  p99 %.3f  (%.1f s audio)\n",
+                audioSec > 0 ? totalMs / (audioSec * 1000.0) : 0.0, rtf.p50, rtf.p95, rtf.p99, audioSec);
+    std::printf("peak RSS %.1f MB  allocations/utterance %.0f (%.1f KB)\n",
+                r.peakRssKb / 1024.0, (double)r.allocationCount / n, (double)r.allocationBytes / n / 1024.0);
+    std::vector<double> stepsRun;
+    for (const auto& s : r.stats) stepsRun.push_back(s.steps_run);
+    const Summary steps = summarize(stepsRun);
+    if (!r.stats.empty() && steps.mean < r.config.steps) {
+        std::printf("diffusion steps run: mean %.2f  p50 %.0f  (of %d)\n", steps.mean, steps.p50, r.config.steps);
+    }
+    if (const SupertonicSynthesisStats* s = lastStats(r)) {
+        const char* names[] = {"te", "dp", "ve", "voc"};
+        std::printf("models");
+        for (int m = 0; m < SUPERTONIC_NUM_MODELS; m++) {
+            std::printf(" %s=%s%s", names[m], variantName(s->model_variant[m]),
+                        (s->xnnpack_models & (1u << m)) != 0 ? "+xnnpack" : "");
+        }
+        std::printf("\n");
+        std::printf("placement: caller cpus 0x%llx, last on cpu%d, pool cpus 0x%llx\n",
+                    (unsigned long long)s->caller_cpus, s->caller_cpu, (unsigned long long)s->pool_cpus);
+    }
+    printPerf(r);
+}
+
+static void writeSummaryJson(FILE* f, const Summary& s) {
+    std::fprintf(f, "{\"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}",
+                 s.mean, s.p50, s.p95, s.p99, s.max);
+}
+
+static std::string jsonEscape(const std::string& in) {
+    std::string out;
+    for (char c : in) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+static bool writeJson(const std::string& path, const std::string& corpus, const std::vector<RunResult>& results) {
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (f == nullptr) {
+        return false;
+    }
+    std::fprintf(f, "{\n  \"abi_version\": %u,\n  \"corpus\": \"%s\",\n  \"runs\": [\n",
+                 supertonic_abi_version(), jsonEscape(corpus).c_str());
+    for (size_t i = 0; i < results.size(); i++) {
+        const RunResult& r = results[i];
+        size_t n = std::max<size_t>(1, r.stats.size());
+        std::fprintf(f, "    {\n      \"threads\": %d, \"steps\": %d, \"speaker\": %d,\n",
+                     r.config.threads, r.config.steps, r.config.speaker);
+        std::fprintf(f, "      \"utterances\": %zu, \"failures\": %d,\n", r.stats.size(), r.failures);
+        const SupertonicSynthesisStats* last = lastStats(r);
+        std::fprintf(f, "      \"model_variants\": [");
+        for (int m = 0; m < SUPERTONIC_NUM_MODELS; m++) {
+            std::fprintf(f, "%s\"%s\"", m > 0 ? ", " : "", variantName(last != nullptr ? last->model_variant[m] : 0));
+        }
+        std::fprintf(f, "], \"xnnpack_models\": %u,\n", last != nullptr ? last->xnnpack_models : 0u);
+        std::fprintf(f, "      \"stages_ms\": {\n");
+        for (int stage = 0; stage < kNumStages; stage++) {
+            std::vector<double> values;
+            for (const auto& s : r.stats) values.push_back(stageValue(s, stage));
+            std::fprintf(f, "        \"%s\": ", kStageNames[stage]);
+            writeSummaryJson(f, summarize(values));
+            std::fprintf(f, ",\n");
+        }
+        std::fprintf(f, "        \"steps\": [");
+        for (int step = 0; step < r.config.steps; step++) {
+            std::vector<double> values;
+            for (const auto& s : r.stats) values.push_back(s.step_ms[step]);
+            writeSummaryJson(f, summarize(values));
+            if (step + 1 < r.config.steps) std::fprintf(f, ", ");
+        }
+        std::fprintf(f, "]\n      },\n");
+        std::vector<double> stepsRun;
+        for (const auto& s : r.stats) stepsRun.push_back(s.steps_run);
+        std::fprintf(f, "      \"steps_run\": ");
+        writeSummaryJson(f, summarize(stepsRun));
+        std::fprintf(f, ",\n");
+        // Mean counts per utterance; counters the kernel refused stay 0
+        std::fprintf(f, "      \"perf\": {");
+        for (int stage = 0; stage < kNumPerfStages; stage++) {
+            uint32_t mask = 0;
+            const SupertonicPerfCounts counts = meanPerfCounts(r, stage, -1, mask);
+            std::fprintf(f, "%s\"%s\": [", stage > 0 ? ", " : "", kPerfStageNames[stage]);
+            for (int c = 0; c < SUPERTONIC_NUM_PERF_COUNTERS; c++) {
+                std::fprintf(f, "%s%llu", c > 0 ? ", " : "", (unsigned long long)counts.count[c]);
+            }
+            std::fprintf(f, "]");
+        }
+        std::fprintf(f, "},\n");
+
+        double totalMs = 0, audioSec = 0;
+        std::vector<double> rtfs;
+        for (const auto& s : r.stats) {
+            totalMs += s.total_ms;
+            audioSec += s.audio_seconds;
+            rtfs.push_back(s.rtf);
+        }
+        std::fprintf(f, "      \"audio_seconds\": %.3f,\n", audioSec);
+        std::fprintf(f, "      \"rtf_aggregate\": %.4f,\n", audioSec > 0 ? totalMs / (audioSec * 1000.0) : 0.0);
+        std::fprintf(f, "      \"rtf\": ");
+        writeSummaryJson(f, summarize(rtfs));
+        std::fprintf(f, ",\n      \"peak_rss_kb\": %ld,\n", r.peakRssKb);
+        std::fprintf(f, "      \"allocations_per_utterance\": %.1f,\n", (double)r.allocationCount / n);
+        std::fprintf(f, "      \"allocated_bytes_per_utterance\": %.1f\n", (double)r.allocationBytes / n);
+        std::fprintf(f, "    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+    std::fclose(f);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Main
+// ---------------------------------------------------------------------------
+
+static std::vector<int> parseIntList(const char* arg) {
+    std::vector<int> values;
+    std::stringstream ss(arg);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) values.push_back(std::atoi(item.c_str()));
+    }
+    return values;
+}
+
+static void printMemoryReport(SupertonicEngine* engine) {
+    SupertonicMemoryReport report;
+    supertonic_memory_report_init(&report);
+    if (supertonic_get_memory_report(engine, &report) != SUPERTONIC_OK) {
+        return;
+    }
+    static const char* const kModels[SUPERTONIC_NUM_MODELS] = {
+        "text_encoder", "duration_predictor", "vector_estimator", "vocoder"};
+    const double mb = 1024.0 * 1024.0;
+    std::printf("\nmemory: heap %.1f MB, rss %.1f MB, arena est. %.1f MB, styles %.2f MB, scratch peak %.2f MB\n",
+                report.native_heap_bytes / mb, report.process_rss_bytes / mb,
+                report.arena_estimate_bytes / mb, report.style_cache_bytes / mb,
+                report.scratch_peak_bytes / mb);
+    std::printf("  text cache: %u entries, %.2f MB\n", report.cached_texts, report.text_cache_bytes / mb);
+    for (int m = 0; m < SUPERTONIC_NUM_MODELS; m++) {
+        std::printf("  %-20s session %7.1f MB  shared %7.1f MB  x%u  file %7.1f MB\n", kModels[m],
+                    report.session_bytes[m] / mb, report.shared_weight_bytes[m] / mb,
+                    report.session_instances[m], report.model_file_bytes[m] / mb);
+    }
+}
+
+static void runShapeWarmup(SupertonicEngine* engine, int speaker, const std::vector<int>& buckets) {
+    const bool defaults = buckets.empty() || (buckets.size() == 1 && buckets[0] == 0);
+    std::vector<int32_t> tokenCounts(buckets.begin(), buckets.end());
+    std::vector<double> bucketMs(defaults ? SUPERTONIC_WARMUP_DEFAULT_BUCKETS : buckets.size());
+    SupertonicStatus status = supertonic_warmup(engine, speaker,
+                                                defaults ? nullptr : tokenCounts.data(), nullptr,
+                                                defaults ? 0 : tokenCounts.size(), bucketMs.data());
+    if (status != SUPERTONIC_OK) {
+        std::fprintf(stderr, "Shape warmup failed: %s\n", supertonic_status_string(status));
+        return;
+    }
+    std::printf("  shape warmup:");
+    for (size_t i = 0; i < bucketMs.size(); i++) {
+        std::printf("%s%.1f", i > 0 ? ", " : " ", bucketMs[i]);
+    }
+    std::printf(" ms\n");
+}
+
+static void runDurationEstimate(SupertonicEngine* engine, int speaker, float speed,
+                                const std::vector<std::string>& corpus, const RunResult& result) {
+    std::vector<const char*> texts;
+    for (const std::string& text : corpus) {
+        texts.push_back(text.c_str());
+    }
+    std::vector<double> seconds(texts.size());
+    const auto start = std::chrono::steady_clock::now();
+    SupertonicStatus status = supertonic_estimate_durations(engine, texts.data(), texts.size(),
+                                                            speaker, speed, seconds.data());
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (status != SUPERTONIC_OK) {
+        std::fprintf(stderr, "Duration estimate failed: %s\n", supertonic_status_string(status));
+        return;
+    }
+    double estimated = 0.0;
+    for (double s : seconds) {
+        estimated += s;
+    }
+    double synthesized = 0.0;
+    for (const auto& stats : result.stats) {
+        synthesized += stats.audio_seconds;
+    }
+    std::printf("  duration estimate: %zu texts in %.1f ms, %.1f s (synthesized %.1f s per pass)\n",
+                texts.size(), ms, estimated, synthesized / std::max<size_t>(1, result.stats.size()) * corpus.size());
+}
+
+static void countCompletion(void* userData, uint64_t, SupertonicStatus) {
+    static_cast<std::atomic<int>*>(userData)->fetch_add(1);
+}
+
+static void runScheduled(SupertonicEngine* engine, const SupertonicSynthesisRequest& base,
+                         const std::vector<std::string>& corpus, SupertonicExecutionClass prefetchClass,
+                         int cancelEvery) {
+    static constexpr int64_t kPrefetchDeadlineMs = 60000;
+    std::atomic<int> completions(0);
+    std::vector<uint64_t> jobs;
+    for (size_t i = 0; i < corpus.size(); i++) {
+        SupertonicSynthesisRequest request = base;
+        request.text = corpus[i].c_str();
+        request.execution_class = prefetchClass;
+        for (int copy = 0; copy < (i % 2 == 1 ? 2 : 1); copy++) {
+            uint64_t job = 0;
+            if (supertonic_submit_async(engine, &request, kPrefetchDeadlineMs, countCompletion, &completions,
+                                        &job) == SUPERTONIC_OK) {
+                jobs.push_back(job);
+            }
+        }
+    }
+    int cancelled = 0;
+    for (size_t i = 0; cancelEvery > 0 && i < jobs.size(); i += (size_t)cancelEvery) {
+        cancelled += supertonic_cancel(engine, jobs[i]) == SUPERTONIC_OK ? 1 : 0;
+    }
+    // Unlike anything in the corpus, so it cannot join a prefetch job
+    const std::string urgentText = corpus.front() + " Now.";
+    SupertonicSynthesisRequest urgent = base;
+    urgent.text = urgentText.c_str();
+    uint64_t urgentJob = 0;
+    SupertonicStatus status = supertonic_submit(engine, &urgent, 0, &urgentJob);
+    if (status != SUPERTONIC_OK) {
+        std::fprintf(stderr, "Scheduled submit failed: %s\n", supertonic_status_string(status));
+    }
+
+    std::vector<double> prefetchQueueMs;
+    int merged = 0;
+    int preemptions = 0;
+    int promoted = 0;
+    double prefetchCpuMs = 0.0;
+    auto collect = [&](uint64_t job, SupertonicSynthesisStats& stats) {
+        supertonic_stats_init(&stats);
+        SupertonicAudio audio;
+        if (supertonic_job_wait(engine, job, &audio, &stats, nullptr) != SUPERTONIC_OK) {
+            return false;
+        }
+        supertonic_audio_free(&audio);
+        return true;
+    };
+    SupertonicSynthesisStats urgentStats;
+    const bool urgentOk = status == SUPERTONIC_OK && collect(urgentJob, urgentStats);
+    for (uint64_t job : jobs) {
+        SupertonicSynthesisStats stats;
+        if (collect(job, stats)) {
+            prefetchQueueMs.push_back(stats.queue_ms);
+            merged += stats.shared_requests > 1 ? 1 : 0;
+            preemptions += stats.preemptions;
+            promoted += stats.execution_class != prefetchClass ? 1 : 0;
+            prefetchCpuMs += stats.cpu_thread_user_ms + stats.cpu_thread_system_ms;
+        }
+    }
+    const Summary queued = summarize(prefetchQueueMs);
+    std::printf("  scheduled: %zu %s prefetch submissions, %d merged, %d paused, %d promoted, "
+                "queued p50 %.1f ms  max %.1f ms, thread cpu %.1f ms\n",
+                jobs.size(), prefetchClass == SUPERTONIC_CLASS_BACKGROUND ? "background" : "foreground", merged,
+                preemptions, promoted, queued.p50, queued.max, prefetchCpuMs);
+    // A callback may still be running when the last wait returns
+    for (int i = 0; i < 100 && completions.load() < (int)jobs.size(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::printf("  scheduled: %d cancelled, %d of %zu completion callbacks\n", cancelled, completions.load(),
+                jobs.size());
+    if (urgentOk) {
+        std::printf("  scheduled: urgent job queued %.1f ms, done in %.1f ms\n", urgentStats.queue_ms,
+                    urgentStats.queue_ms + urgentStats.total_ms);
+    }
+}
+
+/** The cores as the engine ranks them, and where each class runs. */
+static void printTopology() {
+    SupertonicCpuTopology topology;
+    supertonic_cpu_topology_init(&topology);
+    if (supertonic_get_cpu_topology(&topology) != SUPERTONIC_OK || topology.num_cores == 0) {
+        std::printf("cpu topology: unknown\n");
+        return;
+    }
+    std::printf("cpu topology:");
+    for (int i = 0; i < topology.num_cores; i++) {
+        std::printf(" cpu%d(c%d %d@%dMHz)", topology.cpu[i], topology.cluster[i], topology.capacity[i],
+                    topology.max_freq_khz[i] / 1000);
+    }
+    std::printf("\n  foreground cpus 0x%llx  background cpus 0x%llx\n",
+                (unsigned long long)topology.foreground_cpus, (unsigned long long)topology.background_cpus);
+}
+
+static void usage(const char* argv0) {
+    std::fprintf(stderr,
+                 "usage: %s --model-dir DIR --corpus FILE [--threads 1,2,4] [--steps 5]\n"
+                 "          [--speakers 0] [--speed 1.0] [--warmup 2] [--repeat 1]\n"
+                 "          [--limit N] [--json OUT] [--profile DIR]\n"
+                 "          [--warmup-buckets 16,64,160,320] [--length-buckets on|off]\n"
+                 "          [--max-chunk-tokens N] [--fp16 on|off] [--model-variants auto|off]\n"
+                 "          [--xnnpack on|off] [--thread-budget N] [--thread-pool global|session]\n"
+                 "          [--spin on|off] [--pin on|off] [--shared-arena on|off]\n"
+                 "          [--arena-limit-mb N] [--early-exit T] [--early-exit-min-steps N]\n"
+                 "          [--scheduled on|off] [--preempt on|off] [--prefetch-class background|foreground]\n"
+                 "          [--cancel-every N] [--share-weights on|off] [--session-pool N]\n"
+                 "          [--perf-counters on|off] [--trace FILE]\n",
+                 argv0);
+}
+
+int main(int argc, char** argv) {
+    std::string modelDir;
+    std::string corpusPath;
+    std::string jsonPath;
+    std::string profileDir;
+    std::string tracePath;
+    std::vector<int> threadList = {2};
+    std::vector<int> stepList = {5};
+    std::vector<int> speakerList = {0};
+    float speed = 1.0f;
+    int warmup = 2;
+    std::vector<int> warmupBuckets;
+    bool shapeWarmup = false;
+    bool lengthBuckets = true;
+    int maxChunkTokens = -1;  // engine default
+    bool fp16 = false;
+    bool modelVariants = true;
+    bool xnnpack = false;
+    int threadBudget = 0;
+    bool globalPool = true;
+    bool spin = false;
+    bool pin = false;
+    bool sharedArena = true;
+    int arenaLimitMb = 0;
+    float earlyExit = 0.0f;
+    int earlyExitMinSteps = -1;  // engine default
+    bool scheduled = false;
+    bool preempt = true;
+    SupertonicExecutionClass prefetchClass = SUPERTONIC_CLASS_BACKGROUND;
+    int cancelEvery = 0;
+    bool shareWeights = true;
+    int sessionPool = 0;
+    bool perfCounters = false;
+    int repeat = 1;
+    size_t limit = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value == nullptr && arg.rfind("--", 0) == 0) {
+            usage(argv[0]);
+            return 2;
+        }
+        if (arg == "--model-dir") { modelDir = value; i++; }
+        else if (arg == "--corpus") { corpusPath = value; i++; }
+        else if (arg == "--json") { jsonPath = value; i++; }
+        else if (arg == "--profile") { profileDir = value; i++; }
+        else if (arg == "--trace") { tracePath = value; i++; }
+        else if (arg == "--threads") { threadList = parseIntList(value); i++; }
+        else if (arg == "--steps") { stepList = parseIntList(value); i++; }
+        else if (arg == "--speakers") { speakerList = parseIntList(value); i++; }
+        else if (arg == "--speed") { speed = (float)std::atof(value); i++; }
+        else if (arg == "--length-buckets") { lengthBuckets = std::strcmp(value, "off") != 0; i++; }
+        else if (arg == "--max-chunk-tokens") { maxChunkTokens = std::atoi(value); i++; }
+        else if (arg == "--fp16") { fp16 = std::strcmp(value, "on") == 0; i++; }
+        else if (arg == "--model-variants") { modelVariants = std::strcmp(value, "off") != 0; i++; }
+        else if (arg == "--xnnpack") { xnnpack = std::strcmp(value, "on") == 0; i++; }
+        else if (arg == "--thread-budget") { threadBudget = std::max(0, std::atoi(value)); i++; }
+        else if (arg == "--thread-pool") { globalPool = std::strcmp(value, "session") != 0; i++; }
+        else if (arg == "--spin") { spin = std::strcmp(value, "on") == 0; i++; }
+        else if (arg == "--pin") { pin = std::strcmp(value, "on") == 0; i++; }
+        else if (arg == "--shared-arena") { sharedArena = std::strcmp(value, "off") != 0; i++; }
+        else if (arg == "--arena-limit-mb") { arenaLimitMb = std::max(0, std::atoi(value)); i++; }
+        else if (arg == "--early-exit") { earlyExit = std::max(0.0f, (float)std::atof(value)); i++; }
+        else if (arg == "--early-exit-min-steps") { earlyExitMinSteps = std::max(0, std::atoi(value)); i++; }
+        else if (arg == "--scheduled") { scheduled = std::strcmp(value, "on") == 0; i++; }
+        else if (arg == "--preempt") { preempt = std::strcmp(value, "off") != 0; i++; }
+        else if (arg == "--cancel-every") { cancelEvery = std::max(0, std::atoi(value)); i++; }
+        else if (arg == "--share-weights") { shareWeights = std::strcmp(value, "off") != 0; i++; }
+        else if (arg == "--session-pool") {
+            sessionPool = std::min(std::max(0, std::atoi(value)), SUPERTONIC_MAX_SESSION_POOL);
+            i++;
+        }
+        else if (arg == "--perf-counters") { perfCounters = std::strcmp(value, "on") == 0; i++; }
+        else if (arg == "--prefetch-class") {
+            prefetchClass = std::strcmp(value, "foreground") == 0 ? SUPERTONIC_CLASS_FOREGROUND
+                                                                  : SUPERTONIC_CLASS_BACKGROUND;
+            i++;
+        }
+        else if (arg == "--warmup-buckets") { warmupBuckets = parseIntList(value); shapeWarmup = true; i++; }
+        else if (arg == "--warmup") { warmup = std::atoi(value); i++; }
+        else if (arg == "--repeat") { repeat = std::max(1, std::atoi(value)); i++; }
+        else if (arg == "--limit") { limit = (size_t)std::atol(value); i++; }
+        else { usage(argv[0]); return 2; }
+    }
+
+    if (modelDir.empty() || corpusPath.empty() || threadList.empty() ||
+        stepList.empty() || speakerList.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+    for (int steps : stepList) {
+        if (steps < 1 || steps > SUPERTONIC_MAX_DIFFUSION_STEPS) {
+            std::fprintf(stderr, "steps must be in 1..%d\n", SUPERTONIC_MAX_DIFFUSION_STEPS);
+            return 2;
+        }
+    }
+
+    std::vector<std::string> corpus = loadCorpus(corpusPath);
+    if (limit > 0 && corpus.size() > limit) {
+        corpus.resize(limit);
+    }
+    if (corpus.empty()) {
+        std::fprintf(stderr, "No utterances found in %s\n", corpusPath.c_str());
+        return 1;
+    }
+    std::printf("corpus: %s (%zu utterances)\n", corpusPath.c_str(), corpus.size());
+    std::printf("cpu features: 0x%x\n", supertonic_cpu_features());
+    printTopology();
+
+    std::vector<RunResult> results;
+
+    if (!tracePath.empty()) {
+        SupertonicStatus status = supertonic_trace_start(tracePath.c_str());
+        if (status != SUPERTONIC_OK) {
+            std::fprintf(stderr, "Failed to start trace: %s\n", supertonic_status_string(status));
+            return 1;
+        }
+    }
+
+    for (int threads : threadList) {
+        SupertonicEngineConfig config;
+        supertonic_engine_config_init(&config);
+        config.intra_op_threads = threads;
+        // Every repetition should pay for the full pipeline
+        config.text_cache_entries = 0;
+        if (!lengthBuckets) {
+            std::fill(std::begin(config.token_buckets), std::end(config.token_buckets), 0);
+            std::fill(std::begin(config.latent_buckets), std::end(config.latent_buckets), 0);
+        }
+        if (maxChunkTokens >= 0) {
+            config.max_chunk_tokens = maxChunkTokens;
+        }
+        config.fp16_io = fp16 ? 1 : 0;
+        config.model_variants = modelVariants ? 1 : 0;
+        config.xnnpack = xnnpack ? 1 : 0;
+        config.thread_budget = threadBudget;
+        config.global_thread_pool = globalPool ? 1 : 0;
+        config.spin_wait = spin ? 1 : 0;
+        config.pin_threads = pin ? 1 : 0;
+        config.shared_arena = sharedArena ? 1 : 0;
+        config.arena_limit_mb = arenaLimitMb;
+        config.early_exit_threshold = earlyExit;
+        if (earlyExitMinSteps >= 0) {
+            config.early_exit_min_steps = earlyExitMinSteps;
+        }
+        config.preempt_jobs = preempt ? 1 : 0;
+        config.share_weights = shareWeights ? 1 : 0;
+        config.session_pool_size = sessionPool;
+        config.perf_counters = perfCounters ? 1 : 0;
+
+        SupertonicEngine* engine = nullptr;
+        SupertonicStatus status = supertonic_engine_create_with_config(modelDir.c_str(), &config, &engine);
+        if (status != SUPERTONIC_OK) {
+            std::fprintf(stderr, "Failed to create engine: %s\n", supertonic_status_string(status));
+            return 1;
+        }
+
+        for (int steps : stepList) {
+            for (int speaker : speakerList) {
+                RunResult result;
+                result.config = {threads, steps, speaker};
+
+                SupertonicSynthesisRequest request;
+                supertonic_request_init(&request);
+                request.speaker_id = speaker;
+                request.speed = speed;
+                request.num_steps = steps;
+
+                // Reloads the sessions, so start before warming them up
+                if (!profileDir.empty()) {
+                    status = supertonic_profiling_start(engine, profileDir.c_str());
+                    if (status != SUPERTONIC_OK) {
+                        std::fprintf(stderr, "Failed to start profiling: %s\n", supertonic_status_string(status));
+                        return 1;
+                    }
+                }
+
+                if (shapeWarmup) {
+                    runShapeWarmup(engine, speaker, warmupBuckets);
+                }
+
+                // Warm up outside the measurement window
+                for (int w = 0; w < warmup; w++) {
+                    request.text = corpus[w % corpus.size()].c_str();
+                    SupertonicAudio audio;
+                    if (supertonic_synthesize(engine, &request, &audio) == SUPERTONIC_OK) {
+                        supertonic_audio_free(&audio);
+                    }
+                }
+
+                resetPeakRss();
+                g_allocationCount = 0;
+                g_allocationBytes = 0;
+                g_countAllocations = true;
+
+                for (int rep = 0; rep < repeat; rep++) {
+                    for (const std::string& text : corpus) {
+                        request.text = text.c_str();
+                        SupertonicAudio audio;
+                        SupertonicSynthesisStats stats;
+                        supertonic_stats_init(&stats);
+                        status = supertonic_synthesize_with_stats(engine, &request, &audio, &stats);
+                        if (status != SUPERTONIC_OK) {
+                            result.failures++;
+                            continue;
+                        }
+                        supertonic_audio_free(&audio);
+                        result.stats.push_back(stats);
+                    }
+                }
+
+                g_countAllocations = false;
+                result.allocationCount = g_allocationCount;
+                result.allocationBytes = g_allocationBytes;
+                result.peakRssKb = readProcStatusKb("VmHWM");
+
+                printResult(result);
+                runDurationEstimate(engine, speaker, speed, corpus, result);
+                if (scheduled) {
+                    runScheduled(engine, request, corpus, prefetchClass, cancelEvery);
+                }
+
+                if (!profileDir.empty()) {
+                    char tracePath[1024];
+                    status = supertonic_profiling_stop(engine, tracePath, sizeof(tracePath));
+                    if (status == SUPERTONIC_OK) {
+                        std::printf("  trace: %s\n", tracePath);
+                    } else {
+                        std::fprintf(stderr, "Failed to write trace: %s\n", supertonic_status_string(status));
+                    }
+                }
+                results.push_back(std::move(result));
+            }
+        }
+
+        printMemoryReport(engine);
+        supertonic_engine_destroy(engine);
+    }
+
+    if (!tracePath.empty()) {
+        SupertonicStatus status = supertonic_trace_stop();
+        if (status == SUPERTONIC_OK) {
+            std::printf("\ntrace: %s\n", tracePath.c_str());
+        } else {
+            std::fprintf(stderr, "Failed to write trace: %s\n", supertonic_status_string(status));
+        }
+    }
+
+    if (!jsonPath.empty()) {
+        if (!writeJson(jsonPath, corpusPath, results)) {
+            std::fprintf(stderr, "Failed to write %s\n", jsonPath.c_str());
+            return 1;
+        }
+        std::printf("\nwrote %s\n", jsonPath.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * cpu_features.cpp - HWCAP (arm64) / CPUID (x86-64) feature probes
+ */
+
+#include "cpu_features.h"
+#include "supertonic.h"
+
+#if defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace supertonic {
+
+namespace {
+
+struct FeatureName {
+    const char* name;
+    uint32_t bit;
+};
+
+const FeatureName kFeatureNames[] = {
+    {"neon", SUPERTONIC_CPU_NEON},
+    {"asimdhp", SUPERTONIC_CPU_ASIMDHP},
+    {"dotprod", SUPERTONIC_CPU_DOTPROD},
+    {"i8mm", SUPERTONIC_CPU_I8MM},
+    {"avx2", SUPERTONIC_CPU_AVX2},
+    {"f16c", SUPERTONIC_CPU_F16C},
+    {"avx512vnni", SUPERTONIC_CPU_AVX512VNNI},
+    {"avxvnni", SUPERTONIC_CPU_AVXVNNI},
+};
+
+#if defined(__aarch64__) && defined(__linux__)
+
+// Linux arm64 hwcap bits; older NDK headers lack the newer ones
+constexpr unsigned long kHwcapAsimd = 1ul << 1;
+constexpr unsigned long kHwcapAsimdHp = 1ul << 10;
+constexpr unsigned long kHwcapAsimdDp = 1ul << 20;
+constexpr unsigned long kHwcap2I8mm = 1ul << 13;
+
+uint32_t probe() {
+    const unsigned long hwcap = getauxval(AT_HWCAP);
+    const unsigned long hwcap2 = getauxval(AT_HWCAP2);
+    uint32_t features = 0;
+    if (hwcap & kHwcapAsimd) features |= SUPERTONIC_CPU_NEON;
+    if (hwcap & kHwcapAsimdHp) features |= SUPERTONIC_CPU_ASIMDHP;
+    if (hwcap & kHwcapAsimdDp) features |= SUPERTONIC_CPU_DOTPROD;
+    if (hwcap2 & kHwcap2I8mm) features |= SUPERTONIC_CPU_I8MM;
+    return features;
+}
+
+#elif defined(__x86_64__) || defined(__i386__)
+
+// XCR0 state the OS saves on context switch
+uint64_t xgetbv0() {
+    uint32_t eax = 0;
+    uint32_t edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+}
+
+uint32_t probe() {
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return 0;
+    }
+    const bool osxsave = (ecx & (1u << 27)) != 0;
+    const bool f16c = (ecx & (1u << 29)) != 0;
+    const uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+    const bool ymm = (xcr0 & 0x6) == 0x6;     // SSE + AVX state
+    const bool zmm = (xcr0 & 0xe6) == 0xe6;   // plus opmask and ZMM state
+    if (!ymm) {
+        return 0;
+    }
+
+    uint32_t features = f16c ? SUPERTONIC_CPU_F16C : 0;
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        if (ebx & (1u << 5)) features |= SUPERTONIC_CPU_AVX2;
+        if (zmm && (ecx & (1u << 11))) features |= SUPERTONIC_CPU_AVX512VNNI;
+    }
+    if (__get_cpuid_count(7, 1, &eax, &ebx, &ecx, &edx)) {
+        if (eax & (1u << 4)) features |= SUPERTONIC_CPU_AVXVNNI;
+    }
+    return features;
+}
+
+#else
+
+uint32_t probe() {
+    return 0;
+}
+
+#endif
+
+} // namespace
+
+uint32_t cpuFeatures() {
+    static const uint32_t features = probe();
+    return features;
+}
+
+uint32_t cpuFeatureBit(const std::string& name) {
+    for (const FeatureName& feature : kFeatureNames) {
+        if (name == feature.name) {
+            return feature.bit;
+        }
+    }
+    return 0;
+}
+
+std::string cpuFeatureNames(uint32_t features) {
+    std::string names;
+    for (const FeatureName& feature : kFeatureNames) {
+        if (features & feature.bit) {
+            if (!names.empty()) {
+                names += ' ';
+            }
+            names += feature.name;
+        }
+    }
+    return names.empty() ? "none" : names;
+}
+
+} // namespace supertonic
@@ -0,0 +1,21 @@
+/*
+ * cpu_features.h - Runtime detection of the SIMD extensions model variants need
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace supertonic {
+
+/** SupertonicCpuFeature bits of this CPU; probed once, then cached. */
+uint32_t cpuFeatures();
+
+/** Bit of a feature name as written in onnx/variants.txt, 0 if unknown. */
+uint32_t cpuFeatureBit(const std::string& name);
+
+/** Space-separated names of the bits in features, for logs. */
+std::string cpuFeatureNames(uint32_t features);
+
+} // namespace supertonic
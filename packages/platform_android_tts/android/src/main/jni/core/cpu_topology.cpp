@@ -0,0 +1,266 @@
+/*
+ * cpu_topology.cpp - sysfs core capacity, clock and SMT probes; thread placement
+ */
+
+#include "cpu_topology.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <set>
+#include <thread>
+#include <utility>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace supertonic {
+
+namespace {
+
+#if defined(__linux__)
+
+long readCpuValue(int cpu, const char* file) {
+    char path[96];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/%s", cpu, file);
+    FILE* f = fopen(path, "r");
+    if (f == nullptr) {
+        return -1;
+    }
+    long value = -1;
+    if (fscanf(f, "%ld", &value) != 1) {
+        value = -1;
+    }
+    fclose(f);
+    return value;
+}
+
+/** Allowed physical cores (SMT siblings dropped), fastest first, clusters numbered. */
+std::vector<CpuCore> probeCores() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    const bool haveMask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+    const long configured = sysconf(_SC_NPROCESSORS_CONF);
+
+    std::vector<CpuCore> cores;
+    std::set<std::pair<long, long>> physical;
+    for (int cpu = 0; cpu < configured && cpu < CPU_SETSIZE; cpu++) {
+        if (haveMask && !CPU_ISSET(cpu, &allowed)) {
+            continue;
+        }
+        // Second hardware thread of a core already counted
+        const std::pair<long, long> id(readCpuValue(cpu, "topology/physical_package_id"),
+                                       readCpuValue(cpu, "topology/core_id"));
+        if (id.second >= 0 && !physical.insert(id).second) {
+            continue;
+        }
+        // cpu_capacity is the scheduler's own ranking; max frequency breaks
+        // ties and stands in for it on kernels without it
+        cores.push_back({cpu, 0, std::max(readCpuValue(cpu, "cpu_capacity"), 0L),
+                         std::max(readCpuValue(cpu, "cpufreq/cpuinfo_max_freq"), 0L)});
+    }
+    auto faster = [](const CpuCore& a, const CpuCore& b) {
+        if (a.capacity != b.capacity) {
+            return a.capacity > b.capacity;
+        }
+        return a.maxFreqKhz > b.maxFreqKhz;
+    };
+    std::stable_sort(cores.begin(), cores.end(), faster);
+    for (size_t i = 1; i < cores.size(); i++) {
+        cores[i].cluster = cores[i - 1].cluster + (faster(cores[i - 1], cores[i]) ? 1 : 0);
+    }
+    return cores;
+}
+
+#else
+
+std::vector<CpuCore> probeCores() {
+    return {};
+}
+
+#endif
+
+struct Clusters {
+    std::vector<int> big;
+    std::vector<int> little;
+};
+
+/**
+ * Big = every cluster above the slowest, little = the slowest; a uniform
+ * CPU (or one sysfs does not describe) is all big and all little.
+ */
+const Clusters& clusters() {
+    static const Clusters split = [] {
+        Clusters c;
+        const std::vector<CpuCore>& cores = cpuTopology();
+        if (cores.empty()) {
+            const unsigned count = std::max(1u, std::thread::hardware_concurrency());
+            for (unsigned cpu = 0; cpu < count; cpu++) {
+                c.big.push_back((int)cpu);
+            }
+            c.little = c.big;
+            return c;
+        }
+        const int slowest = cores.back().cluster;
+        for (const CpuCore& core : cores) {
+            if (core.cluster < slowest || slowest == 0) {
+                c.big.push_back(core.cpu);
+            }
+            if (core.cluster == slowest) {
+                c.little.push_back(core.cpu);
+            }
+        }
+        return c;
+    }();
+    return split;
+}
+
+} // namespace
+
+const std::vector<CpuCore>& cpuTopology() {
+    static const std::vector<CpuCore> cores = probeCores();
+    return cores;
+}
+
+const std::vector<int>& bigCores() {
+    return clusters().big;
+}
+
+const std::vector<int>& littleCores() {
+    return clusters().little;
+}
+
+bool heterogeneousCores() {
+    return clusters().big != clusters().little;
+}
+
+std::string describeTopology() {
+    const std::vector<CpuCore>& cores = cpuTopology();
+    if (cores.empty()) {
+        return "unknown, " + std::to_string(bigCores().size()) + " cores";
+    }
+    std::string text;
+    for (size_t i = 0; i < cores.size(); i++) {
+        char core[64];
+        if (i == 0 || cores[i].cluster != cores[i - 1].cluster) {
+            snprintf(core, sizeof(core), "%scluster %d: ", i == 0 ? "" : "; ", cores[i].cluster);
+            text += core;
+        } else {
+            text += ", ";
+        }
+        snprintf(core, sizeof(core), "cpu%d %ld@%ldMHz", cores[i].cpu, cores[i].capacity, cores[i].maxFreqKhz / 1000);
+        text += core;
+    }
+    return text;
+}
+
+uint64_t cpuMask(const std::vector<int>& cores) {
+    uint64_t mask = 0;
+    for (int cpu : cores) {
+        if (cpu >= 0 && cpu < 64) {
+            mask |= 1ull << cpu;
+        }
+    }
+    return mask;
+}
+
+std::vector<int> currentThreadCpus() {
+    std::vector<int> cpus;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    return cpus;
+}
+
+int currentCpu() {
+#if defined(__linux__)
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+bool placeCurrentThread(const std::vector<int>& cores, int nice) {
+#if defined(__linux__)
+    bool ok = true;
+    if (!cores.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cores) {
+            CPU_SET(cpu, &set);
+        }
+        ok = sched_setaffinity(0, sizeof(set), &set) == 0;
+    }
+    // On Linux the nice value of a thread id applies to that thread alone
+    if (nice != 0) {
+        ok = setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), nice) == 0 && ok;
+    }
+    return ok;
+#else
+    (void)cores;
+    (void)nice;
+    return false;
+#endif
+}
+
+ScopedAffinity::ScopedAffinity(const std::vector<int>& cores) {
+    if (cores.empty()) {
+        return;
+    }
+    std::vector<int> current = currentThreadCpus();
+    if (!current.empty() && current != cores && placeCurrentThread(cores, 0)) {
+        saved_ = std::move(current);
+    }
+}
+
+ScopedAffinity::~ScopedAffinity() {
+    if (!saved_.empty()) {
+        placeCurrentThread(saved_, 0);
+    }
+}
+
+std::vector<std::vector<int>> poolCores(int threads, bool pin) {
+    const std::vector<int>& cores = bigCores();
+    std::vector<std::vector<int>> pool;
+    if (!pin && !heterogeneousCores()) {
+        return pool;
+    }
+    for (int t = 1; t < threads; t++) {
+        if (pin) {
+            // Core 0 of the list is left to the calling thread
+            pool.push_back({cores[(size_t)t % cores.size()]});
+        } else {
+            pool.push_back(cores);
+        }
+    }
+    return pool;
+}
+
+std::string poolAffinity(int threads, bool pin) {
+    std::string affinity;
+    for (const std::vector<int>& thread : poolCores(threads, pin)) {
+        if (!affinity.empty()) {
+            affinity += ';';
+        }
+        for (size_t i = 0; i < thread.size(); i++) {
+            if (i > 0) {
+                affinity += ',';
+            }
+            affinity += std::to_string(thread[i] + 1);
+        }
+    }
+    return affinity;
+}
+
+} // namespace supertonic
@@ -0,0 +1,97 @@
+/*
+ * cpu_topology.h - Which cores are worth running inference threads on
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace supertonic {
+
+/** One physical core this process may run on, as sysfs describes it. */
+struct CpuCore {
+    int cpu;          // logical id (its first hardware thread)
+    int cluster;      // 0 = fastest; cores of a cluster share capacity and clock
+    long capacity;    // cpu_capacity, 0 if the kernel does not report it
+    long maxFreqKhz;  // cpufreq/cpuinfo_max_freq, 0 if unknown
+};
+
+/**
+ * Allowed physical cores (SMT siblings dropped), fastest first by
+ * cpu_capacity and then cpuinfo_max_freq. Empty when sysfs is unreadable.
+ * Probed once, then cached.
+ */
+const std::vector<CpuCore>& cpuTopology();
+
+/**
+ * Logical CPU ids of the physical big cores this process may run on, one
+ * per core (SMT siblings dropped), fastest first. "Big" is every cluster
+ * above the slowest; a uniform CPU counts all its cores. Falls back to
+ * 0..hardware_concurrency-1 when sysfs is unreadable.
+ */
+const std::vector<int>& bigCores();
+
+/**
+ * Logical CPU ids of the slowest cluster this process may run on, one per
+ * physical core; the same cores as bigCores() on a uniform CPU.
+ */
+const std::vector<int>& littleCores();
+
+/** True if the big and little cores differ, i.e. placement matters. */
+bool heterogeneousCores();
+
+/** "cluster 0: cpu7 1024@3200MHz; cluster 1: ..." for logs. */
+std::string describeTopology();
+
+/** Bit i set for each CPU id i below 64 in cores. */
+uint64_t cpuMask(const std::vector<int>& cores);
+
+/** CPUs the calling thread may run on; empty if unknown. */
+std::vector<int> currentThreadCpus();
+
+/** CPU the calling thread is running on, -1 if unknown. */
+int currentCpu();
+
+/**
+ * Restrict the calling thread to cores (empty = leave its affinity) and
+ * set its nice value (0 = leave it). Raising the nice value cannot be
+ * undone without privileges, so only use it on threads the engine owns.
+ * False if either call failed.
+ */
+bool placeCurrentThread(const std::vector<int>& cores, int nice);
+
+/**
+ * Confines the calling thread to cores while in scope and then gives it
+ * back the affinity it had, so a caller's thread can be lent to a class.
+ * An empty list, or one the thread may not use, leaves it alone.
+ */
+class ScopedAffinity {
+public:
+    explicit ScopedAffinity(const std::vector<int>& cores);
+    ~ScopedAffinity();
+
+    ScopedAffinity(const ScopedAffinity&) = delete;
+    ScopedAffinity& operator=(const ScopedAffinity&) = delete;
+
+private:
+    std::vector<int> saved_;  // empty = nothing to restore
+};
+
+/**
+ * Cores each of the threads - 1 pool threads may use (the caller is the
+ * remaining one). pin gives every thread one big core of its own, round
+ * robin; otherwise on a heterogeneous CPU each may float over all big
+ * cores, and on a uniform one the pool is left unplaced (empty lists).
+ */
+std::vector<std::vector<int>> poolCores(int threads, bool pin);
+
+/**
+ * poolCores() as an ONNX Runtime thread affinity string: "2;3;4" when
+ * pinned, "5,6,7,8;5,6,7,8" when confined to a cluster, in ORT's 1-based
+ * processor numbering. Empty when the pool is left unplaced.
+ */
+std::string poolAffinity(int threads, bool pin);
+
+} // namespace supertonic
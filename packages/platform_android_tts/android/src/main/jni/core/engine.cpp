@@ -0,0 +1,3291 @@
+/*
+ * engine.cpp - Platform-independent Supertonic TTS pipeline
+ *
+ * This is the hot path shared by the Android JNI shim and the desktop
+ * library. It must not include jni.h or any Android header; logging goes
+ * through log.h.
+ */
+
+#include "engine.h"
+#include "cpu_features.h"
+#include "cpu_topology.h"
+#include "float16.h"
+#include "log.h"
+#include "memory.h"
+#include "noise.h"
+#include "ort_runtime.h"
+#include "timing.h"
+
+#include <onnxruntime_run_options_config_keys.h>
+#include <onnxruntime_session_options_config_keys.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <limits>
+#include <sstream>
+#include <system_error>
+#include <thread>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace supertonic {
+
+/**
+ * Load unicode_indexer.json for text tokenization
+ *
+ * The file is a JSON array where:
+ * - Array index = Unicode codepoint
+ * - Array value = token index (-1 means invalid/unknown)
+ *
+ * Example: [−1, −1, ..., 0, 1, 2, ...] where index 32 (space) might map to token 0
+ */
+static bool loadUnicodeIndexer(SupertonicEngine* engine, const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        LOGE("Failed to open unicode_indexer.json: %s", path.c_str());
+        return false;
+    }
+
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string content = buffer.str();
+
+    engine->unicodeIndexer.clear();
+
+    // Parse JSON array: [val0, val1, val2, ...]
+    // Find the opening bracket
+    size_t start = content.find('[');
+    if (start == std::string::npos) {
+        LOGE("Invalid unicode_indexer.json: no opening bracket");
+        return false;
+    }
+
+    size_t pos = start + 1;
+    int32_t codepoint = 0;
+    int validCount = 0;
+
+    while (pos < content.size()) {
+        // Skip whitespace and commas
+        while (pos < content.size() && (content[pos] == ' ' || content[pos] == '\t' ||
+               content[pos] == '\n' || content[pos] == '\r' || content[pos] == ',')) {
+            pos++;
+        }
+
+        if (pos >= content.size() || content[pos] == ']') {
+            break;  // End of array
+        }
+
+        // Parse the integer value (may be negative)
+        size_t valueStart = pos;
+        if (content[pos] == '-') {
+            pos++;
+        }
+        while (pos < content.size() && isdigit(content[pos])) {
+            pos++;
+        }
+
+        if (pos > valueStart) {
+            try {
+                int64_t tokenIndex = std::stoll(content.substr(valueStart, pos - valueStart));
+                // Only store valid mappings (token index >= 0)
+                if (tokenIndex >= 0) {
+                    engine->unicodeIndexer[codepoint] = tokenIndex;
+                    validCount++;
+                }
+            } catch (...) {
+                // Skip invalid entries
+            }
+        }
+
+        codepoint++;
+    }
+
+    LOGI("Loaded unicode_indexer.json: %d codepoints scanned, %d valid mappings",
+         codepoint, validCount);
+    return validCount > 0;
+}
+
+/**
+ * Parse a nested float array from JSON: [[[ ... ]]]
+ * Extracts all float values into a flattened vector
+ */
+static std::vector<float> parseNestedFloatArray(const std::string& json, const std::string& key) {
+    std::vector<float> result;
+
+    // Find the key
+    std::string searchKey = "\"" + key + "\"";
+    size_t keyPos = json.find(searchKey);
+    if (keyPos == std::string::npos) {
+        return result;
+    }
+
+    // Find "data" under this key
+    size_t dataPos = json.find("\"data\"", keyPos);
+    if (dataPos == std::string::npos) {
+        return result;
+    }
+
+    // Find the opening bracket of the array
+    size_t start = json.find('[', dataPos);
+    if (start == std::string::npos) {
+        return result;
+    }
+
+    // Count nested brackets to find all floats
+    size_t pos = start;
+    while (pos < json.size()) {
+        char c = json[pos];
+
+        if (c == ']') {
+            // Check if we're done with this array
+            size_t nextBracket = json.find_first_of("[]", pos + 1);
+            if (nextBracket == std::string::npos || json[nextBracket] == '[') {
+                // We might be at a new key, check if there's a colon before the bracket
+                size_t colonPos = json.find(':', pos + 1);
+                if (colonPos != std::string::npos && colonPos < nextBracket) {
+                    break;  // New key found, stop parsing
+                }
+            }
+            pos++;
+        } else if (c == '-' || isdigit(c)) {
+            // Parse a number
+            size_t numStart = pos;
+            while (pos < json.size() && (isdigit(json[pos]) || json[pos] == '.' ||
+                   json[pos] == '-' || json[pos] == 'e' || json[pos] == 'E' || json[pos] == '+')) {
+                pos++;
+            }
+            try {
+                float val = std::stof(json.substr(numStart, pos - numStart));
+                result.push_back(val);
+            } catch (...) {
+                // Skip invalid numbers
+            }
+        } else {
+            pos++;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Load voice style from JSON file, caching it on the engine.
+ * Format: {"style_ttl": {"data": [[[...]]]}, "style_dp": {"data": [[[...]]]}}
+ *
+ * Returns nullptr if the style could not be loaded.
+ */
+static std::shared_ptr<const VoiceStyle> loadVoiceStyle(SupertonicEngine* engine, int speakerId) {
+    {
+        std::lock_guard<std::mutex> lock(engine->styleMutex);
+        auto it = engine->voiceStyles.find(speakerId);
+        if (it != engine->voiceStyles.end()) {
+            return it->second;  // Already loaded
+        }
+    }
+
+    // Map speaker ID to voice file name
+    // M1-M5 = 0-4, F1-F5 = 5-9
+    const char* voiceNames[] = {"M1", "M2", "M3", "M4", "M5", "F1", "F2", "F3", "F4", "F5"};
+    if (speakerId < 0 || speakerId >= NUM_SPEAKERS) {
+        LOGE("Invalid speaker ID: %d", speakerId);
+        return nullptr;
+    }
+
+    std::string path = engine->modelBasePath + "/voice_styles/" + voiceNames[speakerId] + ".json";
+
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        LOGE("Failed to open voice style file: %s", path.c_str());
+        return nullptr;
+    }
+
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string content = buffer.str();
+    file.close();
+
+    auto style = std::make_shared<VoiceStyle>();
+
+    // Parse style_ttl [1, 50, 256] = 12800 floats
+    style->style_ttl = parseNestedFloatArray(content, "style_ttl");
+    if (style->style_ttl.size() != N_STYLE_TTL * STYLE_TTL_DIM) {
+        LOGE("Invalid style_ttl size: %zu (expected %d)", style->style_ttl.size(), N_STYLE_TTL * STYLE_TTL_DIM);
+        return nullptr;
+    }
+
+    // Parse style_dp [1, 8, 16] = 128 floats
+    style->style_dp = parseNestedFloatArray(content, "style_dp");
+    if (style->style_dp.size() != N_STYLE_DP * STYLE_DP_DIM) {
+        LOGE("Invalid style_dp size: %zu (expected %d)", style->style_dp.size(), N_STYLE_DP * STYLE_DP_DIM);
+        return nullptr;
+    }
+
+    if (engine->config.fp16_io != 0) {
+        style->style_ttl_half.resize(style->style_ttl.size());
+        floatToHalf(style->style_ttl.data(), style->style_ttl_half.data(), style->style_ttl.size());
+        style->style_dp_half.resize(style->style_dp.size());
+        floatToHalf(style->style_dp.data(), style->style_dp_half.data(), style->style_dp.size());
+    }
+
+    LOGD("Loaded voice style for speaker %d (%s)", speakerId, voiceNames[speakerId]);
+
+    std::lock_guard<std::mutex> lock(engine->styleMutex);
+    // Another thread may have raced us; keep whichever landed first
+    auto inserted = engine->voiceStyles.emplace(speakerId, std::move(style));
+    return inserted.first->second;
+}
+
+/**
+ * Tokenize text using unicode indexer. offsets (optional) receives the
+ * byte offset of each token's codepoint.
+ */
+static std::vector<int64_t> tokenizeText(const SupertonicEngine* engine, const std::string& text,
+                                         std::vector<uint32_t>* offsets = nullptr) {
+    std::vector<int64_t> tokens;
+    tokens.reserve(text.length());
+
+    // Decode UTF-8 and look up each codepoint
+    const unsigned char* s = (const unsigned char*)text.c_str();
+    size_t len = text.length();
+    size_t i = 0;
+
+    while (i < len) {
+        int32_t codepoint = 0;
+        const size_t start = i;
+
+        if ((s[i] & 0x80) == 0) {
+            codepoint = s[i];
+            i += 1;
+        } else if ((s[i] & 0xE0) == 0xC0 && i + 1 < len) {
+            codepoint = ((s[i] & 0x1F) << 6) | (s[i+1] & 0x3F);
+            i += 2;
+        } else if ((s[i] & 0xF0) == 0xE0 && i + 2 < len) {
+            codepoint = ((s[i] & 0x0F) << 12) | ((s[i+1] & 0x3F) << 6) | (s[i+2] & 0x3F);
+            i += 3;
+        } else if ((s[i] & 0xF8) == 0xF0 && i + 3 < len) {
+            codepoint = ((s[i] & 0x07) << 18) | ((s[i+1] & 0x3F) << 12) | ((s[i+2] & 0x3F) << 6) | (s[i+3] & 0x3F);
+            i += 4;
+        } else {
+            i += 1;  // Skip invalid byte
+            continue;
+        }
+
+        if (offsets != nullptr) {
+            offsets->push_back((uint32_t)start);
+        }
+        auto it = engine->unicodeIndexer.find(codepoint);
+        if (it != engine->unicodeIndexer.end()) {
+            tokens.push_back(it->second);
+        } else {
+            // Unknown character - use 0 (usually <unk>)
+            tokens.push_back(0);
+        }
+    }
+
+    return tokens;
+}
+
+/**
+ * The shared weights of model for the file at path, read now if the model
+ * holds none or those of another file; nullptr when config.share_weights
+ * is off or the file cannot be read that way.
+ */
+static SharedWeights* sharedWeightsFor(SupertonicEngine* engine, ModelId model, const std::string& path) {
+    if (engine->config.share_weights == 0) {
+        return nullptr;
+    }
+    SharedWeights& weights = engine->sharedWeights[model];
+    if (weights.path != path && !loadSharedWeights(path, engine->memoryInfo, weights)) {
+        LOGW("Sessions of %s keep weights of their own", modelName(model));
+        return nullptr;
+    }
+    return &weights;
+}
+
+/**
+ * True, with engine->globalPoolMissing set and status freed, if a session
+ * was refused only because the environment has no global thread pool for
+ * it: one created earlier by another library (sherpa-onnx) lacks it, and
+ * ORT checks this before reading the model.
+ */
+static bool refusedForGlobalPool(SupertonicEngine* engine, OrtStatus* status) {
+    if (status == nullptr || !engine->globalThreadPool ||
+        strstr(g_ortApi->GetErrorMessage(status), "global threadpool") == nullptr) {
+        return false;
+    }
+    engine->globalPoolMissing = true;
+    g_ortApi->ReleaseStatus(status);
+    return true;
+}
+
+/** CreateSession on a copy of options that takes the shared initializers and prepacked kernels. */
+static OrtSession* createSharedSession(SupertonicEngine* engine, const SharedWeights& weights,
+                                       const std::string& path, const OrtSessionOptions* options) {
+    OrtSessionOptions* shared = nullptr;
+    if (checkStatus(g_ortApi->CloneSessionOptions(options, &shared), "CloneSessionOptions")) {
+        return nullptr;
+    }
+    OrtSession* session = nullptr;
+    if (addSharedWeights(weights, shared)) {
+        OrtStatus* status = g_ortApi->CreateSessionWithPrepackedWeightsContainer(engine->ortEnv, path.c_str(),
+                                                                                 shared, weights.prepacked, &session);
+        if (!refusedForGlobalPool(engine, status)) {
+            checkStatus(status, "CreateSessionWithPrepackedWeightsContainer");
+        }
+    }
+    g_ortApi->ReleaseSessionOptions(shared);
+    return session;
+}
+
+/**
+ * Load an ONNX model and log its input/output info. Sessions share the
+ * model's weights where config.share_weights allows. bytes receives the
+ * heap growth while creating the session: its graph, plus weights and
+ * prepacked kernels unless another session of the model holds them.
+ */
+static OrtSession* loadModel(SupertonicEngine* engine, ModelId model, const std::string& path,
+                             const OrtSessionOptions* options, uint64_t& bytes) {
+    const SharedWeights* weights = sharedWeightsFor(engine, model, path);
+    OrtSession* session = nullptr;
+    const uint64_t heapBefore = nativeHeapBytes();
+    if (weights != nullptr) {
+        session = createSharedSession(engine, *weights, path, options);
+        if (session == nullptr && engine->globalPoolMissing) {
+            return nullptr;
+        }
+        if (session == nullptr) {
+            LOGW("Shared weights rejected for %s, loading a copy of its own", path.c_str());
+        }
+    }
+    OrtStatus* status = nullptr;
+    if (session == nullptr) {
+        status = g_ortApi->CreateSession(engine->ortEnv, path.c_str(), options, &session);
+    }
+    const uint64_t heapAfter = nativeHeapBytes();
+
+    if (refusedForGlobalPool(engine, status)) {
+        return nullptr;
+    }
+    if (checkStatus(status, "CreateSession")) {
+        LOGE("Failed to load model: %s", path.c_str());
+        return nullptr;
+    }
+    bytes = heapAfter > heapBefore ? heapAfter - heapBefore : 0;
+
+    // Log input info
+    size_t numInputs = 0;
+    status = g_ortApi->SessionGetInputCount(session, &numInputs);
+    if (status == nullptr) {
+        LOGI("Model %s has %zu inputs:", path.c_str(), numInputs);
+        for (size_t i = 0; i < numInputs; i++) {
+            char* name = nullptr;
+            status = g_ortApi->SessionGetInputName(session, i, engine->allocator, &name);
+            if (status == nullptr && name != nullptr) {
+                LOGI("  Input %zu: %s", i, name);
+                checkStatus(g_ortApi->AllocatorFree(engine->allocator, name), "AllocatorFree");
+            }
+        }
+    }
+
+    // Log output info
+    size_t numOutputs = 0;
+    status = g_ortApi->SessionGetOutputCount(session, &numOutputs);
+    if (status == nullptr) {
+        LOGI("Model %s has %zu outputs:", path.c_str(), numOutputs);
+        for (size_t i = 0; i < numOutputs; i++) {
+            char* name = nullptr;
+            status = g_ortApi->SessionGetOutputName(session, i, engine->allocator, &name);
+            if (status == nullptr && name != nullptr) {
+                LOGI("  Output %zu: %s", i, name);
+                checkStatus(g_ortApi->AllocatorFree(engine->allocator, name), "AllocatorFree");
+            }
+        }
+    }
+
+    LOGI("Loaded model: %s", path.c_str());
+    return session;
+}
+
+static OrtSession** sessionSlot(SupertonicEngine* engine, ModelId model) {
+    switch (model) {
+        case MODEL_TEXT_ENCODER: return &engine->textEncoder;
+        case MODEL_DURATION_PREDICTOR: return &engine->durationPredictor;
+        case MODEL_VECTOR_ESTIMATOR: return &engine->vectorEstimator;
+        case MODEL_VOCODER: return &engine->vocoder;
+        default: return nullptr;
+    }
+}
+
+static uint64_t fileBytes(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? (uint64_t)st.st_size : 0;
+}
+
+static std::string variantPath(SupertonicEngine* engine, const ModelVariant& variant) {
+    return engine->modelBasePath + "/onnx/" + variant.file;
+}
+
+/** Model file of a session: the variant loaded last (or to be tried first). */
+static std::string modelPath(SupertonicEngine* engine, ModelId model) {
+    return variantPath(engine, engine->modelVariants[model][engine->loadedVariant[model]]);
+}
+
+/**
+ * Fill engine->modelVariants: the onnx/variants.txt entries this CPU can
+ * run, fastest first, then <model>.onnx. With fp16_io an unlisted
+ * <model>_fp16.onnx counts as an fp16 variant.
+ */
+static void selectModelVariants(SupertonicEngine* engine) {
+    const uint32_t features = cpuFeatures();
+    const bool preferHalf = engine->config.fp16_io != 0;
+    LOGI("CPU features: %s", cpuFeatureNames(features).c_str());
+
+    std::vector<ModelVariant> listed[MODEL_COUNT];
+    if (engine->config.model_variants != 0) {
+        loadVariantManifest(engine->modelBasePath + "/onnx/variants.txt", listed);
+    }
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        const std::string name = modelName((ModelId)m);
+        if (preferHalf &&
+            std::none_of(listed[m].begin(), listed[m].end(),
+                         [](const ModelVariant& v) { return v.precision == SUPERTONIC_VARIANT_FP16; }) &&
+            fileBytes(engine->modelBasePath + "/onnx/" + name + "_fp16.onnx") > 0) {
+            ModelVariant half;
+            half.precision = SUPERTONIC_VARIANT_FP16;
+            half.file = name + "_fp16.onnx";
+            listed[m].push_back(std::move(half));
+        }
+        engine->modelVariants[m] = rankVariants(listed[m], features, preferHalf);
+        ModelVariant fallback;
+        fallback.file = name + ".onnx";
+        engine->modelVariants[m].push_back(std::move(fallback));
+        engine->loadedVariant[m] = 0;
+    }
+}
+
+/**
+ * Element type of one session input or output into type; false on ORT
+ * errors. Non-tensor values report UNDEFINED.
+ */
+static bool sessionValueType(const OrtSession* session, bool output, size_t index,
+                             ONNXTensorElementDataType& type) {
+    OrtTypeInfo* typeInfo = nullptr;
+    OrtStatus* status = output ? g_ortApi->SessionGetOutputTypeInfo(session, index, &typeInfo)
+                               : g_ortApi->SessionGetInputTypeInfo(session, index, &typeInfo);
+    if (checkStatus(status, "SessionGetTypeInfo")) {
+        return false;
+    }
+    type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+    const OrtTensorTypeAndShapeInfo* tensorInfo = nullptr;
+    status = g_ortApi->CastTypeInfoToTensorInfo(typeInfo, &tensorInfo);
+    if (status == nullptr && tensorInfo != nullptr) {
+        status = g_ortApi->GetTensorElementType(tensorInfo, &type);
+    }
+    g_ortApi->ReleaseTypeInfo(typeInfo);
+    return !checkStatus(status, "GetTensorElementType");
+}
+
+/**
+ * Whether the float inputs and outputs of a session are fp16 (into half).
+ * Models mixing fp32 and fp16 I/O are rejected; the pipeline converts
+ * whole models, not single tensors.
+ */
+static bool detectHalfIo(OrtSession* session, const std::string& path, bool& half) {
+    size_t counts[2] = {0, 0};
+    if (checkStatus(g_ortApi->SessionGetInputCount(session, &counts[0]), "SessionGetInputCount") ||
+        checkStatus(g_ortApi->SessionGetOutputCount(session, &counts[1]), "SessionGetOutputCount")) {
+        return false;
+    }
+    bool sawFloat = false;
+    bool sawHalf = false;
+    for (int output = 0; output < 2; output++) {
+        for (size_t i = 0; i < counts[output]; i++) {
+            ONNXTensorElementDataType type;
+            if (!sessionValueType(session, output != 0, i, type)) {
+                return false;
+            }
+            sawFloat |= type == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+            sawHalf |= type == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16;
+        }
+    }
+    if (sawFloat && sawHalf) {
+        LOGE("Model mixes fp32 and fp16 inputs/outputs: %s", path.c_str());
+        return false;
+    }
+    half = sawHalf;
+    return true;
+}
+
+/**
+ * Create one session of a model file. A non-empty profileDir enables ORT
+ * profiling with one file prefix per model; xnnpack appends the XNNPACK
+ * execution provider. bytes receives the heap growth while loading.
+ */
+static SupertonicStatus openSession(SupertonicEngine* engine, ModelId model, const std::string& path,
+                                    const std::string& profileDir, bool xnnpack,
+                                    OrtSession*& session, uint64_t& bytes) {
+    OrtSessionOptions* options = nullptr;
+    if (!profileDir.empty() || xnnpack) {
+        if (checkStatus(g_ortApi->CloneSessionOptions(engine->sessionOptions, &options),
+                        "CloneSessionOptions")) {
+            return SUPERTONIC_ERROR_RUNTIME_UNAVAILABLE;
+        }
+    }
+    if (!profileDir.empty()) {
+        const std::string prefix = profileDir + "/ort_" + modelName(model);
+        if (checkStatus(g_ortApi->EnableProfiling(options, prefix.c_str()), "EnableProfiling")) {
+            g_ortApi->ReleaseSessionOptions(options);
+            return SUPERTONIC_ERROR_RUNTIME_UNAVAILABLE;
+        }
+    }
+    if (xnnpack) {
+        // XNNPACK runs its own pool; ORT's intra-op pool would only spin
+        // against it, as the XNNPACK EP documentation recommends. A single
+        // ORT thread takes no affinity list.
+        const std::string threads = std::to_string(engine->intraOpThreads);
+        const char* keys[] = {"intra_op_num_threads"};
+        const char* values[] = {threads.c_str()};
+        if (checkStatus(g_ortApi->SessionOptionsAppendExecutionProvider(options, "XNNPACK", keys, values, 1),
+                        "SessionOptionsAppendExecutionProvider") ||
+            checkStatus(g_ortApi->SetIntraOpNumThreads(options, 1), "SetIntraOpNumThreads") ||
+            checkStatus(g_ortApi->AddSessionConfigEntry(options, kOrtSessionOptionsConfigAllowIntraOpSpinning, "0"),
+                        "AddSessionConfigEntry") ||
+            checkStatus(g_ortApi->AddSessionConfigEntry(options, kOrtSessionOptionsConfigIntraOpThreadAffinities, ""),
+                        "AddSessionConfigEntry")) {
+            g_ortApi->ReleaseSessionOptions(options);
+            return SUPERTONIC_ERROR_RUNTIME_UNAVAILABLE;
+        }
+    }
+
+    session = loadModel(engine, model, path, options != nullptr ? options : engine->sessionOptions, bytes);
+    if (options != nullptr) {
+        g_ortApi->ReleaseSessionOptions(options);
+    }
+    return session != nullptr ? SUPERTONIC_OK : SUPERTONIC_ERROR_MODEL_LOAD;
+}
+
+/**
+ * Load one model file into the model's session slot, plus an XNNPACK
+ * candidate next to it while config.xnnpack has not settled on a provider
+ * (or straight into the slot once XNNPACK has won).
+ */
+static SupertonicStatus createSession(SupertonicEngine* engine, ModelId model, const std::string& path,
+                                      const std::string& profileDir) {
+    std::atomic<int>& xnnpack = engine->xnnpackState[model];
+    OrtSession* session = nullptr;
+    uint64_t bytes = 0;
+    SupertonicStatus status = SUPERTONIC_ERROR_MODEL_LOAD;
+    if (xnnpack.load() == XNNPACK_ACTIVE) {
+        status = openSession(engine, model, path, profileDir, true, session, bytes);
+        if (status != SUPERTONIC_OK) {
+            LOGW("XNNPACK session of %s failed to reload, using the CPU provider", modelName(model));
+            xnnpack.store(XNNPACK_REJECTED);
+        }
+    }
+    if (session == nullptr) {
+        status = openSession(engine, model, path, profileDir, false, session, bytes);
+        if (status != SUPERTONIC_OK) {
+            return status;
+        }
+    }
+    bool half = false;
+    if (!detectHalfIo(session, path, half)) {
+        g_ortApi->ReleaseSession(session);
+        return SUPERTONIC_ERROR_MODEL_LOAD;
+    }
+
+    const int state = xnnpack.load();
+    if (engine->config.xnnpack != 0 && (state == XNNPACK_UNTESTED || state == XNNPACK_PENDING)) {
+        OrtSession* candidate = nullptr;
+        uint64_t candidateBytes = 0;
+        if (openSession(engine, model, path, profileDir, true, candidate, candidateBytes) == SUPERTONIC_OK) {
+            engine->xnnpackSession[model] = candidate;
+            bytes += candidateBytes;
+            xnnpack.store(XNNPACK_PENDING);
+        } else {
+            LOGW("XNNPACK unavailable for %s, using the CPU provider", modelName(model));
+            xnnpack.store(XNNPACK_REJECTED);
+        }
+    }
+
+    engine->halfIo[model] = half;
+    *sessionSlot(engine, model) = session;
+    engine->sessionBytes[model] = bytes;
+    return SUPERTONIC_OK;
+}
+
+/**
+ * Foreground sessions per model config.session_pool_size asks for; see
+ * SupertonicEngineConfig. More than one only pays off when each brings an
+ * intra-op pool of its own.
+ */
+static int sessionPoolTarget(const SupertonicEngine* engine) {
+    if (engine->config.xnnpack != 0) {
+        return 1;
+    }
+    if (engine->config.session_pool_size > 0) {
+        return engine->config.session_pool_size;
+    }
+    return engine->globalThreadPool ? 1 : std::min(parallelRuns(engine), SUPERTONIC_MAX_SESSION_POOL);
+}
+
+/**
+ * Load pooled sessions of a model, from the file in its slot, until it has
+ * target instances. An automatic size stops early once the last instance
+ * took more than a quarter of the available memory.
+ */
+static void createSessionPool(SupertonicEngine* engine, ModelId model, int target) {
+    const std::string path = modelPath(engine, model);
+    int& instances = engine->sessionInstances[model];
+    instances = 1;
+    uint64_t lastBytes = engine->sessionBytes[model];
+    while (instances < target) {
+        const uint64_t available = availableMemoryBytes();
+        if (engine->config.session_pool_size == 0 && available > 0 && lastBytes > available / 4) {
+            LOGI("Session pool of %s stops at %d, %.1f MB each, %.1f MB available", modelName(model), instances,
+                 lastBytes / (1024.0 * 1024.0), available / (1024.0 * 1024.0));
+            break;
+        }
+        uint64_t bytes = 0;
+        OrtSession* session = loadModel(engine, model, path, engine->sessionOptions, bytes);
+        if (session == nullptr) {
+            LOGW("Session pool of %s stops at %d, the next one failed to load", modelName(model), instances);
+            break;
+        }
+        engine->pooledSession[model][instances - 1] = session;
+        engine->pooledBytes[model] += bytes;
+        lastBytes = bytes;
+        instances++;
+    }
+    if (instances > 1) {
+        LOGI("%d sessions of %s, %.1f MB beyond the first", instances, modelName(model),
+             engine->pooledBytes[model] / (1024.0 * 1024.0));
+    }
+}
+
+/**
+ * Create the missing sessions from engine->sessionOptions, each from the
+ * first of its variants that loads, and their pooled instances. With
+ * config.perf_counters the intra-op threads they start are counted.
+ */
+static SupertonicStatus loadSessions(SupertonicEngine* engine, const std::string& profileDir);
+
+static SupertonicStatus createSessions(SupertonicEngine* engine, const std::string& profileDir) {
+    if (!engine->perf.enabled) {
+        return loadSessions(engine, profileDir);
+    }
+    const std::vector<int> before = processThreads();
+    const SupertonicStatus status = loadSessions(engine, profileDir);
+    updateWorkerThreads(engine->perf, before, processThreads());
+    return status;
+}
+
+static SupertonicStatus loadSessions(SupertonicEngine* engine, const std::string& profileDir) {
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        const ModelId model = (ModelId)m;
+        if (*sessionSlot(engine, model) != nullptr) {
+            continue;
+        }
+        SupertonicStatus status = SUPERTONIC_ERROR_MODEL_LOAD;
+        // A variant that failed once is not retried on reloads after trim
+        for (size_t v = engine->loadedVariant[m]; v < engine->modelVariants[m].size(); v++) {
+            const ModelVariant& variant = engine->modelVariants[m][v];
+            if (v + 1 < engine->modelVariants[m].size() && fileBytes(variantPath(engine, variant)) == 0) {
+                LOGW("Model variant %s not found, skipping", variant.file.c_str());
+                continue;
+            }
+            status = createSession(engine, model, variantPath(engine, variant), profileDir);
+            if (status == SUPERTONIC_OK) {
+                engine->loadedVariant[m] = v;
+                LOGI("Using %s (%s) for %s", variant.file.c_str(), variantName(variant.precision), modelName(model));
+                // Profiles cover one session per model
+                createSessionPool(engine, model, profileDir.empty() ? sessionPoolTarget(engine) : 1);
+                break;
+            }
+            if (status == SUPERTONIC_ERROR_RUNTIME_UNAVAILABLE) {
+                return status;
+            }
+            if (engine->globalPoolMissing) {
+                // Every variant would be refused the same way
+                return SUPERTONIC_ERROR_RUNTIME_UNAVAILABLE;
+            }
+            LOGW("Model variant %s failed to load, trying the next one", variant.file.c_str());
+        }
+        if (status != SUPERTONIC_OK) {
+            return status;
+        }
+    }
+    return SUPERTONIC_OK;
+}
+
+static constexpr uint32_t kAllModels = (1u << MODEL_COUNT) - 1;
+
+/**
+ * Create the ORT environment; with config.global_thread_pool it owns the
+ * one intra-op pool every session runs on, sized and pinned here.
+ */
+static bool createOrtEnv(SupertonicEngine* engine) {
+    if (!engine->globalThreadPool) {
+        return !checkStatus(g_ortApi->CreateEnv(ORT_LOGGING_LEVEL_WARNING, "supertonic", &engine->ortEnv),
+                            "CreateEnv");
+    }
+    OrtThreadingOptions* threading = nullptr;
+    if (checkStatus(g_ortApi->CreateThreadingOptions(&threading), "CreateThreadingOptions")) {
+        return false;
+    }
+    const std::string affinity = poolAffinity(engine->intraOpThreads, engine->config.pin_threads != 0);
+    // Inter-op parallelism stays off: the graphs are sequential and a second
+    // pool would only add threads beyond the budget
+    bool failed = checkStatus(g_ortApi->SetGlobalIntraOpNumThreads(threading, engine->intraOpThreads),
+                              "SetGlobalIntraOpNumThreads") ||
+        checkStatus(g_ortApi->SetGlobalInterOpNumThreads(threading, 1), "SetGlobalInterOpNumThreads") ||
+        checkStatus(g_ortApi->SetGlobalSpinControl(threading, engine->config.spin_wait != 0 ? 1 : 0),
+                    "SetGlobalSpinControl");
+    if (!failed && !affinity.empty()) {
+        failed = checkStatus(g_ortApi->SetGlobalIntraOpThreadAffinity(threading, affinity.c_str()),
+                             "SetGlobalIntraOpThreadAffinity");
+    }
+    if (!failed) {
+        failed = checkStatus(g_ortApi->CreateEnvWithGlobalThreadPools(ORT_LOGGING_LEVEL_WARNING, "supertonic",
+                                                                       threading, &engine->ortEnv),
+                             "CreateEnvWithGlobalThreadPools");
+    }
+    g_ortApi->ReleaseThreadingOptions(threading);
+    return !failed;
+}
+
+/**
+ * Register the CPU arena every session allocates from (config.shared_arena).
+ * It grows by exactly what is requested, so its high-water mark tracks the
+ * largest stage rather than the next power of two above it.
+ */
+static void registerSharedArena(SupertonicEngine* engine) {
+    const size_t limit = (size_t)engine->config.arena_limit_mb << 20;
+    const char* keys[] = {"max_mem", "arena_extend_strategy"};
+    const size_t values[] = {limit, 1 /* kSameAsRequested */};
+    OrtArenaCfg* arena = nullptr;
+    if (checkStatus(g_ortApi->CreateArenaCfgV2(keys, values, 2, &arena), "CreateArenaCfgV2")) {
+        return;
+    }
+    // Fails when the process-wide environment already has one, e.g. from a
+    // second engine; the sessions then share that arena instead
+    engine->sharedArena = !checkStatus(g_ortApi->CreateAndRegisterAllocator(engine->ortEnv, engine->memoryInfo, arena),
+                                       "CreateAndRegisterAllocator");
+    g_ortApi->ReleaseArenaCfg(arena);
+    if (engine->sharedArena) {
+        LOGI("Shared CPU arena registered, limit %d MB", engine->config.arena_limit_mb);
+    } else {
+        LOGW("Shared CPU arena not registered, sessions use an existing one or their own");
+    }
+}
+
+/**
+ * (Re)build engine->sessionOptions for the global pool or for a pool per
+ * session, with the same size, spinning and affinity either way.
+ */
+static bool createSessionOptions(SupertonicEngine* engine) {
+    if (engine->sessionOptions != nullptr) {
+        g_ortApi->ReleaseSessionOptions(engine->sessionOptions);
+        engine->sessionOptions = nullptr;
+    }
+    if (checkStatus(g_ortApi->CreateSessionOptions(&engine->sessionOptions), "CreateSessionOptions") ||
+        checkStatus(g_ortApi->SetSessionGraphOptimizationLevel(engine->sessionOptions, ORT_ENABLE_ALL),
+                    "SetSessionGraphOptimizationLevel")) {
+        return false;
+    }
+    if (engine->config.shared_arena != 0 &&
+        checkStatus(g_ortApi->AddSessionConfigEntry(engine->sessionOptions, kOrtSessionOptionsConfigUseEnvAllocators,
+                                                    "1"),
+                    "AddSessionConfigEntry")) {
+        return false;
+    }
+    if (engine->globalThreadPool) {
+        return !checkStatus(g_ortApi->DisablePerSessionThreads(engine->sessionOptions), "DisablePerSessionThreads");
+    }
+
+    const std::string affinity = poolAffinity(engine->intraOpThreads, engine->config.pin_threads != 0);
+    if (checkStatus(g_ortApi->SetIntraOpNumThreads(engine->sessionOptions, engine->intraOpThreads),
+                    "SetIntraOpNumThreads") ||
+        checkStatus(g_ortApi->AddSessionConfigEntry(engine->sessionOptions, kOrtSessionOptionsConfigAllowIntraOpSpinning,
+                                                    engine->config.spin_wait != 0 ? "1" : "0"),
+                    "AddSessionConfigEntry")) {
+        return false;
+    }
+    if (!affinity.empty()) {
+        return !checkStatus(g_ortApi->AddSessionConfigEntry(engine->sessionOptions,
+                                                            kOrtSessionOptionsConfigIntraOpThreadAffinities,
+                                                            affinity.c_str()),
+                            "AddSessionConfigEntry");
+    }
+    return true;
+}
+
+/**
+ * Options of the BACKGROUND class sessions: a pool of their own in which
+ * the calling thread is the only intra-op thread, so nothing spins and the
+ * caller's affinity and priority cover all of the work.
+ */
+static bool createBackgroundOptions(SupertonicEngine* engine) {
+    if (engine->backgroundOptions != nullptr) {
+        return true;
+    }
+    OrtSessionOptions* options = nullptr;
+    if (checkStatus(g_ortApi->CreateSessionOptions(&options), "CreateSessionOptions")) {
+        return false;
+    }
+    const bool failed =
+        checkStatus(g_ortApi->SetSessionGraphOptimizationLevel(options, ORT_ENABLE_ALL),
+                    "SetSessionGraphOptimizationLevel") ||
+        checkStatus(g_ortApi->SetIntraOpNumThreads(options, 1), "SetIntraOpNumThreads") ||
+        checkStatus(g_ortApi->AddSessionConfigEntry(options, kOrtSessionOptionsConfigAllowIntraOpSpinning, "0"),
+                    "AddSessionConfigEntry") ||
+        (engine->config.shared_arena != 0 &&
+         checkStatus(g_ortApi->AddSessionConfigEntry(options, kOrtSessionOptionsConfigUseEnvAllocators, "1"),
+                     "AddSessionConfigEntry"));
+    if (failed) {
+        g_ortApi->ReleaseSessionOptions(options);
+        return false;
+    }
+    engine->backgroundOptions = options;
+    return true;
+}
+
+/**
+ * Create the missing background sessions from the files the foreground
+ * sessions use, so both take and return the same tensor types. Callers
+ * hold sessionMutex exclusively with the foreground sessions loaded.
+ */
+static SupertonicStatus createBackgroundSessions(SupertonicEngine* engine) {
+    if (!createBackgroundOptions(engine)) {
+        return SUPERTONIC_ERROR_RUNTIME_UNAVAILABLE;
+    }
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        if (engine->backgroundSession[m] != nullptr) {
+            continue;
+        }
+        const std::string path = variantPath(engine, engine->modelVariants[m][engine->loadedVariant[m]]);
+        OrtSession* session = loadModel(engine, (ModelId)m, path, engine->backgroundOptions,
+                                        engine->backgroundBytes[m]);
+        if (session == nullptr) {
+            return SUPERTONIC_ERROR_MODEL_LOAD;
+        }
+        engine->backgroundSession[m] = session;
+    }
+    return SUPERTONIC_OK;
+}
+
+/**
+ * Release the sessions, background and pooled ones included, whose bit is
+ * set in modelMask, and the weights they shared.
+ */
+static void releaseSessions(SupertonicEngine* engine, uint32_t modelMask = kAllModels) {
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        if ((modelMask & (1u << m)) != 0 && engine->backgroundSession[m] != nullptr) {
+            g_ortApi->ReleaseSession(engine->backgroundSession[m]);
+            engine->backgroundSession[m] = nullptr;
+            engine->backgroundBytes[m] = 0;
+        }
+        OrtSession** slot = sessionSlot(engine, (ModelId)m);
+        if ((modelMask & (1u << m)) != 0 && *slot != nullptr) {
+            g_ortApi->ReleaseSession(*slot);
+            *slot = nullptr;
+            engine->sessionBytes[m] = 0;
+            if (engine->xnnpackSession[m] != nullptr) {
+                g_ortApi->ReleaseSession(engine->xnnpackSession[m]);
+                engine->xnnpackSession[m] = nullptr;
+            }
+            // An accepted candidate is gone with it; reload straight into XNNPACK
+            int accepted = XNNPACK_ACCEPTED;
+            engine->xnnpackState[m].compare_exchange_strong(accepted, XNNPACK_ACTIVE);
+        }
+        if ((modelMask & (1u << m)) != 0) {
+            for (int i = 0; i + 1 < engine->sessionInstances[m]; i++) {
+                g_ortApi->ReleaseSession(engine->pooledSession[m][i]);
+                engine->pooledSession[m][i] = nullptr;
+            }
+            engine->sessionInstances[m] = 0;
+            engine->pooledBytes[m] = 0;
+            // Every session of the model is gone, so nothing references them
+            releaseSharedWeights(engine->sharedWeights[m]);
+        }
+    }
+}
+
+static uint32_t loadedSessionMask(SupertonicEngine* engine) {
+    uint32_t mask = 0;
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        if (*sessionSlot(engine, (ModelId)m) != nullptr) {
+            mask |= 1u << m;
+        }
+    }
+    return mask;
+}
+
+static uint32_t backgroundSessionMask(SupertonicEngine* engine) {
+    uint32_t mask = 0;
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        if (engine->backgroundSession[m] != nullptr) {
+            mask |= 1u << m;
+        }
+    }
+    return mask;
+}
+
+/**
+ * Run options for one model run, or nullptr when none are needed.
+ *
+ * While profiling runs are tagged "req<id>/<model>[/step<n>]" so ORT logs
+ * can be matched to requests. After supertonic_trim() the model's next
+ * final run of a request also shrinks the CPU arena back to its initial
+ * chunk once the run completes.
+ */
+class RunOptions {
+public:
+    RunOptions(SupertonicEngine* engine, uint64_t requestId, ModelId model, int step = -1,
+               bool finalRunOfRequest = true) {
+        const bool tag = engine->profiling.enabled.load(std::memory_order_relaxed);
+        const bool shrink = finalRunOfRequest &&
+            engine->shrinkArenaPending[model].load(std::memory_order_relaxed) &&
+            engine->shrinkArenaPending[model].exchange(false);
+        if (!tag && !shrink) {
+            return;
+        }
+        if (checkStatus(g_ortApi->CreateRunOptions(&options_), "CreateRunOptions")) {
+            options_ = nullptr;
+            return;
+        }
+        if (tag) {
+            const std::string runTag = formatRunTag(requestId, model, step);
+            checkStatus(g_ortApi->RunOptionsSetRunTag(options_, runTag.c_str()), "RunOptionsSetRunTag");
+        }
+        if (shrink) {
+            checkStatus(g_ortApi->AddRunConfigEntry(options_, kOrtRunOptionsConfigEnableMemoryArenaShrinkage,
+                                                    "cpu:0"),
+                        "AddRunConfigEntry");
+        }
+    }
+
+    ~RunOptions() {
+        if (options_ != nullptr) {
+            g_ortApi->ReleaseRunOptions(options_);
+        }
+    }
+
+    RunOptions(const RunOptions&) = delete;
+    RunOptions& operator=(const RunOptions&) = delete;
+
+    const OrtRunOptions* get() const { return options_; }
+
+private:
+    OrtRunOptions* options_ = nullptr;
+};
+
+SupertonicStatus createEngine(const std::string& basePath,
+                              const SupertonicEngineConfig& config,
+                              SupertonicEngine** outEngine) {
+    *outEngine = nullptr;
+
+    // Initialize ONNX Runtime API
+    if (!initOrtApi()) {
+        return SUPERTONIC_ERROR_RUNTIME_UNAVAILABLE;
+    }
+
+    // Verify model files exist
+    std::vector<std::string> requiredFiles = {
+        basePath + "/onnx/text_encoder.onnx",
+        basePath + "/onnx/duration_predictor.onnx",
+        basePath + "/onnx/vector_estimator.onnx",
+        basePath + "/onnx/vocoder.onnx",
+        basePath + "/onnx/unicode_indexer.json",
+    };
+
+    for (const auto& file : requiredFiles) {
+        FILE* f = fopen(file.c_str(), "r");
+        if (f == nullptr) {
+            LOGE("Required file not found: %s", file.c_str());
+            return SUPERTONIC_ERROR_MODEL_LOAD;
+        }
+        fclose(f);
+        LOGD("Found: %s", file.c_str());
+    }
+
+    // Owned by this function until fully initialized
+    std::unique_ptr<SupertonicEngine, void (*)(SupertonicEngine*)> engine(new SupertonicEngine(), destroyEngine);
+    engine->modelBasePath = basePath;
+    engine->config = config;
+    selectModelVariants(engine.get());
+
+    // Load unicode indexer
+    if (!loadUnicodeIndexer(engine.get(), basePath + "/onnx/unicode_indexer.json")) {
+        LOGE("Failed to load unicode indexer");
+        return SUPERTONIC_ERROR_MODEL_LOAD;
+    }
+
+    // Use 2 threads per inference unless the caller asked otherwise, never
+    // more than the big cores (or the caller's budget) in total
+    engine->threadBudget = config.thread_budget > 0 ? config.thread_budget : (int)bigCores().size();
+    engine->intraOpThreads = std::min(
+        config.intra_op_threads > 0 ? config.intra_op_threads : DEFAULT_INTRA_OP_THREADS, engine->threadBudget);
+    engine->globalThreadPool = config.global_thread_pool != 0;
+    for (const std::vector<int>& cores : poolCores(engine->intraOpThreads, config.pin_threads != 0)) {
+        engine->poolCpus |= cpuMask(cores);
+    }
+    LOGI("CPU topology: %s", describeTopology().c_str());
+    LOGI("Thread budget %d, %d intra-op threads, %s pool, pool cpus 0x%llx", engine->threadBudget,
+         engine->intraOpThreads, engine->globalThreadPool ? "global" : "per-session",
+         (unsigned long long)engine->poolCpus);
+
+    // Create ONNX Runtime environment; a global pool starts its threads here
+    engine->perf.enabled = config.perf_counters != 0;
+    const std::vector<int> threadsBefore = engine->perf.enabled ? processThreads() : std::vector<int>();
+    if (!createOrtEnv(engine.get())) {
+        return SUPERTONIC_ERROR_RUNTIME_UNAVAILABLE;
+    }
+    if (engine->perf.enabled) {
+        updateWorkerThreads(engine->perf, threadsBefore, processThreads());
+    }
+
+    // Get default allocator
+    OrtStatus* status = g_ortApi->GetAllocatorWithDefaultOptions(&engine->allocator);
+    if (checkStatus(status, "GetAllocatorWithDefaultOptions")) {
+        return SUPERTONIC_ERROR_RUNTIME_UNAVAILABLE;
+    }
+
+    // Create CPU memory info
+    status = g_ortApi->CreateCpuMemoryInfo(OrtArenaAllocator, OrtMemTypeDefault, &engine->memoryInfo);
+    if (checkStatus(status, "CreateCpuMemoryInfo")) {
+        return SUPERTONIC_ERROR_RUNTIME_UNAVAILABLE;
+    }
+
+    // One arena for all sessions, then the options that point them at it
+    if (config.shared_arena != 0) {
+        registerSharedArena(engine.get());
+    }
+    if (!createSessionOptions(engine.get())) {
+        return SUPERTONIC_ERROR_RUNTIME_UNAVAILABLE;
+    }
+
+    // Load all 4 models
+    LOGI("Loading Supertonic models...");
+    SupertonicStatus sessionStatus = createSessions(engine.get(), "");
+    if (engine->globalPoolMissing) {
+        // The environment is a process singleton: one created earlier by
+        // another library (sherpa-onnx) has no global pool to share, and
+        // ORT refuses sessions without threads of their own. Only that
+        // refusal gets here; models that fail to load fail the engine
+        LOGW("Global thread pool unavailable, falling back to per-session threads");
+        releaseSessions(engine.get());
+        std::fill(std::begin(engine->loadedVariant), std::end(engine->loadedVariant), 0);
+        engine->globalThreadPool = false;
+        engine->globalPoolMissing = false;
+        if (!createSessionOptions(engine.get())) {
+            return SUPERTONIC_ERROR_RUNTIME_UNAVAILABLE;
+        }
+        sessionStatus = createSessions(engine.get(), "");
+    }
+    if (sessionStatus != SUPERTONIC_OK) {
+        return sessionStatus;
+    }
+
+    if (engine->perf.enabled) {
+        const uint32_t counted = PerfGroup(0).mask();
+        if (counted == 0) {
+            LOGW("perf_event_open refused, counters stay 0 (see /proc/sys/kernel/perf_event_paranoid)");
+        } else {
+            LOGI("Perf counters 0x%x on the calling threads and %zu pool threads", counted,
+                 engine->perf.workers.size());
+        }
+    }
+
+    LOGI("Supertonic initialized successfully at %s", basePath.c_str());
+    *outEngine = engine.release();
+    return SUPERTONIC_OK;
+}
+
+void destroyEngine(SupertonicEngine* engine) {
+    if (engine == nullptr) {
+        return;
+    }
+
+    // Scheduler threads call into the sessions released below
+    stopScheduler(engine);
+
+    // Cached text_emb values must go before the environment
+    engine->textCache.clear();
+    releaseSessions(engine);
+
+    if (engine->sessionOptions != nullptr) {
+        g_ortApi->ReleaseSessionOptions(engine->sessionOptions);
+    }
+    if (engine->backgroundOptions != nullptr) {
+        g_ortApi->ReleaseSessionOptions(engine->backgroundOptions);
+    }
+
+    // The environment may outlive this engine (sherpa-onnx holds it too)
+    if (engine->sharedArena) {
+        checkStatus(g_ortApi->UnregisterAllocator(engine->ortEnv, engine->memoryInfo), "UnregisterAllocator");
+    }
+
+    if (engine->memoryInfo != nullptr) {
+        g_ortApi->ReleaseMemoryInfo(engine->memoryInfo);
+    }
+
+    if (engine->ortEnv != nullptr) {
+        g_ortApi->ReleaseEnv(engine->ortEnv);
+    }
+
+    delete engine;
+}
+
+/**
+ * Create an OrtValue tensor from data using the default allocator
+ * This lets ONNX Runtime manage the memory automatically
+ */
+static OrtValue* allocateTensor(SupertonicEngine* engine, const int64_t* shape, size_t shapeLen,
+                                ONNXTensorElementDataType type, void** tensorData) {
+    OrtValue* tensor = nullptr;
+
+    // Create tensor using allocator (ORT manages memory)
+    OrtStatus* status = g_ortApi->CreateTensorAsOrtValue(
+        engine->allocator, shape, shapeLen, type, &tensor);
+
+    if (checkStatus(status, "CreateTensorAsOrtValue")) {
+        return nullptr;
+    }
+
+    status = g_ortApi->GetTensorMutableData(tensor, tensorData);
+    if (checkStatus(status, "GetTensorMutableData")) {
+        g_ortApi->ReleaseValue(tensor);
+        return nullptr;
+    }
+    return tensor;
+}
+
+static OrtValue* createTensor(SupertonicEngine* engine, SupertonicSynthesisStats* stats,
+                              const void* data, size_t dataSize,
+                              const int64_t* shape, size_t shapeLen,
+                              ONNXTensorElementDataType type) {
+    void* tensorData = nullptr;
+    OrtValue* tensor = allocateTensor(engine, shape, shapeLen, type, &tensorData);
+    if (tensor == nullptr) {
+        return nullptr;
+    }
+
+    // Copy data into the tensor
+    memcpy(tensorData, data, dataSize);
+    stats->tensor_bytes_allocated += dataSize;
+
+    return tensor;
+}
+
+/** Element type of the float inputs and outputs of a model. */
+static ONNXTensorElementDataType floatType(const SupertonicEngine* engine, ModelId model) {
+    return engine->halfIo[model] ? ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16 : ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+}
+
+/**
+ * Float input of a model from fp32 data, converted on the way in if the
+ * model takes half precision.
+ */
+static OrtValue* createFloatTensor(SupertonicEngine* engine, SupertonicSynthesisStats* stats, ModelId model,
+                                   const float* data, size_t count,
+                                   const int64_t* shape, size_t shapeLen) {
+    if (!engine->halfIo[model]) {
+        return createTensor(engine, stats, data, count * sizeof(float), shape, shapeLen,
+                            ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT);
+    }
+    void* tensorData = nullptr;
+    OrtValue* tensor = allocateTensor(engine, shape, shapeLen, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16, &tensorData);
+    if (tensor == nullptr) {
+        return nullptr;
+    }
+    floatToHalf(data, static_cast<uint16_t*>(tensorData), count);
+    stats->tensor_bytes_allocated += count * sizeof(uint16_t);
+    return tensor;
+}
+
+/** Style input of a model, from the style's fp16 copy if it has one and the model takes fp16. */
+static OrtValue* createStyleTensor(SupertonicEngine* engine, SupertonicSynthesisStats* stats, ModelId model,
+                                   const std::vector<float>& style, const std::vector<uint16_t>& styleHalf,
+                                   const int64_t* shape, size_t shapeLen) {
+    if (engine->halfIo[model] && styleHalf.size() == style.size()) {
+        return createTensor(engine, stats, styleHalf.data(), styleHalf.size() * sizeof(uint16_t), shape, shapeLen,
+                            ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16);
+    }
+    return createFloatTensor(engine, stats, model, style.data(), style.size(), shape, shapeLen);
+}
+
+/** Element type and count of a tensor; false on ORT errors. */
+static bool tensorInfo(const OrtValue* value, ONNXTensorElementDataType& type, size_t& count) {
+    OrtTensorTypeAndShapeInfo* info = nullptr;
+    if (checkStatus(g_ortApi->GetTensorTypeAndShape(value, &info), "GetTensorTypeAndShape")) {
+        return false;
+    }
+    OrtStatus* status = g_ortApi->GetTensorElementType(info, &type);
+    if (status == nullptr) {
+        status = g_ortApi->GetTensorShapeElementCount(info, &count);
+    }
+    g_ortApi->ReleaseTensorTypeAndShapeInfo(info);
+    return !checkStatus(status, "GetTensorElementType");
+}
+
+/** Copy a float or fp16 model output into out as fp32. */
+static bool readFloatTensor(OrtValue* value, std::vector<float>& out) {
+    ONNXTensorElementDataType type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+    size_t count = 0;
+    void* data = nullptr;
+    if (!tensorInfo(value, type, count) ||
+        checkStatus(g_ortApi->GetTensorMutableData(value, &data), "GetTensorMutableData")) {
+        return false;
+    }
+    if (type == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16) {
+        out.resize(count);
+        halfToFloat(static_cast<const uint16_t*>(data), out.data(), count);
+    } else if (type == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+        const float* floats = static_cast<const float*>(data);
+        out.assign(floats, floats + count);
+    } else {
+        LOGE("Expected a float output, got element type %d", (int)type);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Copy of a float tensor in the float type model takes, or nullptr if it
+ * already has that type (or on failure, with ok cleared).
+ */
+static OrtValue* convertForModel(SupertonicEngine* engine, SupertonicSynthesisStats* stats, ModelId model,
+                                 OrtValue* value, bool& ok) {
+    ok = true;
+    ONNXTensorElementDataType type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+    size_t count = 0;
+    if (!tensorInfo(value, type, count)) {
+        ok = false;
+        return nullptr;
+    }
+    if (type == floatType(engine, model)) {
+        return nullptr;
+    }
+    OrtTensorTypeAndShapeInfo* info = nullptr;
+    if (checkStatus(g_ortApi->GetTensorTypeAndShape(value, &info), "GetTensorTypeAndShape")) {
+        ok = false;
+        return nullptr;
+    }
+    size_t rank = 0;
+    std::vector<int64_t> shape;
+    OrtStatus* status = g_ortApi->GetDimensionsCount(info, &rank);
+    if (status == nullptr) {
+        shape.resize(rank);
+        status = g_ortApi->GetDimensions(info, shape.data(), rank);
+    }
+    g_ortApi->ReleaseTensorTypeAndShapeInfo(info);
+    std::vector<float> values;
+    if (checkStatus(status, "GetDimensions") || !readFloatTensor(value, values)) {
+        ok = false;
+        return nullptr;
+    }
+    OrtValue* converted = createFloatTensor(engine, stats, model, values.data(), values.size(),
+                                            shape.data(), shape.size());
+    ok = converted != nullptr;
+    return converted;
+}
+
+static void releaseValues(std::initializer_list<OrtValue*> values) {
+    for (OrtValue* value : values) {
+        if (value != nullptr) {
+            g_ortApi->ReleaseValue(value);
+        }
+    }
+}
+
+static void releaseOutputs(std::vector<OrtValue*>& outputs) {
+    for (OrtValue*& value : outputs) {
+        if (value != nullptr) {
+            g_ortApi->ReleaseValue(value);
+            value = nullptr;
+        }
+    }
+}
+
+/**
+ * Largest difference between two runs' float outputs relative to the
+ * reference's magnitude; infinity if they differ in size or type.
+ */
+static double outputDivergence(const std::vector<OrtValue*>& reference, const std::vector<OrtValue*>& candidate) {
+    double worst = 0.0;
+    for (size_t i = 0; i < reference.size(); i++) {
+        std::vector<float> a;
+        std::vector<float> b;
+        if (!readFloatTensor(reference[i], a) || !readFloatTensor(candidate[i], b) || a.size() != b.size()) {
+            return INFINITY;
+        }
+        double maxDiff = 0.0;
+        double scale = 1.0;
+        for (size_t k = 0; k < a.size(); k++) {
+            maxDiff = std::max(maxDiff, (double)std::fabs(a[k] - b[k]));
+            scale = std::max(scale, (double)std::fabs(a[k]));
+        }
+        if (!std::isfinite(maxDiff)) {
+            return INFINITY;
+        }
+        worst = std::max(worst, maxDiff / scale);
+    }
+    return worst;
+}
+
+// XNNPACK outputs may differ from MLAS by accumulation order, not more
+static constexpr double kXnnpackTolerance = 1e-2;
+
+/**
+ * First run of a PENDING model: run the CPU session and the XNNPACK
+ * candidate twice each on the same inputs (the first pair warms them up
+ * and is compared, the second is timed) and keep the candidate only if it
+ * agrees and is faster. outputs receives the CPU results.
+ */
+static OrtStatus* verifyXnnpack(SupertonicEngine* engine, ModelId model, const OrtRunOptions* runOptions,
+                                const char* const* inputNames, const OrtValue* const* inputs, size_t numInputs,
+                                const char* const* outputNames, size_t numOutputs, OrtValue** outputs) {
+    OrtSession* cpu = *sessionSlot(engine, model);
+    OrtSession* candidate = engine->xnnpackSession[model];
+    std::vector<OrtValue*> reference(numOutputs, nullptr);
+    std::vector<OrtValue*> trial(numOutputs, nullptr);
+
+    OrtStatus* status = g_ortApi->Run(cpu, runOptions, inputNames, inputs, numInputs,
+                                      outputNames, numOutputs, reference.data());
+    if (status != nullptr) {
+        return status;  // the model itself fails; leave the decision for a later run
+    }
+    bool accept = !checkStatus(g_ortApi->Run(candidate, runOptions, inputNames, inputs, numInputs,
+                                             outputNames, numOutputs, trial.data()),
+                               "XNNPACK Run");
+    const double divergence = accept ? outputDivergence(reference, trial) : INFINITY;
+    accept = accept && divergence <= kXnnpackTolerance;
+    releaseOutputs(trial);
+
+    double cpuMs = 0.0;
+    double xnnpackMs = 0.0;
+    if (accept) {
+        releaseOutputs(reference);
+        Clock::time_point start = Clock::now();
+        status = g_ortApi->Run(cpu, runOptions, inputNames, inputs, numInputs,
+                               outputNames, numOutputs, reference.data());
+        cpuMs = elapsedMs(start);
+        if (status != nullptr) {
+            return status;
+        }
+        start = Clock::now();
+        accept = !checkStatus(g_ortApi->Run(candidate, runOptions, inputNames, inputs, numInputs,
+                                            outputNames, numOutputs, trial.data()),
+                              "XNNPACK Run");
+        xnnpackMs = elapsedMs(start);
+        releaseOutputs(trial);
+        accept = accept && xnnpackMs < cpuMs;
+    }
+
+    LOGI("XNNPACK %s for %s: divergence %.2g, %.1f ms vs %.1f ms on CPU", accept ? "kept" : "rejected",
+         modelName(model), divergence, xnnpackMs, cpuMs);
+    engine->xnnpackState[model].store(accept ? XNNPACK_ACCEPTED : XNNPACK_REJECTED);
+    engine->xnnpackSwapPending.store(true);
+    std::copy(reference.begin(), reference.end(), outputs);
+    return nullptr;
+}
+
+/** One foreground instance of a model held for the length of a Run. */
+struct InstanceLease {
+    std::atomic<uint32_t>* busy = nullptr;
+    uint32_t bit = 0;
+
+    ~InstanceLease() {
+        if (busy != nullptr) {
+            busy->fetch_and(~bit, std::memory_order_release);
+        }
+    }
+};
+
+/**
+ * Claim the first idle foreground instance of model into lease; -1 if all
+ * are running, and concurrent Runs then share the slot's session.
+ */
+static int acquireInstance(SupertonicEngine* engine, ModelId model, InstanceLease& lease) {
+    std::atomic<uint32_t>& busy = engine->sessionBusy[model];
+    uint32_t current = busy.load(std::memory_order_relaxed);
+    for (;;) {
+        int idle = -1;
+        for (int i = 0; i < engine->sessionInstances[model]; i++) {
+            if ((current & (1u << i)) == 0) {
+                idle = i;
+                break;
+            }
+        }
+        if (idle < 0) {
+            return -1;
+        }
+        if (busy.compare_exchange_weak(current, current | (1u << idle), std::memory_order_acquire)) {
+            lease.busy = &busy;
+            lease.bit = 1u << idle;
+            return idle;
+        }
+    }
+}
+
+/**
+ * Run a model on the session its XNNPACK state selects, settling a
+ * PENDING comparison on the way, on an idle pooled instance, or on the
+ * model's background session for that class. Callers hold sessionMutex
+ * shared.
+ */
+static OrtStatus* runModel(SupertonicEngine* engine, ModelId model, SupertonicExecutionClass executionClass,
+                           const OrtRunOptions* runOptions,
+                           const char* const* inputNames, const OrtValue* const* inputs, size_t numInputs,
+                           const char* const* outputNames, size_t numOutputs, OrtValue** outputs) {
+    if (executionClass == SUPERTONIC_CLASS_BACKGROUND && engine->backgroundSession[model] != nullptr) {
+        return g_ortApi->Run(engine->backgroundSession[model], runOptions, inputNames, inputs, numInputs,
+                             outputNames, numOutputs, outputs);
+    }
+    // Pools exist only without XNNPACK, so instance 0 is the plain slot below
+    InstanceLease lease;
+    const int instance = engine->sessionInstances[model] > 1 ? acquireInstance(engine, model, lease) : 0;
+    if (instance > 0) {
+        return g_ortApi->Run(engine->pooledSession[model][instance - 1], runOptions, inputNames, inputs,
+                             numInputs, outputNames, numOutputs, outputs);
+    }
+    const int state = engine->xnnpackState[model].load(std::memory_order_acquire);
+    if (state == XNNPACK_ACCEPTED && engine->xnnpackSession[model] != nullptr) {
+        return g_ortApi->Run(engine->xnnpackSession[model], runOptions, inputNames, inputs, numInputs,
+                             outputNames, numOutputs, outputs);
+    }
+    // One caller compares; concurrent ones keep using the CPU session meanwhile
+    if (state == XNNPACK_PENDING && !engine->xnnpackVerifying[model].exchange(true)) {
+        OrtStatus* status = verifyXnnpack(engine, model, runOptions, inputNames, inputs, numInputs,
+                                          outputNames, numOutputs, outputs);
+        engine->xnnpackVerifying[model].store(false);
+        return status;
+    }
+    return g_ortApi->Run(*sessionSlot(engine, model), runOptions, inputNames, inputs, numInputs,
+                         outputNames, numOutputs, outputs);
+}
+
+/**
+ * Move settled XNNPACK decisions into the session slots and release the
+ * losing sessions. Takes sessionMutex exclusively, so call it without it.
+ */
+static void settleXnnpack(SupertonicEngine* engine) {
+    if (!engine->xnnpackSwapPending.exchange(false)) {
+        return;
+    }
+    std::unique_lock<std::shared_mutex> lock(engine->sessionMutex);
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        OrtSession*& candidate = engine->xnnpackSession[m];
+        const int state = engine->xnnpackState[m].load();
+        if (candidate == nullptr || (state != XNNPACK_ACCEPTED && state != XNNPACK_REJECTED)) {
+            continue;
+        }
+        OrtSession** slot = sessionSlot(engine, (ModelId)m);
+        if (state == XNNPACK_ACCEPTED) {
+            std::swap(*slot, candidate);
+            engine->xnnpackState[m].store(XNNPACK_ACTIVE);
+        }
+        g_ortApi->ReleaseSession(candidate);
+        candidate = nullptr;
+    }
+}
+
+/** Mask input of a model: [1, 1, padded] with ones over the first valid entries. */
+static OrtValue* createMaskTensor(SupertonicEngine* engine, SupertonicSynthesisStats* stats, ModelId model,
+                                  int64_t valid, int64_t padded) {
+    std::vector<float> mask(padded, 0.0f);
+    std::fill(mask.begin(), mask.begin() + std::min(valid, padded), 1.0f);
+    int64_t shape[] = {1, 1, padded};
+    return createFloatTensor(engine, stats, model, mask.data(), mask.size(), shape, 3);
+}
+
+/** All-zero style used when a speaker's style file cannot be loaded. */
+static const VoiceStyle& fallbackStyle() {
+    static const VoiceStyle style = [] {
+        VoiceStyle zero;
+        zero.style_ttl.assign(N_STYLE_TTL * STYLE_TTL_DIM, 0.0f);
+        zero.style_dp.assign(N_STYLE_DP * STYLE_DP_DIM, 0.0f);
+        zero.style_ttl_half.assign(zero.style_ttl.size(), 0);
+        zero.style_dp_half.assign(zero.style_dp.size(), 0);
+        return zero;
+    }();
+    return style;
+}
+
+/**
+ * Size in bytes of a float (fp32 or fp16) tensor produced by a model run
+ */
+static uint64_t floatTensorBytes(const OrtValue* value) {
+    ONNXTensorElementDataType type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+    size_t count = 0;
+    if (!tensorInfo(value, type, count)) {
+        return 0;
+    }
+    return (uint64_t)count * (type == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16 ? sizeof(uint16_t) : sizeof(float));
+}
+
+/**
+ * Round length up to the smallest configured bucket that holds it. Beyond
+ * the largest bucket lengths are rounded to a multiple of
+ * SUPERTONIC_BUCKET_OVERFLOW_MULTIPLE; an empty list disables padding.
+ */
+static int64_t bucketLength(const int32_t* buckets, int64_t length) {
+    if (buckets[0] <= 0) {
+        return length;
+    }
+    for (int i = 0; i < SUPERTONIC_MAX_LENGTH_BUCKETS && buckets[i] > 0; i++) {
+        if (length <= buckets[i]) {
+            return buckets[i];
+        }
+    }
+    const int64_t multiple = SUPERTONIC_BUCKET_OVERFLOW_MULTIPLE;
+    return (length + multiple - 1) / multiple * multiple;
+}
+
+/**
+ * Zero frames [length, paddedLength) of every channel of a [144, paddedLength]
+ * latent, fp32 or fp16 (both have all-zero bits for +0).
+ */
+template <typename T>
+static void zeroLatentPadding(std::vector<T>& latent, int64_t length, int64_t paddedLength) {
+    if (paddedLength <= length) {
+        return;
+    }
+    for (int c = 0; c < LATENT_CHANNELS; c++) {
+        T* row = latent.data() + (size_t)c * paddedLength;
+        std::fill(row + length, row + paddedLength, T(0));
+    }
+}
+
+/**
+ * Path of the latent's valid frames through the diffusion steps, for the
+ * early exit (config.early_exit_threshold). Flow matching moves the latent
+ * by velocity * dt every step, so the latent itself never settles; what
+ * converges on easy inputs is the velocity. advance() measures how much
+ * the step displacement changed; once successive steps agree the rest of
+ * the path is a straight line, which extrapolate() covers in one jump.
+ */
+class LatentTrajectory {
+public:
+    LatentTrajectory(int64_t length, int64_t stride)
+        : length_((size_t)length), stride_((size_t)stride),
+          position_((size_t)LATENT_CHANNELS * length_), displacement_(position_.size()) {}
+
+    /**
+     * Record the [144, stride] latent after a step (the noise first) and
+     * return ||d_k - d_{k-1}|| / ||d_k|| of the step displacements d;
+     * infinity until two steps are known.
+     */
+    double advance(const float* latent) {
+        double change = 0.0;
+        double norm = 0.0;
+        for (size_t c = 0; c < (size_t)LATENT_CHANNELS; c++) {
+            const float* row = latent + c * stride_;
+            float* position = position_.data() + c * length_;
+            float* displacement = displacement_.data() + c * length_;
+            // Float sums per row keep the loop vectorizable
+            float rowChange = 0.0f;
+            float rowNorm = 0.0f;
+            for (size_t i = 0; i < length_; i++) {
+                const float d = row[i] - position[i];
+                const float bend = d - displacement[i];
+                rowChange += bend * bend;
+                rowNorm += d * d;
+                displacement[i] = d;
+                position[i] = row[i];
+            }
+            change += rowChange;
+            norm += rowNorm;
+        }
+        if (++points_ < 3) {
+            return std::numeric_limits<double>::infinity();
+        }
+        return norm > 0.0 ? std::sqrt(change / norm) : 0.0;
+    }
+
+    /** Move the latent's valid frames on by remainingSteps more displacements. */
+    void extrapolate(float* latent, int remainingSteps) const {
+        for (size_t c = 0; c < (size_t)LATENT_CHANNELS; c++) {
+            float* row = latent + c * stride_;
+            const float* displacement = displacement_.data() + c * length_;
+            for (size_t i = 0; i < length_; i++) {
+                row[i] += (float)remainingSteps * displacement[i];
+            }
+        }
+    }
+
+private:
+    size_t length_;
+    size_t stride_;
+    std::vector<float> position_;
+    std::vector<float> displacement_;
+    int points_ = 0;  // latents recorded so far
+};
+
+/**
+ * Per-row totals of a duration predictor output for rows padded to seqLen,
+ * one entry of tokenCounts per row. The model emits one total in seconds
+ * per row; a per-token output is summed over the row's valid tokens and,
+ * if perToken is given, its valid values are appended there row by row
+ * (perToken stays empty for total-only output).
+ */
+static bool sumDurations(OrtValue* durations, const std::vector<int64_t>& tokenCounts, int64_t seqLen,
+                         std::vector<float>& sums, std::vector<float>* perToken = nullptr) {
+    const size_t rows = tokenCounts.size();
+    std::vector<float> values;
+    if (!readFloatTensor(durations, values)) {
+        return false;
+    }
+    const size_t count = values.size();
+    if (rows == 0 || count == 0 || count % rows != 0) {
+        LOGE("Unexpected duration output: %zu values for %zu rows", count, rows);
+        return false;
+    }
+    const float* data = values.data();
+    const size_t perRow = count / rows;
+    const bool tokenLevel = perRow == (size_t)seqLen;
+    sums.assign(rows, 0.0f);
+    if (perToken != nullptr) {
+        perToken->clear();
+    }
+    for (size_t r = 0; r < rows; r++) {
+        const float* row = data + r * perRow;
+        const size_t used = tokenLevel ? (size_t)tokenCounts[r] : perRow;
+        for (size_t i = 0; i < used; i++) {
+            sums[r] += row[i];
+        }
+        if (tokenLevel && perToken != nullptr) {
+            perToken->insert(perToken->end(), row, row + used);
+        }
+    }
+    return true;
+}
+
+/** Latent frames for a predicted duration (seconds) at a speech rate. */
+static int64_t latentLength(float durationSum, float speed) {
+    // Scale duration by speed; speed 1.0 is the reference pace
+    float scaledDurSum = durationSum / (BASE_SPEED * speed);
+
+    // Duration is in seconds (from the Supertonic model)
+    // Latent length = ceil(scaledDurSum * SAMPLE_RATE / CHUNK_SIZE)
+    // where CHUNK_SIZE = BASE_CHUNK_SIZE * CHUNK_COMPRESS_FACTOR = 512 * 6 = 3072
+    float wavLen = scaledDurSum * SAMPLE_RATE;  // audio samples
+    int64_t latentLen = (int64_t)((wavLen + CHUNK_SIZE - 1) / CHUNK_SIZE);  // ceil division
+
+    // Ensure minimum latent length of 1
+    return std::max<int64_t>(latentLen, 1);
+}
+
+/**
+ * Spread numSamples of audio over the tokens in proportion to their
+ * predicted durations, so the speed scaling and latent rounding applied to
+ * the total carry over to every token. Without per-token durations each
+ * token gets an equal share and the timings are marked approximate.
+ */
+static void alignTokens(const std::vector<float>& tokenDurations, uint64_t numSamples, TokenTimings& timings) {
+    const size_t count = timings.tokens.size();
+    timings.approximate = tokenDurations.size() != count;
+    double total = 0.0;
+    if (!timings.approximate) {
+        for (float d : tokenDurations) {
+            total += std::max(0.0f, d);
+        }
+        timings.approximate = !(total > 0.0);
+    }
+
+    double elapsed = 0.0;
+    uint64_t start = 0;
+    for (size_t i = 0; i < count; i++) {
+        elapsed += timings.approximate ? 1.0 : std::max(0.0f, tokenDurations[i]);
+        const double fraction = elapsed / (timings.approximate ? (double)count : total);
+        const uint64_t end = i + 1 == count
+            ? numSamples
+            : std::min(numSamples, (uint64_t)std::llround(fraction * numSamples));
+        timings.tokens[i].start_sample = start;
+        timings.tokens[i].end_sample = end;
+        start = end;
+    }
+}
+
+/**
+ * Steps 2-3 for one token sequence padded to seqLen: run the text encoder
+ * and duration predictor. On success textEmb owns the encoder output,
+ * durationSum holds the predicted length in seconds before speed scaling
+ * and tokenDurations the per-token split of it, if the model outputs one.
+ */
+static SupertonicStatus encodeText(SupertonicEngine* engine,
+                                   const std::vector<int64_t>& tokens,
+                                   int64_t seqLen,
+                                   const VoiceStyle& voiceStyle,
+                                   uint64_t requestId,
+                                   SupertonicExecutionClass executionClass,
+                                   SupertonicSynthesisStats* stats,
+                                   OrtValue*& textEmb,
+                                   float& durationSum,
+                                   std::vector<float>& tokenDurations) {
+    Clock::time_point stageStart = Clock::now();
+
+    // Create input tensors for text encoder
+    // Inputs: text_ids [batch, seq_len], style_ttl [batch, n_style, style_dim], text_mask [batch, seq_len]
+    std::vector<int64_t> paddedTokens;
+    const int64_t* tokenData = tokens.data();
+    if (seqLen > (int64_t)tokens.size()) {
+        paddedTokens.assign(seqLen, 0);
+        std::copy(tokens.begin(), tokens.end(), paddedTokens.begin());
+        tokenData = paddedTokens.data();
+    }
+    int64_t textShape[] = {1, seqLen};
+    OrtValue* textInput = createTensor(engine, stats, tokenData, seqLen * sizeof(int64_t),
+                                       textShape, 2, ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64);
+    int64_t styleTtlShape[] = {1, N_STYLE_TTL, STYLE_TTL_DIM};
+    OrtValue* styleTensor = createStyleTensor(engine, stats, MODEL_TEXT_ENCODER, voiceStyle.style_ttl,
+                                              voiceStyle.style_ttl_half, styleTtlShape, 3);
+    OrtValue* textMask = createMaskTensor(engine, stats, MODEL_TEXT_ENCODER, (int64_t)tokens.size(), seqLen);
+    if (textInput == nullptr || styleTensor == nullptr || textMask == nullptr) {
+        releaseValues({textInput, styleTensor, textMask});
+        return SUPERTONIC_ERROR_OUT_OF_MEMORY;
+    }
+
+    // Step 2: Run text encoder
+    // Inputs: text_ids, style_ttl, text_mask -> Output: text_emb
+    OrtValue* textEncoderInputTensors[] = {textInput, styleTensor, textMask};
+    const char* textEncoderInputs[] = {"text_ids", "style_ttl", "text_mask"};
+    const char* textEncoderOutputs[] = {"text_emb"};
+
+    std::vector<OrtValue*> textEncoderOutputTensors(1, nullptr);
+    OrtStatus* runStatus = nullptr;
+    {
+        TraceScope span(engine, "text_encoder", requestId, MODEL_TEXT_ENCODER);
+        PerfScope counters(engine, stats, &stats->perf_text_encoder);
+        RunOptions runOptions(engine, requestId, MODEL_TEXT_ENCODER);
+        runStatus = runModel(engine, MODEL_TEXT_ENCODER, executionClass, runOptions.get(),
+                             textEncoderInputs, (const OrtValue* const*)textEncoderInputTensors, 3,
+                             textEncoderOutputs, 1, textEncoderOutputTensors.data());
+    }
+
+    releaseValues({textInput, styleTensor, textMask});
+
+    if (checkStatus(runStatus, "TextEncoder Run")) {
+        LOGE("Text encoder failed");
+        return SUPERTONIC_ERROR_INFERENCE;
+    }
+    textEmb = textEncoderOutputTensors[0];
+    stats->text_emb_bytes = floatTensorBytes(textEmb);
+    stats->tensor_bytes_allocated += stats->text_emb_bytes;
+    stats->text_encoder_ms = elapsedMs(stageStart);
+    LOGD("Text encoder completed");
+
+    // Step 3: Run duration predictor
+    // Inputs: text_ids, style_dp [1, 8, 16], text_mask -> Output: duration
+    // Reuse text_ids token tensor, need fresh one since we released it
+    stageStart = Clock::now();
+    OrtValue* textInput2 = createTensor(engine, stats, tokenData, seqLen * sizeof(int64_t),
+                                        textShape, 2, ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64);
+
+    // style_dp has shape [1, 8, 16] - different from style_ttl
+    int64_t styleDpShape[] = {1, N_STYLE_DP, STYLE_DP_DIM};
+    OrtValue* styleDpTensor = createStyleTensor(engine, stats, MODEL_DURATION_PREDICTOR, voiceStyle.style_dp,
+                                                voiceStyle.style_dp_half, styleDpShape, 3);
+
+    // Recreate text mask with 3D shape [1, 1, seq_len]
+    OrtValue* textMask2 = createMaskTensor(engine, stats, MODEL_DURATION_PREDICTOR, (int64_t)tokens.size(), seqLen);
+    if (textInput2 == nullptr || styleDpTensor == nullptr || textMask2 == nullptr) {
+        releaseValues({textInput2, styleDpTensor, textMask2, textEmb});
+        textEmb = nullptr;
+        return SUPERTONIC_ERROR_OUT_OF_MEMORY;
+    }
+
+    OrtValue* durPredInputTensors[] = {textInput2, styleDpTensor, textMask2};
+    const char* durPredInputs[] = {"text_ids", "style_dp", "text_mask"};
+    const char* durPredOutputs[] = {"duration"};
+
+    std::vector<OrtValue*> durPredOutputTensors(1, nullptr);
+    {
+        TraceScope span(engine, "duration_predictor", requestId, MODEL_DURATION_PREDICTOR);
+        PerfScope counters(engine, stats, &stats->perf_duration_predictor);
+        RunOptions runOptions(engine, requestId, MODEL_DURATION_PREDICTOR);
+        runStatus = runModel(engine, MODEL_DURATION_PREDICTOR, executionClass, runOptions.get(),
+                             durPredInputs, (const OrtValue* const*)durPredInputTensors, 3,
+                             durPredOutputs, 1, durPredOutputTensors.data());
+    }
+
+    g_ortApi->ReleaseValue(textInput2);
+    g_ortApi->ReleaseValue(styleDpTensor);
+    g_ortApi->ReleaseValue(textMask2);
+
+    if (checkStatus(runStatus, "DurationPredictor Run")) {
+        g_ortApi->ReleaseValue(textEmb);
+        textEmb = nullptr;
+        LOGE("Duration predictor failed");
+        return SUPERTONIC_ERROR_INFERENCE;
+    }
+    OrtValue* durations = durPredOutputTensors[0];
+    stats->tensor_bytes_allocated += floatTensorBytes(durations);
+    LOGD("Duration predictor completed");
+
+    std::vector<float> sums;
+    const bool summed = sumDurations(durations, {(int64_t)tokens.size()}, seqLen, sums, &tokenDurations);
+    g_ortApi->ReleaseValue(durations);
+    if (!summed) {
+        g_ortApi->ReleaseValue(textEmb);
+        textEmb = nullptr;
+        return SUPERTONIC_ERROR_INFERENCE;
+    }
+    durationSum = sums[0];
+    LOGD("Duration sum: %.2f", durationSum);
+    stats->duration_predictor_ms = elapsedMs(stageStart);
+    return SUPERTONIC_OK;
+}
+
+/** Cached result for (speakerId, tokens), moved to the front; nullptr if absent. */
+static std::shared_ptr<const TextCacheEntry> findCachedText(SupertonicEngine* engine, int speakerId,
+                                                            const std::vector<int64_t>& tokens) {
+    std::lock_guard<std::mutex> lock(engine->textCacheMutex);
+    for (auto it = engine->textCache.begin(); it != engine->textCache.end(); ++it) {
+        if ((*it)->speakerId == speakerId && (*it)->tokens == tokens) {
+            engine->textCache.splice(engine->textCache.begin(), engine->textCache, it);
+            return engine->textCache.front();
+        }
+    }
+    return nullptr;
+}
+
+/** Insert at the front, evicting the least recently used entries beyond the limit. */
+static void cacheText(SupertonicEngine* engine, std::shared_ptr<const TextCacheEntry> entry) {
+    const size_t limit = engine->config.text_cache_entries > 0 ? (size_t)engine->config.text_cache_entries : 0;
+    if (limit == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(engine->textCacheMutex);
+    engine->textCache.push_front(std::move(entry));
+    while (engine->textCache.size() > limit) {
+        engine->textCache.pop_back();  // in-flight calls keep their copy alive
+    }
+}
+
+/**
+ * One utterance between the duration predictor and the vocoder: the text
+ * embedding, the tensors every diffusion step shares, the latent and the
+ * next step to run. Between steps the latent stays in the estimator's own
+ * precision.
+ */
+struct DiffusionState {
+    ~DiffusionState() { releaseTensors(); }
+
+    void releaseTensors() {
+        releaseValues({styleTensor, textMask, convertedTextEmb});
+        styleTensor = nullptr;
+        textMask = nullptr;
+        convertedTextEmb = nullptr;
+        textEmb = nullptr;
+    }
+
+    uint64_t requestId = 0;
+    SupertonicExecutionClass executionClass = SUPERTONIC_CLASS_FOREGROUND;
+    int numSteps = 0;
+    int nextStep = 0;
+    bool finished = false;  // all steps run, or the rest extrapolated
+
+    // style_ttl backs styleTensor, so it lives as long as the tensors
+    std::shared_ptr<const VoiceStyle> voiceStyle;
+    std::shared_ptr<const TextCacheEntry> text;
+    OrtValue* textEmb = nullptr;           // text->textEmb or convertedTextEmb
+    OrtValue* convertedTextEmb = nullptr;  // owned, like the two below
+    OrtValue* styleTensor = nullptr;
+    OrtValue* textMask = nullptr;
+
+    int64_t latentLen = 0;
+    int64_t paddedLatentLen = 0;
+    bool halfLatent = false;
+    std::vector<float> latentData;
+    std::vector<uint16_t> latentHalf;  // the latent itself when halfLatent
+    std::unique_ptr<LatentTrajectory> trajectory;
+};
+
+/** The sub-utterances of one chunked input and those done; see runChunks(). */
+struct ChunkProgress {
+    std::vector<int64_t> tokens;
+    std::vector<size_t> chunkEnds;  // token index each chunk ends at
+    int speakerId = 0;
+    float speed = 1.0f;
+    int numSteps = 0;
+    unsigned int seed = 0;
+    uint64_t requestId = 0;
+    // Per chunk
+    std::vector<char> done;
+    std::vector<std::vector<float>> audio;
+    std::vector<SupertonicSynthesisStats> stats;
+    std::vector<TokenTimings> timings;
+};
+
+/**
+ * A synthesis paused between diffusion steps, or for chunked input between
+ * chunks (chunks set, diffusion unused); see Preemption.
+ */
+struct SuspendedSynthesis {
+    std::unique_ptr<ChunkProgress> chunks;
+    DiffusionState diffusion;
+    SupertonicSynthesisStats stats;  // so far
+    TokenTimings timings;
+    Clock::time_point suspendedAt;
+};
+
+/**
+ * Everything before the first diffusion step: voice style, text encoder
+ * and duration predictor (or their cached results) and the initial noise.
+ * latentLenOverride > 0 replaces the length derived from the predicted
+ * durations (warmup).
+ */
+static SupertonicStatus prepareDiffusion(SupertonicEngine* engine,
+                                         const std::vector<int64_t>& tokens,
+                                         int speakerId,
+                                         float speed,
+                                         bool useTextCache,
+                                         int numSteps,
+                                         unsigned int noiseSeed,
+                                         int64_t latentLenOverride,
+                                         uint64_t requestId,
+                                         SupertonicExecutionClass executionClass,
+                                         SupertonicSynthesisStats* stats,
+                                         DiffusionState& s) {
+    // synthesize() reloads trimmed sessions; this only fails if that did
+    if (engine->textEncoder == nullptr || engine->durationPredictor == nullptr ||
+        engine->vectorEstimator == nullptr || engine->vocoder == nullptr) {
+        LOGE("Sessions unavailable");
+        return SUPERTONIC_ERROR_MODEL_LOAD;
+    }
+    s.requestId = requestId;
+    s.executionClass = executionClass;
+    s.numSteps = numSteps;
+
+    Clock::time_point stageStart = Clock::now();
+
+    // seq_len is padded up to a token bucket; text_mask hides the padding
+    const int64_t tokenCount = (int64_t)tokens.size();
+    const int64_t seqLen = bucketLength(engine->config.token_buckets, tokenCount);
+
+    // Create style_ttl embedding [1, 50, 256] - from voice_styles/*.json
+    // Load voice style if not already loaded
+    s.voiceStyle = loadVoiceStyle(engine, speakerId);
+    if (s.voiceStyle == nullptr) {
+        LOGE("Failed to load voice style for speaker %d, using fallback", speakerId);
+    }
+    // Use loaded style if available, otherwise use zeros
+    const VoiceStyle& style = s.voiceStyle != nullptr ? *s.voiceStyle : fallbackStyle();
+
+    // Steps 2-3: text encoder and duration predictor. Neither depends on
+    // speed, so re-rendering a recent segment at another speed reuses them.
+    std::shared_ptr<const TextCacheEntry> text =
+        useTextCache ? findCachedText(engine, speakerId, tokens) : nullptr;
+    if (text != nullptr) {
+        stats->text_cache_hit = 1;
+        stats->text_emb_bytes = text->bytes - tokens.size() * sizeof(int64_t) -
+                                text->tokenDurations.size() * sizeof(float);
+        LOGD("Text cache hit (%lld tokens, speaker %d)", (long long)tokenCount, speakerId);
+    } else {
+        OrtValue* encoded = nullptr;
+        float durationSum = 0.0f;
+        std::vector<float> tokenDurations;
+        SupertonicStatus status = encodeText(engine, tokens, seqLen, style, requestId, executionClass, stats,
+                                             encoded, durationSum, tokenDurations);
+        if (status != SUPERTONIC_OK) {
+            return status;
+        }
+        auto entry = std::make_shared<TextCacheEntry>();
+        entry->speakerId = speakerId;
+        entry->textEmb.reset(encoded, [](OrtValue* value) { g_ortApi->ReleaseValue(value); });
+        entry->durationSum = durationSum;
+        entry->tokenDurations = std::move(tokenDurations);
+        entry->bytes = stats->text_emb_bytes + tokens.size() * sizeof(int64_t) +
+                       entry->tokenDurations.size() * sizeof(float);
+        // Results computed with the zero fallback style are not worth keeping
+        if (useTextCache && s.voiceStyle != nullptr) {
+            entry->tokens = tokens;
+            cacheText(engine, entry);
+        }
+        text = std::move(entry);
+    }
+    s.text = std::move(text);
+    s.textEmb = s.text->textEmb.get();
+
+    // fp16 and fp32 encoder/estimator files can be mixed; convert text_emb between them
+    bool converted = false;
+    s.convertedTextEmb = convertForModel(engine, stats, MODEL_VECTOR_ESTIMATOR, s.textEmb, converted);
+    if (!converted) {
+        return SUPERTONIC_ERROR_OUT_OF_MEMORY;
+    }
+    if (s.convertedTextEmb != nullptr) {
+        s.textEmb = s.convertedTextEmb;
+    }
+
+    int64_t latentLen = latentLength(s.text->durationSum, speed);
+    LOGD("Computed latent length: %lld (duration %.2f s, speed %.2f)", (long long)latentLen,
+         s.text->durationSum, speed);
+    if (latentLenOverride > 0) {
+        latentLen = latentLenOverride;
+    }
+    stats->latent_len = latentLen;
+
+    // The tensors use the padded length; latent_mask hides the padding
+    const int64_t paddedLatentLen = bucketLength(engine->config.latent_buckets, latentLen);
+    if (paddedLatentLen != latentLen || seqLen != tokenCount) {
+        LOGD("Bucketed shapes: tokens %lld -> %lld, latent %lld -> %lld", (long long)tokenCount,
+             (long long)seqLen, (long long)latentLen, (long long)paddedLatentLen);
+    }
+    s.latentLen = latentLen;
+    s.paddedLatentLen = paddedLatentLen;
+    s.halfLatent = engine->halfIo[MODEL_VECTOR_ESTIMATOR];
+    const size_t latentElementBytes = s.halfLatent ? sizeof(uint16_t) : sizeof(float);
+    stats->latent_bytes = (uint64_t)LATENT_CHANNELS * paddedLatentLen * latentElementBytes;
+
+    // noisy_latent shape: [batch, LATENT_CHANNELS (144), latent_length]
+    // Gaussian noise from a seeded Box-Muller transform (noise.cpp)
+    stageStart = Clock::now();
+    TraceScope noiseSpan(engine, "noise", requestId);
+    std::vector<float>& latentData = s.latentData;
+    latentData.assign(LATENT_CHANNELS * paddedLatentLen, 0.0f);
+
+    // Noise is drawn for the unpadded [144, latent_len] layout so a segment
+    // gets the same noise whatever bucket it lands in. The generator is
+    // local to this call: chunks and scheduler jobs run concurrently
+    const size_t noiseCount = (size_t)LATENT_CHANNELS * latentLen;
+    fillGaussianNoise(noiseSeed, latentData.data(), noiseCount);
+    if (paddedLatentLen > latentLen) {
+        // Spread the rows out to the padded stride, last row first
+        for (int c = LATENT_CHANNELS - 1; c > 0; c--) {
+            float* row = latentData.data() + (size_t)c * paddedLatentLen;
+            memmove(row, latentData.data() + (size_t)c * latentLen, latentLen * sizeof(float));
+        }
+        zeroLatentPadding(latentData, latentLen, paddedLatentLen);
+    }
+    if (s.halfLatent) {
+        s.latentHalf.resize(latentData.size());
+        floatToHalf(latentData.data(), s.latentHalf.data(), latentData.size());
+    }
+
+    int64_t styleTtlShape[] = {1, N_STYLE_TTL, STYLE_TTL_DIM};
+    s.styleTensor = createStyleTensor(engine, stats, MODEL_VECTOR_ESTIMATOR, style.style_ttl,
+                                      style.style_ttl_half, styleTtlShape, 3);
+    // Text mask for vector estimator with 3D shape [1, 1, seq_len]
+    s.textMask = createMaskTensor(engine, stats, MODEL_VECTOR_ESTIMATOR, tokenCount, seqLen);
+    if (s.styleTensor == nullptr || s.textMask == nullptr) {
+        return SUPERTONIC_ERROR_OUT_OF_MEMORY;
+    }
+
+    // Early exit tracks the path from the noise on (float, before any
+    // conversion to half); at least two steps are needed to compare
+    const int exitMinSteps = std::max(2, engine->config.early_exit_min_steps);
+    if (engine->config.early_exit_threshold > 0.0f && numSteps > exitMinSteps) {
+        s.trajectory.reset(new LatentTrajectory(latentLen, paddedLatentLen));
+        s.trajectory->advance(latentData.data());
+    }
+
+    stats->noise_ms = elapsedMs(stageStart);
+    stats->num_steps = numSteps;
+    stats->steps_run = numSteps;
+    return SUPERTONIC_OK;
+}
+
+/**
+ * Step 4: the vector estimator (flow-matching denoiser) from s.nextStep
+ * on. Inputs: noisy_latent, text_emb, style_ttl, latent_mask, text_mask,
+ * current_step, total_step; output: denoised_latent. When preemption's
+ * yield() asks for the thread between two steps, returns early with
+ * s.finished unset.
+ */
+static SupertonicStatus runDiffusion(SupertonicEngine* engine, DiffusionState& s,
+                                     SupertonicSynthesisStats* stats, const Preemption* preemption) {
+    const int numSteps = s.numSteps;
+    const bool halfLatent = s.halfLatent;
+    void* latentBuffer = halfLatent ? (void*)s.latentHalf.data() : (void*)s.latentData.data();
+    const size_t latentBufferBytes = s.latentData.size() * (halfLatent ? sizeof(uint16_t) : sizeof(float));
+    int64_t latentShape[] = {1, LATENT_CHANNELS, s.paddedLatentLen};
+    const float exitThreshold = engine->config.early_exit_threshold;
+    const int exitMinSteps = std::max(2, engine->config.early_exit_min_steps);
+
+    OrtStatus* runStatus = nullptr;
+    while (s.nextStep < numSteps) {
+        const int step = s.nextStep;
+        const Clock::time_point stepStart = Clock::now();
+        OrtValue* noisyLatent = createTensor(engine, stats, latentBuffer, latentBufferBytes,
+                                             latentShape, 3, floatType(engine, MODEL_VECTOR_ESTIMATOR));
+        // Latent mask (ones = valid frames, zeros = padding) - shape [1, 1, latent_len]
+        OrtValue* latentMask = createMaskTensor(engine, stats, MODEL_VECTOR_ESTIMATOR, s.latentLen,
+                                                s.paddedLatentLen);
+
+        // Step tensors - model expects float, not int64
+        int64_t stepShape[] = {1};
+        float currentStepVal = static_cast<float>(step);
+        float totalStepVal = static_cast<float>(numSteps);
+        OrtValue* currentStepTensor = createFloatTensor(engine, stats, MODEL_VECTOR_ESTIMATOR, &currentStepVal, 1,
+                                                        stepShape, 1);
+        OrtValue* totalStepTensor = createFloatTensor(engine, stats, MODEL_VECTOR_ESTIMATOR, &totalStepVal, 1,
+                                                      stepShape, 1);
+
+        OrtValue* vecEstInputTensors[] = {noisyLatent, s.textEmb, s.styleTensor, latentMask, s.textMask, currentStepTensor, totalStepTensor};
+        const char* vecEstInputNames[] = {"noisy_latent", "text_emb", "style_ttl", "latent_mask", "text_mask", "current_step", "total_step"};
+        const char* vecEstOutputs[] = {"denoised_latent"};
+
+        std::vector<OrtValue*> vecEstOutputTensors(1, nullptr);
+        {
+            TraceScope span(engine, "vector_estimator", s.requestId, MODEL_VECTOR_ESTIMATOR, step);
+            PerfScope counters(engine, stats, &stats->perf_step[step]);
+            RunOptions runOptions(engine, s.requestId, MODEL_VECTOR_ESTIMATOR, step, step == numSteps - 1);
+            runStatus = runModel(engine, MODEL_VECTOR_ESTIMATOR, s.executionClass, runOptions.get(),
+                                 vecEstInputNames, (const OrtValue* const*)vecEstInputTensors, 7,
+                                 vecEstOutputs, 1, vecEstOutputTensors.data());
+        }
+
+        g_ortApi->ReleaseValue(noisyLatent);
+        g_ortApi->ReleaseValue(latentMask);
+        g_ortApi->ReleaseValue(currentStepTensor);
+        g_ortApi->ReleaseValue(totalStepTensor);
+
+        if (checkStatus(runStatus, "VectorEstimator Run")) {
+            LOGE("Vector estimator failed at step %d", step);
+            return SUPERTONIC_ERROR_INFERENCE;
+        }
+
+        // Copy denoised output back to the latent buffer for next step
+        void* denoisedData = nullptr;
+        if (checkStatus(g_ortApi->GetTensorMutableData(vecEstOutputTensors[0], &denoisedData),
+                        "GetTensorMutableData")) {
+            g_ortApi->ReleaseValue(vecEstOutputTensors[0]);
+            return SUPERTONIC_ERROR_INFERENCE;
+        }
+        memcpy(latentBuffer, denoisedData, latentBufferBytes);
+        g_ortApi->ReleaseValue(vecEstOutputTensors[0]);
+        stats->tensor_bytes_allocated += stats->latent_bytes;
+        s.nextStep = step + 1;
+
+        // latentData is free scratch between steps when the latent is half
+        bool converged = false;
+        if (s.trajectory) {
+            float* current = s.latentData.data();
+            if (halfLatent) {
+                halfToFloat(s.latentHalf.data(), current, s.latentHalf.size());
+            }
+            const double bend = s.trajectory->advance(current);
+            const int done = step + 1;
+            if (done >= exitMinSteps && done < numSteps && bend < exitThreshold) {
+                s.trajectory->extrapolate(current, numSteps - done);
+                if (halfLatent) {
+                    floatToHalf(current, s.latentHalf.data(), s.latentHalf.size());
+                }
+                LOGD("Diffusion converged after %d of %d steps (change %.3g)", done, numSteps, bend);
+                stats->steps_run = done;
+                converged = true;
+            }
+        }
+
+        stats->step_ms[step] = elapsedMs(stepStart);
+        stats->vector_estimator_ms += stats->step_ms[step];
+        if (converged) {
+            break;
+        }
+        if (s.nextStep < numSteps && preemption != nullptr && preemption->yield && preemption->yield()) {
+            LOGD("Request %llu paused after step %d of %d", (unsigned long long)s.requestId, s.nextStep,
+                 numSteps);
+            return SUPERTONIC_OK;
+        }
+    }
+    s.finished = true;
+    LOGD("Vector estimator completed (%d steps)", stats->steps_run);
+    return SUPERTONIC_OK;
+}
+
+/**
+ * Step 5: the vocoder, latent [batch, 144, latent_length] -> wav_tts.
+ * timings (optional) arrives with one entry per token and leaves with
+ * their sample ranges in the audio.
+ */
+static SupertonicStatus runVocoder(SupertonicEngine* engine, DiffusionState& s,
+                                   std::vector<float>& audio,
+                                   SupertonicSynthesisStats* stats,
+                                   TokenTimings* timings) {
+    s.releaseTensors();
+    std::vector<float> tokenDurations;
+    if (timings != nullptr) {
+        tokenDurations = s.text->tokenDurations;
+    }
+    s.text.reset();
+
+    const int64_t latentLen = s.latentLen;
+    const int64_t paddedLatentLen = s.paddedLatentLen;
+    int64_t latentShape[] = {1, LATENT_CHANNELS, paddedLatentLen};
+    Clock::time_point stageStart = Clock::now();
+    // Silent padding frames, so only the real frames shape the tail of the audio
+    OrtValue* finalLatent = nullptr;
+    if (s.halfLatent && engine->halfIo[MODEL_VOCODER]) {
+        zeroLatentPadding(s.latentHalf, latentLen, paddedLatentLen);
+        finalLatent = createTensor(engine, stats, s.latentHalf.data(), s.latentHalf.size() * sizeof(uint16_t),
+                                   latentShape, 3, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16);
+    } else {
+        if (s.halfLatent) {
+            halfToFloat(s.latentHalf.data(), s.latentData.data(), s.latentData.size());
+        }
+        zeroLatentPadding(s.latentData, latentLen, paddedLatentLen);
+        finalLatent = createFloatTensor(engine, stats, MODEL_VOCODER, s.latentData.data(), s.latentData.size(),
+                                        latentShape, 3);
+    }
+    if (finalLatent == nullptr) {
+        return SUPERTONIC_ERROR_OUT_OF_MEMORY;
+    }
+
+    const char* vocoderInputs[] = {"latent"};
+    const char* vocoderOutputs[] = {"wav_tts"};
+
+    std::vector<OrtValue*> vocoderOutputTensors(1, nullptr);
+    OrtStatus* runStatus = nullptr;
+    {
+        TraceScope span(engine, "vocoder", s.requestId, MODEL_VOCODER);
+        PerfScope counters(engine, stats, &stats->perf_vocoder);
+        RunOptions runOptions(engine, s.requestId, MODEL_VOCODER);
+        runStatus = runModel(engine, MODEL_VOCODER, s.executionClass, runOptions.get(),
+                             vocoderInputs, (const OrtValue* const*)&finalLatent, 1,
+                             vocoderOutputs, 1, vocoderOutputTensors.data());
+    }
+
+    g_ortApi->ReleaseValue(finalLatent);
+
+    if (checkStatus(runStatus, "Vocoder Run") || vocoderOutputTensors[0] == nullptr) {
+        LOGE("Vocoder failed");
+        return SUPERTONIC_ERROR_INFERENCE;
+    }
+    OrtValue* audioTensor = vocoderOutputTensors[0];
+    LOGD("Vocoder completed");
+
+    size_t numSamples = 0;
+    {
+        TraceScope span(engine, "convert_output", s.requestId);
+        // Get audio data from tensor, widened to fp32 if the vocoder emits fp16
+        const bool read = readFloatTensor(audioTensor, audio);
+        g_ortApi->ReleaseValue(audioTensor);
+        if (!read || audio.empty()) {
+            audio.clear();
+            return SUPERTONIC_ERROR_INFERENCE;
+        }
+        numSamples = audio.size();
+        if (paddedLatentLen > latentLen) {
+            // Drop the audio generated for the padding frames
+            numSamples = std::min(numSamples, (size_t)latentLen * CHUNK_SIZE);
+            audio.resize(numSamples);
+        }
+    }
+
+    LOGD("Generated %zu audio samples", numSamples);
+
+    stats->vocoder_ms = elapsedMs(stageStart);
+
+    stats->num_samples = numSamples;
+    stats->audio_bytes = numSamples * sizeof(float);
+    stats->tensor_bytes_allocated += stats->audio_bytes;
+    stats->audio_seconds = (double)numSamples / SAMPLE_RATE;
+
+    if (timings != nullptr) {
+        alignTokens(tokenDurations, numSamples, *timings);
+    }
+    return SUPERTONIC_OK;
+}
+
+/**
+ * Diffusion from the state's next step on, then the vocoder. If preemption
+ * pauses the diffusion, the state moves to preemption->suspended and audio
+ * stays empty.
+ */
+static SupertonicStatus continueModels(SupertonicEngine* engine,
+                                       std::shared_ptr<SuspendedSynthesis> state,
+                                       std::vector<float>& audio,
+                                       SupertonicSynthesisStats* stats,
+                                       TokenTimings* timings,
+                                       Preemption* preemption) {
+    SupertonicStatus status = runDiffusion(engine, state->diffusion, stats, preemption);
+    if (status != SUPERTONIC_OK) {
+        return status;
+    }
+    if (!state->diffusion.finished) {
+        preemption->suspended = std::move(state);
+        return SUPERTONIC_OK;
+    }
+    return runVocoder(engine, state->diffusion, audio, stats, timings);
+}
+
+/**
+ * Models stage of the pipeline, from tokens to audio; see
+ * prepareDiffusion() and continueModels(). preemption (optional) lets the
+ * caller pause between diffusion steps.
+ */
+static SupertonicStatus runModels(SupertonicEngine* engine,
+                                  const std::vector<int64_t>& tokens,
+                                  int speakerId,
+                                  float speed,
+                                  bool useTextCache,
+                                  int numSteps,
+                                  unsigned int noiseSeed,
+                                  int64_t latentLenOverride,
+                                  uint64_t requestId,
+                                  SupertonicExecutionClass executionClass,
+                                  std::vector<float>& audio,
+                                  SupertonicSynthesisStats* stats,
+                                  TokenTimings* timings,
+                                  Preemption* preemption = nullptr) {
+    auto state = std::make_shared<SuspendedSynthesis>();
+    SupertonicStatus status = prepareDiffusion(engine, tokens, speakerId, speed, useTextCache, numSteps,
+                                               noiseSeed, latentLenOverride, requestId, executionClass, stats,
+                                               state->diffusion);
+    if (status != SUPERTONIC_OK) {
+        return status;
+    }
+    return continueModels(engine, std::move(state), audio, stats, timings, preemption);
+}
+
+/**
+ * How good a place to end a sub-utterance the codepoint at offset is:
+ * 3 sentence end, 2 clause end, 1 comma, 0 whitespace, -1 none.
+ */
+static int boundaryRank(const std::string& text, uint32_t offset) {
+    static const char* const kSentenceEnds[] = {".", "!", "?", "。", "！", "？"};
+    static const char* const kClauseEnds[] = {";", ":", "—", "…", "；", "："};
+    static const char* const kCommas[] = {",", "、", "，"};
+    auto matches = [&](const char* mark) { return text.compare(offset, strlen(mark), mark) == 0; };
+    for (const char* mark : kSentenceEnds) {
+        if (matches(mark)) return 3;
+    }
+    for (const char* mark : kClauseEnds) {
+        if (matches(mark)) return 2;
+    }
+    for (const char* mark : kCommas) {
+        if (matches(mark)) return 1;
+    }
+    return std::isspace((unsigned char)text[offset]) ? 0 : -1;
+}
+
+/**
+ * End (exclusive token index) of each sub-utterance of at most maxTokens
+ * tokens. A chunk ends after whitespace or punctuation in the second half
+ * of its window, preferring sentence over clause over comma over word
+ * boundaries and later over earlier; text without any is cut at maxTokens.
+ */
+static std::vector<size_t> splitChunks(const std::string& text, const std::vector<uint32_t>& offsets,
+                                       size_t maxTokens) {
+    std::vector<size_t> ends;
+    const size_t count = offsets.size();
+    size_t start = 0;
+    while (count - start > maxTokens) {
+        size_t best = start + maxTokens;
+        int bestRank = -1;
+        int lastMark = -1;  // rank of the last non-whitespace token seen
+        for (size_t i = start; i < start + maxTokens; i++) {
+            const int rank = boundaryRank(text, offsets[i]);
+            const bool space = rank == 0;
+            if (!space) {
+                lastMark = rank;
+            }
+            // Splitting after token i: after a space the clause mark before it counts
+            const int splitRank = space ? std::max(0, lastMark) : rank;
+            if (i + 1 >= start + maxTokens / 2 && splitRank >= 0 && splitRank >= bestRank) {
+                bestRank = splitRank;
+                best = i + 1;
+            }
+        }
+        ends.push_back(best);
+        start = best;
+    }
+    ends.push_back(count);
+    return ends;
+}
+
+/** Samples shared by audio of length have and the next chunk of length next. */
+static size_t crossfadeOverlap(size_t crossfade, size_t have, size_t next) {
+    return std::min({crossfade, have / 2, next / 2});
+}
+
+int parallelRuns(const SupertonicEngine* engine) {
+    // Each caller joins the pool it runs on
+    const int budget = engine->threadBudget;
+    const int intraOp = engine->intraOpThreads;
+    return std::max(1, engine->globalThreadPool ? budget - intraOp + 1 : budget / intraOp);
+}
+
+RunSlots::RunSlots(SupertonicEngine* engine) : engine_(engine) {
+    std::unique_lock<std::mutex> lock(engine->runSlotMutex);
+    engine->runSlotReleased.wait(lock, [engine]() { return engine->runSlotsUsed < parallelRuns(engine); });
+    engine->runSlotsUsed++;
+    count_ = 1;
+}
+
+RunSlots::RunSlots(SupertonicEngine* engine, size_t wanted) : engine_(engine) {
+    std::lock_guard<std::mutex> lock(engine->runSlotMutex);
+    const int spare = std::max(0, parallelRuns(engine) - engine->runSlotsUsed);
+    count_ = (int)std::min(wanted, (size_t)spare);
+    engine->runSlotsUsed += count_;
+}
+
+RunSlots::~RunSlots() {
+    if (count_ == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(engine_->runSlotMutex);
+        engine_->runSlotsUsed -= count_;
+    }
+    engine_->runSlotReleased.notify_all();
+    // Foreground scheduler threads take a slot before their next job
+    notifyRunSlotReleased(engine_);
+}
+
+bool runSlotFree(SupertonicEngine* engine) {
+    std::lock_guard<std::mutex> lock(engine->runSlotMutex);
+    return engine->runSlotsUsed < parallelRuns(engine);
+}
+
+/** Add a sub-utterance's stats into the call's. */
+static void mergeChunkStats(SupertonicSynthesisStats* total, const SupertonicSynthesisStats& chunk) {
+    total->text_encoder_ms += chunk.text_encoder_ms;
+    total->duration_predictor_ms += chunk.duration_predictor_ms;
+    total->noise_ms += chunk.noise_ms;
+    total->vector_estimator_ms += chunk.vector_estimator_ms;
+    total->vocoder_ms += chunk.vocoder_ms;
+    total->num_steps = chunk.num_steps;
+    total->steps_run = std::max(total->steps_run, chunk.steps_run);
+    for (int i = 0; i < SUPERTONIC_MAX_DIFFUSION_STEPS; i++) {
+        total->step_ms[i] += chunk.step_ms[i];
+        addPerfCounts(total->perf_step[i], chunk.perf_step[i]);
+    }
+    addPerfCounts(total->perf_text_encoder, chunk.perf_text_encoder);
+    addPerfCounts(total->perf_duration_predictor, chunk.perf_duration_predictor);
+    addPerfCounts(total->perf_vocoder, chunk.perf_vocoder);
+    total->perf_counters |= chunk.perf_counters;
+    total->perf_threads = std::max(total->perf_threads, chunk.perf_threads);
+    total->latent_len += chunk.latent_len;
+    total->text_emb_bytes += chunk.text_emb_bytes;
+    total->latent_bytes += chunk.latent_bytes;
+    total->tensor_bytes_allocated += chunk.tensor_bytes_allocated;
+    total->text_cache_hit = total->num_chunks == 0 ? chunk.text_cache_hit
+                                                   : total->text_cache_hit && chunk.text_cache_hit;
+    total->num_chunks++;
+}
+
+/**
+ * Synthesize the chunks of one input on up to maxParallel threads and join
+ * them with a linear crossfade. Runs under the caller's session lock; the
+ * threads besides the caller's are the run slots spare right now.
+ * preemption (optional) is asked before every chunk but the first this
+ * call runs; once it says yes no further chunk starts, and when the
+ * running ones are done the state moves to preemption->suspended and audio
+ * stays empty. Passing that state again runs the chunks left, in the
+ * execution class given then.
+ */
+static SupertonicStatus runChunks(SupertonicEngine* engine,
+                                  std::shared_ptr<SuspendedSynthesis> state,
+                                  SupertonicExecutionClass executionClass,
+                                  std::vector<float>& audio,
+                                  SupertonicSynthesisStats* stats,
+                                  TokenTimings* timings,
+                                  Preemption* preemption) {
+    ChunkProgress& progress = *state->chunks;
+    const std::vector<int64_t>& tokens = progress.tokens;
+    const std::vector<size_t>& chunkEnds = progress.chunkEnds;
+    const uint64_t requestId = progress.requestId;
+    const size_t numChunks = chunkEnds.size();
+    std::vector<std::vector<float>>& chunkAudio = progress.audio;
+    std::vector<TokenTimings>& chunkTimings = progress.timings;
+    std::vector<SupertonicStatus> chunkStatus(numChunks, SUPERTONIC_OK);
+    const size_t chunksLeft = (size_t)std::count(progress.done.begin(), progress.done.end(), 0);
+
+    // A background request stays on its one thread
+    const size_t budgetParallel =
+        executionClass == SUPERTONIC_CLASS_BACKGROUND ? 1 : (size_t)parallelRuns(engine);
+    size_t maxParallel = (size_t)engine->config.max_parallel_chunks;
+    if (maxParallel == 0 || maxParallel > budgetParallel) {
+        maxParallel = budgetParallel;
+    }
+    // The calling thread runs on the slot synthesize() took for it
+    RunSlots extraSlots(engine, std::min(maxParallel, chunksLeft) - 1);
+    const size_t numWorkers = 1 + extraSlots.count();
+    LOGD("Splitting %zu tokens into %zu chunks, %zu left, on %zu threads", tokens.size(), numChunks, chunksLeft,
+         numWorkers);
+
+    std::atomic<size_t> nextChunk{0};
+    std::atomic<bool> started{false};
+    std::atomic<bool> paused{false};
+    auto work = [&]() {
+        for (size_t c = nextChunk.fetch_add(1); c < numChunks && !paused.load(); c = nextChunk.fetch_add(1)) {
+            if (progress.done[c] != 0) {
+                continue;
+            }
+            // Nothing may escape: a worker thread would terminate the process,
+            // and so would the caller's while the workers are joinable
+            try {
+                // The first chunk always runs, so every call makes progress
+                if (started.exchange(true) && preemption != nullptr && preemption->yield && preemption->yield()) {
+                    paused.store(true);
+                    break;
+                }
+                const size_t begin = c == 0 ? 0 : chunkEnds[c - 1];
+                std::vector<int64_t> chunkTokens(tokens.begin() + begin, tokens.begin() + chunkEnds[c]);
+                if (timings != nullptr) {
+                    chunkTimings[c].tokens.assign(timings->tokens.begin() + begin,
+                                                  timings->tokens.begin() + chunkEnds[c]);
+                }
+                TraceScope span(engine, "chunk", requestId);
+                // Chunk 0 keeps the seed an unsplit input would use
+                chunkStatus[c] = runModels(engine, chunkTokens, progress.speakerId, progress.speed, true,
+                                           progress.numSteps, progress.seed + (unsigned int)c * 7919u, 0,
+                                           requestId, executionClass, chunkAudio[c], &progress.stats[c],
+                                           timings != nullptr ? &chunkTimings[c] : nullptr);
+            } catch (const std::bad_alloc&) {
+                chunkStatus[c] = SUPERTONIC_ERROR_OUT_OF_MEMORY;
+            } catch (...) {
+                LOGE("Unexpected exception in chunk %zu of request %llu", c, (unsigned long long)requestId);
+                chunkStatus[c] = SUPERTONIC_ERROR_INFERENCE;
+            }
+            progress.done[c] = chunkStatus[c] == SUPERTONIC_OK ? 1 : 0;
+        }
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(numWorkers);
+    for (size_t w = 1; w < numWorkers; w++) {
+        try {
+            workers.emplace_back(work);
+        } catch (const std::system_error&) {
+            LOGW("Could not start chunk thread %zu, continuing with fewer", w);
+            break;
+        }
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (size_t c = 0; c < numChunks; c++) {
+        if (chunkStatus[c] != SUPERTONIC_OK) {
+            return chunkStatus[c];
+        }
+    }
+    if (std::count(progress.done.begin(), progress.done.end(), 0) != 0) {
+        LOGD("Request %llu paused with %zu of %zu chunks done", (unsigned long long)requestId,
+             (size_t)std::count(progress.done.begin(), progress.done.end(), 1), numChunks);
+        preemption->suspended = std::move(state);
+        return SUPERTONIC_OK;
+    }
+    for (size_t c = 0; c < numChunks; c++) {
+        mergeChunkStats(stats, progress.stats[c]);
+    }
+
+    // Overlap each chunk's head with the previous tail
+    TraceScope joinSpan(engine, "join_chunks", requestId);
+    const size_t crossfade = (size_t)engine->config.chunk_crossfade_ms * SAMPLE_RATE / 1000;
+    audio = std::move(chunkAudio[0]);
+    if (timings != nullptr) {
+        std::copy(chunkTimings[0].tokens.begin(), chunkTimings[0].tokens.end(), timings->tokens.begin());
+        timings->approximate = chunkTimings[0].approximate;
+    }
+    for (size_t c = 1; c < numChunks; c++) {
+        const std::vector<float>& next = chunkAudio[c];
+        const size_t overlap = crossfadeOverlap(crossfade, audio.size(), next.size());
+        const size_t start = audio.size() - overlap;
+        for (size_t i = 0; i < overlap; i++) {
+            const float fadeIn = (float)(i + 1) / (float)(overlap + 1);
+            audio[start + i] = audio[start + i] * (1.0f - fadeIn) + next[i] * fadeIn;
+        }
+        audio.insert(audio.end(), next.begin() + overlap, next.end());
+
+        if (timings != nullptr) {
+            const size_t begin = chunkEnds[c - 1];
+            // The previous chunk's last token now ends where this one starts
+            SupertonicTokenTiming& last = timings->tokens[begin - 1];
+            last.end_sample = std::min<uint64_t>(last.end_sample, start);
+            last.start_sample = std::min(last.start_sample, last.end_sample);
+            for (size_t i = 0; i < chunkTimings[c].tokens.size(); i++) {
+                SupertonicTokenTiming& token = timings->tokens[begin + i];
+                token.start_sample = chunkTimings[c].tokens[i].start_sample + start;
+                token.end_sample = chunkTimings[c].tokens[i].end_sample + start;
+            }
+            timings->approximate = timings->approximate || chunkTimings[c].approximate;
+        }
+    }
+
+    stats->num_samples = audio.size();
+    stats->audio_bytes = audio.size() * sizeof(float);
+    stats->audio_seconds = (double)audio.size() / SAMPLE_RATE;
+    return SUPERTONIC_OK;
+}
+
+/**
+ * The pipeline proper. Fills the stage fields of stats; synthesize() owns
+ * the request id, totals, CPU time and history bookkeeping. Inputs split
+ * into chunks run to the end; only a single utterance can be preempted.
+ */
+static SupertonicStatus runPipeline(SupertonicEngine* engine,
+                                    const SupertonicSynthesisRequest& request,
+                                    std::vector<float>& audio,
+                                    SupertonicSynthesisStats* stats,
+                                    TokenTimings* timings,
+                                    Preemption* preemption) {
+    std::string inputText(request.text);
+    int speakerId = request.speaker_id;
+    const uint64_t requestId = stats->request_id;
+    const SupertonicExecutionClass executionClass = (SupertonicExecutionClass)request.execution_class;
+    const int numSteps = request.num_steps > 0 ? request.num_steps : DEFAULT_NUM_STEPS;
+    if (numSteps > SUPERTONIC_MAX_DIFFUSION_STEPS) {
+        LOGE("Invalid step count: %d (max %d)", numSteps, SUPERTONIC_MAX_DIFFUSION_STEPS);
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    if (!(request.speed > 0.0f) || !std::isfinite(request.speed)) {
+        LOGE("Invalid speed: %f", request.speed);
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+
+    LOGD("Synthesizing: '%s' (speaker=%d, speed=%.2f, steps=%d)", inputText.c_str(), speakerId, request.speed, numSteps);
+
+    // Step 1: Tokenize text
+    Clock::time_point stageStart = Clock::now();
+    std::vector<int64_t> tokens;
+    std::vector<uint32_t> offsets;
+    {
+        TraceScope span(engine, "tokenize", requestId);
+        tokens = tokenizeText(engine, inputText, &offsets);
+    }
+    stats->tokenize_ms = elapsedMs(stageStart);
+    if (tokens.empty()) {
+        LOGE("Failed to tokenize text");
+        return SUPERTONIC_ERROR_TOKENIZE;
+    }
+    stats->token_count = (int64_t)tokens.size();
+    LOGD("Tokenized %zu characters into %zu tokens", inputText.length(), tokens.size());
+
+    // Use deterministic seed for reproducibility (based on text hash)
+    unsigned int seed = 0;
+    for (size_t i = 0; i < inputText.length(); i++) {
+        seed = seed * 31 + inputText[i];
+    }
+
+    if (timings != nullptr) {
+        timings->tokens.assign(tokens.size(), SupertonicTokenTiming{});
+        for (size_t i = 0; i < tokens.size(); i++) {
+            const size_t end = i + 1 < offsets.size() ? offsets[i + 1] : inputText.length();
+            timings->tokens[i].text_offset = offsets[i];
+            timings->tokens[i].text_length = (uint32_t)(end - offsets[i]);
+        }
+    }
+
+    const size_t maxChunkTokens = (size_t)engine->config.max_chunk_tokens;
+    if (maxChunkTokens > 0 && tokens.size() > maxChunkTokens) {
+        auto state = std::make_shared<SuspendedSynthesis>();
+        state->chunks.reset(new ChunkProgress());
+        ChunkProgress& progress = *state->chunks;
+        progress.chunkEnds = splitChunks(inputText, offsets, maxChunkTokens);
+        progress.tokens = std::move(tokens);
+        progress.speakerId = speakerId;
+        progress.speed = request.speed;
+        progress.numSteps = numSteps;
+        progress.seed = seed;
+        progress.requestId = requestId;
+        const size_t numChunks = progress.chunkEnds.size();
+        progress.done.assign(numChunks, 0);
+        progress.audio.resize(numChunks);
+        progress.stats.assign(numChunks, SupertonicSynthesisStats{});
+        progress.timings.resize(numChunks);
+        return runChunks(engine, std::move(state), executionClass, audio, stats, timings, preemption);
+    }
+    stats->num_chunks = 1;
+    return runModels(engine, tokens, speakerId, request.speed, true, numSteps, seed, 0, requestId, executionClass,
+                     audio, stats, timings, preemption);
+}
+
+/**
+ * Call fn with sessionMutex held shared and all four sessions of the class
+ * loaded, reloading sessions released by supertonic_trim() (or creating
+ * the background ones on first use) first.
+ */
+template <typename Fn>
+static SupertonicStatus withLoadedSessions(SupertonicEngine* engine, Fn fn,
+                                           SupertonicExecutionClass executionClass = SUPERTONIC_CLASS_FOREGROUND) {
+    const bool background = executionClass == SUPERTONIC_CLASS_BACKGROUND;
+    for (;;) {
+        {
+            std::shared_lock<std::shared_mutex> sessionLock(engine->sessionMutex);
+            if (loadedSessionMask(engine) == kAllModels &&
+                (!background || backgroundSessionMask(engine) == kAllModels)) {
+                SupertonicStatus status = fn();
+                sessionLock.unlock();
+                settleXnnpack(engine);
+                return status;
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> reloadLock(engine->sessionMutex);
+        LOGI("Loading sessions (loaded mask 0x%x, background 0x%x)", loadedSessionMask(engine),
+             backgroundSessionMask(engine));
+        SupertonicStatus status =
+            createSessions(engine, engine->profiling.enabled.load() ? engine->profiling.outputDir : "");
+        if (status == SUPERTONIC_OK && background) {
+            status = createBackgroundSessions(engine);
+        }
+        if (status != SUPERTONIC_OK) {
+            return status;
+        }
+    }
+}
+
+SupertonicStatus synthesize(SupertonicEngine* engine,
+                            const SupertonicSynthesisRequest& request,
+                            std::vector<float>& audio,
+                            SupertonicSynthesisStats* stats,
+                            TokenTimings* timings,
+                            Preemption* preemption,
+                            bool holdsRunSlot) {
+    // Stats are always collected; they cost a few clock reads per stage
+    SupertonicSynthesisStats localStats;
+    if (stats == nullptr) {
+        stats = &localStats;
+    }
+    std::shared_ptr<SuspendedSynthesis> resumed;
+    if (preemption != nullptr) {
+        resumed = std::move(preemption->suspended);
+    }
+    const SupertonicExecutionClass executionClass = (SupertonicExecutionClass)request.execution_class;
+    if (resumed != nullptr) {
+        // The scheduler may have moved a paused background job to the
+        // foreground; chunks take the class with each call
+        resumed->diffusion.executionClass = executionClass;
+        *stats = resumed->stats;
+        stats->suspended_ms += elapsedMs(resumed->suspendedAt);
+        if (timings != nullptr) {
+            *timings = std::move(resumed->timings);
+        }
+    } else {
+        *stats = SupertonicSynthesisStats{};
+        stats->struct_size = sizeof(SupertonicSynthesisStats);
+        stats->request_id = request.request_id != 0
+            ? request.request_id
+            : engine->nextRequestId.fetch_add(1, std::memory_order_relaxed);
+    }
+    stats->execution_class = executionClass;
+    stats->intra_op_threads = executionClass == SUPERTONIC_CLASS_BACKGROUND ? 1 : engine->intraOpThreads;
+
+    // The calling thread runs a share of every operator, so it goes where
+    // its class's pool runs: background on the little cores, foreground
+    // off them. Left alone on a uniform CPU
+    const bool background = executionClass == SUPERTONIC_CLASS_BACKGROUND;
+    ScopedAffinity placement(!heterogeneousCores() ? std::vector<int>()
+                             : background       ? littleCores()
+                                                : bigCores());
+    stats->caller_cpus = cpuMask(currentThreadCpus());
+    stats->pool_cpus = background ? 0 : engine->poolCpus;
+
+    // Background calls run on the little cores, outside the budget
+    std::unique_ptr<RunSlots> runSlot;
+    if (!background && !holdsRunSlot) {
+        runSlot.reset(new RunSlots(engine));
+    }
+
+    const CpuTimes cpuStart = cpuTimesNow();
+    const Clock::time_point synthStart = Clock::now();
+
+    SupertonicStatus status = withLoadedSessions(engine, [&]() {
+        TraceScope span(engine, "synthesize", stats->request_id);
+        for (int m = 0; m < MODEL_COUNT; m++) {
+            stats->model_variant[m] = engine->modelVariants[m][engine->loadedVariant[m]].precision;
+        }
+        // A reload after trim can only fall back to another estimator file
+        // if the paused one fails to load; its tensors no longer fit then
+        if (resumed != nullptr && resumed->chunks == nullptr &&
+            resumed->diffusion.halfLatent != engine->halfIo[MODEL_VECTOR_ESTIMATOR]) {
+            LOGW("Estimator precision changed while request %llu was paused, starting over",
+                 (unsigned long long)stats->request_id);
+            resumed.reset();
+        }
+        SupertonicStatus pipelineStatus;
+        if (resumed == nullptr) {
+            pipelineStatus = runPipeline(engine, request, audio, stats, timings, preemption);
+        } else if (resumed->chunks != nullptr) {
+            pipelineStatus = runChunks(engine, std::move(resumed), executionClass, audio, stats, timings, preemption);
+        } else {
+            pipelineStatus = continueModels(engine, std::move(resumed), audio, stats, timings, preemption);
+        }
+        for (int m = 0; m < MODEL_COUNT; m++) {
+            const int xnnpack = engine->xnnpackState[m].load();
+            if (xnnpack == XNNPACK_ACCEPTED || xnnpack == XNNPACK_ACTIVE) {
+                stats->xnnpack_models |= 1u << m;
+            }
+        }
+        return pipelineStatus;
+    }, executionClass);
+    stats->caller_cpu = currentCpu();
+
+    uint64_t peak = engine->scratchPeakBytes.load(std::memory_order_relaxed);
+    while (stats->tensor_bytes_allocated > peak &&
+           !engine->scratchPeakBytes.compare_exchange_weak(peak, stats->tensor_bytes_allocated)) {
+    }
+
+    // Running time only; a paused synthesis adds up its slices
+    stats->total_ms += elapsedMs(synthStart);
+    const CpuTimes cpuEnd = cpuTimesNow();
+    stats->cpu_thread_user_ms += cpuEnd.threadUserMs - cpuStart.threadUserMs;
+    stats->cpu_thread_system_ms += cpuEnd.threadSystemMs - cpuStart.threadSystemMs;
+    stats->cpu_process_ms += cpuEnd.processMs - cpuStart.processMs;
+    if (status == SUPERTONIC_OK && preemption != nullptr && preemption->suspended != nullptr) {
+        SuspendedSynthesis& paused = *preemption->suspended;
+        stats->preemptions++;
+        paused.stats = *stats;
+        if (timings != nullptr) {
+            paused.timings = std::move(*timings);
+        }
+        paused.suspendedAt = Clock::now();
+        return SUPERTONIC_OK;
+    }
+    stats->status = status;
+    if (stats->audio_seconds > 0) {
+        stats->rtf = stats->total_ms / (stats->audio_seconds * 1000.0);
+    }
+
+    LOGD("Request %llu: %.1f ms (te %.1f, dp %.1f, ve %.1f, voc %.1f), RTF %.3f, cpu %.1f ms",
+         (unsigned long long)stats->request_id, stats->total_ms, stats->text_encoder_ms,
+         stats->duration_predictor_ms, stats->vector_estimator_ms, stats->vocoder_ms,
+         stats->rtf, stats->cpu_process_ms);
+
+    std::lock_guard<std::mutex> lock(engine->statsMutex);
+    engine->statsHistory.push_back(*stats);
+    while (engine->statsHistory.size() > SUPERTONIC_STATS_HISTORY) {
+        engine->statsHistory.pop_front();
+    }
+    return status;
+}
+
+// Representative segment sizes: a short phrase up to a long sentence
+static const int32_t kDefaultWarmupTokens[SUPERTONIC_WARMUP_DEFAULT_BUCKETS] = {16, 64, 160, 320};
+
+// Bound on warmup shapes (4096 latent frames is ~285 s of audio)
+static constexpr int32_t kMaxWarmupLength = 4096;
+
+/**
+ * Fill tokens with the default buckets and return how many: the shorter
+ * kDefaultWarmupTokens below max_chunk_tokens, then that length itself,
+ * the longest run of a chunked request. Longer shapes never occur then.
+ */
+static size_t defaultWarmupTokens(const SupertonicEngine* engine, int32_t* tokens) {
+    const int32_t longest = engine->config.max_chunk_tokens > 0
+        ? std::min(engine->config.max_chunk_tokens, kMaxWarmupLength)
+        : kDefaultWarmupTokens[SUPERTONIC_WARMUP_DEFAULT_BUCKETS - 1];
+    size_t count = 0;
+    for (int i = 0; i + 1 < SUPERTONIC_WARMUP_DEFAULT_BUCKETS && kDefaultWarmupTokens[i] < longest; i++) {
+        tokens[count++] = kDefaultWarmupTokens[i];
+    }
+    tokens[count++] = longest;
+    return count;
+}
+
+/** Token of a plain letter, so warmup inputs look like ordinary text. */
+static int64_t warmupToken(const SupertonicEngine* engine) {
+    auto it = engine->unicodeIndexer.find('a');
+    if (it != engine->unicodeIndexer.end()) {
+        return it->second;
+    }
+    return engine->unicodeIndexer.empty() ? 0 : engine->unicodeIndexer.begin()->second;
+}
+
+SupertonicStatus warmup(SupertonicEngine* engine, int speakerId,
+                        const int32_t* tokenCounts, const int32_t* latentLens, size_t numBuckets,
+                        double* outBucketMs) {
+    int32_t defaultTokens[SUPERTONIC_WARMUP_DEFAULT_BUCKETS];
+    if (numBuckets == 0) {
+        tokenCounts = defaultTokens;
+        latentLens = nullptr;
+        numBuckets = defaultWarmupTokens(engine, defaultTokens);
+        if (outBucketMs != nullptr) {
+            std::fill(outBucketMs, outBucketMs + SUPERTONIC_WARMUP_DEFAULT_BUCKETS, 0.0);
+        }
+    }
+    for (size_t i = 0; i < numBuckets; i++) {
+        const int32_t latentLen = latentLens != nullptr ? latentLens[i] : 0;
+        if (tokenCounts[i] < 1 || tokenCounts[i] > kMaxWarmupLength ||
+            latentLen < 0 || latentLen > kMaxWarmupLength) {
+            LOGE("Invalid warmup bucket %zu: %d tokens, latent %d", i, tokenCounts[i], latentLen);
+            return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+        }
+    }
+
+    const int64_t token = warmupToken(engine);
+    for (size_t i = 0; i < numBuckets; i++) {
+        // One diffusion step per bucket: the other steps run the same shapes
+        const uint64_t requestId = engine->nextRequestId.fetch_add(1, std::memory_order_relaxed);
+        const std::vector<int64_t> tokens(tokenCounts[i], token);
+        const int32_t latentLen = latentLens != nullptr ? latentLens[i] : 0;
+        SupertonicSynthesisStats stats{};
+        std::vector<float> audio;
+
+        // A bucket at a time, so queued requests wait for one at most
+        RunSlots runSlot(engine);
+        const Clock::time_point bucketStart = Clock::now();
+        SupertonicStatus status = withLoadedSessions(engine, [&]() {
+            TraceScope span(engine, "warmup", requestId);
+            // Throwaway tokens stay out of the text cache
+            return runModels(engine, tokens, speakerId, 1.0f, false, 1, (unsigned int)requestId, latentLen,
+                             requestId, SUPERTONIC_CLASS_FOREGROUND, audio, &stats, nullptr);
+        });
+        const double bucketMs = elapsedMs(bucketStart);
+        if (status != SUPERTONIC_OK) {
+            LOGE("Warmup bucket %zu failed: %s", i, supertonic_status_string(status));
+            return status;
+        }
+        if (outBucketMs != nullptr) {
+            outBucketMs[i] = bucketMs;
+        }
+        LOGI("Warmup bucket %zu: %d tokens, latent %lld: %.1f ms", i, tokenCounts[i],
+             (long long)stats.latent_len, bucketMs);
+    }
+    return SUPERTONIC_OK;
+}
+
+// Rows per duration predictor run when estimating; the model is small, so
+// this mostly bounds the padded [rows, seq_len] inputs
+static constexpr size_t kDurationBatchRows = 32;
+
+/**
+ * Run the duration predictor on rows of tokens padded to one length and
+ * append each row's total to sums. Rows must share the voice style.
+ */
+static SupertonicStatus predictDurationBatch(SupertonicEngine* engine,
+                                             const std::vector<const std::vector<int64_t>*>& rows,
+                                             const float* styleDp,
+                                             uint64_t requestId,
+                                             SupertonicSynthesisStats* stats,
+                                             std::vector<float>& sums) {
+    const int64_t batch = (int64_t)rows.size();
+    std::vector<int64_t> tokenCounts;
+    int64_t longest = 0;
+    for (const auto* row : rows) {
+        tokenCounts.push_back((int64_t)row->size());
+        longest = std::max(longest, (int64_t)row->size());
+    }
+    const int64_t seqLen = bucketLength(engine->config.token_buckets, longest);
+
+    std::vector<int64_t> tokenData(batch * seqLen, 0);
+    std::vector<float> maskData(batch * seqLen, 0.0f);
+    std::vector<float> styleData(batch * N_STYLE_DP * STYLE_DP_DIM);
+    for (int64_t b = 0; b < batch; b++) {
+        std::copy(rows[b]->begin(), rows[b]->end(), tokenData.begin() + b * seqLen);
+        std::fill(maskData.begin() + b * seqLen, maskData.begin() + b * seqLen + tokenCounts[b], 1.0f);
+        std::copy(styleDp, styleDp + N_STYLE_DP * STYLE_DP_DIM, styleData.begin() + b * N_STYLE_DP * STYLE_DP_DIM);
+    }
+
+    int64_t textShape[] = {batch, seqLen};
+    int64_t maskShape[] = {batch, 1, seqLen};
+    int64_t styleDpShape[] = {batch, N_STYLE_DP, STYLE_DP_DIM};
+    OrtValue* inputs[] = {
+        createTensor(engine, stats, tokenData.data(), tokenData.size() * sizeof(int64_t),
+                     textShape, 2, ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64),
+        createFloatTensor(engine, stats, MODEL_DURATION_PREDICTOR, styleData.data(), styleData.size(),
+                          styleDpShape, 3),
+        createFloatTensor(engine, stats, MODEL_DURATION_PREDICTOR, maskData.data(), maskData.size(),
+                          maskShape, 3),
+    };
+    if (inputs[0] == nullptr || inputs[1] == nullptr || inputs[2] == nullptr) {
+        releaseValues({inputs[0], inputs[1], inputs[2]});
+        return SUPERTONIC_ERROR_OUT_OF_MEMORY;
+    }
+
+    const char* inputNames[] = {"text_ids", "style_dp", "text_mask"};
+    const char* outputNames[] = {"duration"};
+    OrtValue* durations = nullptr;
+    OrtStatus* runStatus = nullptr;
+    {
+        TraceScope span(engine, "duration_predictor", requestId, MODEL_DURATION_PREDICTOR);
+        RunOptions runOptions(engine, requestId, MODEL_DURATION_PREDICTOR);
+        runStatus = runModel(engine, MODEL_DURATION_PREDICTOR, SUPERTONIC_CLASS_FOREGROUND, runOptions.get(),
+                             inputNames, (const OrtValue* const*)inputs, 3,
+                             outputNames, 1, &durations);
+    }
+    releaseValues({inputs[0], inputs[1], inputs[2]});
+    if (checkStatus(runStatus, "DurationPredictor Run")) {
+        return SUPERTONIC_ERROR_INFERENCE;
+    }
+
+    std::vector<float> batchSums;
+    const bool summed = sumDurations(durations, tokenCounts, seqLen, batchSums);
+    g_ortApi->ReleaseValue(durations);
+    if (!summed) {
+        return SUPERTONIC_ERROR_INFERENCE;
+    }
+    sums.insert(sums.end(), batchSums.begin(), batchSums.end());
+    return SUPERTONIC_OK;
+}
+
+SupertonicStatus estimateDurations(SupertonicEngine* engine, const std::vector<std::string>& texts,
+                                   int speakerId, float speed, double* outSeconds) {
+    if (!(speed > 0.0f) || !std::isfinite(speed)) {
+        LOGE("Invalid speed: %f", speed);
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    RunSlots runSlot(engine);
+    const uint64_t requestId = engine->nextRequestId.fetch_add(1, std::memory_order_relaxed);
+    TraceScope span(engine, "estimate_durations", requestId);
+    const Clock::time_point start = Clock::now();
+
+    // One row per sub-utterance synthesis would run, tagged with its text
+    std::vector<std::vector<int64_t>> tokens;
+    std::vector<size_t> rowText;
+    const size_t maxChunkTokens = (size_t)engine->config.max_chunk_tokens;
+    for (size_t i = 0; i < texts.size(); i++) {
+        std::vector<uint32_t> offsets;
+        std::vector<int64_t> textTokens = tokenizeText(engine, texts[i], &offsets);
+        outSeconds[i] = 0.0;  // no tokens, no audio
+        if (textTokens.empty()) {
+            continue;
+        }
+        std::vector<size_t> chunkEnds = maxChunkTokens > 0 && textTokens.size() > maxChunkTokens
+            ? splitChunks(texts[i], offsets, maxChunkTokens)
+            : std::vector<size_t>{textTokens.size()};
+        size_t begin = 0;
+        for (size_t end : chunkEnds) {
+            tokens.emplace_back(textTokens.begin() + begin, textTokens.begin() + end);
+            rowText.push_back(i);
+            begin = end;
+        }
+    }
+    std::vector<size_t> order(tokens.size());
+    for (size_t k = 0; k < order.size(); k++) {
+        order[k] = k;
+    }
+    // Similar lengths share a batch, so little of it is padding
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return tokens[a].size() < tokens[b].size(); });
+
+    std::shared_ptr<const VoiceStyle> voiceStyle = loadVoiceStyle(engine, speakerId);
+    const float* styleDp = (voiceStyle != nullptr ? *voiceStyle : fallbackStyle()).style_dp.data();
+
+    SupertonicSynthesisStats stats{};
+    std::vector<float> sums;
+    SupertonicStatus status = withLoadedSessions(engine, [&]() {
+        size_t batchRows = kDurationBatchRows;
+        for (size_t first = 0; first < order.size();) {
+            const size_t count = std::min(batchRows, order.size() - first);
+            std::vector<const std::vector<int64_t>*> rows;
+            for (size_t k = 0; k < count; k++) {
+                rows.push_back(&tokens[order[first + k]]);
+            }
+            SupertonicStatus batchStatus = predictDurationBatch(engine, rows, styleDp, requestId, &stats, sums);
+            if (batchStatus == SUPERTONIC_ERROR_INFERENCE && count > 1) {
+                // A model exported with a fixed batch of 1 still works row by row
+                LOGW("Batched duration prediction failed, retrying one row at a time");
+                batchRows = 1;
+                continue;
+            }
+            if (batchStatus != SUPERTONIC_OK) {
+                return batchStatus;
+            }
+            first += count;
+        }
+        return SUPERTONIC_OK;
+    });
+    if (status != SUPERTONIC_OK) {
+        return status;
+    }
+
+    // Report the length the audio will have: whole latent frames per
+    // sub-utterance, joined with the same crossfades as runChunks()
+    std::vector<size_t> rowSamples(tokens.size());
+    for (size_t k = 0; k < order.size(); k++) {
+        rowSamples[order[k]] = (size_t)latentLength(sums[k], speed) * CHUNK_SIZE;
+    }
+    std::vector<size_t> textSamples(texts.size(), 0);
+    const size_t crossfade = (size_t)engine->config.chunk_crossfade_ms * SAMPLE_RATE / 1000;
+    for (size_t row = 0; row < tokens.size(); row++) {
+        size_t& total = textSamples[rowText[row]];
+        total += rowSamples[row] - crossfadeOverlap(crossfade, total, rowSamples[row]);
+    }
+    for (size_t i = 0; i < texts.size(); i++) {
+        outSeconds[i] = (double)textSamples[i] / SAMPLE_RATE;
+    }
+    LOGI("Estimated %zu segment durations in %.1f ms", texts.size(), elapsedMs(start));
+    return SUPERTONIC_OK;
+}
+
+bool findStats(SupertonicEngine* engine, uint64_t requestId, SupertonicSynthesisStats& out) {
+    std::lock_guard<std::mutex> lock(engine->statsMutex);
+    // Newest first: ids supplied by callers may repeat
+    for (auto it = engine->statsHistory.rbegin(); it != engine->statsHistory.rend(); ++it) {
+        if (it->request_id == requestId) {
+            out = *it;
+            return true;
+        }
+    }
+    return false;
+}
+
+SupertonicStatus startProfiling(SupertonicEngine* engine, const std::string& outputDir) {
+    std::unique_lock<std::shared_mutex> lock(engine->sessionMutex);
+    if (engine->profiling.enabled.load()) {
+        LOGE("Profiling already enabled (%s)", engine->profiling.outputDir.c_str());
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    if (access(outputDir.c_str(), W_OK) != 0) {
+        LOGE("Profile directory not writable: %s", outputDir.c_str());
+        return SUPERTONIC_ERROR_IO;
+    }
+
+    releaseSessions(engine);
+    SupertonicStatus status = createSessions(engine, outputDir);
+    if (status != SUPERTONIC_OK) {
+        // Keep the engine usable without profiling
+        releaseSessions(engine);
+        if (createSessions(engine, "") != SUPERTONIC_OK) {
+            LOGE("Failed to restore sessions after profiling setup failed");
+        }
+        return status;
+    }
+
+    {
+        std::lock_guard<std::mutex> spansLock(engine->profiling.spansMutex);
+        engine->profiling.spans.clear();
+        engine->profiling.droppedSpans = 0;
+    }
+    engine->profiling.outputDir = outputDir;
+    engine->profiling.enabled.store(true);
+    LOGI("Profiling enabled, writing to %s", outputDir.c_str());
+    return SUPERTONIC_OK;
+}
+
+SupertonicStatus stopProfiling(SupertonicEngine* engine, std::string& tracePath) {
+    std::unique_lock<std::shared_mutex> lock(engine->sessionMutex);
+    if (!engine->profiling.enabled.load()) {
+        return SUPERTONIC_ERROR_NOT_FOUND;
+    }
+    engine->profiling.enabled.store(false);
+
+    std::vector<OrtProfile> profiles;
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        OrtSession* session = *sessionSlot(engine, (ModelId)m);
+        if (session == nullptr) {
+            continue;
+        }
+        uint64_t startNs = 0;
+        if (checkStatus(g_ortApi->SessionGetProfilingStartTimeNs(session, &startNs),
+                        "SessionGetProfilingStartTimeNs")) {
+            continue;
+        }
+        char* file = nullptr;
+        if (checkStatus(g_ortApi->SessionEndProfiling(session, engine->allocator, &file), "SessionEndProfiling") ||
+            file == nullptr) {
+            continue;
+        }
+        profiles.push_back(OrtProfile{(ModelId)m, startNs, file});
+        checkStatus(g_ortApi->AllocatorFree(engine->allocator, file), "AllocatorFree");
+    }
+
+    std::vector<TraceSpan> spans;
+    {
+        std::lock_guard<std::mutex> spansLock(engine->profiling.spansMutex);
+        spans.swap(engine->profiling.spans);
+        if (engine->profiling.droppedSpans > 0) {
+            LOGW("Dropped %zu trace spans over the buffer limit", engine->profiling.droppedSpans);
+        }
+    }
+    const bool written = writeChromeTrace(engine->profiling.outputDir, profiles, spans, tracePath);
+
+    releaseSessions(engine);
+    SupertonicStatus status = createSessions(engine, "");
+    if (status != SUPERTONIC_OK) {
+        return status;
+    }
+    return written ? SUPERTONIC_OK : SUPERTONIC_ERROR_IO;
+}
+
+void memoryReport(SupertonicEngine* engine, SupertonicMemoryReport& report) {
+    uint64_t sessionTotal = 0;
+    {
+        std::shared_lock<std::shared_mutex> lock(engine->sessionMutex);
+        report.sessions_loaded = loadedSessionMask(engine);
+        for (int m = 0; m < MODEL_COUNT; m++) {
+            report.session_bytes[m] = engine->sessionBytes[m] + engine->backgroundBytes[m] + engine->pooledBytes[m];
+            report.model_file_bytes[m] = fileBytes(modelPath(engine, (ModelId)m));
+            report.shared_weight_bytes[m] = engine->sharedWeights[m].bytes;
+            report.session_instances[m] = (uint32_t)engine->sessionInstances[m];
+            sessionTotal += report.session_bytes[m] + report.shared_weight_bytes[m];
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(engine->styleMutex);
+        report.cached_styles = (uint32_t)engine->voiceStyles.size();
+        report.style_cache_bytes = 0;
+        for (const auto& entry : engine->voiceStyles) {
+            report.style_cache_bytes +=
+                (entry.second->style_ttl.size() + entry.second->style_dp.size()) * sizeof(float) +
+                (entry.second->style_ttl_half.size() + entry.second->style_dp_half.size()) * sizeof(uint16_t);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(engine->textCacheMutex);
+        report.cached_texts = (uint32_t)engine->textCache.size();
+        report.text_cache_bytes = 0;
+        for (const auto& entry : engine->textCache) {
+            report.text_cache_bytes += entry->bytes;
+        }
+    }
+
+    report.scratch_peak_bytes = engine->scratchPeakBytes.load(std::memory_order_relaxed);
+    report.native_heap_bytes = nativeHeapBytes();
+    const uint64_t explained = sessionTotal + report.style_cache_bytes + report.text_cache_bytes;
+    report.arena_estimate_bytes = report.native_heap_bytes > explained
+        ? report.native_heap_bytes - explained
+        : 0;
+    report.process_rss_bytes = processRssBytes();
+}
+
+SupertonicStatus trimEngine(SupertonicEngine* engine, SupertonicTrimLevel level) {
+    if (level <= SUPERTONIC_TRIM_NONE) {
+        return SUPERTONIC_OK;
+    }
+    const uint64_t heapBefore = nativeHeapBytes();
+
+    // Arenas can only shrink at the end of a Run, so flag every model
+    for (auto& pending : engine->shrinkArenaPending) {
+        pending.store(true);
+    }
+    engine->scratchPeakBytes.store(0);
+
+    if (level >= SUPERTONIC_TRIM_CACHES) {
+        // In-flight calls keep their shared_ptr copies alive
+        {
+            std::lock_guard<std::mutex> lock(engine->styleMutex);
+            engine->voiceStyles.clear();
+        }
+        std::lock_guard<std::mutex> lock(engine->textCacheMutex);
+        engine->textCache.clear();
+    }
+
+    if (level >= SUPERTONIC_TRIM_LARGE_SESSIONS) {
+        uint32_t mask = level >= SUPERTONIC_TRIM_ALL_SESSIONS
+            ? kAllModels
+            : (1u << MODEL_VECTOR_ESTIMATOR) | (1u << MODEL_VOCODER);
+        std::unique_lock<std::shared_mutex> lock(engine->sessionMutex);
+        if (engine->profiling.enabled.load()) {
+            LOGW("Profiling active, keeping sessions loaded");
+        } else {
+            releaseSessions(engine, mask);
+        }
+    }
+
+    releaseFreeHeap();
+    const uint64_t heapAfter = nativeHeapBytes();
+    LOGI("Trim level %d: native heap %.1f MB -> %.1f MB", (int)level,
+         heapBefore / (1024.0 * 1024.0), heapAfter / (1024.0 * 1024.0));
+    return SUPERTONIC_OK;
+}
+
+} // namespace supertonic
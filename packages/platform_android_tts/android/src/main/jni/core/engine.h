@@ -0,0 +1,311 @@
+/*
+ * engine.h - Internal state of the Supertonic engine core
+ *
+ * Supertonic Pipeline:
+ * 1. text_encoder.onnx: Text tokens → hidden states
+ * 2. duration_predictor.onnx: Hidden states → durations
+ * 3. vector_estimator.onnx: Hidden + durations → latent vectors
+ * 4. vocoder.onnx: Latent vectors → audio samples
+ */
+
+#pragma once
+
+#include "model_variants.h"
+#include "ort_api.h"
+#include "perf_counters.h"
+#include "profiling.h"
+#include "scheduler.h"
+#include "shared_weights.h"
+#include "supertonic.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+namespace supertonic {
+
+// Constants from tts.json
+static constexpr int SAMPLE_RATE = 44100;           // ae.sample_rate
+static constexpr int BASE_CHUNK_SIZE = 512;         // ae.base_chunk_size
+static constexpr int CHUNK_COMPRESS_FACTOR = 6;     // ttl.chunk_compress_factor
+static constexpr int LATENT_DIM = 24;               // ttl.latent_dim
+static constexpr int LATENT_CHANNELS = LATENT_DIM * CHUNK_COMPRESS_FACTOR;  // 24 * 6 = 144
+static constexpr int CHUNK_SIZE = BASE_CHUNK_SIZE * CHUNK_COMPRESS_FACTOR;  // 512 * 6 = 3072
+
+// Voice style shapes from voice_styles/*.json
+static constexpr int N_STYLE_TTL = 50;
+static constexpr int STYLE_TTL_DIM = 256;
+static constexpr int N_STYLE_DP = 8;
+static constexpr int STYLE_DP_DIM = 16;
+
+static constexpr int NUM_SPEAKERS = 10;
+
+// Defaults for SupertonicEngineConfig / SupertonicSynthesisRequest
+static constexpr int DEFAULT_INTRA_OP_THREADS = 2;
+static constexpr int DEFAULT_NUM_STEPS = 5;  // 5 is default in reference implementation
+
+// Pace of request.speed = 1.0; the reference implementation divides the
+// predicted duration by 1.05
+static constexpr float BASE_SPEED = 1.05f;
+
+// Voice style cache entry: speaker_id -> {style_ttl, style_dp}
+struct VoiceStyle {
+    std::vector<float> style_ttl;  // [50 * 256] flattened
+    std::vector<float> style_dp;   // [8 * 16] flattened
+    // fp16 bits of the above; empty unless config.fp16_io is set
+    std::vector<uint16_t> style_ttl_half;
+    std::vector<uint16_t> style_dp_half;
+};
+
+/**
+ * Speed-independent text encoder and duration predictor results of one
+ * (speaker, tokens) pair. Immutable once cached; ORT allows the same
+ * input value in concurrent runs.
+ */
+struct TextCacheEntry {
+    int speakerId;
+    std::vector<int64_t> tokens;    // unpadded
+    std::shared_ptr<OrtValue> textEmb;  // [1, C, padded seq_len]
+    float durationSum;              // seconds at the model's own pace
+    std::vector<float> tokenDurations;  // per token, empty if the model emits totals only
+    uint64_t bytes;                 // text_emb plus tokens and durations
+};
+
+/**
+ * XNNPACK lifecycle of one model (config.xnnpack). A PENDING model has the
+ * CPU session in its slot and the XNNPACK candidate beside it until the
+ * first run compares them; the winner takes the slot under the exclusive
+ * session lock.
+ */
+enum XnnpackState : int {
+    XNNPACK_UNTESTED = 0,
+    XNNPACK_PENDING,     // both sessions loaded, not yet compared
+    XNNPACK_ACCEPTED,    // candidate won, waiting to move into the slot
+    XNNPACK_ACTIVE,      // slot holds the XNNPACK session
+    XNNPACK_REJECTED,    // unsupported, mismatching or slower; CPU only
+};
+
+/** Where each token of one synthesis plays; see SupertonicTimestamps. */
+struct TokenTimings {
+    std::vector<SupertonicTokenTiming> tokens;
+    bool approximate = false;
+};
+
+struct SuspendedSynthesis;
+
+/**
+ * Lets the caller of synthesize() pause it between diffusion steps. yield
+ * is asked after every step but the last (chunked input: before each
+ * chunk, see runChunks()); once it returns true, synthesize() returns
+ * SUPERTONIC_OK with no audio and the progress (tokens' text embedding,
+ * latent, next step, or the chunks done; stats so far) in suspended.
+ * Calling synthesize() again with the same Preemption continues from
+ * there, on any thread.
+ */
+struct Preemption {
+    std::function<bool()> yield;
+    std::shared_ptr<SuspendedSynthesis> suspended;
+};
+
+} // namespace supertonic
+
+/**
+ * Engine instance behind the opaque C handle.
+ *
+ * ONNX Runtime allows concurrent Run() calls on one session. Synthesis
+ * holds sessionMutex shared; toggling profiling, trimming and reloading
+ * released sessions take it exclusively.
+ */
+struct SupertonicEngine {
+    std::string modelBasePath;
+    SupertonicEngineConfig config;
+
+    OrtEnv* ortEnv = nullptr;
+    OrtMemoryInfo* memoryInfo = nullptr;
+    OrtAllocator* allocator = nullptr;
+    OrtSessionOptions* sessionOptions = nullptr;
+    // Resolved from config at create: total threads, threads per Run and
+    // whether sessions use the environment's global pool
+    int threadBudget = 1;
+    int intraOpThreads = 1;
+    bool globalThreadPool = false;
+    // Set when ORT refused a session because the environment, created
+    // earlier by another library, has no global pool
+    bool globalPoolMissing = false;
+    uint64_t poolCpus = 0;  // cores the pool threads may use (cpuMask), 0 = unplaced
+    // This engine registered the environment's shared CPU arena
+    bool sharedArena = false;
+
+    // Session pointers for Supertonic models (null while trimmed)
+    std::shared_mutex sessionMutex;
+    OrtSession* textEncoder = nullptr;
+    OrtSession* durationPredictor = nullptr;
+    OrtSession* vectorEstimator = nullptr;
+    OrtSession* vocoder = nullptr;
+    uint64_t sessionBytes[supertonic::MODEL_COUNT] = {};
+    // Float inputs and outputs of the model are fp16; fixed per model file
+    bool halfIo[supertonic::MODEL_COUNT] = {};
+
+    // config.share_weights: initializers and prepacked kernels of the file
+    // in use, shared by every session of the model; released with them
+    supertonic::SharedWeights sharedWeights[supertonic::MODEL_COUNT];
+
+    // config.session_pool_size: sessionInstances[m] - 1 more foreground
+    // sessions of the model beside its slot (instance 0). Bit i of
+    // sessionBusy is set while a Run holds instance i.
+    int sessionInstances[supertonic::MODEL_COUNT] = {};
+    OrtSession* pooledSession[supertonic::MODEL_COUNT][SUPERTONIC_MAX_SESSION_POOL - 1] = {};
+    uint64_t pooledBytes[supertonic::MODEL_COUNT] = {};
+    std::atomic<uint32_t> sessionBusy[supertonic::MODEL_COUNT] = {};
+
+    // SUPERTONIC_CLASS_BACKGROUND: single-threaded copies of the sessions
+    // from the same files, created on the first background request
+    OrtSessionOptions* backgroundOptions = nullptr;
+    OrtSession* backgroundSession[supertonic::MODEL_COUNT] = {};
+    uint64_t backgroundBytes[supertonic::MODEL_COUNT] = {};
+
+    // Files to try per model, fastest first, ending with <model>.onnx
+    // (read-only after create); loadedVariant indexes the one in use
+    std::vector<supertonic::ModelVariant> modelVariants[supertonic::MODEL_COUNT];
+    size_t loadedVariant[supertonic::MODEL_COUNT] = {};
+
+    // XNNPACK candidates under test; see XnnpackState
+    OrtSession* xnnpackSession[supertonic::MODEL_COUNT] = {};
+    std::atomic<int> xnnpackState[supertonic::MODEL_COUNT] = {};
+    std::atomic<bool> xnnpackVerifying[supertonic::MODEL_COUNT] = {};
+    std::atomic<bool> xnnpackSwapPending{false};
+
+    // Set by supertonic_trim(); consumed by the model's next run
+    std::atomic<bool> shrinkArenaPending[supertonic::MODEL_COUNT] = {};
+    std::atomic<uint64_t> scratchPeakBytes{0};
+
+    // Unicode indexer for text tokenization (read-only after create)
+    std::map<int32_t, int64_t> unicodeIndexer;
+
+    std::mutex styleMutex;
+    std::map<int, std::shared_ptr<const supertonic::VoiceStyle>> voiceStyles;
+
+    // Most recently used first, at most config.text_cache_entries
+    std::mutex textCacheMutex;
+    std::list<std::shared_ptr<const supertonic::TextCacheEntry>> textCache;
+
+    // Stats of the last SUPERTONIC_STATS_HISTORY calls, oldest first
+    std::atomic<uint64_t> nextRequestId{1};
+    std::mutex statsMutex;
+    std::deque<SupertonicSynthesisStats> statsHistory;
+
+    supertonic::ProfilingState profiling;
+    supertonic::PerfState perf;
+
+    // Jobs from supertonic_submit(), earliest deadline first
+    supertonic::SchedulerState scheduler;
+
+    // Foreground calls and chunk workers running now, at most
+    // parallelRuns() of them however they were started (see RunSlots)
+    std::mutex runSlotMutex;
+    std::condition_variable runSlotReleased;
+    int runSlotsUsed = 0;
+};
+
+namespace supertonic {
+
+SupertonicStatus createEngine(const std::string& corePath,
+                              const SupertonicEngineConfig& config,
+                              SupertonicEngine** outEngine);
+
+void destroyEngine(SupertonicEngine* engine);
+
+/**
+ * Synthesis calls the thread budget lets run side by side: each adds one
+ * thread to the shared pool, or a whole pool of its own per session.
+ */
+int parallelRuns(const SupertonicEngine* engine);
+
+/**
+ * Shares of parallelRuns() held for the lifetime of the object. Every
+ * foreground run (synthesize(), a warmup bucket, estimateDurations())
+ * holds one for its calling thread, and chunk workers take only what is
+ * spare, so they all together never run more than the budget allows.
+ */
+class RunSlots {
+public:
+    /** Wait for one slot. */
+    explicit RunSlots(SupertonicEngine* engine);
+    /** Take up to wanted slots without waiting; count() may be 0. */
+    RunSlots(SupertonicEngine* engine, size_t wanted);
+    ~RunSlots();
+
+    RunSlots(const RunSlots&) = delete;
+    RunSlots& operator=(const RunSlots&) = delete;
+
+    size_t count() const { return (size_t)count_; }
+
+private:
+    SupertonicEngine* engine_;
+    int count_ = 0;
+};
+
+/** A RunSlots(engine) would not have to wait right now. */
+bool runSlotFree(SupertonicEngine* engine);
+
+/**
+ * Run tokenize → text encoder → duration predictor → diffusion → vocoder.
+ * On success audio holds mono samples at SAMPLE_RATE, stats (if not null)
+ * the full-size per-stage timings and timings (if not null) the sample
+ * range of every token. preemption (if not null) may pause the call; see
+ * Preemption. A foreground call waits for a RunSlots share unless the
+ * caller already holds one for it (holdsRunSlot).
+ */
+SupertonicStatus synthesize(SupertonicEngine* engine,
+                            const SupertonicSynthesisRequest& request,
+                            std::vector<float>& audio,
+                            SupertonicSynthesisStats* stats,
+                            TokenTimings* timings = nullptr,
+                            Preemption* preemption = nullptr,
+                            bool holdsRunSlot = false);
+
+/**
+ * Run the four models once per bucket with throwaway input of the given
+ * token count and latent length (0 = as predicted); see supertonic_warmup().
+ */
+SupertonicStatus warmup(SupertonicEngine* engine, int speakerId,
+                        const int32_t* tokenCounts, const int32_t* latentLens, size_t numBuckets,
+                        double* outBucketMs);
+
+/**
+ * Predict the audio length of each text in seconds without synthesizing;
+ * see supertonic_estimate_durations().
+ */
+SupertonicStatus estimateDurations(SupertonicEngine* engine, const std::vector<std::string>& texts,
+                                   int speakerId, float speed, double* outSeconds);
+
+/** Copy the recorded stats of requestId; false if no longer in the history. */
+bool findStats(SupertonicEngine* engine, uint64_t requestId, SupertonicSynthesisStats& out);
+
+/**
+ * Recreate all sessions with ORT profiling writing into outputDir and start
+ * recording engine stage spans. Blocks until in-flight calls finish.
+ */
+SupertonicStatus startProfiling(SupertonicEngine* engine, const std::string& outputDir);
+
+/**
+ * End the ORT profiles, write the merged Chrome trace and recreate the
+ * sessions without profiling. tracePath receives the written file.
+ */
+SupertonicStatus stopProfiling(SupertonicEngine* engine, std::string& tracePath);
+
+void memoryReport(SupertonicEngine* engine, SupertonicMemoryReport& report);
+
+/** Apply a SupertonicTrimLevel; see supertonic_trim(). */
+SupertonicStatus trimEngine(SupertonicEngine* engine, SupertonicTrimLevel level);
+
+} // namespace supertonic
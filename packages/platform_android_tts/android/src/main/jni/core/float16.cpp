@@ -0,0 +1,70 @@
+/*
+ * float16.cpp - fp32 <-> IEEE half conversion for fp16 model inputs/outputs
+ *
+ * Uses the hardware conversion instructions where the target has them
+ * (AArch64 NEON, x86 F16C) and the bit-exact scalar routines from
+ * onnxruntime_float16.h for the tail and everywhere else.
+ */
+
+#include "float16.h"
+
+#include <onnxruntime_float16.h>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+namespace supertonic {
+
+namespace {
+
+// Exposes the conversions of ORT's CRTP base without the C++ API header
+struct Half : onnxruntime_float16::Float16Impl<Half> {
+    static uint16_t fromFloat(float v) noexcept { return ToUint16Impl(v); }
+
+    static float toFloat(uint16_t bits) noexcept {
+        Half h;
+        h.val = bits;
+        return h.ToFloatImpl();
+    }
+};
+
+} // namespace
+
+void floatToHalf(const float* in, uint16_t* out, size_t count) {
+    size_t i = 0;
+#if defined(__aarch64__)
+    for (; i + 4 <= count; i += 4) {
+        vst1_u16(out + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(in + i))));
+    }
+#elif defined(__F16C__)
+    for (; i + 8 <= count; i += 8) {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), h);
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = Half::fromFloat(in[i]);
+    }
+}
+
+void halfToFloat(const uint16_t* in, float* out, size_t count) {
+    size_t i = 0;
+#if defined(__aarch64__)
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(out + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(in + i))));
+    }
+#elif defined(__F16C__)
+    for (; i + 8 <= count; i += 8) {
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm256_storeu_ps(out + i, _mm256_cvtph_ps(h));
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = Half::toFloat(in[i]);
+    }
+}
+
+} // namespace supertonic
@@ -0,0 +1,18 @@
+/*
+ * float16.h - fp32 <-> IEEE half conversion for fp16 model inputs/outputs
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace supertonic {
+
+/** Round count floats to half precision (nearest even). */
+void floatToHalf(const float* in, uint16_t* out, size_t count);
+
+/** Widen count half precision values to float. */
+void halfToFloat(const uint16_t* in, float* out, size_t count);
+
+} // namespace supertonic
@@ -0,0 +1,53 @@
+/*
+ * log.h - Logging macros shared by the engine core and the JNI shim
+ *
+ * On Android these forward to logcat. On desktop builds they write to
+ * stderr; debug messages are only printed when SUPERTONIC_VERBOSE is set
+ * so benchmarks are not flooded with per-segment output.
+ */
+
+#pragma once
+
+#define LOG_TAG "SupertonicNative"
+
+#ifdef __ANDROID__
+
+#include <android/log.h>
+
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+
+#else
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace supertonic {
+
+inline bool verboseLoggingEnabled() {
+    static const bool enabled = std::getenv("SUPERTONIC_VERBOSE") != nullptr;
+    return enabled;
+}
+
+} // namespace supertonic
+
+#define SUPERTONIC_LOG_PRINT(level, ...)                    \
+    do {                                                    \
+        std::fprintf(stderr, level "/" LOG_TAG ": ");       \
+        std::fprintf(stderr, __VA_ARGS__);                  \
+        std::fputc('\n', stderr);                           \
+    } while (0)
+
+#define LOGI(...) SUPERTONIC_LOG_PRINT("I", __VA_ARGS__)
+#define LOGW(...) SUPERTONIC_LOG_PRINT("W", __VA_ARGS__)
+#define LOGE(...) SUPERTONIC_LOG_PRINT("E", __VA_ARGS__)
+#define LOGD(...)                                           \
+    do {                                                    \
+        if (supertonic::verboseLoggingEnabled()) {          \
+            SUPERTONIC_LOG_PRINT("D", __VA_ARGS__);         \
+        }                                                   \
+    } while (0)
+
+#endif
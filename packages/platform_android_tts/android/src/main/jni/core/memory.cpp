@@ -0,0 +1,67 @@
+/*
+ * memory.cpp - mallinfo / procfs based memory probes
+ */
+
+#include "memory.h"
+
+#include <cstdio>
+#include <malloc.h>
+#include <unistd.h>
+
+namespace supertonic {
+
+uint64_t nativeHeapBytes() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+    return (uint64_t)info.uordblks + (uint64_t)info.hblkhd;
+#else
+    // bionic (scudo/jemalloc) reports in-use bytes in uordblks
+    struct mallinfo info = mallinfo();
+    return (uint64_t)(size_t)info.uordblks + (uint64_t)(size_t)info.hblkhd;
+#endif
+}
+
+uint64_t processRssBytes() {
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (f == nullptr) {
+        return 0;
+    }
+    unsigned long long sizePages = 0;
+    unsigned long long residentPages = 0;
+    int matched = fscanf(f, "%llu %llu", &sizePages, &residentPages);
+    fclose(f);
+    if (matched != 2) {
+        return 0;
+    }
+    return (uint64_t)residentPages * (uint64_t)sysconf(_SC_PAGESIZE);
+}
+
+uint64_t availableMemoryBytes() {
+    FILE* f = fopen("/proc/meminfo", "r");
+    if (f == nullptr) {
+        return 0;
+    }
+    char line[128];
+    unsigned long long kb = 0;
+    while (fgets(line, sizeof(line), f) != nullptr) {
+        if (sscanf(line, "MemAvailable: %llu kB", &kb) == 1) {
+            break;
+        }
+    }
+    fclose(f);
+    return (uint64_t)kb * 1024;
+}
+
+void releaseFreeHeap() {
+#if defined(__ANDROID__)
+    // mallopt() exists from API 26 and honours M_PURGE from 28; below
+    // minSdk's level it is a weak reference (see CMakeLists.txt)
+    if (__builtin_available(android 28, *)) {
+        mallopt(M_PURGE, 0);
+    }
+#elif defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+}
+
+} // namespace supertonic
@@ -0,0 +1,23 @@
+/*
+ * memory.h - Process memory probes used by the native memory report
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace supertonic {
+
+/** Bytes currently allocated from the native (malloc) heap, whole process. */
+uint64_t nativeHeapBytes();
+
+/** Resident set size of the process in bytes, 0 if unavailable. */
+uint64_t processRssBytes();
+
+/** MemAvailable of the system in bytes, 0 if unavailable. */
+uint64_t availableMemoryBytes();
+
+/** Return freed heap pages to the OS where the allocator supports it. */
+void releaseFreeHeap();
+
+} // namespace supertonic
@@ -0,0 +1,139 @@
+/*
+ * model_variants.cpp - onnx/variants.txt parsing and per-CPU ranking
+ */
+
+#include "model_variants.h"
+#include "cpu_features.h"
+#include "log.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace supertonic {
+
+static bool parsePrecision(const std::string& name, SupertonicModelVariant& out) {
+    static const SupertonicModelVariant kPrecisions[] = {
+        SUPERTONIC_VARIANT_FP32, SUPERTONIC_VARIANT_FP16,
+        SUPERTONIC_VARIANT_INT8_DYNAMIC, SUPERTONIC_VARIANT_INT8_QDQ,
+    };
+    for (SupertonicModelVariant precision : kPrecisions) {
+        if (name == variantName(precision)) {
+            out = precision;
+            return true;
+        }
+    }
+    return false;
+}
+
+static int modelIndex(const std::string& name) {
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        if (name == modelName((ModelId)m)) {
+            return m;
+        }
+    }
+    return -1;
+}
+
+void loadVariantManifest(const std::string& path, std::vector<ModelVariant> (&variants)[MODEL_COUNT]) {
+    for (auto& list : variants) {
+        list.clear();
+    }
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return;  // optional: every model uses <model>.onnx
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        const size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        std::istringstream fields(line);
+        std::string model;
+        std::string precision;
+        ModelVariant variant;
+        if (!(fields >> model)) {
+            continue;  // blank or comment
+        }
+        const int m = modelIndex(model);
+        if (m < 0 || !(fields >> precision >> variant.file) || !parsePrecision(precision, variant.precision) ||
+            variant.file.find('/') != std::string::npos) {
+            LOGW("variants.txt:%d: expected '<model> <precision> <file> [features...]'", lineNumber);
+            continue;
+        }
+        std::string feature;
+        bool known = true;
+        while (fields >> feature) {
+            const uint32_t bit = cpuFeatureBit(feature);
+            if (bit == 0) {
+                LOGW("variants.txt:%d: unknown CPU feature '%s', skipping %s", lineNumber, feature.c_str(),
+                     variant.file.c_str());
+                known = false;
+                break;
+            }
+            variant.requiredFeatures |= bit;
+        }
+        if (known) {
+            variants[m].push_back(std::move(variant));
+        }
+    }
+}
+
+/** Expected speed of a variant on this CPU, higher is faster; < 0 = do not use. */
+static int variantScore(SupertonicModelVariant precision, uint32_t features, bool preferHalf) {
+    const bool int8Dot = (features & (SUPERTONIC_CPU_DOTPROD | SUPERTONIC_CPU_I8MM |
+                                      SUPERTONIC_CPU_AVX512VNNI | SUPERTONIC_CPU_AVXVNNI)) != 0;
+    switch (precision) {
+        case SUPERTONIC_VARIANT_INT8_QDQ:
+            // Without dot-product instructions QDQ kernels widen to int16
+            if (!int8Dot) return 15;
+            return (features & SUPERTONIC_CPU_I8MM) != 0 ? 55 : 50;
+        case SUPERTONIC_VARIANT_INT8_DYNAMIC:
+            return int8Dot ? 40 : 20;
+        case SUPERTONIC_VARIANT_FP16:
+            if (preferHalf) return 100;
+            // ORT's CPU fp16 kernels need ARMv8.2 fp16 arithmetic; elsewhere
+            // the graph is wrapped in casts and ends up slower than fp32
+            return (features & SUPERTONIC_CPU_ASIMDHP) != 0 ? 30 : -1;
+        case SUPERTONIC_VARIANT_FP32:
+            return 10;
+        case SUPERTONIC_VARIANT_DEFAULT:
+            return 0;
+    }
+    return -1;
+}
+
+std::vector<ModelVariant> rankVariants(const std::vector<ModelVariant>& variants, uint32_t features,
+                                       bool preferHalf) {
+    std::vector<std::pair<int, ModelVariant>> scored;
+    for (const ModelVariant& variant : variants) {
+        const int score = variantScore(variant.precision, features, preferHalf);
+        if (score >= 0 && (variant.requiredFeatures & ~features) == 0) {
+            scored.emplace_back(score, variant);
+        }
+    }
+    std::stable_sort(scored.begin(), scored.end(),
+                     [](const auto& a, const auto& b) { return a.first > b.first; });
+    std::vector<ModelVariant> ranked;
+    for (auto& entry : scored) {
+        ranked.push_back(std::move(entry.second));
+    }
+    return ranked;
+}
+
+const char* variantName(SupertonicModelVariant precision) {
+    switch (precision) {
+        case SUPERTONIC_VARIANT_DEFAULT: return "default";
+        case SUPERTONIC_VARIANT_FP32: return "fp32";
+        case SUPERTONIC_VARIANT_FP16: return "fp16";
+        case SUPERTONIC_VARIANT_INT8_DYNAMIC: return "int8_dynamic";
+        case SUPERTONIC_VARIANT_INT8_QDQ: return "int8_qdq";
+    }
+    return "unknown";
+}
+
+} // namespace supertonic
@@ -0,0 +1,40 @@
+/*
+ * model_variants.h - Per-model choice among fp32 / fp16 / int8 files
+ */
+
+#pragma once
+
+#include "profiling.h"
+#include "supertonic.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace supertonic {
+
+/** One file of a model, as listed in onnx/variants.txt. */
+struct ModelVariant {
+    SupertonicModelVariant precision = SUPERTONIC_VARIANT_DEFAULT;
+    std::string file;               // relative to onnx/
+    uint32_t requiredFeatures = 0;  // SupertonicCpuFeature bits
+};
+
+/**
+ * Read onnx/variants.txt into one list per model, in file order. A missing
+ * manifest leaves the lists empty; malformed lines are logged and skipped.
+ */
+void loadVariantManifest(const std::string& path, std::vector<ModelVariant> (&variants)[MODEL_COUNT]);
+
+/**
+ * Variants the CPU with the given features can run, fastest first:
+ * int8 with dot-product instructions, then fp16 where the CPU has fp16
+ * arithmetic, then dynamic int8 and fp32. preferHalf (fp16_io) moves fp16
+ * variants to the front whatever the CPU.
+ */
+std::vector<ModelVariant> rankVariants(const std::vector<ModelVariant>& variants, uint32_t features,
+                                       bool preferHalf);
+
+const char* variantName(SupertonicModelVariant precision);
+
+} // namespace supertonic
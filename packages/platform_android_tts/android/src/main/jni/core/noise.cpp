@@ -0,0 +1,29 @@
+/*
+ * noise.cpp - Seeded Gaussian noise for the initial diffusion latent
+ */
+
+#include "noise.h"
+
+#include <cmath>
+#include <random>
+
+namespace supertonic {
+
+void fillGaussianNoise(unsigned int seed, float* out, size_t count) {
+    // mt19937's output sequence is fixed by the standard, unlike the
+    // distributions, so the uniforms are derived by hand to match across
+    // C++ runtimes
+    std::mt19937 generator(seed);
+    constexpr double kRange = 4294967296.0;  // 2^32
+    for (size_t i = 0; i < count; i += 2) {
+        const double u1 = ((double)generator() + 1.0) / (kRange + 1.0);  // (0, 1], log-safe
+        const double u2 = (double)generator() / kRange;                  // [0, 1)
+        const double radius = std::sqrt(-2.0 * std::log(u1));
+        out[i] = (float)(radius * std::cos(2.0 * M_PI * u2));
+        if (i + 1 < count) {
+            out[i + 1] = (float)(radius * std::sin(2.0 * M_PI * u2));
+        }
+    }
+}
+
+} // namespace supertonic
@@ -0,0 +1,18 @@
+/*
+ * noise.h - Seeded Gaussian noise for the initial diffusion latent
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace supertonic {
+
+/**
+ * Fill out with count standard normal samples (Box-Muller) drawn from a
+ * generator private to this call, so the same seed gives the same noise
+ * however many syntheses run concurrently.
+ */
+void fillGaussianNoise(unsigned int seed, float* out, size_t count);
+
+} // namespace supertonic
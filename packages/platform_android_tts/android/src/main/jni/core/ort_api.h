@@ -0,0 +1,22 @@
+/*
+ * ort_api.h - ONNX Runtime C API declarations
+ *
+ * The engine never links against libonnxruntime.so directly; it resolves
+ * OrtGetApiBase with dlsym at runtime (see ort_runtime.cpp). The type and
+ * function table declarations come from the official v17 header vendored
+ * with the iOS framework (SUPERTONIC_ORT_INCLUDE_DIR in CMakeLists.txt),
+ * which matches the ONNX Runtime bundled with sherpa-onnx.
+ */
+
+#pragma once
+
+#include <onnxruntime_c_api.h>
+
+static_assert(ORT_API_VERSION >= 17, "ONNX Runtime headers must be v17 or newer");
+
+namespace supertonic {
+
+// API version requested from the runtime (matches sherpa-onnx bundled version)
+constexpr uint32_t kOrtApiVersion = 17;
+
+} // namespace supertonic
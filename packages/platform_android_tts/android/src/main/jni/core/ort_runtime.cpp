@@ -0,0 +1,101 @@
+/*
+ * ort_runtime.cpp - dlopen/dlsym binding to libonnxruntime.so
+ */
+
+#include "ort_runtime.h"
+#include "log.h"
+
+#include <dlfcn.h>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+
+#ifndef SUPERTONIC_ORT_LIBRARY
+#define SUPERTONIC_ORT_LIBRARY "libonnxruntime.so"
+#endif
+
+namespace supertonic {
+
+const OrtApi* g_ortApi = nullptr;
+
+static void* g_ortLibHandle = nullptr;
+static std::mutex g_ortInitMutex;
+
+static void* openOrtLibrary() {
+    const char* override = std::getenv("SUPERTONIC_ORT_LIBRARY");
+    const char* candidates[] = {override, SUPERTONIC_ORT_LIBRARY, "libonnxruntime.so.1"};
+    std::string lastError = "no candidate library name";
+
+    for (const char* name : candidates) {
+        if (name == nullptr || name[0] == '\0') {
+            continue;
+        }
+        // Prefer a handle to an already-loaded copy (sherpa-onnx on Android)
+        void* handle = dlopen(name, RTLD_NOW | RTLD_NOLOAD);
+        if (handle == nullptr) {
+            handle = dlopen(name, RTLD_NOW);
+        }
+        if (handle != nullptr) {
+            LOGI("Successfully loaded %s", name);
+            return handle;
+        }
+        const char* err = dlerror();
+        lastError = err != nullptr ? err : name;
+    }
+    LOGE("Failed to load libonnxruntime.so: %s", lastError.c_str());
+    return nullptr;
+}
+
+bool initOrtApi() {
+    std::lock_guard<std::mutex> lock(g_ortInitMutex);
+    if (g_ortApi != nullptr) {
+        return true;
+    }
+
+    g_ortLibHandle = openOrtLibrary();
+    if (g_ortLibHandle == nullptr) {
+        return false;
+    }
+
+    // Get OrtGetApiBase function
+    typedef const OrtApiBase* (*OrtGetApiBaseFunc)();
+    auto getApiBase = (OrtGetApiBaseFunc)dlsym(g_ortLibHandle, "OrtGetApiBase");
+    if (getApiBase == nullptr) {
+        LOGE("Failed to find OrtGetApiBase: %s", dlerror());
+        return false;
+    }
+
+    // Get API base and then the API
+    const OrtApiBase* apiBase = getApiBase();
+    if (apiBase == nullptr) {
+        LOGE("OrtGetApiBase returned null");
+        return false;
+    }
+
+    // Log version for debugging
+    const char* version = apiBase->GetVersionString();
+    LOGI("ONNX Runtime version: %s", version);
+
+    // Get API version 17 (matches sherpa-onnx bundled version)
+    g_ortApi = apiBase->GetApi(kOrtApiVersion);
+
+    if (g_ortApi == nullptr) {
+        LOGE("Failed to get ORT API v%u", kOrtApiVersion);
+        return false;
+    }
+
+    LOGI("ONNX Runtime API v%u initialized successfully", kOrtApiVersion);
+    return true;
+}
+
+bool checkStatus(OrtStatus* status, const char* operation) {
+    if (status != nullptr) {
+        const char* msg = g_ortApi->GetErrorMessage(status);
+        LOGE("ONNX Runtime error during %s: %s", operation, msg);
+        g_ortApi->ReleaseStatus(status);
+        return true;
+    }
+    return false;
+}
+
+} // namespace supertonic
@@ -0,0 +1,28 @@
+/*
+ * ort_runtime.h - Runtime binding to the ONNX Runtime shared library
+ */
+
+#pragma once
+
+#include "ort_api.h"
+
+namespace supertonic {
+
+// Resolved by initOrtApi(); valid for the lifetime of the process once set.
+extern const OrtApi* g_ortApi;
+
+/**
+ * Resolve the ONNX Runtime API from libonnxruntime.so.
+ *
+ * On Android the library is already loaded by sherpa-onnx. On desktop the
+ * SUPERTONIC_ORT_LIBRARY environment variable overrides the library path.
+ */
+bool initOrtApi();
+
+/**
+ * Check if a status indicates an error, log it, and free the status.
+ * Returns true if there was an error.
+ */
+bool checkStatus(OrtStatus* status, const char* operation);
+
+} // namespace supertonic
@@ -0,0 +1,229 @@
+/*
+ * perf_counters.cpp - perf_event_open groups, pool thread discovery and stage scopes
+ */
+
+#include "perf_counters.h"
+#include "engine.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace supertonic {
+
+#if defined(__linux__)
+
+namespace {
+
+struct EventSpec {
+    uint32_t type;
+    uint64_t config;
+    bool kernel;  // switches happen in the kernel; the rest count user code only
+};
+
+// Indexed by SupertonicPerfCounter; hardware first so one leads the group
+const EventSpec kEvents[SUPERTONIC_NUM_PERF_COUNTERS] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, false},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, false},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, false},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, false},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, true},
+};
+
+int openEvent(const EventSpec& event, int tid, int groupFd) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.exclude_kernel = event.kernel ? 0 : 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, tid, -1, groupFd, PERF_FLAG_FD_CLOEXEC);
+}
+
+int currentTid() {
+    return (int)syscall(SYS_gettid);
+}
+
+} // namespace
+
+PerfGroup::PerfGroup(int tid) : tid_(tid != 0 ? tid : currentTid()) {
+    for (int c = 0; c < SUPERTONIC_NUM_PERF_COUNTERS; c++) {
+        const int fd = openEvent(kEvents[c], tid_, leader_);
+        if (fd < 0) {
+            continue;
+        }
+        if (leader_ < 0) {
+            leader_ = fd;
+        }
+        fds_[opened_] = fd;
+        order_[opened_] = c;
+        opened_++;
+        mask_ |= 1u << c;
+    }
+}
+
+PerfGroup::~PerfGroup() {
+    // Members first; closing the leader would orphan them into groups of one
+    for (int i = opened_ - 1; i >= 0; i--) {
+        close(fds_[i]);
+    }
+}
+
+bool PerfGroup::read(PerfReading& out) const {
+    if (leader_ < 0) {
+        return false;
+    }
+    // nr, time_enabled, time_running, then one value per opened event
+    uint64_t buffer[3 + SUPERTONIC_NUM_PERF_COUNTERS];
+    const ssize_t bytes = ::read(leader_, buffer, sizeof(buffer));
+    if (bytes < (ssize_t)(3 * sizeof(uint64_t)) || buffer[0] != (uint64_t)opened_ ||
+        bytes < (ssize_t)((3 + opened_) * sizeof(uint64_t))) {
+        return false;
+    }
+    out.valid = true;
+    out.enabledNs = buffer[1];
+    out.runningNs = buffer[2];
+    for (int i = 0; i < opened_; i++) {
+        out.value[order_[i]] = buffer[3 + i];
+    }
+    return true;
+}
+
+std::vector<int> processThreads() {
+    std::vector<int> tids;
+    DIR* dir = opendir("/proc/self/task");
+    if (dir == nullptr) {
+        return tids;
+    }
+    while (dirent* entry = readdir(dir)) {
+        const int tid = atoi(entry->d_name);
+        if (tid > 0) {
+            tids.push_back(tid);
+        }
+    }
+    closedir(dir);
+    std::sort(tids.begin(), tids.end());
+    return tids;
+}
+
+void updateWorkerThreads(PerfState& state, const std::vector<int>& before, const std::vector<int>& after) {
+    // Threads of released sessions have exited; their counters only read 0
+    const std::vector<int> alive = processThreads();
+    state.workers.erase(std::remove_if(state.workers.begin(), state.workers.end(),
+                                       [&](const std::unique_ptr<PerfGroup>& group) {
+                                           return !std::binary_search(alive.begin(), alive.end(), group->tid());
+                                       }),
+                        state.workers.end());
+    for (int tid : after) {
+        if (std::binary_search(before.begin(), before.end(), tid)) {
+            continue;
+        }
+        std::unique_ptr<PerfGroup> group(new PerfGroup(tid));
+        if (group->mask() != 0) {
+            state.workers.push_back(std::move(group));
+        }
+    }
+}
+
+#else
+
+PerfGroup::PerfGroup(int tid) : tid_(tid) {}
+
+PerfGroup::~PerfGroup() {}
+
+bool PerfGroup::read(PerfReading& out) const {
+    (void)out;
+    return false;
+}
+
+std::vector<int> processThreads() {
+    return {};
+}
+
+void updateWorkerThreads(PerfState& state, const std::vector<int>& before, const std::vector<int>& after) {
+    (void)state;
+    (void)before;
+    (void)after;
+}
+
+#endif
+
+namespace {
+
+/** The calling thread's group, opened on its first counted run. */
+const PerfGroup* callerGroup() {
+    thread_local std::unique_ptr<PerfGroup> group;
+    if (!group) {
+        group.reset(new PerfGroup(0));
+    }
+    return group.get();
+}
+
+/** end - start per counter, scaled up by the share of time the group was multiplexed out. */
+void addDelta(const PerfReading& start, const PerfReading& end, SupertonicPerfCounts& counts) {
+    const uint64_t enabled = end.enabledNs - start.enabledNs;
+    const uint64_t running = end.runningNs - start.runningNs;
+    const double scale = running > 0 && running < enabled ? (double)enabled / (double)running : 1.0;
+    for (int c = 0; c < SUPERTONIC_NUM_PERF_COUNTERS; c++) {
+        counts.count[c] += (uint64_t)((double)(end.value[c] - start.value[c]) * scale);
+    }
+}
+
+} // namespace
+
+PerfScope::PerfScope(SupertonicEngine* engine, SupertonicSynthesisStats* stats, SupertonicPerfCounts* counts)
+    : state_(engine->perf.enabled && stats != nullptr && counts != nullptr ? &engine->perf : nullptr),
+      stats_(stats),
+      counts_(counts) {
+    if (state_ == nullptr) {
+        return;
+    }
+    caller_ = callerGroup();
+    start_.resize(1 + state_->workers.size());
+    start_[0].valid = caller_->read(start_[0]);
+    for (size_t w = 0; w < state_->workers.size(); w++) {
+        start_[1 + w].valid = state_->workers[w]->read(start_[1 + w]);
+    }
+}
+
+PerfScope::~PerfScope() {
+    if (state_ == nullptr) {
+        return;
+    }
+    int threads = 0;
+    uint32_t mask = 0;
+    PerfReading end;
+    if (start_[0].valid && caller_->read(end)) {
+        addDelta(start_[0], end, *counts_);
+        threads++;
+        mask |= caller_->mask();
+    }
+    for (size_t w = 0; w < state_->workers.size(); w++) {
+        const PerfGroup& worker = *state_->workers[w];
+        // A pool thread that calls in itself is already counted as the caller
+        if (worker.tid() != caller_->tid() && start_[1 + w].valid && worker.read(end)) {
+            addDelta(start_[1 + w], end, *counts_);
+            threads++;
+            mask |= worker.mask();
+        }
+    }
+    stats_->perf_counters |= mask;
+    stats_->perf_threads = std::max(stats_->perf_threads, threads);
+}
+
+void addPerfCounts(SupertonicPerfCounts& a, const SupertonicPerfCounts& b) {
+    for (int c = 0; c < SUPERTONIC_NUM_PERF_COUNTERS; c++) {
+        a.count[c] += b.count[c];
+    }
+}
+
+} // namespace supertonic
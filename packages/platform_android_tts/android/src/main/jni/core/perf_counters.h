@@ -0,0 +1,100 @@
+/*
+ * perf_counters.h - perf_event_open counters per inference thread
+ *
+ * With config.perf_counters every thread that runs inference gets one
+ * counter group: the threads calling synthesize() open theirs on first
+ * use, the ONNX Runtime pool threads are found as the threads that appear
+ * while the environment and sessions are created. A PerfScope around a
+ * model run reads all of them before and after and adds the difference
+ * to that stage's SupertonicPerfCounts.
+ */
+
+#pragma once
+
+#include "supertonic.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct SupertonicEngine;
+
+namespace supertonic {
+
+/** Raw values of one group read, with the times multiplexing scales by. */
+struct PerfReading {
+    bool valid = false;  // the read succeeded
+    uint64_t enabledNs = 0;
+    uint64_t runningNs = 0;
+    uint64_t value[SUPERTONIC_NUM_PERF_COUNTERS] = {};
+};
+
+/**
+ * The SupertonicPerfCounter events of one thread that the kernel lets this
+ * process count, as one group so they are scheduled together.
+ */
+class PerfGroup {
+public:
+    /** Open the counters of thread tid (0 = the calling thread). */
+    explicit PerfGroup(int tid);
+    ~PerfGroup();
+
+    PerfGroup(const PerfGroup&) = delete;
+    PerfGroup& operator=(const PerfGroup&) = delete;
+
+    int tid() const { return tid_; }
+    /** Bit i = SupertonicPerfCounter i is counted; 0 = nothing could be opened. */
+    uint32_t mask() const { return mask_; }
+    bool read(PerfReading& out) const;
+
+private:
+    int tid_;
+    int leader_ = -1;
+    int fds_[SUPERTONIC_NUM_PERF_COUNTERS];
+    int order_[SUPERTONIC_NUM_PERF_COUNTERS];  // counter of each value in a group read
+    int opened_ = 0;
+    uint32_t mask_ = 0;
+};
+
+/** Per-engine counter state; see SupertonicEngineConfig.perf_counters. */
+struct PerfState {
+    bool enabled = false;  // fixed at create
+    // Groups of the ONNX Runtime pool threads; changed only while no
+    // model runs (engine creation, or sessionMutex held exclusively)
+    std::vector<std::unique_ptr<PerfGroup>> workers;
+};
+
+/** Thread ids of this process, ascending; empty if /proc is unreadable. */
+std::vector<int> processThreads();
+
+/**
+ * Drop the groups of exited threads and open groups on the threads in
+ * after that are not in before. Callers guarantee no model runs.
+ */
+void updateWorkerThreads(PerfState& state, const std::vector<int>& before, const std::vector<int>& after);
+
+/**
+ * Adds what the calling thread and the engine's pool threads count while
+ * in scope to counts, and marks stats with the counters and threads read.
+ * Costs one load when config.perf_counters is off.
+ */
+class PerfScope {
+public:
+    PerfScope(SupertonicEngine* engine, SupertonicSynthesisStats* stats, SupertonicPerfCounts* counts);
+    ~PerfScope();
+
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+
+private:
+    const PerfState* state_;
+    SupertonicSynthesisStats* stats_;
+    SupertonicPerfCounts* counts_;
+    const PerfGroup* caller_ = nullptr;
+    std::vector<PerfReading> start_;  // caller first, then the workers
+};
+
+/** Add b into a counter by counter. */
+void addPerfCounts(SupertonicPerfCounts& a, const SupertonicPerfCounts& b);
+
+} // namespace supertonic
@@ -0,0 +1,315 @@
+/*
+ * profiling.cpp - Engine trace spans and Chrome trace merging
+ */
+
+#include "profiling.h"
+#include "engine.h"
+#include "log.h"
+#include "trace_markers.h"
+
+#include <algorithm>
+#include <cctype>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <thread>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace supertonic {
+
+// Upper bound on buffered engine spans (~11 per request, ~48 bytes each)
+static constexpr size_t kMaxTraceSpans = 1 << 18;
+
+// Process lanes in the merged trace
+static constexpr int kEnginePid = 1;
+static constexpr int kFirstModelPid = 2;
+
+static const char* const kModelNames[MODEL_COUNT] = {
+    "text_encoder",
+    "duration_predictor",
+    "vector_estimator",
+    "vocoder",
+};
+
+const char* modelName(ModelId model) {
+    if (model < 0 || model >= MODEL_COUNT) {
+        return "none";
+    }
+    return kModelNames[model];
+}
+
+int64_t traceThreadId() {
+#if defined(__linux__)
+    return (int64_t)syscall(SYS_gettid);
+#else
+    return (int64_t)(std::hash<std::thread::id>()(std::this_thread::get_id()) & 0x7fffffff);
+#endif
+}
+
+std::string formatRunTag(uint64_t requestId, ModelId model, int step) {
+    std::string tag = "req" + std::to_string(requestId) + "/" + modelName(model);
+    if (step >= 0) {
+        tag += "/step" + std::to_string(step);
+    }
+    return tag;
+}
+
+TraceScope::TraceScope(SupertonicEngine* engine, const char* name, uint64_t requestId,
+                       ModelId model, int step)
+    : state_(engine->profiling.enabled.load(std::memory_order_relaxed) ? &engine->profiling : nullptr) {
+    const bool markers = traceMarkersEnabled();
+    if (state_ == nullptr && !markers) {
+        return;
+    }
+    span_.name = name;
+    span_.requestId = requestId;
+    span_.tid = traceThreadId();
+    span_.startUs = traceNowUs();
+    span_.durUs = 0;
+    span_.model = model;
+    span_.step = step;
+    if (markers) {
+        markers_ = beginTraceMarker(span_);
+    }
+}
+
+TraceScope::~TraceScope() {
+    if (state_ == nullptr && markers_ == 0) {
+        return;
+    }
+    span_.durUs = traceNowUs() - span_.startUs;
+    if (markers_ != 0) {
+        endTraceMarker(span_, markers_);
+    }
+    if (state_ == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(state_->spansMutex);
+    if (state_->spans.size() < kMaxTraceSpans) {
+        state_->spans.push_back(span_);
+    } else {
+        state_->droppedSpans++;
+    }
+}
+
+static std::string jsonEscape(const std::string& s) {
+    std::string out;
+    out.reserve(s.size());
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if ((unsigned char)c < 0x20) {
+            out += ' ';
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+std::string formatSpanEvent(const TraceSpan& span, int64_t pid, int64_t baseUs) {
+    std::string event = "{\"name\":\"" + jsonEscape(span.name) +
+        "\",\"cat\":\"supertonic\",\"ph\":\"X\",\"pid\":" + std::to_string(pid) +
+        ",\"tid\":" + std::to_string(span.tid) +
+        ",\"ts\":" + std::to_string(span.startUs - baseUs) +
+        ",\"dur\":" + std::to_string(span.durUs);
+    if (span.requestId != 0) {
+        // Flow v2: every span of the request both ends and continues it
+        event += ",\"bind_id\":\"req" + std::to_string(span.requestId) + "\",\"flow_in\":true,\"flow_out\":true";
+    }
+    event += ",\"args\":{\"request_id\":" + std::to_string(span.requestId);
+    if (span.step >= 0) {
+        event += ",\"step\":" + std::to_string(span.step);
+    }
+    if (span.model != MODEL_NONE) {
+        event += ",\"run_tag\":\"" + formatRunTag(span.requestId, span.model, span.step) + "\"";
+    }
+    return event + "}}";
+}
+
+/**
+ * Locate the integer value of "key" in a single-line JSON object as
+ * written by ORT's profiler ({"cat" : "Node","pid" :12,...}).
+ */
+static bool findNumberField(const std::string& obj, const char* key, size_t& begin, size_t& end) {
+    const std::string quoted = std::string("\"") + key + "\"";
+    size_t pos = obj.find(quoted);
+    if (pos == std::string::npos) {
+        return false;
+    }
+    pos = obj.find(':', pos + quoted.size());
+    if (pos == std::string::npos) {
+        return false;
+    }
+    pos++;
+    while (pos < obj.size() && obj[pos] == ' ') {
+        pos++;
+    }
+    begin = pos;
+    while (pos < obj.size() && (std::isdigit((unsigned char)obj[pos]) || obj[pos] == '-')) {
+        pos++;
+    }
+    end = pos;
+    return end > begin;
+}
+
+static bool readNumberField(const std::string& obj, const char* key, int64_t& value) {
+    size_t begin = 0;
+    size_t end = 0;
+    if (!findNumberField(obj, key, begin, end)) {
+        return false;
+    }
+    value = std::strtoll(obj.c_str() + begin, nullptr, 10);
+    return true;
+}
+
+static void replaceNumberField(std::string& obj, const char* key, int64_t value) {
+    size_t begin = 0;
+    size_t end = 0;
+    if (findNumberField(obj, key, begin, end)) {
+        obj.replace(begin, end - begin, std::to_string(value));
+    }
+}
+
+static void insertArg(std::string& obj, const std::string& key, const std::string& value) {
+    size_t args = obj.find("\"args\"");
+    size_t brace = args == std::string::npos ? std::string::npos : obj.find('{', args);
+    if (brace == std::string::npos) {
+        return;
+    }
+    size_t next = obj.find_first_not_of(' ', brace + 1);
+    bool empty = next != std::string::npos && obj[next] == '}';
+    obj.insert(brace + 1, "\"" + key + "\" : \"" + jsonEscape(value) + "\"" + (empty ? "" : ","));
+}
+
+/**
+ * Innermost engine run span of the same model enclosing [startUs, endUs].
+ * Spans are sorted by start time.
+ */
+static const TraceSpan* findEnclosingSpan(const std::vector<const TraceSpan*>& spans,
+                                          int64_t startUs, int64_t endUs) {
+    auto it = std::upper_bound(spans.begin(), spans.end(), startUs,
+                               [](int64_t ts, const TraceSpan* span) { return ts < span->startUs; });
+    // Walk back over a bounded number of candidates; more only overlap
+    // when many requests run the same model concurrently
+    for (int checked = 0; it != spans.begin() && checked < 64; checked++) {
+        --it;
+        if ((*it)->startUs + (*it)->durUs >= endUs) {
+            return *it;
+        }
+    }
+    return nullptr;
+}
+
+static std::string traceFileName() {
+    std::time_t now = std::time(nullptr);
+    std::tm local{};
+    localtime_r(&now, &local);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%d_%H-%M-%S", &local);
+    return std::string("supertonic_trace_") + stamp + ".json";
+}
+
+bool writeChromeTrace(const std::string& outputDir,
+                      const std::vector<OrtProfile>& profiles,
+                      const std::vector<TraceSpan>& spans,
+                      std::string& tracePath) {
+    tracePath = outputDir + "/" + traceFileName();
+    std::ofstream out(tracePath);
+    if (!out.is_open()) {
+        LOGE("Failed to create trace file: %s", tracePath.c_str());
+        return false;
+    }
+
+    // Rebase everything on the earliest timestamp so the trace starts at 0
+    int64_t baseUs = std::numeric_limits<int64_t>::max();
+    for (const auto& profile : profiles) {
+        baseUs = std::min(baseUs, (int64_t)(profile.startNs / 1000));
+    }
+    std::vector<const TraceSpan*> runSpans[MODEL_COUNT];
+    for (const auto& span : spans) {
+        baseUs = std::min(baseUs, span.startUs);
+        if (span.model != MODEL_NONE) {
+            runSpans[span.model].push_back(&span);
+        }
+    }
+    if (baseUs == std::numeric_limits<int64_t>::max()) {
+        baseUs = 0;
+    }
+    for (auto& list : runSpans) {
+        std::sort(list.begin(), list.end(),
+                  [](const TraceSpan* a, const TraceSpan* b) { return a->startUs < b->startUs; });
+    }
+
+    bool first = true;
+    auto emit = [&](const std::string& event) {
+        out << (first ? "" : ",\n") << event;
+        first = false;
+    };
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    emit("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + std::to_string(kEnginePid) +
+         ",\"args\":{\"name\":\"supertonic\"}}");
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        emit("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + std::to_string(kFirstModelPid + m) +
+             ",\"args\":{\"name\":\"ort " + kModelNames[m] + "\"}}");
+    }
+
+    for (const auto& span : spans) {
+        emit(formatSpanEvent(span, kEnginePid, baseUs));
+    }
+
+    size_t ortEvents = 0;
+    for (const auto& profile : profiles) {
+        std::ifstream in(profile.path);
+        if (!in.is_open()) {
+            LOGW("Cannot read ORT profile %s", profile.path.c_str());
+            continue;
+        }
+        const int64_t profileStartUs = (int64_t)(profile.startNs / 1000);
+        std::string line;
+        while (std::getline(in, line)) {
+            size_t begin = line.find('{');
+            size_t end = line.rfind('}');
+            if (begin == std::string::npos || end == std::string::npos || end < begin) {
+                continue;  // "[" / "]" framing lines
+            }
+            std::string event = line.substr(begin, end - begin + 1);
+
+            int64_t ts = 0;
+            int64_t dur = 0;
+            if (!readNumberField(event, "ts", ts)) {
+                continue;
+            }
+            readNumberField(event, "dur", dur);
+            const int64_t absUs = profileStartUs + ts;
+
+            replaceNumberField(event, "pid", kFirstModelPid + profile.model);
+            replaceNumberField(event, "ts", absUs - baseUs);
+            const TraceSpan* run = findEnclosingSpan(runSpans[profile.model], absUs, absUs + dur);
+            if (run != nullptr) {
+                insertArg(event, "run_tag", formatRunTag(run->requestId, run->model, run->step));
+            }
+            emit(event);
+            ortEvents++;
+        }
+    }
+
+    out << "\n]}\n";
+    out.close();
+    if (out.fail()) {
+        LOGE("Failed to write trace file: %s", tracePath.c_str());
+        return false;
+    }
+
+    LOGI("Wrote trace %s (%zu engine spans, %zu ORT events)", tracePath.c_str(), spans.size(), ortEvents);
+    return true;
+}
+
+} // namespace supertonic
@@ -0,0 +1,119 @@
+/*
+ * profiling.h - ONNX Runtime profiling and merged Chrome trace export
+ *
+ * While profiling is on, every session is created with EnableProfiling and
+ * the pipeline records its own stage spans. Stopping ends the ORT profiles
+ * and writes one Chrome trace (chrome://tracing, Perfetto) that contains
+ * both the engine stages and the ORT session/kernel events.
+ */
+
+#pragma once
+
+#include "ort_api.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct SupertonicEngine;
+
+namespace supertonic {
+
+enum ModelId {
+    MODEL_TEXT_ENCODER = 0,
+    MODEL_DURATION_PREDICTOR,
+    MODEL_VECTOR_ESTIMATOR,
+    MODEL_VOCODER,
+    MODEL_COUNT,
+    MODEL_NONE = -1,
+};
+
+/** File stem of a model, e.g. "vector_estimator". */
+const char* modelName(ModelId model);
+
+/**
+ * Trace timestamps use the same clock ORT's profiler uses for
+ * SessionGetProfilingStartTimeNs, so both sides line up without
+ * calibration. Our core and ORT are built against the same C++ runtime.
+ */
+using TraceClock = std::chrono::high_resolution_clock;
+
+inline int64_t traceNowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        TraceClock::now().time_since_epoch()).count();
+}
+
+/** Thread id spans are recorded under; the kernel tid on Linux. */
+int64_t traceThreadId();
+
+/** One complete ("ph":"X") engine event. */
+struct TraceSpan {
+    const char* name;   // static string
+    uint64_t requestId;
+    int64_t tid;
+    int64_t startUs;
+    int64_t durUs;
+    ModelId model;      // session the span ran, MODEL_NONE for CPU-only stages
+    int step;           // diffusion step, -1 otherwise
+};
+
+/** ORT profile file produced by SessionEndProfiling. */
+struct OrtProfile {
+    ModelId model;
+    uint64_t startNs;
+    std::string path;
+};
+
+/** Per-engine profiling state; spans are only recorded while enabled. */
+struct ProfilingState {
+    std::atomic<bool> enabled{false};
+    std::string outputDir;
+    std::mutex spansMutex;
+    std::vector<TraceSpan> spans;
+    size_t droppedSpans = 0;  // beyond the buffer cap
+};
+
+/**
+ * Records a span on destruction if profiling is enabled, and opens a trace
+ * marker for it while a system trace runs (see trace_markers.h). Costs a
+ * relaxed atomic load and the marker check when neither is on.
+ */
+class TraceScope {
+public:
+    TraceScope(SupertonicEngine* engine, const char* name, uint64_t requestId,
+               ModelId model = MODEL_NONE, int step = -1);
+    ~TraceScope();
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    ProfilingState* state_;
+    unsigned markers_ = 0;  // backends the marker was opened in
+    TraceSpan span_;
+};
+
+/** ORT run tag / trace label of one model run: "req<id>/<model>[/step<n>]". */
+std::string formatRunTag(uint64_t requestId, ModelId model, int step);
+
+/**
+ * One span as a Chrome trace event in lane pid, timestamps relative to
+ * baseUs. Spans of a request are bound into one flow by its id, so the
+ * viewer draws arrows from stage to stage across threads.
+ */
+std::string formatSpanEvent(const TraceSpan& span, int64_t pid, int64_t baseUs);
+
+/**
+ * Merge the ORT profiles and engine spans into outputDir and return the
+ * written file in tracePath. ORT events are moved to one process lane per
+ * model and tagged with the request whose run encloses them.
+ */
+bool writeChromeTrace(const std::string& outputDir,
+                      const std::vector<OrtProfile>& profiles,
+                      const std::vector<TraceSpan>& spans,
+                      std::string& tracePath);
+
+} // namespace supertonic
@@ -0,0 +1,473 @@
+/*
+ * scheduler.cpp - EDF job queues per execution class and single-flight merging of requests
+ */
+
+#include "scheduler.h"
+#include "cpu_topology.h"
+#include "engine.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <system_error>
+#include <utility>
+
+namespace supertonic {
+
+// Deadlines further out than this are all equally "whenever"
+static constexpr int64_t kMaxDeadlineMs = 7LL * 24 * 3600 * 1000;
+
+enum JobState {
+    JOB_QUEUED,
+    JOB_RUNNING,
+    JOB_DONE,
+};
+
+/** supertonic_submit_async() handle waiting for its job. */
+struct JobCallback {
+    uint64_t handle;
+    SupertonicJobCallback callback;
+    void* userData;
+};
+
+struct ScheduledJob {
+    std::string key;
+    std::string text;
+    SupertonicSynthesisRequest request;  // text points at the copy above
+    Clock::time_point deadline;
+    SupertonicExecutionClass executionClass = SUPERTONIC_CLASS_FOREGROUND;  // queue it belongs in; request's is the one it runs in
+    uint64_t sequence = 0;  // submission order among equal deadlines
+    JobState state = JOB_QUEUED;
+    Clock::time_point started;  // first start; a paused job keeps it
+    Preemption preemption;
+    int submissions = 0;    // handles ever attached
+    int unclaimed = 0;      // handles neither waited for nor cancelled
+    std::vector<JobCallback> callbacks;  // kept here: a handle may be waited for before the job is done
+    bool cancelled = false;  // every handle cancelled while it ran
+
+    SupertonicStatus status = SUPERTONIC_OK;
+    std::vector<float> audio;
+    SupertonicSynthesisStats stats = {};
+    TokenTimings timings;
+};
+
+/** Heap order: true if a is due after b, so the earliest deadline is on top. */
+static bool dueAfter(const std::shared_ptr<ScheduledJob>& a, const std::shared_ptr<ScheduledJob>& b) {
+    if (a->deadline != b->deadline) {
+        return a->deadline > b->deadline;
+    }
+    return a->sequence > b->sequence;
+}
+
+/** Requests with the same key produce the same samples. */
+static std::string jobKey(const SupertonicSynthesisRequest& request) {
+    const int numSteps = request.num_steps > 0 ? request.num_steps : DEFAULT_NUM_STEPS;
+    uint32_t speedBits;
+    memcpy(&speedBits, &request.speed, sizeof(speedBits));
+    char params[48];
+    snprintf(params, sizeof(params), "%d:%08x:%d:", request.speaker_id, speedBits, numSteps);
+    return params + std::string(request.text);
+}
+
+/** Add job to the queue of its class and wake one of that class's threads. */
+static void pushJob(SchedulerState& scheduler, const std::shared_ptr<ScheduledJob>& job) {
+    ClassQueue& queue = scheduler.classes[job->executionClass];
+    job->state = JOB_QUEUED;
+    queue.queue.push_back(job);
+    std::push_heap(queue.queue.begin(), queue.queue.end(), dueAfter);
+    queue.wake.notify_one();
+}
+
+/**
+ * Mark job done, wake waitJob() and call back the handles that asked for
+ * it. Callbacks run with the lock released, so they may call back in.
+ */
+static void finishJob(SchedulerState& scheduler, const std::shared_ptr<ScheduledJob>& job, SupertonicStatus status,
+                      std::unique_lock<std::mutex>& lock) {
+    job->status = status;
+    job->state = JOB_DONE;
+    auto pending = scheduler.pending.find(job->key);
+    if (pending != scheduler.pending.end() && pending->second == job) {
+        scheduler.pending.erase(pending);
+    }
+    scheduler.done.notify_all();
+
+    std::vector<JobCallback> callbacks;
+    callbacks.swap(job->callbacks);
+    if (callbacks.empty()) {
+        return;
+    }
+    lock.unlock();
+    for (const JobCallback& callback : callbacks) {
+        callback.callback(callback.userData, callback.handle, status);
+    }
+    lock.lock();
+}
+
+/** Move a queued background job to the foreground queue. */
+static void promoteQueued(SchedulerState& scheduler, const std::shared_ptr<ScheduledJob>& job) {
+    auto& background = scheduler.classes[SUPERTONIC_CLASS_BACKGROUND].queue;
+    auto found = std::find(background.begin(), background.end(), job);
+    if (found == background.end()) {
+        return;
+    }
+    background.erase(found);
+    std::make_heap(background.begin(), background.end(), dueAfter);
+    job->executionClass = SUPERTONIC_CLASS_FOREGROUND;
+    pushJob(scheduler, job);
+}
+
+/** Promote queued background jobs that are due within SUPERTONIC_PROMOTE_MS. */
+static void promoteDueJobs(SchedulerState& scheduler, Clock::time_point now) {
+    auto& background = scheduler.classes[SUPERTONIC_CLASS_BACKGROUND].queue;
+    const Clock::time_point horizon = now + std::chrono::milliseconds(SUPERTONIC_PROMOTE_MS);
+    while (!background.empty() && background.front()->deadline <= horizon) {
+        std::pop_heap(background.begin(), background.end(), dueAfter);
+        std::shared_ptr<ScheduledJob> job = std::move(background.back());
+        background.pop_back();
+        job->executionClass = SUPERTONIC_CLASS_FOREGROUND;
+        pushJob(scheduler, job);
+        LOGD("Background job promoted, due in %lld ms",
+             (long long)std::chrono::duration_cast<std::chrono::milliseconds>(job->deadline - now).count());
+    }
+}
+
+/**
+ * Asked by a running job between diffusion steps: pause if a queued job of
+ * its class is due sooner and every thread is busy (an idle one would take
+ * it anyway), or if it was promoted out of the background class.
+ */
+static bool shouldYield(SupertonicEngine* engine, ScheduledJob& job) {
+    SchedulerState& scheduler = engine->scheduler;
+    std::lock_guard<std::mutex> lock(scheduler.mutex);
+    if (scheduler.stopping) {
+        return false;
+    }
+    if (job.cancelled) {
+        return true;
+    }
+    const SupertonicExecutionClass runningClass = (SupertonicExecutionClass)job.request.execution_class;
+    if (runningClass == SUPERTONIC_CLASS_BACKGROUND) {
+        if (job.executionClass == SUPERTONIC_CLASS_FOREGROUND) {
+            return true;  // a foreground request joined it
+        }
+        // Near its deadline, move over only if a foreground thread is free
+        const ClassQueue& foreground = scheduler.classes[SUPERTONIC_CLASS_FOREGROUND];
+        const Clock::time_point horizon = Clock::now() + std::chrono::milliseconds(SUPERTONIC_PROMOTE_MS);
+        if (job.deadline <= horizon &&
+            foreground.running + foreground.queue.size() < foreground.threads.size()) {
+            job.executionClass = SUPERTONIC_CLASS_FOREGROUND;
+            return true;
+        }
+    }
+    if (engine->config.preempt_jobs == 0) {
+        return false;
+    }
+    const ClassQueue& own = scheduler.classes[runningClass];
+    if (own.queue.empty() || own.queue.front()->deadline >= job.deadline) {
+        return false;
+    }
+    // A foreground job also waits while chunk workers or direct calls hold
+    // every run slot, even with a scheduler thread idle
+    return own.running >= own.threads.size() ||
+        (runningClass == SUPERTONIC_CLASS_FOREGROUND && !runSlotFree(engine));
+}
+
+static void runJobs(SupertonicEngine* engine, SupertonicExecutionClass executionClass) {
+    if (executionClass == SUPERTONIC_CLASS_BACKGROUND &&
+        !placeCurrentThread(littleCores(), engine->config.background_nice)) {
+        LOGW("Could not move the background scheduler thread to the little cores");
+    }
+    SchedulerState& scheduler = engine->scheduler;
+    ClassQueue& own = scheduler.classes[executionClass];
+    const ClassQueue& background = scheduler.classes[SUPERTONIC_CLASS_BACKGROUND];
+    std::unique_lock<std::mutex> lock(scheduler.mutex);
+    for (;;) {
+        promoteDueJobs(scheduler, Clock::now());
+        if (scheduler.stopping) {
+            return;
+        }
+        if (own.queue.empty()) {
+            // Foreground threads also wake when the next background job becomes due
+            if (executionClass == SUPERTONIC_CLASS_FOREGROUND && !background.queue.empty()) {
+                own.wake.wait_until(lock, background.queue.front()->deadline -
+                                              std::chrono::milliseconds(SUPERTONIC_PROMOTE_MS));
+            } else {
+                own.wake.wait(lock);
+            }
+            continue;
+        }
+        // A foreground job leaves the queue only once a run slot is free for
+        // it, so until then it stays visible to shouldYield() and to
+        // earlier-due jobs arriving meanwhile
+        std::unique_ptr<RunSlots> runSlot;
+        if (executionClass == SUPERTONIC_CLASS_FOREGROUND) {
+            runSlot.reset(new RunSlots(engine, 1));
+            if (runSlot->count() == 0) {
+                runSlot.reset();
+                own.wake.wait(lock);
+                continue;
+            }
+        }
+        std::pop_heap(own.queue.begin(), own.queue.end(), dueAfter);
+        std::shared_ptr<ScheduledJob> job = std::move(own.queue.back());
+        own.queue.pop_back();
+        const bool resuming = job->preemption.suspended != nullptr;
+        job->state = JOB_RUNNING;
+        job->request.execution_class = executionClass;
+        if (!resuming) {
+            job->started = Clock::now();
+        }
+        own.running++;
+        lock.unlock();
+
+        if (resuming) {
+            LOGD("Resuming job of request %llu", (unsigned long long)job->stats.request_id);
+        }
+        SupertonicStatus status;
+        try {
+            status = synthesize(engine, job->request, job->audio, &job->stats, &job->timings, &job->preemption,
+                                runSlot != nullptr);
+        } catch (const std::bad_alloc&) {
+            status = SUPERTONIC_ERROR_OUT_OF_MEMORY;
+        } catch (...) {
+            LOGE("Unexpected exception in scheduled synthesis");
+            status = SUPERTONIC_ERROR_INFERENCE;
+        }
+        runSlot.reset();
+
+        lock.lock();
+        own.running--;
+        if (job->cancelled) {
+            // Whatever it produced, nobody is waiting for it any more
+            job->preemption.suspended.reset();
+            status = SUPERTONIC_ERROR_CANCELLED;
+        }
+        if (job->preemption.suspended != nullptr) {
+            if (status == SUPERTONIC_OK && !scheduler.stopping) {
+                // Back in line with its deadline, in the queue of its (maybe new) class
+                pushJob(scheduler, job);
+                continue;
+            }
+            job->preemption.suspended.reset();
+            if (status == SUPERTONIC_OK) {
+                status = SUPERTONIC_ERROR_RUNTIME_UNAVAILABLE;
+            }
+        }
+        finishJob(scheduler, job, status, lock);
+    }
+}
+
+/** Start a class's threads on first use; false if none could be started. */
+static bool startThreads(SupertonicEngine* engine, SupertonicExecutionClass executionClass) {
+    ClassQueue& queue = engine->scheduler.classes[executionClass];
+    if (!queue.threads.empty()) {
+        return true;
+    }
+    int count = 1;  // background jobs only need to finish before their deadline
+    if (executionClass == SUPERTONIC_CLASS_FOREGROUND) {
+        // Their jobs take run slots like any call, so chunk workers and
+        // direct calls are counted against the same budget
+        count = engine->config.scheduler_threads > 0 ? engine->config.scheduler_threads : parallelRuns(engine);
+    }
+    for (int t = 0; t < count; t++) {
+        try {
+            queue.threads.emplace_back(runJobs, engine, executionClass);
+        } catch (const std::system_error&) {
+            LOGW("Could not start scheduler thread %d, continuing with fewer", t);
+            break;
+        }
+    }
+    LOGI("Scheduler started %zu %s threads", queue.threads.size(),
+         executionClass == SUPERTONIC_CLASS_FOREGROUND ? "foreground" : "background");
+    return !queue.threads.empty();
+}
+
+void notifyRunSlotReleased(SupertonicEngine* engine) {
+    SchedulerState& scheduler = engine->scheduler;
+    std::lock_guard<std::mutex> lock(scheduler.mutex);
+    if (!scheduler.classes[SUPERTONIC_CLASS_FOREGROUND].queue.empty()) {
+        scheduler.classes[SUPERTONIC_CLASS_FOREGROUND].wake.notify_all();
+    }
+}
+
+SupertonicStatus submitJob(SupertonicEngine* engine, const SupertonicSynthesisRequest& request,
+                           int64_t deadlineMs, uint64_t& outHandle, SupertonicJobCallback callback,
+                           void* userData) {
+    const Clock::time_point now = Clock::now();
+    const Clock::time_point deadline =
+        now + std::chrono::milliseconds(std::min(std::max<int64_t>(deadlineMs, 0), kMaxDeadlineMs));
+    const SupertonicExecutionClass executionClass = (SupertonicExecutionClass)request.execution_class;
+    std::string key = jobKey(request);
+
+    SchedulerState& scheduler = engine->scheduler;
+    std::lock_guard<std::mutex> lock(scheduler.mutex);
+    // Promotion needs the foreground threads even if only background work arrives
+    if (scheduler.stopping || !startThreads(engine, SUPERTONIC_CLASS_FOREGROUND) ||
+        !startThreads(engine, executionClass)) {
+        return SUPERTONIC_ERROR_RUNTIME_UNAVAILABLE;
+    }
+
+    std::shared_ptr<ScheduledJob> job;
+    auto pending = scheduler.pending.find(key);
+    if (pending != scheduler.pending.end()) {
+        job = pending->second;
+        if (deadline < job->deadline) {
+            // A running job only needs the new deadline for shouldYield()
+            job->deadline = deadline;
+            if (job->state == JOB_QUEUED) {
+                auto& queue = scheduler.classes[job->executionClass].queue;
+                std::make_heap(queue.begin(), queue.end(), dueAfter);
+            }
+        }
+        if (executionClass == SUPERTONIC_CLASS_FOREGROUND && job->executionClass == SUPERTONIC_CLASS_BACKGROUND) {
+            if (job->state == JOB_QUEUED) {
+                promoteQueued(scheduler, job);
+            } else {
+                job->executionClass = SUPERTONIC_CLASS_FOREGROUND;  // shouldYield() moves it over
+            }
+        }
+        LOGD("Request joins %s job (%d sharing)", job->state == JOB_QUEUED ? "queued" : "running",
+             job->submissions + 1);
+    } else {
+        job = std::make_shared<ScheduledJob>();
+        job->text = request.text;
+        job->request = request;
+        job->request.text = job->text.c_str();
+        job->deadline = deadline;
+        job->executionClass = executionClass;
+        job->sequence = scheduler.nextSequence++;
+        ScheduledJob* raw = job.get();
+        job->preemption.yield = [engine, raw]() { return shouldYield(engine, *raw); };
+        job->key = std::move(key);
+        scheduler.pending[job->key] = job;
+        pushJob(scheduler, job);
+        if (executionClass == SUPERTONIC_CLASS_BACKGROUND) {
+            // Foreground threads sleep until the earliest background job is due
+            scheduler.classes[SUPERTONIC_CLASS_FOREGROUND].wake.notify_all();
+        }
+    }
+    job->submissions++;
+    job->unclaimed++;
+
+    outHandle = scheduler.nextHandle++;
+    scheduler.handles[outHandle] = JobHandle{job, now};
+    if (callback != nullptr) {
+        job->callbacks.push_back(JobCallback{outHandle, callback, userData});
+    }
+    return SUPERTONIC_OK;
+}
+
+SupertonicStatus cancelJob(SupertonicEngine* engine, uint64_t handle) {
+    SchedulerState& scheduler = engine->scheduler;
+    std::unique_lock<std::mutex> lock(scheduler.mutex);
+    auto found = scheduler.handles.find(handle);
+    if (found == scheduler.handles.end() || found->second.cancelled || found->second.job->state == JOB_DONE) {
+        return SUPERTONIC_ERROR_NOT_FOUND;
+    }
+    found->second.cancelled = true;
+    const std::shared_ptr<ScheduledJob> job = found->second.job;
+    JobCallback callback = {handle, nullptr, nullptr};
+    auto own = std::find_if(job->callbacks.begin(), job->callbacks.end(),
+                            [handle](const JobCallback& c) { return c.handle == handle; });
+    if (own != job->callbacks.end()) {
+        callback = *own;
+        job->callbacks.erase(own);
+    }
+
+    // A shared job goes on for the other handles
+    if (--job->unclaimed == 0) {
+        auto pending = scheduler.pending.find(job->key);
+        if (pending != scheduler.pending.end() && pending->second == job) {
+            scheduler.pending.erase(pending);  // an identical request starts afresh
+        }
+        if (job->state == JOB_QUEUED) {
+            auto& queue = scheduler.classes[job->executionClass].queue;
+            auto queued = std::find(queue.begin(), queue.end(), job);
+            if (queued != queue.end()) {
+                queue.erase(queued);
+                std::make_heap(queue.begin(), queue.end(), dueAfter);
+            }
+            job->preemption.suspended.reset();
+            finishJob(scheduler, job, SUPERTONIC_ERROR_CANCELLED, lock);
+        } else {
+            job->cancelled = true;  // shouldYield() stops it after the current step
+        }
+        LOGD("Job of handle %llu cancelled", (unsigned long long)handle);
+    }
+    lock.unlock();
+    if (callback.callback != nullptr) {
+        callback.callback(callback.userData, handle, SUPERTONIC_ERROR_CANCELLED);
+    }
+    return SUPERTONIC_OK;
+}
+
+SupertonicStatus waitJob(SupertonicEngine* engine, uint64_t handle, std::vector<float>& audio,
+                         SupertonicSynthesisStats* stats, TokenTimings* timings) {
+    SchedulerState& scheduler = engine->scheduler;
+    std::unique_lock<std::mutex> lock(scheduler.mutex);
+    auto found = scheduler.handles.find(handle);
+    if (found == scheduler.handles.end()) {
+        return SUPERTONIC_ERROR_NOT_FOUND;
+    }
+    const JobHandle submission = found->second;
+    scheduler.handles.erase(found);
+    if (submission.cancelled) {
+        if (stats != nullptr) {
+            stats->status = SUPERTONIC_ERROR_CANCELLED;
+        }
+        return SUPERTONIC_ERROR_CANCELLED;
+    }
+    ScheduledJob& job = *submission.job;
+    scheduler.done.wait(lock, [&]() { return job.state == JOB_DONE; });
+
+    // The last claimant takes the buffers, earlier ones copy them
+    const bool last = --job.unclaimed == 0;
+    if (stats != nullptr) {
+        *stats = job.stats;
+        stats->queue_ms = job.started > submission.submitted ? elapsedMs(submission.submitted, job.started) : 0.0;
+        stats->shared_requests = job.submissions;
+    }
+    if (job.status == SUPERTONIC_OK) {
+        if (last) {
+            audio = std::move(job.audio);
+        } else {
+            audio = job.audio;
+        }
+        if (timings != nullptr) {
+            *timings = last ? std::move(job.timings) : job.timings;
+        }
+    }
+    return job.status;
+}
+
+void stopScheduler(SupertonicEngine* engine) {
+    SchedulerState& scheduler = engine->scheduler;
+    {
+        std::unique_lock<std::mutex> lock(scheduler.mutex);
+        scheduler.stopping = true;
+        for (ClassQueue& queue : scheduler.classes) {
+            std::vector<std::shared_ptr<ScheduledJob>> dropped;
+            dropped.swap(queue.queue);
+            queue.wake.notify_all();
+            for (auto& job : dropped) {
+                // Paused state holds ORT values, which must go before the environment
+                job->preemption.suspended.reset();
+                finishJob(scheduler, job, SUPERTONIC_ERROR_RUNTIME_UNAVAILABLE, lock);
+            }
+        }
+    }
+    for (ClassQueue& queue : scheduler.classes) {
+        for (auto& thread : queue.threads) {
+            thread.join();
+        }
+        queue.threads.clear();
+    }
+    std::lock_guard<std::mutex> lock(scheduler.mutex);
+    scheduler.pending.clear();
+    scheduler.done.notify_all();
+}
+
+} // namespace supertonic
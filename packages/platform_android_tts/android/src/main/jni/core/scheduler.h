@@ -0,0 +1,112 @@
+/*
+ * scheduler.h - Earliest-deadline-first request queue of an engine
+ *
+ * supertonic_submit() queues a request with the time its audio is needed;
+ * the engine's scheduler threads always pick the queued job whose deadline
+ * is nearest, and a running job pauses between diffusion steps (or the
+ * chunks of a split input) when one due sooner is waiting for a thread. A
+ * request identical to one still queued or running (same text, speaker,
+ * speed and steps) joins that job instead of computing the same audio
+ * twice.
+ *
+ * Each execution class has its own queue and threads: foreground jobs get
+ * the full-width sessions, background jobs run one at a time on a single
+ * niced thread on the little cores. A background job is promoted to the
+ * foreground queue once it is due within SUPERTONIC_PROMOTE_MS or a
+ * foreground request joins it.
+ *
+ * Results are taken with waitJob(), either blocking or after the
+ * submission's completion callback ran. A cancelled submission detaches
+ * from its job, and a job nobody is left waiting for stops.
+ */
+
+#pragma once
+
+#include "supertonic.h"
+#include "timing.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct SupertonicEngine;
+
+namespace supertonic {
+
+struct ScheduledJob;
+struct TokenTimings;
+
+/** One supertonic_submit() call; several may share a job. */
+struct JobHandle {
+    std::shared_ptr<ScheduledJob> job;
+    Clock::time_point submitted;
+    bool cancelled = false;
+};
+
+/** Queue and threads of one execution class. */
+struct ClassQueue {
+    std::condition_variable wake;  // a job was queued, or stopping
+    std::vector<std::shared_ptr<ScheduledJob>> queue;  // heap, earliest deadline on top
+    std::vector<std::thread> threads;
+    size_t running = 0;  // threads inside synthesize()
+};
+
+/** Per-engine queue state; the threads start with the first submission. */
+struct SchedulerState {
+    std::mutex mutex;
+    std::condition_variable done;  // a job finished
+    ClassQueue classes[SUPERTONIC_NUM_EXECUTION_CLASSES];
+    std::map<std::string, std::shared_ptr<ScheduledJob>> pending;  // queued or running, by key
+    std::map<uint64_t, JobHandle> handles;  // not yet waited for
+    bool stopping = false;
+    uint64_t nextHandle = 1;
+    uint64_t nextSequence = 0;
+};
+
+/**
+ * Queue request to be done deadlineMs from now in request.execution_class,
+ * or attach to an identical job already queued or running (moving its
+ * deadline earlier and its class to foreground if needed).
+ * outHandle identifies this submission to waitJob() and cancelJob().
+ * callback, if given, runs on a scheduler thread once the job is done.
+ */
+SupertonicStatus submitJob(SupertonicEngine* engine, const SupertonicSynthesisRequest& request,
+                           int64_t deadlineMs, uint64_t& outHandle, SupertonicJobCallback callback = nullptr,
+                           void* userData = nullptr);
+
+/**
+ * Withdraw one submission; its callback runs at once with
+ * SUPERTONIC_ERROR_CANCELLED and waitJob() returns that status. The job
+ * itself is dropped from the queue, or stopped after its current
+ * diffusion step or running chunks, once no other submission shares it.
+ * NOT_FOUND if the handle is unknown, already cancelled, or its job is
+ * done.
+ */
+SupertonicStatus cancelJob(SupertonicEngine* engine, uint64_t handle);
+
+/**
+ * Block until the handle's job is done and take its results; the handle
+ * is gone afterwards. stats and timings may be null. A cancelled handle
+ * returns SUPERTONIC_ERROR_CANCELLED without waiting.
+ */
+SupertonicStatus waitJob(SupertonicEngine* engine, uint64_t handle, std::vector<float>& audio,
+                         SupertonicSynthesisStats* stats, TokenTimings* timings);
+
+/**
+ * Wake foreground scheduler threads whose next job waits for a run slot;
+ * called by RunSlots as slots are given back.
+ */
+void notifyRunSlotReleased(SupertonicEngine* engine);
+
+/**
+ * Join the scheduler threads. Jobs still queued or paused finish with
+ * SUPERTONIC_ERROR_RUNTIME_UNAVAILABLE; running ones complete first.
+ */
+void stopScheduler(SupertonicEngine* engine);
+
+} // namespace supertonic
@@ -0,0 +1,328 @@
+/*
+ * shared_weights.cpp - ONNX initializer extraction for AddInitializer sharing
+ *
+ * Reads just enough of the protobuf wire format to find the raw_data
+ * initializers of ModelProto.graph; everything else is skipped.
+ */
+
+#include "shared_weights.h"
+#include "log.h"
+#include "ort_runtime.h"
+
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace supertonic {
+
+namespace {
+
+// Smaller tensors (biases, scales, shape constants) stay with each session,
+// where constant folding may still rewrite them
+constexpr uint64_t kMinSharedBytes = 4096;
+constexpr size_t kAlignment = 64;
+
+// Field numbers from onnx.proto3
+constexpr uint32_t kModelGraph = 7;
+constexpr uint32_t kGraphInitializer = 5;
+constexpr uint32_t kTensorDims = 1;
+constexpr uint32_t kTensorDataType = 2;
+constexpr uint32_t kTensorName = 8;
+constexpr uint32_t kTensorRawData = 9;
+constexpr uint32_t kTensorDataLocation = 14;
+
+enum WireType : uint32_t { WIRE_VARINT = 0, WIRE_FIXED64 = 1, WIRE_BYTES = 2, WIRE_FIXED32 = 5 };
+
+/** Bounds-checked cursor over one protobuf message. */
+struct Reader {
+    const uint8_t* pos;
+    const uint8_t* end;
+
+    bool varint(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && pos < end; shift += 7) {
+            const uint8_t byte = *pos++;
+            value |= (uint64_t)(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** Next field's number, wire type and, for WIRE_BYTES, its payload. */
+    bool field(uint32_t& number, uint32_t& wire, Reader& payload) {
+        uint64_t key = 0;
+        if (!varint(key)) {
+            return false;
+        }
+        number = (uint32_t)(key >> 3);
+        wire = (uint32_t)(key & 7);
+        if (wire == WIRE_BYTES) {
+            uint64_t length = 0;
+            if (!varint(length) || length > (uint64_t)(end - pos)) {
+                return false;
+            }
+            payload = {pos, pos + length};
+            pos += length;
+        }
+        return true;
+    }
+
+    bool skip(uint32_t wire) {
+        uint64_t ignored = 0;
+        switch (wire) {
+            case WIRE_VARINT: return varint(ignored);
+            case WIRE_BYTES: return true;  // consumed by field()
+            case WIRE_FIXED64: return advance(8);
+            case WIRE_FIXED32: return advance(4);
+            default: return false;  // groups are not used by onnx.proto
+        }
+    }
+
+    bool advance(size_t bytes) {
+        if (bytes > (size_t)(end - pos)) {
+            return false;
+        }
+        pos += bytes;
+        return true;
+    }
+};
+
+/** One initializer found in the file; data points into the mapping. */
+struct TensorRef {
+    std::string name;
+    std::vector<int64_t> dims;
+    ONNXTensorElementDataType type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+    const uint8_t* data = nullptr;
+    uint64_t bytes = 0;
+    bool external = false;
+};
+
+size_t elementBytes(ONNXTensorElementDataType type) {
+    switch (type) {
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_BOOL:
+            return 1;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT16:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT16:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_BFLOAT16:
+            return 2;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT32:
+            return 4;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT64:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_DOUBLE:
+            return 8;
+        default:
+            return 0;  // strings, complex and sub-byte types are left alone
+    }
+}
+
+bool parseTensor(Reader reader, TensorRef& tensor) {
+    uint32_t number = 0;
+    uint32_t wire = 0;
+    Reader payload{nullptr, nullptr};
+    while (reader.pos < reader.end) {
+        if (!reader.field(number, wire, payload)) {
+            return false;
+        }
+        uint64_t value = 0;
+        if (number == kTensorDims && wire == WIRE_VARINT) {
+            if (!reader.varint(value)) {
+                return false;
+            }
+            tensor.dims.push_back((int64_t)value);
+        } else if (number == kTensorDims && wire == WIRE_BYTES) {
+            while (payload.pos < payload.end) {
+                if (!payload.varint(value)) {
+                    return false;
+                }
+                tensor.dims.push_back((int64_t)value);
+            }
+        } else if (number == kTensorDataType && wire == WIRE_VARINT) {
+            if (!reader.varint(value)) {
+                return false;
+            }
+            tensor.type = (ONNXTensorElementDataType)value;
+        } else if (number == kTensorName && wire == WIRE_BYTES) {
+            tensor.name.assign((const char*)payload.pos, (size_t)(payload.end - payload.pos));
+        } else if (number == kTensorRawData && wire == WIRE_BYTES) {
+            tensor.data = payload.pos;
+            tensor.bytes = (uint64_t)(payload.end - payload.pos);
+        } else if (number == kTensorDataLocation && wire == WIRE_VARINT) {
+            if (!reader.varint(value)) {
+                return false;
+            }
+            tensor.external = value != 0;
+        } else if (!reader.skip(wire)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Whether ORT can take tensor as a shared initializer and it is worth it. */
+bool shareable(const TensorRef& tensor) {
+    const size_t size = elementBytes(tensor.type);
+    if (tensor.external || tensor.data == nullptr || tensor.name.empty() || size == 0 ||
+        tensor.bytes < kMinSharedBytes) {
+        return false;
+    }
+    uint64_t elements = 1;
+    for (int64_t dim : tensor.dims) {
+        if (dim < 0) {
+            return false;
+        }
+        elements *= (uint64_t)dim;
+    }
+    return elements * size == tensor.bytes;
+}
+
+bool parseModel(const uint8_t* data, size_t size, std::vector<TensorRef>& tensors) {
+    Reader model{data, data + size};
+    uint32_t number = 0;
+    uint32_t wire = 0;
+    Reader graph{nullptr, nullptr};
+    bool haveGraph = false;
+    while (model.pos < model.end) {
+        Reader payload{nullptr, nullptr};
+        if (!model.field(number, wire, payload)) {
+            return false;
+        }
+        if (number == kModelGraph && wire == WIRE_BYTES) {
+            graph = payload;
+            haveGraph = true;
+        } else if (!model.skip(wire)) {
+            return false;
+        }
+    }
+    if (!haveGraph) {
+        return false;
+    }
+    while (graph.pos < graph.end) {
+        Reader payload{nullptr, nullptr};
+        if (!graph.field(number, wire, payload)) {
+            return false;
+        }
+        if (number == kGraphInitializer && wire == WIRE_BYTES) {
+            TensorRef tensor;
+            if (!parseTensor(payload, tensor)) {
+                return false;
+            }
+            if (shareable(tensor)) {
+                tensors.push_back(std::move(tensor));
+            }
+        } else if (!graph.skip(wire)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t alignUp(uint64_t value) {
+    return (value + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+} // namespace
+
+bool loadSharedWeights(const std::string& path, const OrtMemoryInfo* memoryInfo, SharedWeights& weights) {
+    releaseSharedWeights(weights);
+
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOGE("Cannot open model for shared weights: %s", path.c_str());
+        return false;
+    }
+    struct stat st;
+    void* mapping = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        mapping = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        LOGE("Cannot map model for shared weights: %s", path.c_str());
+        return false;
+    }
+
+    std::vector<TensorRef> tensors;
+    bool ok = parseModel((const uint8_t*)mapping, (size_t)st.st_size, tensors);
+    if (!ok) {
+        LOGE("Not an ONNX model: %s", path.c_str());
+    }
+    uint64_t total = 0;
+    for (const TensorRef& tensor : tensors) {
+        total += alignUp(tensor.bytes);
+    }
+    if (ok && total > 0) {
+        weights.storage = ::operator new((size_t)total, std::align_val_t(kAlignment), std::nothrow);
+        ok = weights.storage != nullptr;
+        if (!ok) {
+            LOGE("Out of memory for %.1f MB of shared weights", total / (1024.0 * 1024.0));
+        }
+    }
+    // The copies are aligned for the kernels and leave the file unmapped
+    uint8_t* next = (uint8_t*)weights.storage;
+    for (size_t i = 0; ok && i < tensors.size(); i++) {
+        const TensorRef& tensor = tensors[i];
+        memcpy(next, tensor.data, (size_t)tensor.bytes);
+        OrtValue* value = nullptr;
+        ok = !checkStatus(g_ortApi->CreateTensorWithDataAsOrtValue(memoryInfo, next, (size_t)tensor.bytes,
+                                                                   tensor.dims.data(), tensor.dims.size(),
+                                                                   tensor.type, &value),
+                          "CreateTensorWithDataAsOrtValue");
+        if (ok) {
+            weights.names.push_back(tensor.name);
+            weights.values.push_back(value);
+        }
+        next += alignUp(tensor.bytes);
+    }
+    munmap(mapping, (size_t)st.st_size);
+
+    if (ok) {
+        ok = !checkStatus(g_ortApi->CreatePrepackedWeightsContainer(&weights.prepacked),
+                          "CreatePrepackedWeightsContainer");
+    }
+    if (!ok) {
+        releaseSharedWeights(weights);
+        return false;
+    }
+    weights.path = path;
+    weights.bytes = total;
+    LOGI("Shared %zu initializers (%.1f MB) of %s", weights.values.size(), total / (1024.0 * 1024.0),
+         path.c_str());
+    return true;
+}
+
+void releaseSharedWeights(SharedWeights& weights) {
+    for (OrtValue* value : weights.values) {
+        g_ortApi->ReleaseValue(value);
+    }
+    if (weights.prepacked != nullptr) {
+        g_ortApi->ReleasePrepackedWeightsContainer(weights.prepacked);
+    }
+    if (weights.storage != nullptr) {
+        ::operator delete(weights.storage, std::align_val_t(kAlignment));
+    }
+    weights = SharedWeights();
+}
+
+bool addSharedWeights(const SharedWeights& weights, OrtSessionOptions* options) {
+    for (size_t i = 0; i < weights.values.size(); i++) {
+        if (checkStatus(g_ortApi->AddInitializer(options, weights.names[i].c_str(), weights.values[i]),
+                        "AddInitializer")) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace supertonic
@@ -0,0 +1,51 @@
+/*
+ * shared_weights.h - One copy of a model's initializers for all its sessions
+ */
+
+#pragma once
+
+#include "ort_api.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace supertonic {
+
+/**
+ * The large initializers of one model file, read once into aligned memory
+ * and handed to every session of that file with AddInitializer, plus the
+ * container their prepacked kernels are cached in. Sessions created with
+ * addSharedWeights() and the container reference the same weights and
+ * packed buffers instead of each holding a copy.
+ *
+ * Only raw_data tensors of the main graph are shared; small ones, external
+ * data and those inside subgraphs stay with each session. Must outlive
+ * every session created from it.
+ */
+struct SharedWeights {
+    std::string path;  // model file the values came from, empty = not loaded
+    std::vector<std::string> names;
+    std::vector<OrtValue*> values;
+    void* storage = nullptr;  // all tensor data, one aligned block
+    uint64_t bytes = 0;       // size of storage
+    OrtPrepackedWeightsContainer* prepacked = nullptr;
+};
+
+/**
+ * Read the initializers of the ONNX file at path into weights (released
+ * first). False if the file is unreadable or not a model ORT could load;
+ * a model without shareable initializers succeeds with none.
+ */
+bool loadSharedWeights(const std::string& path, const OrtMemoryInfo* memoryInfo, SharedWeights& weights);
+
+/** Release the values, their storage and the prepacked container. */
+void releaseSharedWeights(SharedWeights& weights);
+
+/**
+ * Register every value of weights with options (a copy owned by the caller,
+ * only ever used for this model). False on ORT errors.
+ */
+bool addSharedWeights(const SharedWeights& weights, OrtSessionOptions* options);
+
+} // namespace supertonic
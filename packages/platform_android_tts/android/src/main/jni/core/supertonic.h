@@ -0,0 +1,758 @@
+/*
+ * supertonic.h - Plain C API for the Supertonic TTS engine core
+ *
+ * This is the only interface the JNI shim, the desktop library and tools
+ * are allowed to use. It is platform independent: nothing here depends on
+ * JNI or Android, and the core loads libonnxruntime.so at runtime.
+ *
+ * ABI rules:
+ * - Structs passed by pointer carry a leading struct_size field; callers
+ *   set it with the matching *_init() function so fields can be appended
+ *   without breaking older callers.
+ * - Existing enum values and function signatures never change; new
+ *   functionality is added as new functions.
+ */
+
+#ifndef SUPERTONIC_H
+#define SUPERTONIC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define SUPERTONIC_API __declspec(dllexport)
+#else
+#define SUPERTONIC_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Bumped whenever functions or struct fields are added. */
+#define SUPERTONIC_ABI_VERSION 25
+
+/** Opaque engine handle owning the ONNX sessions and caches. */
+typedef struct SupertonicEngine SupertonicEngine;
+
+typedef enum SupertonicStatus {
+    SUPERTONIC_OK = 0,
+    SUPERTONIC_ERROR_INVALID_ARGUMENT = 1,
+    SUPERTONIC_ERROR_RUNTIME_UNAVAILABLE = 2,
+    SUPERTONIC_ERROR_MODEL_LOAD = 3,
+    SUPERTONIC_ERROR_TOKENIZE = 4,
+    SUPERTONIC_ERROR_INFERENCE = 5,
+    SUPERTONIC_ERROR_OUT_OF_MEMORY = 6,
+    SUPERTONIC_ERROR_NOT_FOUND = 7,
+    SUPERTONIC_ERROR_IO = 8,
+    SUPERTONIC_ERROR_CANCELLED = 9,  /* ABI 22 */
+} SupertonicStatus;
+
+/** Upper bound for SupertonicSynthesisRequest.num_steps. */
+#define SUPERTONIC_MAX_DIFFUSION_STEPS 32
+
+/** Upper bound for SupertonicEngineConfig.session_pool_size. */
+#define SUPERTONIC_MAX_SESSION_POOL 8
+
+/** Capacity of the length bucket lists in SupertonicEngineConfig. */
+#define SUPERTONIC_MAX_LENGTH_BUCKETS 16
+
+/** Lengths above the largest bucket are padded to a multiple of this. */
+#define SUPERTONIC_BUCKET_OVERFLOW_MULTIPLE 64
+
+/** Engine-wide settings fixed at creation time. */
+typedef struct SupertonicEngineConfig {
+    uint32_t struct_size;
+    int32_t intra_op_threads;  /* 0 = default (2); at most thread_budget */
+    /* ABI 7 */
+    /*
+     * Token and latent lengths are padded up to the smallest bucket that
+     * holds them, with the padding masked out, so ONNX Runtime sees a few
+     * recurring shapes and reuses its memory plans. Ascending, terminated
+     * by 0 or the end of the array; an all-zero list keeps exact lengths.
+     * supertonic_engine_config_init() fills in multiples of 8 from 16 to 512.
+     */
+    int32_t token_buckets[SUPERTONIC_MAX_LENGTH_BUCKETS];
+    int32_t latent_buckets[SUPERTONIC_MAX_LENGTH_BUCKETS];
+    /* ABI 8 */
+    int32_t text_cache_entries;  /* recent texts whose encoder/duration results are
+                                    kept for re-rendering at another speed; 0 = off,
+                                    supertonic_engine_config_init() sets 8 */
+    /* ABI 11 */
+    /*
+     * Inputs longer than max_chunk_tokens are split at clause boundaries
+     * into sub-utterances of at most that many tokens, synthesized in
+     * parallel and joined with a chunk_crossfade_ms crossfade. This bounds
+     * attention cost and latent buffers per call. 0 = never split, otherwise
+     * at least SUPERTONIC_MIN_CHUNK_TOKENS; supertonic_engine_config_init()
+     * sets 192 tokens and 10 ms.
+     */
+    int32_t max_chunk_tokens;
+    int32_t chunk_crossfade_ms;
+    int32_t max_parallel_chunks;  /* sub-utterances in flight per call; 0 = as many
+                                     as thread_budget allows, which also caps it */
+    /* ABI 12 */
+    /*
+     * Non-zero loads onnx/<model>_fp16.onnx where present and keeps voice
+     * styles and diffusion latents in half precision between models that
+     * take fp16 inputs. The I/O type of every session is read from the model,
+     * so any mix of fp16 and fp32 files works. 0 (default) = fp32 files.
+     */
+    int32_t fp16_io;
+    /* ABI 13 */
+    /*
+     * Non-zero picks each model's file from onnx/variants.txt, the fastest
+     * variant this CPU can run (see SupertonicModelVariant), falling back
+     * to the next one if it fails to load and finally to <model>.onnx.
+     * 0 = always <model>.onnx (or its fp16 file). Default 1.
+     */
+    int32_t model_variants;
+    /* ABI 14 */
+    /*
+     * Non-zero also loads every model with the XNNPACK execution provider.
+     * On its first run the XNNPACK session is checked against the CPU
+     * session on the same input and kept only if its outputs match and it
+     * is faster; otherwise that model stays on the CPU provider. Runtimes
+     * built without XNNPACK fall back silently. Default 0.
+     */
+    int32_t xnnpack;
+    /* ABI 15 */
+    /*
+     * Inference threads of the engine in total, counting callers and pool
+     * workers; intra_op_threads and parallel sub-utterances are clamped to
+     * it. 0 (default) = one per physical big core, so the engine never
+     * oversubscribes the cores that matter.
+     *
+     * global_thread_pool (default 1) runs every session on one intra-op
+     * pool owned by the ONNX Runtime environment (CreateEnvWithGlobalThreadPools)
+     * instead of a pool per session. The environment is per process: when
+     * another library (sherpa-onnx) created it first, sessions fall back to
+     * per-session pools, still sized within the budget.
+     *
+     * spin_wait (default 0) lets idle pool threads busy-wait for work,
+     * trading CPU time and battery for a little latency between operators.
+     * pin_threads (default 0) binds each pool thread to its own big core.
+     * Otherwise, on a CPU with big and little cores, pool threads may run on
+     * any big core but never on a little one (see supertonic_get_cpu_topology()).
+     */
+    int32_t thread_budget;
+    int32_t global_thread_pool;
+    int32_t spin_wait;
+    int32_t pin_threads;
+    /* ABI 16 */
+    /*
+     * Non-zero (default) registers one CPU memory arena with the ONNX
+     * Runtime environment and runs every session on it instead of an arena
+     * per session. The models run one after another, so the shared arena
+     * peaks at the largest stage rather than the sum of all four.
+     * arena_limit_mb caps it (0 = no cap); a run that would need more fails
+     * with SUPERTONIC_ERROR_INFERENCE instead of growing the heap.
+     */
+    int32_t shared_arena;
+    int32_t arena_limit_mb;
+    /* ABI 17 */
+    /*
+     * Non-zero ends diffusion early once the latent's path has straightened
+     * out: when the displacement of a step differs from the previous one by
+     * less than this fraction of its norm, after at least
+     * early_exit_min_steps steps (2 or more), the remaining steps are taken
+     * as one straight-line jump. Short, simple segments often converge
+     * after 3 of 5 steps. 0 (default) = always run every step;
+     * supertonic_engine_config_init() sets a floor of 3 steps.
+     */
+    float early_exit_threshold;
+    int32_t early_exit_min_steps;
+    /* ABI 18 */
+    int32_t scheduler_threads;  /* threads running foreground supertonic_submit() jobs,
+                                   started with the first submission; 0 (default) = as
+                                   many calls as thread_budget lets run side by side.
+                                   Background jobs always get one thread of their own */
+    /* ABI 19 */
+    int32_t preempt_jobs;       /* 1 (default) = a submitted job may pause between
+                                   diffusion steps, or chunks of chunked input, for
+                                   one due sooner; 0 = jobs run to the end once
+                                   started */
+    /* ABI 20 */
+    int32_t background_nice;    /* nice value of the background scheduler thread,
+                                   0-19 (default 10); 0 = leave it unchanged */
+    /* ABI 23 */
+    /*
+     * Non-zero (default) reads each model's large initializers once and
+     * gives every session of that model (foreground, background, pooled,
+     * XNNPACK candidate) the same copy and the same prepacked kernels, so
+     * another session costs its graph and activations, not the weights.
+     */
+    int32_t share_weights;
+    /*
+     * Sessions per model that foreground calls running side by side take
+     * turns on, each with an intra-op pool of its own, at most
+     * SUPERTONIC_MAX_SESSION_POOL. 0 (default) = as many as thread_budget
+     * lets run side by side with per-session pools, while each extra one
+     * fits in a quarter of the available memory; 1 with the global thread
+     * pool, whose threads every session already shares. Not used with
+     * xnnpack.
+     */
+    int32_t session_pool_size;
+    /* ABI 24 */
+    /*
+     * Non-zero counts SupertonicPerfCounter events with perf_event_open on
+     * the calling thread and the ONNX Runtime pool threads during every
+     * model run, reported per stage in SupertonicSynthesisStats. Needs a
+     * Linux kernel that allows it (perf_event_paranoid <= 2, or a rooted or
+     * debuggable Android build); otherwise the counts stay 0. Pool threads
+     * serve every call, so runs of overlapping calls count each other's
+     * work. 0 (default) = off, at no cost.
+     */
+    int32_t perf_counters;
+} SupertonicEngineConfig;
+
+/**
+ * Precision of a model file. onnx/variants.txt lists the variants of each
+ * model, one per line:
+ *
+ *     # model          precision     file                        [requires...]
+ *     vector_estimator int8_qdq      vector_estimator_qdq.onnx   dotprod
+ *     vector_estimator int8_dynamic  vector_estimator_dyn.onnx
+ *     vocoder          fp16          vocoder_fp16.onnx           asimdhp
+ *
+ * Precisions are fp32, fp16, int8_dynamic and int8_qdq; requirements are
+ * SupertonicCpuFeature names (neon, asimdhp, dotprod, i8mm, avx2, f16c,
+ * avx512vnni, avxvnni).
+ */
+typedef enum SupertonicModelVariant {
+    SUPERTONIC_VARIANT_DEFAULT = 0,       /* <model>.onnx, precision unknown */
+    SUPERTONIC_VARIANT_FP32 = 1,
+    SUPERTONIC_VARIANT_FP16 = 2,
+    SUPERTONIC_VARIANT_INT8_DYNAMIC = 3,  /* fp32 activations quantized at run time */
+    SUPERTONIC_VARIANT_INT8_QDQ = 4,      /* static QuantizeLinear/DequantizeLinear */
+} SupertonicModelVariant;
+
+/** Bits of supertonic_cpu_features(). */
+typedef enum SupertonicCpuFeature {
+    SUPERTONIC_CPU_NEON = 1u << 0,
+    SUPERTONIC_CPU_ASIMDHP = 1u << 1,      /* ARMv8.2 fp16 arithmetic */
+    SUPERTONIC_CPU_DOTPROD = 1u << 2,      /* ARMv8.2 SDOT/UDOT */
+    SUPERTONIC_CPU_I8MM = 1u << 3,         /* ARMv8.6 SMMLA/UMMLA */
+    SUPERTONIC_CPU_AVX2 = 1u << 4,
+    SUPERTONIC_CPU_F16C = 1u << 5,
+    SUPERTONIC_CPU_AVX512VNNI = 1u << 6,
+    SUPERTONIC_CPU_AVXVNNI = 1u << 7,
+} SupertonicCpuFeature;
+
+/** Smallest non-zero SupertonicEngineConfig.max_chunk_tokens. */
+#define SUPERTONIC_MIN_CHUNK_TOKENS 32
+
+/**
+ * How a request shares the CPU with the app and with other requests.
+ *
+ * FOREGROUND runs on the engine's thread budget: the big cores, spinning
+ * per spin_wait. BACKGROUND runs on a second set of sessions with a single
+ * intra-op thread that never spins, created on first use; jobs of this
+ * class from supertonic_submit() run one at a time on a scheduler thread
+ * of their own, pinned to the little cores at a raised nice value
+ * (background_nice). A background job moves to the foreground once it is
+ * due within SUPERTONIC_PROMOTE_MS or a foreground submission joins it.
+ */
+typedef enum SupertonicExecutionClass {
+    SUPERTONIC_CLASS_FOREGROUND = 0,
+    SUPERTONIC_CLASS_BACKGROUND = 1,
+} SupertonicExecutionClass;
+
+#define SUPERTONIC_NUM_EXECUTION_CLASSES 2
+
+/** Background jobs due sooner than this run in the foreground. */
+#define SUPERTONIC_PROMOTE_MS 2000
+
+/** Parameters of a single synthesis call. */
+typedef struct SupertonicSynthesisRequest {
+    uint32_t struct_size;
+    const char* text;      /* UTF-8, not retained after the call */
+    int32_t speaker_id;    /* M1-M5 = 0-4, F1-F5 = 5-9 */
+    float speed;           /* speech rate multiplier, > 0 (1.0 = reference pace) */
+    /* ABI 2 */
+    int32_t num_steps;     /* diffusion steps, 0 = default (5) */
+    /* ABI 3 */
+    uint64_t request_id;   /* key for supertonic_get_stats(), 0 = engine assigns */
+    /* ABI 20 */
+    int32_t execution_class;  /* SupertonicExecutionClass, default FOREGROUND */
+} SupertonicSynthesisRequest;
+
+/** Number of ONNX models in the pipeline, in pipeline order. */
+#define SUPERTONIC_NUM_MODELS 4
+
+/** Number of recent calls whose stats stay queryable by request id. */
+#define SUPERTONIC_STATS_HISTORY 64
+
+/** Events counted per stage with SupertonicEngineConfig.perf_counters. */
+typedef enum SupertonicPerfCounter {
+    SUPERTONIC_PERF_CYCLES = 0,
+    SUPERTONIC_PERF_INSTRUCTIONS = 1,
+    SUPERTONIC_PERF_CACHE_MISSES = 2,     /* last-level cache */
+    SUPERTONIC_PERF_BRANCH_MISSES = 3,
+    SUPERTONIC_PERF_CONTEXT_SWITCHES = 4,
+} SupertonicPerfCounter;
+
+#define SUPERTONIC_NUM_PERF_COUNTERS 5
+
+/**
+ * Counts of one stage summed over the counted threads, indexed by
+ * SupertonicPerfCounter and scaled up where the kernel multiplexed them.
+ */
+typedef struct SupertonicPerfCounts {
+    uint64_t count[SUPERTONIC_NUM_PERF_COUNTERS];
+} SupertonicPerfCounts;
+
+/**
+ * Per-call timings measured with a monotonic clock, in milliseconds.
+ * Stages that did not run are left at zero.
+ */
+typedef struct SupertonicSynthesisStats {
+    uint32_t struct_size;
+    double tokenize_ms;
+    double text_encoder_ms;
+    double duration_predictor_ms;
+    double noise_ms;
+    double vector_estimator_ms;  /* sum of step_ms */
+    double vocoder_ms;
+    double total_ms;
+    int32_t num_steps;
+    double step_ms[SUPERTONIC_MAX_DIFFUSION_STEPS];
+    int64_t token_count;
+    int64_t latent_len;
+    uint64_t num_samples;
+    double audio_seconds;
+    double rtf;                  /* total_ms / audio duration */
+    /* ABI 3 */
+    uint64_t request_id;
+    int32_t status;              /* SupertonicStatus of the call */
+    int32_t intra_op_threads;
+    double cpu_thread_user_ms;   /* calling thread (RUSAGE_THREAD) */
+    double cpu_thread_system_ms;
+    double cpu_process_ms;       /* whole process incl. ORT workers and any
+                                    concurrent calls (RUSAGE_SELF) */
+    uint64_t text_emb_bytes;     /* text encoder output */
+    uint64_t latent_bytes;       /* one [1, 144, latent_len] latent */
+    uint64_t audio_bytes;        /* vocoder output */
+    uint64_t tensor_bytes_allocated;  /* all input/output tensors of the call */
+    /* ABI 8 */
+    int32_t text_cache_hit;      /* 1 = text encoder and duration predictor were
+                                    skipped (their stage times stay 0) */
+    /* ABI 11 */
+    int32_t num_chunks;          /* sub-utterances the input was split into; stage
+                                    times, step times and sizes are summed over them,
+                                    so with parallel chunks they exceed total_ms */
+    /* ABI 13 */
+    int32_t model_variant[SUPERTONIC_NUM_MODELS];  /* SupertonicModelVariant of each
+                                                      loaded model */
+    /* ABI 14 */
+    uint32_t xnnpack_models;     /* bit i set = model i runs on XNNPACK */
+    /* ABI 17 */
+    int32_t steps_run;           /* diffusion steps actually run, below num_steps
+                                    after an early exit (the most of any
+                                    sub-utterance); later step_ms entries stay 0 */
+    /* ABI 18 */
+    double queue_ms;             /* submission to start of synthesis; only set by
+                                    supertonic_job_wait() */
+    int32_t shared_requests;     /* submissions served by this one synthesis, 1 = not
+                                    shared; only set by supertonic_job_wait() */
+    /* ABI 19 */
+    int32_t preemptions;         /* times a submitted job was paused between
+                                    diffusion steps or chunks for a job due sooner */
+    double suspended_ms;         /* paused time, not part of total_ms */
+    /* ABI 20 */
+    int32_t execution_class;     /* SupertonicExecutionClass the call finished in */
+    /* ABI 21 */
+    uint64_t caller_cpus;        /* bit i = the calling thread could run on CPU i
+                                    during the call (CPUs 0-63) */
+    int32_t caller_cpu;          /* CPU the calling thread finished on, -1 if unknown */
+    uint64_t pool_cpus;          /* CPUs the intra-op pool threads are confined to,
+                                    0 = not placed (uniform CPU, or background) */
+    /* ABI 24 */
+    uint32_t perf_counters;      /* bit i = SupertonicPerfCounter i was counted; 0 =
+                                    config.perf_counters off or refused by the kernel */
+    int32_t perf_threads;        /* threads counted: the calling thread(s) plus the
+                                    ONNX Runtime pool threads */
+    SupertonicPerfCounts perf_text_encoder;    /* model runs only, not tensor setup */
+    SupertonicPerfCounts perf_duration_predictor;
+    SupertonicPerfCounts perf_step[SUPERTONIC_MAX_DIFFUSION_STEPS];
+    SupertonicPerfCounts perf_vocoder;
+} SupertonicSynthesisStats;
+
+/**
+ * Native memory owned by an engine. Model index order is text_encoder,
+ * duration_predictor, vector_estimator, vocoder.
+ */
+typedef struct SupertonicMemoryReport {
+    uint32_t struct_size;
+    uint32_t sessions_loaded;       /* bit i set = model i resident */
+    uint64_t session_bytes[SUPERTONIC_NUM_MODELS];     /* heap growth while creating each
+                                                          session: weights, prepacked
+                                                          kernels, graph; plus its
+                                                          background and pooled copies,
+                                                          if loaded */
+    uint64_t model_file_bytes[SUPERTONIC_NUM_MODELS];
+    uint64_t style_cache_bytes;
+    uint32_t cached_styles;
+    uint64_t scratch_peak_bytes;    /* largest per-call tensor working set since
+                                       the last trim */
+    uint64_t native_heap_bytes;     /* malloc in use, whole process */
+    uint64_t arena_estimate_bytes;  /* native heap not explained by sessions or
+                                       styles: ORT arenas plus anything else in
+                                       the process (other engines) */
+    uint64_t process_rss_bytes;
+    /* ABI 8 */
+    uint64_t text_cache_bytes;
+    uint32_t cached_texts;
+    /* ABI 23 */
+    uint64_t shared_weight_bytes[SUPERTONIC_NUM_MODELS];  /* initializers all sessions of
+                                                             the model share, not part of
+                                                             session_bytes */
+    uint32_t session_instances[SUPERTONIC_NUM_MODELS];    /* foreground sessions per model
+                                                             (session_pool_size) */
+} SupertonicMemoryReport;
+
+/**
+ * Tiers for supertonic_trim(). Each level includes the ones below it.
+ * Released sessions are reloaded by the next synthesis call.
+ */
+typedef enum SupertonicTrimLevel {
+    SUPERTONIC_TRIM_NONE = 0,
+    SUPERTONIC_TRIM_ARENAS = 1,          /* shrink ORT arenas at the end of each model's next
+                                            run, return free heap pages to the OS */
+    SUPERTONIC_TRIM_CACHES = 2,          /* drop cached voice styles and text results */
+    SUPERTONIC_TRIM_LARGE_SESSIONS = 3,  /* release vector_estimator and vocoder */
+    SUPERTONIC_TRIM_ALL_SESSIONS = 4,    /* release every session */
+} SupertonicTrimLevel;
+
+/** Mono float samples in [-1, 1]; release with supertonic_audio_free(). */
+typedef struct SupertonicAudio {
+    const float* samples;
+    size_t num_samples;
+    int32_t sample_rate;
+    void* internal;
+} SupertonicAudio;
+
+SUPERTONIC_API uint32_t supertonic_abi_version(void);
+
+SUPERTONIC_API const char* supertonic_status_string(SupertonicStatus status);
+
+/** Sample rate of all generated audio in Hz. */
+SUPERTONIC_API int32_t supertonic_sample_rate(void);
+
+/* ABI 13 */
+/** SupertonicCpuFeature bits of the CPU the process runs on. */
+SUPERTONIC_API uint32_t supertonic_cpu_features(void);
+
+/**
+ * Load the four models, the unicode indexer and prepare sessions.
+ *
+ * core_path must contain onnx/{text_encoder,duration_predictor,
+ * vector_estimator,vocoder}.onnx, onnx/unicode_indexer.json and
+ * voice_styles/{M1..M5,F1..F5}.json.
+ */
+SUPERTONIC_API SupertonicStatus supertonic_engine_create(const char* core_path,
+                                                         SupertonicEngine** out_engine);
+
+/** Fill a config with defaults. */
+SUPERTONIC_API void supertonic_engine_config_init(SupertonicEngineConfig* config);
+
+/** Like supertonic_engine_create() with explicit settings; config may be NULL. */
+SUPERTONIC_API SupertonicStatus supertonic_engine_create_with_config(const char* core_path,
+                                                                     const SupertonicEngineConfig* config,
+                                                                     SupertonicEngine** out_engine);
+
+SUPERTONIC_API void supertonic_engine_destroy(SupertonicEngine* engine);
+
+/** Fill a request with defaults (speaker 0, speed 1.0, 5 steps). */
+SUPERTONIC_API void supertonic_request_init(SupertonicSynthesisRequest* request);
+
+/**
+ * Run the full pipeline for one utterance. Safe to call from multiple
+ * threads on the same engine.
+ */
+SUPERTONIC_API SupertonicStatus supertonic_synthesize(SupertonicEngine* engine,
+                                                      const SupertonicSynthesisRequest* request,
+                                                      SupertonicAudio* out_audio);
+
+/** Zero a stats struct and set its struct_size. */
+SUPERTONIC_API void supertonic_stats_init(SupertonicSynthesisStats* stats);
+
+/**
+ * supertonic_synthesize() that also reports per-stage timings. out_stats
+ * may be NULL; otherwise initialize it with supertonic_stats_init().
+ */
+SUPERTONIC_API SupertonicStatus supertonic_synthesize_with_stats(SupertonicEngine* engine,
+                                                                 const SupertonicSynthesisRequest* request,
+                                                                 SupertonicAudio* out_audio,
+                                                                 SupertonicSynthesisStats* out_stats);
+
+/**
+ * Look up the stats of one of the last SUPERTONIC_STATS_HISTORY calls,
+ * including failed ones. Returns SUPERTONIC_ERROR_NOT_FOUND if evicted.
+ */
+SUPERTONIC_API SupertonicStatus supertonic_get_stats(SupertonicEngine* engine,
+                                                     uint64_t request_id,
+                                                     SupertonicSynthesisStats* out_stats);
+
+SUPERTONIC_API void supertonic_audio_free(SupertonicAudio* audio);
+
+/* ABI 4 */
+
+/**
+ * Recreate the sessions with ONNX Runtime profiling on and start recording
+ * the engine's own stage spans. ORT writes one ort_<model>_*.json file per
+ * session into output_dir, which must exist. Waits for in-flight calls and
+ * reloads the models, so this is not meant for the playback path.
+ */
+SUPERTONIC_API SupertonicStatus supertonic_profiling_start(SupertonicEngine* engine,
+                                                           const char* output_dir);
+
+/**
+ * Stop profiling and write a Chrome trace merging the engine stage spans
+ * and the ORT session/operator events of all four models into output_dir.
+ * ORT events are tagged with the request they ran for ("req<id>/<model>").
+ * The trace path is copied to out_trace_path (may be NULL). Returns
+ * SUPERTONIC_ERROR_NOT_FOUND if profiling was not running.
+ */
+SUPERTONIC_API SupertonicStatus supertonic_profiling_stop(SupertonicEngine* engine,
+                                                          char* out_trace_path,
+                                                          size_t out_trace_path_size);
+
+/* ABI 5 */
+
+/** Zero a memory report and set its struct_size. */
+SUPERTONIC_API void supertonic_memory_report_init(SupertonicMemoryReport* report);
+
+/** Snapshot the engine's native memory; initialize with supertonic_memory_report_init(). */
+SUPERTONIC_API SupertonicStatus supertonic_get_memory_report(SupertonicEngine* engine,
+                                                             SupertonicMemoryReport* out_report);
+
+/**
+ * Shed memory under pressure. Levels that release sessions wait for
+ * in-flight calls and are skipped while profiling. The next synthesis call
+ * reloads released sessions, so expect one slow call afterwards.
+ */
+SUPERTONIC_API SupertonicStatus supertonic_trim(SupertonicEngine* engine, SupertonicTrimLevel level);
+
+/* ABI 6 */
+
+/** Number of buckets supertonic_warmup() runs when none are given. */
+#define SUPERTONIC_WARMUP_DEFAULT_BUCKETS 4
+
+/**
+ * Run every model once per bucket with throwaway input so ONNX Runtime
+ * allocates its arenas and selects kernels for those shapes before the
+ * first audible request. Bucket i uses token_counts[i] tokens and
+ * latent_lens[i] latent frames; latent_lens may be NULL, and a 0 entry
+ * uses the length predicted for the tokens. Both are padded to the
+ * engine's length buckets like any request. num_buckets = 0 runs the
+ * default buckets: 16, 64 and 160 tokens where shorter than
+ * max_chunk_tokens, then max_chunk_tokens itself (320 when chunking is
+ * off), the longest single run. out_bucket_ms may be NULL or receives the
+ * wall time of each bucket (SUPERTONIC_WARMUP_DEFAULT_BUCKETS values for
+ * the defaults, 0 past the buckets run). Also loads the speaker's voice style. Meant for
+ * idle time: each bucket costs about one diffusion step more than a
+ * synthesis call of that size.
+ */
+SUPERTONIC_API SupertonicStatus supertonic_warmup(SupertonicEngine* engine,
+                                                  int32_t speaker_id,
+                                                  const int32_t* token_counts,
+                                                  const int32_t* latent_lens,
+                                                  size_t num_buckets,
+                                                  double* out_bucket_ms);
+
+/* ABI 9 */
+
+/**
+ * Predict the audio length of each text in seconds, as
+ * supertonic_synthesize() would produce it at this speaker and speed, by
+ * running only tokenization and the duration predictor. Texts are batched
+ * by length, so a whole chapter takes a few tens of milliseconds. Texts
+ * without any token get 0. out_seconds must hold num_texts values.
+ */
+SUPERTONIC_API SupertonicStatus supertonic_estimate_durations(SupertonicEngine* engine,
+                                                              const char* const* texts,
+                                                              size_t num_texts,
+                                                              int32_t speaker_id,
+                                                              float speed,
+                                                              double* out_seconds);
+
+/* ABI 10 */
+
+/** Where one input token plays. Tokens are the codepoints of the text. */
+typedef struct SupertonicTokenTiming {
+    uint32_t text_offset;    /* UTF-8 byte offset in the request text */
+    uint32_t text_length;    /* bytes up to the next token */
+    uint64_t start_sample;
+    uint64_t end_sample;     /* exclusive; equals the next token's start */
+} SupertonicTokenTiming;
+
+/**
+ * Token alignment of one synthesized utterance, derived from the duration
+ * predictor and scaled by speed and latent rounding, so the last token
+ * ends at the last sample. Release with supertonic_timestamps_free().
+ */
+typedef struct SupertonicTimestamps {
+    uint32_t struct_size;
+    const SupertonicTokenTiming* tokens;
+    size_t num_tokens;
+    int32_t approximate;     /* 1 = the model only predicts a total duration,
+                                which is spread evenly over the tokens */
+    void* internal;
+} SupertonicTimestamps;
+
+/** Zero a timestamps struct and set its struct_size. */
+SUPERTONIC_API void supertonic_timestamps_init(SupertonicTimestamps* timestamps);
+
+/**
+ * supertonic_synthesize_with_stats() that also returns where each token
+ * plays in the audio, for word highlighting and seeking within an
+ * utterance. out_stats may be NULL; out_timestamps must be initialized
+ * with supertonic_timestamps_init().
+ */
+SUPERTONIC_API SupertonicStatus supertonic_synthesize_with_timestamps(SupertonicEngine* engine,
+                                                                      const SupertonicSynthesisRequest* request,
+                                                                      SupertonicAudio* out_audio,
+                                                                      SupertonicSynthesisStats* out_stats,
+                                                                      SupertonicTimestamps* out_timestamps);
+
+SUPERTONIC_API void supertonic_timestamps_free(SupertonicTimestamps* timestamps);
+
+/* ABI 18 */
+
+/**
+ * Queue a request on the engine's scheduler threads and return at once.
+ * deadline_ms is when the audio is needed, in milliseconds from now (0 =
+ * as soon as possible): queued jobs run earliest deadline first, so a
+ * segment due in 2 s never waits behind a prefetch due in 60 s. When every
+ * scheduler thread is busy, a running job whose deadline is later than a
+ * queued one's pauses after its current diffusion step and goes back into
+ * the queue with its latent; it later resumes at the next step. Chunked
+ * input (max_chunk_tokens) pauses between chunks and keeps those done. A request with the same text, speaker, speed
+ * and steps as one still queued or running joins it instead of being
+ * computed again, moving a queued job's deadline earlier if needed.
+ * The request is copied. Every job returned in out_job must be collected
+ * with supertonic_job_wait() exactly once.
+ */
+SUPERTONIC_API SupertonicStatus supertonic_submit(SupertonicEngine* engine,
+                                                  const SupertonicSynthesisRequest* request,
+                                                  int64_t deadline_ms,
+                                                  uint64_t* out_job);
+
+/**
+ * Block until a submitted job is done and take its audio, like
+ * supertonic_synthesize_with_timestamps(). out_stats and out_timestamps
+ * may be NULL; if given, initialize them with supertonic_stats_init() and
+ * supertonic_timestamps_init(). Returns SUPERTONIC_ERROR_NOT_FOUND for an
+ * unknown or already collected job.
+ */
+SUPERTONIC_API SupertonicStatus supertonic_job_wait(SupertonicEngine* engine,
+                                                    uint64_t job,
+                                                    SupertonicAudio* out_audio,
+                                                    SupertonicSynthesisStats* out_stats,
+                                                    SupertonicTimestamps* out_timestamps);
+
+/* ABI 21 */
+
+/** Most cores a SupertonicCpuTopology lists. */
+#define SUPERTONIC_MAX_CPUS 32
+
+/**
+ * Physical cores the process may run on (SMT siblings dropped), fastest
+ * first, from sysfs cpu_capacity and cpufreq/cpuinfo_max_freq. Cluster 0
+ * is the fastest. FOREGROUND work runs on every cluster but the slowest,
+ * BACKGROUND work on the slowest; on a uniform CPU both use every core.
+ * num_cores is 0 where sysfs is unreadable.
+ */
+typedef struct SupertonicCpuTopology {
+    uint32_t struct_size;
+    int32_t num_cores;
+    int32_t cpu[SUPERTONIC_MAX_CPUS];           /* logical CPU id */
+    int32_t cluster[SUPERTONIC_MAX_CPUS];
+    int32_t capacity[SUPERTONIC_MAX_CPUS];      /* 0 if the kernel does not report it */
+    int32_t max_freq_khz[SUPERTONIC_MAX_CPUS];  /* 0 if unknown */
+    uint64_t foreground_cpus;                   /* bit i = CPU i (CPUs 0-63) */
+    uint64_t background_cpus;
+} SupertonicCpuTopology;
+
+/** Zero a topology and set its struct_size. */
+SUPERTONIC_API void supertonic_cpu_topology_init(SupertonicCpuTopology* topology);
+
+/**
+ * Describe the cores the engine places its threads on; no engine needed.
+ * Initialize out_topology with supertonic_cpu_topology_init().
+ */
+SUPERTONIC_API SupertonicStatus supertonic_get_cpu_topology(SupertonicCpuTopology* out_topology);
+
+/* ABI 22 */
+
+/**
+ * Completion callback of supertonic_submit_async(). Runs on one of the
+ * engine's scheduler threads when the job is done, or on the cancelling
+ * thread with SUPERTONIC_ERROR_CANCELLED, possibly before
+ * supertonic_submit_async() has returned. Keep it short: it holds up the
+ * next job. supertonic_job_wait() on job no longer blocks from here on.
+ */
+typedef void (*SupertonicJobCallback)(void* user_data, uint64_t job, SupertonicStatus status);
+
+/**
+ * supertonic_submit() that also calls callback once the job is done, so
+ * no thread has to block in supertonic_job_wait(). The job must still be
+ * collected with supertonic_job_wait(), which then returns at once.
+ */
+SUPERTONIC_API SupertonicStatus supertonic_submit_async(SupertonicEngine* engine,
+                                                        const SupertonicSynthesisRequest* request,
+                                                        int64_t deadline_ms,
+                                                        SupertonicJobCallback callback,
+                                                        void* user_data,
+                                                        uint64_t* out_job);
+
+/**
+ * Withdraw a submitted job. Its callback runs with
+ * SUPERTONIC_ERROR_CANCELLED before this returns, and supertonic_job_wait()
+ * returns that status without audio; it must still be called. The
+ * synthesis itself is dropped from the queue, or stopped after its current
+ * diffusion step (chunked input: once its running chunks are done), unless an identical submission shares it. Returns
+ * SUPERTONIC_ERROR_NOT_FOUND if the job is unknown, collected, already
+ * cancelled or already done (its audio is then ready to collect).
+ */
+SUPERTONIC_API SupertonicStatus supertonic_cancel(SupertonicEngine* engine, uint64_t job);
+
+/* ABI 25 */
+
+/*
+ * Trace markers. The engine marks tokenize, every model run and diffusion
+ * step, output conversion and each whole synthesis, tagged with the
+ * request id. On Android they are atrace sections ("supertonic <stage>
+ * req=<id>") whenever Perfetto or systrace records the app. With no trace
+ * running a marker costs next to nothing.
+ */
+
+/**
+ * Also stream the markers of every engine in this process to path as a
+ * Chrome JSON trace (chrome://tracing, Perfetto) until
+ * supertonic_trace_stop(). The spans of one request are linked by a flow
+ * across threads. Unlike profiling this reloads nothing and can run during
+ * playback. SUPERTONIC_ERROR_INVALID_ARGUMENT if a trace is already open.
+ */
+SUPERTONIC_API SupertonicStatus supertonic_trace_start(const char* path);
+
+/** Finish and close the trace file; SUPERTONIC_ERROR_NOT_FOUND if none is open. */
+SUPERTONIC_API SupertonicStatus supertonic_trace_stop(void);
+
+/**
+ * Open a marker on the calling thread for work outside the engine, e.g.
+ * handing the audio to the caller or writing it out. request_id 0 = none.
+ * name must stay valid until the matching supertonic_trace_end() on the
+ * same thread.
+ */
+SUPERTONIC_API void supertonic_trace_begin(const char* name, uint64_t request_id);
+
+/** Close the calling thread's innermost supertonic_trace_begin() marker. */
+SUPERTONIC_API void supertonic_trace_end(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* SUPERTONIC_H */
@@ -0,0 +1,625 @@
+/*
+ * supertonic_c_api.cpp - extern "C" entry points of the engine core
+ *
+ * Thin argument validation on top of engine.cpp. No C++ exception may
+ * cross this boundary.
+ */
+
+#include "supertonic.h"
+#include "cpu_features.h"
+#include "cpu_topology.h"
+#include "engine.h"
+#include "log.h"
+#include "trace_markers.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+// Struct sizes as shipped in ABI version 1
+static constexpr size_t kRequestV1Size =
+    offsetof(SupertonicSynthesisRequest, speed) + sizeof(float);
+static constexpr size_t kConfigV1Size =
+    offsetof(SupertonicEngineConfig, intra_op_threads) + sizeof(int32_t);
+
+// At most 1.33x apart above 64, so padding adds less than a third of the work
+static constexpr int32_t kDefaultLengthBuckets[SUPERTONIC_MAX_LENGTH_BUCKETS] = {
+    16, 24, 32, 40, 48, 64, 80, 96, 128, 160, 192, 256, 320, 384, 448, 512,
+};
+
+// A few segments around the playback position, re-rendered on a speed change
+static constexpr int32_t kDefaultTextCacheEntries = 8;
+
+// Sentences up to ~190 characters stay whole; longer ones split at clauses
+static constexpr int32_t kDefaultMaxChunkTokens = 192;
+static constexpr int32_t kDefaultChunkCrossfadeMs = 10;
+
+// Diffusion steps always run before the early exit may cut the rest
+static constexpr int32_t kDefaultEarlyExitMinSteps = 3;
+
+// Android's THREAD_PRIORITY_BACKGROUND
+static constexpr int32_t kDefaultBackgroundNice = 10;
+
+// Ascending positive entries up to the first 0
+static bool validBuckets(const int32_t* buckets) {
+    for (int i = 0; i < SUPERTONIC_MAX_LENGTH_BUCKETS && buckets[i] != 0; i++) {
+        if (buckets[i] < 0 || (i > 0 && buckets[i] <= buckets[i - 1])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Copy only what the caller's (possibly older) stats struct can hold
+static void copyStatsOut(const SupertonicSynthesisStats& stats, SupertonicSynthesisStats* out) {
+    if (out == nullptr) {
+        return;
+    }
+    uint32_t callerSize = out->struct_size;
+    memcpy(out, &stats, std::min<size_t>(callerSize, sizeof(stats)));
+    out->struct_size = callerSize;
+}
+
+// Older callers pass a shorter struct; fields they don't know keep defaults
+static bool copyRequestIn(const SupertonicSynthesisRequest* request, SupertonicSynthesisRequest& effective) {
+    if (request == nullptr || request->struct_size < kRequestV1Size || request->text == nullptr) {
+        return false;
+    }
+    supertonic_request_init(&effective);
+    memcpy(&effective, request, std::min<size_t>(request->struct_size, sizeof(effective)));
+    effective.struct_size = sizeof(effective);
+    return effective.execution_class >= 0 && effective.execution_class < SUPERTONIC_NUM_EXECUTION_CLASSES;
+}
+
+// Hand the result buffers to the caller, who frees them with the *_free() calls
+static void publishResults(std::unique_ptr<std::vector<float>> samples,
+                           std::unique_ptr<supertonic::TokenTimings> timings,
+                           SupertonicAudio* out_audio,
+                           SupertonicTimestamps* out_timestamps) {
+    out_audio->samples = samples->data();
+    out_audio->num_samples = samples->size();
+    out_audio->sample_rate = supertonic::SAMPLE_RATE;
+    out_audio->internal = samples.release();
+    if (timings != nullptr) {
+        out_timestamps->tokens = timings->tokens.data();
+        out_timestamps->num_tokens = timings->tokens.size();
+        out_timestamps->approximate = timings->approximate ? 1 : 0;
+        out_timestamps->internal = timings.release();
+    }
+}
+
+/**
+ * Shared body of the synthesize entry points; out_timestamps may be null.
+ * Arguments other than the timestamps are validated here.
+ */
+static SupertonicStatus synthesizeOut(SupertonicEngine* engine,
+                                      const SupertonicSynthesisRequest* request,
+                                      SupertonicAudio* out_audio,
+                                      SupertonicSynthesisStats* out_stats,
+                                      SupertonicTimestamps* out_timestamps) {
+    SupertonicSynthesisRequest effective;
+    if (engine == nullptr || out_audio == nullptr || !copyRequestIn(request, effective) ||
+        (out_stats != nullptr && out_stats->struct_size < sizeof(uint32_t))) {
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    *out_audio = SupertonicAudio{};
+
+    try {
+        std::unique_ptr<std::vector<float>> samples(new std::vector<float>());
+        std::unique_ptr<supertonic::TokenTimings> timings(
+            out_timestamps != nullptr ? new supertonic::TokenTimings() : nullptr);
+        SupertonicSynthesisStats stats;
+        SupertonicStatus status = supertonic::synthesize(engine, effective, *samples, &stats, timings.get());
+        copyStatsOut(stats, out_stats);
+        if (status != SUPERTONIC_OK) {
+            return status;
+        }
+        publishResults(std::move(samples), std::move(timings), out_audio, out_timestamps);
+        return SUPERTONIC_OK;
+    } catch (const std::bad_alloc&) {
+        return SUPERTONIC_ERROR_OUT_OF_MEMORY;
+    } catch (...) {
+        LOGE("Unexpected exception during synthesis");
+        return SUPERTONIC_ERROR_INFERENCE;
+    }
+}
+
+extern "C" {
+
+uint32_t supertonic_abi_version(void) {
+    return SUPERTONIC_ABI_VERSION;
+}
+
+const char* supertonic_status_string(SupertonicStatus status) {
+    switch (status) {
+        case SUPERTONIC_OK: return "ok";
+        case SUPERTONIC_ERROR_INVALID_ARGUMENT: return "invalid argument";
+        case SUPERTONIC_ERROR_RUNTIME_UNAVAILABLE: return "ONNX Runtime unavailable";
+        case SUPERTONIC_ERROR_MODEL_LOAD: return "model load failed";
+        case SUPERTONIC_ERROR_TOKENIZE: return "tokenization failed";
+        case SUPERTONIC_ERROR_INFERENCE: return "inference failed";
+        case SUPERTONIC_ERROR_OUT_OF_MEMORY: return "out of memory";
+        case SUPERTONIC_ERROR_NOT_FOUND: return "not found";
+        case SUPERTONIC_ERROR_IO: return "I/O error";
+        case SUPERTONIC_ERROR_CANCELLED: return "cancelled";
+    }
+    return "unknown error";
+}
+
+int32_t supertonic_sample_rate(void) {
+    return supertonic::SAMPLE_RATE;
+}
+
+uint32_t supertonic_cpu_features(void) {
+    return supertonic::cpuFeatures();
+}
+
+void supertonic_engine_config_init(SupertonicEngineConfig* config) {
+    if (config == nullptr) {
+        return;
+    }
+    *config = SupertonicEngineConfig{};
+    config->struct_size = sizeof(SupertonicEngineConfig);
+    config->intra_op_threads = 0;
+    std::copy(std::begin(kDefaultLengthBuckets), std::end(kDefaultLengthBuckets), config->token_buckets);
+    std::copy(std::begin(kDefaultLengthBuckets), std::end(kDefaultLengthBuckets), config->latent_buckets);
+    config->text_cache_entries = kDefaultTextCacheEntries;
+    config->max_chunk_tokens = kDefaultMaxChunkTokens;
+    config->chunk_crossfade_ms = kDefaultChunkCrossfadeMs;
+    config->max_parallel_chunks = 0;
+    config->fp16_io = 0;
+    config->model_variants = 1;
+    config->xnnpack = 0;
+    config->thread_budget = 0;
+    config->global_thread_pool = 1;
+    config->spin_wait = 0;
+    config->pin_threads = 0;
+    config->shared_arena = 1;
+    config->arena_limit_mb = 0;
+    config->early_exit_threshold = 0.0f;
+    config->early_exit_min_steps = kDefaultEarlyExitMinSteps;
+    config->scheduler_threads = 0;
+    config->preempt_jobs = 1;
+    config->background_nice = kDefaultBackgroundNice;
+    config->share_weights = 1;
+    config->session_pool_size = 0;
+    config->perf_counters = 0;
+}
+
+SupertonicStatus supertonic_engine_create(const char* core_path, SupertonicEngine** out_engine) {
+    return supertonic_engine_create_with_config(core_path, nullptr, out_engine);
+}
+
+SupertonicStatus supertonic_engine_create_with_config(const char* core_path,
+                                                      const SupertonicEngineConfig* config,
+                                                      SupertonicEngine** out_engine) {
+    if (core_path == nullptr || out_engine == nullptr ||
+        (config != nullptr && config->struct_size < kConfigV1Size)) {
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+
+    SupertonicEngineConfig effective;
+    supertonic_engine_config_init(&effective);
+    if (config != nullptr) {
+        memcpy(&effective, config, std::min<size_t>(config->struct_size, sizeof(effective)));
+        effective.struct_size = sizeof(effective);
+    }
+    if (!validBuckets(effective.token_buckets) || !validBuckets(effective.latent_buckets)) {
+        LOGE("Length buckets must be ascending and positive");
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    if (effective.text_cache_entries < 0) {
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    if (effective.max_chunk_tokens < 0 ||
+        (effective.max_chunk_tokens > 0 && effective.max_chunk_tokens < SUPERTONIC_MIN_CHUNK_TOKENS) ||
+        effective.chunk_crossfade_ms < 0 || effective.max_parallel_chunks < 0) {
+        LOGE("Invalid chunking config: %d tokens, %d ms crossfade, %d parallel", effective.max_chunk_tokens,
+             effective.chunk_crossfade_ms, effective.max_parallel_chunks);
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    if (effective.thread_budget < 0) {
+        LOGE("Invalid thread budget: %d", effective.thread_budget);
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    if (effective.arena_limit_mb < 0) {
+        LOGE("Invalid arena limit: %d MB", effective.arena_limit_mb);
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    if (!(effective.early_exit_threshold >= 0.0f) || effective.early_exit_min_steps < 0) {
+        LOGE("Invalid early exit: threshold %g, %d min steps", effective.early_exit_threshold,
+             effective.early_exit_min_steps);
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    if (effective.background_nice < 0 || effective.background_nice > 19) {
+        LOGE("Invalid background nice value: %d", effective.background_nice);
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    if (effective.scheduler_threads < 0) {
+        LOGE("Invalid scheduler threads: %d", effective.scheduler_threads);
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    if (effective.session_pool_size < 0 || effective.session_pool_size > SUPERTONIC_MAX_SESSION_POOL) {
+        LOGE("Invalid session pool size: %d", effective.session_pool_size);
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+
+    try {
+        return supertonic::createEngine(core_path, effective, out_engine);
+    } catch (const std::bad_alloc&) {
+        return SUPERTONIC_ERROR_OUT_OF_MEMORY;
+    } catch (...) {
+        LOGE("Unexpected exception while creating engine");
+        return SUPERTONIC_ERROR_MODEL_LOAD;
+    }
+}
+
+void supertonic_engine_destroy(SupertonicEngine* engine) {
+    supertonic::destroyEngine(engine);
+}
+
+void supertonic_request_init(SupertonicSynthesisRequest* request) {
+    if (request == nullptr) {
+        return;
+    }
+    *request = SupertonicSynthesisRequest{};
+    request->struct_size = sizeof(SupertonicSynthesisRequest);
+    request->text = nullptr;
+    request->speaker_id = 0;
+    request->speed = 1.0f;
+    request->num_steps = 0;
+    request->request_id = 0;
+}
+
+void supertonic_stats_init(SupertonicSynthesisStats* stats) {
+    if (stats == nullptr) {
+        return;
+    }
+    *stats = SupertonicSynthesisStats{};
+    stats->struct_size = sizeof(SupertonicSynthesisStats);
+}
+
+SupertonicStatus supertonic_synthesize(SupertonicEngine* engine,
+                                       const SupertonicSynthesisRequest* request,
+                                       SupertonicAudio* out_audio) {
+    return supertonic_synthesize_with_stats(engine, request, out_audio, nullptr);
+}
+
+SupertonicStatus supertonic_synthesize_with_stats(SupertonicEngine* engine,
+                                                  const SupertonicSynthesisRequest* request,
+                                                  SupertonicAudio* out_audio,
+                                                  SupertonicSynthesisStats* out_stats) {
+    return synthesizeOut(engine, request, out_audio, out_stats, nullptr);
+}
+
+SupertonicStatus supertonic_get_stats(SupertonicEngine* engine,
+                                     uint64_t request_id,
+                                     SupertonicSynthesisStats* out_stats) {
+    if (engine == nullptr || out_stats == nullptr || out_stats->struct_size < sizeof(uint32_t)) {
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    SupertonicSynthesisStats stats;
+    if (!supertonic::findStats(engine, request_id, stats)) {
+        return SUPERTONIC_ERROR_NOT_FOUND;
+    }
+    copyStatsOut(stats, out_stats);
+    return SUPERTONIC_OK;
+}
+
+void supertonic_audio_free(SupertonicAudio* audio) {
+    if (audio == nullptr) {
+        return;
+    }
+    delete static_cast<std::vector<float>*>(audio->internal);
+    *audio = SupertonicAudio{};
+}
+
+SupertonicStatus supertonic_profiling_start(SupertonicEngine* engine, const char* output_dir) {
+    if (engine == nullptr || output_dir == nullptr || output_dir[0] == '\0') {
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    try {
+        return supertonic::startProfiling(engine, output_dir);
+    } catch (const std::bad_alloc&) {
+        return SUPERTONIC_ERROR_OUT_OF_MEMORY;
+    } catch (...) {
+        LOGE("Unexpected exception while starting profiling");
+        return SUPERTONIC_ERROR_MODEL_LOAD;
+    }
+}
+
+SupertonicStatus supertonic_profiling_stop(SupertonicEngine* engine,
+                                           char* out_trace_path,
+                                           size_t out_trace_path_size) {
+    if (engine == nullptr || (out_trace_path != nullptr && out_trace_path_size == 0)) {
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    try {
+        std::string tracePath;
+        SupertonicStatus status = supertonic::stopProfiling(engine, tracePath);
+        if (out_trace_path != nullptr) {
+            snprintf(out_trace_path, out_trace_path_size, "%s", tracePath.c_str());
+        }
+        return status;
+    } catch (const std::bad_alloc&) {
+        return SUPERTONIC_ERROR_OUT_OF_MEMORY;
+    } catch (...) {
+        LOGE("Unexpected exception while stopping profiling");
+        return SUPERTONIC_ERROR_IO;
+    }
+}
+
+void supertonic_memory_report_init(SupertonicMemoryReport* report) {
+    if (report == nullptr) {
+        return;
+    }
+    *report = SupertonicMemoryReport{};
+    report->struct_size = sizeof(SupertonicMemoryReport);
+}
+
+SupertonicStatus supertonic_get_memory_report(SupertonicEngine* engine,
+                                              SupertonicMemoryReport* out_report) {
+    if (engine == nullptr || out_report == nullptr || out_report->struct_size < sizeof(uint32_t)) {
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    SupertonicMemoryReport report;
+    supertonic_memory_report_init(&report);
+    supertonic::memoryReport(engine, report);
+
+    uint32_t callerSize = out_report->struct_size;
+    memcpy(out_report, &report, std::min<size_t>(callerSize, sizeof(report)));
+    out_report->struct_size = callerSize;
+    return SUPERTONIC_OK;
+}
+
+SupertonicStatus supertonic_trim(SupertonicEngine* engine, SupertonicTrimLevel level) {
+    if (engine == nullptr || level < SUPERTONIC_TRIM_NONE || level > SUPERTONIC_TRIM_ALL_SESSIONS) {
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    try {
+        return supertonic::trimEngine(engine, level);
+    } catch (...) {
+        LOGE("Unexpected exception while trimming");
+        return SUPERTONIC_ERROR_OUT_OF_MEMORY;
+    }
+}
+
+SupertonicStatus supertonic_warmup(SupertonicEngine* engine,
+                                   int32_t speaker_id,
+                                   const int32_t* token_counts,
+                                   const int32_t* latent_lens,
+                                   size_t num_buckets,
+                                   double* out_bucket_ms) {
+    if (engine == nullptr || (num_buckets > 0 && token_counts == nullptr) ||
+        speaker_id < 0 || speaker_id >= supertonic::NUM_SPEAKERS) {
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    try {
+        return supertonic::warmup(engine, speaker_id, token_counts, latent_lens, num_buckets, out_bucket_ms);
+    } catch (const std::bad_alloc&) {
+        return SUPERTONIC_ERROR_OUT_OF_MEMORY;
+    } catch (...) {
+        LOGE("Unexpected exception during warmup");
+        return SUPERTONIC_ERROR_INFERENCE;
+    }
+}
+
+SupertonicStatus supertonic_estimate_durations(SupertonicEngine* engine,
+                                               const char* const* texts,
+                                               size_t num_texts,
+                                               int32_t speaker_id,
+                                               float speed,
+                                               double* out_seconds) {
+    if (engine == nullptr || (num_texts > 0 && (texts == nullptr || out_seconds == nullptr)) ||
+        speaker_id < 0 || speaker_id >= supertonic::NUM_SPEAKERS) {
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    try {
+        std::vector<std::string> textList;
+        textList.reserve(num_texts);
+        for (size_t i = 0; i < num_texts; i++) {
+            if (texts[i] == nullptr) {
+                return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+            }
+            textList.emplace_back(texts[i]);
+        }
+        return supertonic::estimateDurations(engine, textList, speaker_id, speed, out_seconds);
+    } catch (const std::bad_alloc&) {
+        return SUPERTONIC_ERROR_OUT_OF_MEMORY;
+    } catch (...) {
+        LOGE("Unexpected exception while estimating durations");
+        return SUPERTONIC_ERROR_INFERENCE;
+    }
+}
+
+void supertonic_timestamps_init(SupertonicTimestamps* timestamps) {
+    if (timestamps == nullptr) {
+        return;
+    }
+    *timestamps = SupertonicTimestamps{};
+    timestamps->struct_size = sizeof(SupertonicTimestamps);
+}
+
+SupertonicStatus supertonic_synthesize_with_timestamps(SupertonicEngine* engine,
+                                                       const SupertonicSynthesisRequest* request,
+                                                       SupertonicAudio* out_audio,
+                                                       SupertonicSynthesisStats* out_stats,
+                                                       SupertonicTimestamps* out_timestamps) {
+    if (out_timestamps == nullptr || out_timestamps->struct_size < sizeof(SupertonicTimestamps)) {
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    supertonic_timestamps_init(out_timestamps);
+    return synthesizeOut(engine, request, out_audio, out_stats, out_timestamps);
+}
+
+void supertonic_timestamps_free(SupertonicTimestamps* timestamps) {
+    if (timestamps == nullptr) {
+        return;
+    }
+    delete static_cast<supertonic::TokenTimings*>(timestamps->internal);
+    supertonic_timestamps_init(timestamps);
+}
+
+SupertonicStatus supertonic_submit(SupertonicEngine* engine,
+                                   const SupertonicSynthesisRequest* request,
+                                   int64_t deadline_ms,
+                                   uint64_t* out_job) {
+    SupertonicSynthesisRequest effective;
+    if (engine == nullptr || out_job == nullptr || !copyRequestIn(request, effective)) {
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    *out_job = 0;
+    try {
+        return supertonic::submitJob(engine, effective, deadline_ms, *out_job);
+    } catch (const std::bad_alloc&) {
+        return SUPERTONIC_ERROR_OUT_OF_MEMORY;
+    } catch (...) {
+        LOGE("Unexpected exception while submitting");
+        return SUPERTONIC_ERROR_INFERENCE;
+    }
+}
+
+SupertonicStatus supertonic_submit_async(SupertonicEngine* engine,
+                                         const SupertonicSynthesisRequest* request,
+                                         int64_t deadline_ms,
+                                         SupertonicJobCallback callback,
+                                         void* user_data,
+                                         uint64_t* out_job) {
+    SupertonicSynthesisRequest effective;
+    if (engine == nullptr || callback == nullptr || out_job == nullptr || !copyRequestIn(request, effective)) {
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    *out_job = 0;
+    try {
+        return supertonic::submitJob(engine, effective, deadline_ms, *out_job, callback, user_data);
+    } catch (const std::bad_alloc&) {
+        return SUPERTONIC_ERROR_OUT_OF_MEMORY;
+    } catch (...) {
+        LOGE("Unexpected exception while submitting");
+        return SUPERTONIC_ERROR_INFERENCE;
+    }
+}
+
+SupertonicStatus supertonic_cancel(SupertonicEngine* engine, uint64_t job) {
+    if (engine == nullptr) {
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    try {
+        return supertonic::cancelJob(engine, job);
+    } catch (const std::bad_alloc&) {
+        return SUPERTONIC_ERROR_OUT_OF_MEMORY;
+    } catch (...) {
+        LOGE("Unexpected exception while cancelling");
+        return SUPERTONIC_ERROR_INFERENCE;
+    }
+}
+
+SupertonicStatus supertonic_job_wait(SupertonicEngine* engine,
+                                     uint64_t job,
+                                     SupertonicAudio* out_audio,
+                                     SupertonicSynthesisStats* out_stats,
+                                     SupertonicTimestamps* out_timestamps) {
+    if (engine == nullptr || out_audio == nullptr ||
+        (out_stats != nullptr && out_stats->struct_size < sizeof(uint32_t)) ||
+        (out_timestamps != nullptr && out_timestamps->struct_size < sizeof(SupertonicTimestamps))) {
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    *out_audio = SupertonicAudio{};
+    if (out_timestamps != nullptr) {
+        supertonic_timestamps_init(out_timestamps);
+    }
+
+    try {
+        std::unique_ptr<std::vector<float>> samples(new std::vector<float>());
+        std::unique_ptr<supertonic::TokenTimings> timings(
+            out_timestamps != nullptr ? new supertonic::TokenTimings() : nullptr);
+        SupertonicSynthesisStats stats = {};
+        SupertonicStatus status = supertonic::waitJob(engine, job, *samples, &stats, timings.get());
+        if (status == SUPERTONIC_ERROR_NOT_FOUND) {
+            return status;
+        }
+        copyStatsOut(stats, out_stats);
+        if (status != SUPERTONIC_OK) {
+            return status;
+        }
+        publishResults(std::move(samples), std::move(timings), out_audio, out_timestamps);
+        return SUPERTONIC_OK;
+    } catch (const std::bad_alloc&) {
+        return SUPERTONIC_ERROR_OUT_OF_MEMORY;
+    } catch (...) {
+        LOGE("Unexpected exception while waiting for a job");
+        return SUPERTONIC_ERROR_INFERENCE;
+    }
+}
+
+void supertonic_cpu_topology_init(SupertonicCpuTopology* topology) {
+    if (topology == nullptr) {
+        return;
+    }
+    *topology = SupertonicCpuTopology{};
+    topology->struct_size = sizeof(SupertonicCpuTopology);
+}
+
+SupertonicStatus supertonic_get_cpu_topology(SupertonicCpuTopology* out_topology) {
+    if (out_topology == nullptr || out_topology->struct_size < sizeof(uint32_t)) {
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    try {
+        SupertonicCpuTopology topology;
+        supertonic_cpu_topology_init(&topology);
+        for (const supertonic::CpuCore& core : supertonic::cpuTopology()) {
+            if (topology.num_cores == SUPERTONIC_MAX_CPUS) {
+                break;
+            }
+            const int32_t i = topology.num_cores++;
+            topology.cpu[i] = core.cpu;
+            topology.cluster[i] = core.cluster;
+            topology.capacity[i] = (int32_t)core.capacity;
+            topology.max_freq_khz[i] = (int32_t)core.maxFreqKhz;
+        }
+        topology.foreground_cpus = supertonic::cpuMask(supertonic::bigCores());
+        topology.background_cpus = supertonic::cpuMask(supertonic::littleCores());
+
+        uint32_t callerSize = out_topology->struct_size;
+        memcpy(out_topology, &topology, std::min<size_t>(callerSize, sizeof(topology)));
+        out_topology->struct_size = callerSize;
+        return SUPERTONIC_OK;
+    } catch (const std::bad_alloc&) {
+        return SUPERTONIC_ERROR_OUT_OF_MEMORY;
+    }
+}
+
+SupertonicStatus supertonic_trace_start(const char* path) {
+    if (path == nullptr || path[0] == '\0') {
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    try {
+        return supertonic::startTraceFile(path);
+    } catch (const std::bad_alloc&) {
+        return SUPERTONIC_ERROR_OUT_OF_MEMORY;
+    }
+}
+
+SupertonicStatus supertonic_trace_stop(void) {
+    try {
+        return supertonic::stopTraceFile();
+    } catch (const std::bad_alloc&) {
+        return SUPERTONIC_ERROR_OUT_OF_MEMORY;
+    }
+}
+
+void supertonic_trace_begin(const char* name, uint64_t request_id) {
+    supertonic::beginCallerMarker(name, request_id);
+}
+
+void supertonic_trace_end(void) {
+    supertonic::endCallerMarker();
+}
+
+} // extern "C"
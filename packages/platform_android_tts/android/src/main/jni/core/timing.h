@@ -0,0 +1,45 @@
+/*
+ * timing.h - Monotonic clock helpers for per-stage statistics
+ */
+
+#pragma once
+
+#include <chrono>
+
+#include <sys/resource.h>
+
+namespace supertonic {
+
+using Clock = std::chrono::steady_clock;
+
+inline double elapsedMs(Clock::time_point start, Clock::time_point end = Clock::now()) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/** CPU time consumed so far, in milliseconds. */
+struct CpuTimes {
+    double threadUserMs = 0;
+    double threadSystemMs = 0;
+    double processMs = 0;
+};
+
+inline double timevalMs(const timeval& tv) {
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+inline CpuTimes cpuTimesNow() {
+    CpuTimes times;
+    rusage usage;
+#ifdef RUSAGE_THREAD
+    if (getrusage(RUSAGE_THREAD, &usage) == 0) {
+        times.threadUserMs = timevalMs(usage.ru_utime);
+        times.threadSystemMs = timevalMs(usage.ru_stime);
+    }
+#endif
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        times.processMs = timevalMs(usage.ru_utime) + timevalMs(usage.ru_stime);
+    }
+    return times;
+}
+
+} // namespace supertonic
@@ -0,0 +1,198 @@
+/*
+ * trace_markers.cpp - atrace sections and the streaming Chrome JSON writer
+ */
+
+#include "trace_markers.h"
+#include "log.h"
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <new>
+
+#include <unistd.h>
+
+#if defined(__ANDROID__)
+#include <android/trace.h>
+#endif
+
+namespace supertonic {
+
+namespace {
+
+enum MarkerBackend : unsigned {
+    MARKER_ATRACE = 1u << 0,
+    MARKER_FILE = 1u << 1,
+};
+
+/** The trace file of supertonic_trace_start(), shared by all engines. */
+struct TraceFile {
+    std::mutex mutex;
+    FILE* file = nullptr;
+    std::string path;
+    int64_t pid = 0;
+    int64_t baseUs = 0;  // spans opened before the start are left out
+    size_t events = 0;
+    bool failed = false;
+};
+
+TraceFile g_traceFile;
+std::atomic<bool> g_traceFileOpen{false};
+
+// Markers opened with supertonic_trace_begin(), innermost last. Deeper
+// nesting is counted but not recorded
+constexpr int kMaxCallerMarkers = 16;
+
+struct CallerMarker {
+    TraceSpan span;
+    unsigned markers;
+};
+
+thread_local CallerMarker t_callerMarkers[kMaxCallerMarkers];
+thread_local int t_callerDepth = 0;
+
+bool atraceEnabled() {
+#if defined(__ANDROID__)
+    return ATrace_isEnabled();
+#else
+    return false;
+#endif
+}
+
+#if defined(__ANDROID__)
+/** "supertonic <name> req=<id> step=<n>"; atrace keeps the first 127 bytes. */
+void beginAtraceSection(const TraceSpan& span) {
+    char name[128];
+    int length = snprintf(name, sizeof(name), "supertonic %s", span.name);
+    if (span.requestId != 0 && length > 0 && length < (int)sizeof(name)) {
+        length += snprintf(name + length, sizeof(name) - length, " req=%llu",
+                           (unsigned long long)span.requestId);
+    }
+    if (span.step >= 0 && length > 0 && length < (int)sizeof(name)) {
+        snprintf(name + length, sizeof(name) - length, " step=%d", span.step);
+    }
+    ATrace_beginSection(name);
+}
+#endif
+
+void writeFileEvent(const TraceSpan& span) {
+    std::lock_guard<std::mutex> lock(g_traceFile.mutex);
+    if (g_traceFile.file == nullptr || span.startUs < g_traceFile.baseUs) {
+        return;
+    }
+    // Called from destructors: a span that cannot be formatted is dropped
+    try {
+        const std::string event = formatSpanEvent(span, g_traceFile.pid, g_traceFile.baseUs);
+        if (fprintf(g_traceFile.file, ",\n%s", event.c_str()) < 0) {
+            g_traceFile.failed = true;
+        }
+        g_traceFile.events++;
+    } catch (const std::bad_alloc&) {
+    }
+}
+
+} // namespace
+
+bool traceMarkersEnabled() {
+    return g_traceFileOpen.load(std::memory_order_relaxed) || atraceEnabled();
+}
+
+unsigned beginTraceMarker(const TraceSpan& span) {
+    unsigned markers = 0;
+#if defined(__ANDROID__)
+    if (ATrace_isEnabled()) {
+        beginAtraceSection(span);
+        markers |= MARKER_ATRACE;
+    }
+#else
+    (void)span;
+#endif
+    if (g_traceFileOpen.load(std::memory_order_relaxed)) {
+        markers |= MARKER_FILE;
+    }
+    return markers;
+}
+
+void endTraceMarker(const TraceSpan& span, unsigned markers) {
+#if defined(__ANDROID__)
+    // Sections close even if tracing stopped meanwhile, so they stay nested
+    if ((markers & MARKER_ATRACE) != 0) {
+        ATrace_endSection();
+    }
+#endif
+    if ((markers & MARKER_FILE) != 0) {
+        writeFileEvent(span);
+    }
+}
+
+void beginCallerMarker(const char* name, uint64_t requestId) {
+    const int depth = t_callerDepth++;
+    if (depth >= kMaxCallerMarkers) {
+        return;
+    }
+    CallerMarker& marker = t_callerMarkers[depth];
+    marker.markers = 0;
+    if (name == nullptr || !traceMarkersEnabled()) {
+        return;
+    }
+    marker.span = TraceSpan{name, requestId, traceThreadId(), traceNowUs(), 0, MODEL_NONE, -1};
+    marker.markers = beginTraceMarker(marker.span);
+}
+
+void endCallerMarker() {
+    if (t_callerDepth == 0) {
+        return;
+    }
+    const int depth = --t_callerDepth;
+    if (depth >= kMaxCallerMarkers || t_callerMarkers[depth].markers == 0) {
+        return;
+    }
+    CallerMarker& marker = t_callerMarkers[depth];
+    marker.span.durUs = traceNowUs() - marker.span.startUs;
+    endTraceMarker(marker.span, marker.markers);
+}
+
+SupertonicStatus startTraceFile(const std::string& path) {
+    std::lock_guard<std::mutex> lock(g_traceFile.mutex);
+    if (g_traceFile.file != nullptr) {
+        LOGE("Trace already being written to %s", g_traceFile.path.c_str());
+        return SUPERTONIC_ERROR_INVALID_ARGUMENT;
+    }
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        LOGE("Failed to create trace file: %s", path.c_str());
+        return SUPERTONIC_ERROR_IO;
+    }
+    g_traceFile.file = file;
+    g_traceFile.path = path;
+    g_traceFile.pid = (int64_t)getpid();
+    g_traceFile.baseUs = traceNowUs();
+    g_traceFile.events = 0;
+    g_traceFile.failed = fprintf(file,
+                                 "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+                                 "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%lld,"
+                                 "\"args\":{\"name\":\"supertonic\"}}",
+                                 (long long)g_traceFile.pid) < 0;
+    g_traceFileOpen.store(true);
+    LOGI("Tracing to %s", path.c_str());
+    return SUPERTONIC_OK;
+}
+
+SupertonicStatus stopTraceFile() {
+    std::lock_guard<std::mutex> lock(g_traceFile.mutex);
+    if (g_traceFile.file == nullptr) {
+        return SUPERTONIC_ERROR_NOT_FOUND;
+    }
+    g_traceFileOpen.store(false);
+    bool failed = g_traceFile.failed || fputs("\n]}\n", g_traceFile.file) < 0;
+    failed = fclose(g_traceFile.file) != 0 || failed;
+    g_traceFile.file = nullptr;
+    if (failed) {
+        LOGE("Failed to write trace file: %s", g_traceFile.path.c_str());
+        return SUPERTONIC_ERROR_IO;
+    }
+    LOGI("Wrote trace %s (%zu spans)", g_traceFile.path.c_str(), g_traceFile.events);
+    return SUPERTONIC_OK;
+}
+
+} // namespace supertonic
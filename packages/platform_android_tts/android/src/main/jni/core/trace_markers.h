@@ -0,0 +1,45 @@
+/*
+ * trace_markers.h - Scoped markers for system traces
+ *
+ * Every TraceScope (profiling.h) is also reported here, independently of
+ * ORT profiling. Two backends:
+ * - Android: atrace sections ("supertonic <stage> req=<id>"), recorded by
+ *   Perfetto / systrace whenever the app is traced.
+ * - Any platform: supertonic_trace_start() streams the spans as Chrome JSON
+ *   to a file, with the spans of each request bound into one flow.
+ * Both are checked as each scope opens; with neither on, a scope costs a
+ * relaxed load plus, on Android, ATrace_isEnabled().
+ */
+
+#pragma once
+
+#include "profiling.h"
+#include "supertonic.h"
+
+#include <string>
+
+namespace supertonic {
+
+/** A backend would record a marker opened now. */
+bool traceMarkersEnabled();
+
+/**
+ * Open a marker for span (name, request, tid and start set) on the calling
+ * thread. Returns the backends it went to, for endTraceMarker().
+ */
+unsigned beginTraceMarker(const TraceSpan& span);
+
+/** Close the calling thread's innermost marker; span.durUs is set. */
+void endTraceMarker(const TraceSpan& span, unsigned markers);
+
+/** Marker pair for callers outside the engine; see supertonic_trace_begin(). */
+void beginCallerMarker(const char* name, uint64_t requestId);
+void endCallerMarker();
+
+/** Start streaming markers to path; see supertonic_trace_start(). */
+SupertonicStatus startTraceFile(const std::string& path);
+
+/** Finish and close the trace file; see supertonic_trace_stop(). */
+SupertonicStatus stopTraceFile();
+
+} // namespace supertonic
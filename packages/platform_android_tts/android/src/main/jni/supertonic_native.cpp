@@ -1,1193 +1,838 @@
 /*
  * SupertonicNative.cpp - JNI bindings for Supertonic TTS using ONNX Runtime
  *
- * This implementation uses the ONNX Runtime already bundled with sherpa-onnx,
- * avoiding native library conflicts. It dynamically links to libonnxruntime.so
- * at runtime using dlopen/dlsym.
+ * Thin shim over the platform-independent engine core (core/supertonic.h).
+ * It only converts between Java and C types and owns the process-wide
+ * engine instance used by SupertonicNative.kt.
  *
- * Supertonic Pipeline:
- * 1. text_encoder.onnx: Text tokens → hidden states
- * 2. duration_predictor.onnx: Hidden states → durations
- * 3. vector_estimator.onnx: Hidden + durations → latent vectors
- * 4. vocoder.onnx: Latent vectors → audio samples
+ * The core uses the ONNX Runtime already bundled with sherpa-onnx,
+ * avoiding native library conflicts. It dynamically links to
+ * libonnxruntime.so at runtime using dlopen/dlsym.
  */
 
 #include <jni.h>
-#include <android/log.h>
-#include <dlfcn.h>
+#include <algorithm>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <vector>
-#include <cstdint>
-#include <memory>
-#include <fstream>
-#include <sstream>
-#include <map>
-#include <cmath>
-#include <cstdlib>
-
-#define LOG_TAG "SupertonicNative"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
-#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
-
-// ONNX Runtime C API type definitions - minimal subset needed for inference
-// Based on ONNX Runtime v17 API (ORT_API_VERSION = 17)
-
-// Opaque types (forward declarations)
-typedef struct OrtEnv OrtEnv;
-typedef struct OrtStatus OrtStatus;
-typedef struct OrtMemoryInfo OrtMemoryInfo;
-typedef struct OrtSession OrtSession;
-typedef struct OrtValue OrtValue;
-typedef struct OrtRunOptions OrtRunOptions;
-typedef struct OrtTypeInfo OrtTypeInfo;
-typedef struct OrtTensorTypeAndShapeInfo OrtTensorTypeAndShapeInfo;
-typedef struct OrtSessionOptions OrtSessionOptions;
-typedef struct OrtCustomOpDomain OrtCustomOpDomain;
-typedef struct OrtAllocator OrtAllocator;
-typedef struct OrtModelMetadata OrtModelMetadata;
-typedef struct OrtThreadingOptions OrtThreadingOptions;
-typedef struct OrtArenaCfg OrtArenaCfg;
-typedef struct OrtPrepackedWeightsContainer OrtPrepackedWeightsContainer;
-typedef struct OrtTensorRTProviderOptionsV2 OrtTensorRTProviderOptionsV2;
-typedef struct OrtCUDAProviderOptionsV2 OrtCUDAProviderOptionsV2;
-typedef struct OrtCANNProviderOptions OrtCANNProviderOptions;
-typedef struct OrtDnnlProviderOptions OrtDnnlProviderOptions;
-typedef struct OrtOp OrtOp;
-typedef struct OrtOpAttr OrtOpAttr;
-typedef struct OrtLogger OrtLogger;
-typedef struct OrtShapeInferContext OrtShapeInferContext;
-typedef struct OrtKernelInfo OrtKernelInfo;
-typedef struct OrtKernelContext OrtKernelContext;
-typedef struct OrtIoBinding OrtIoBinding;
-typedef struct OrtMapTypeInfo OrtMapTypeInfo;
-typedef struct OrtSequenceTypeInfo OrtSequenceTypeInfo;
-typedef struct OrtOptionalTypeInfo OrtOptionalTypeInfo;
-
-// Enums
-typedef enum {
-    ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED = 0,
-    ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT = 1,
-    ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8 = 2,
-    ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8 = 3,
-    ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT16 = 4,
-    ONNX_TENSOR_ELEMENT_DATA_TYPE_INT16 = 5,
-    ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32 = 6,
-    ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64 = 7,
-    ONNX_TENSOR_ELEMENT_DATA_TYPE_STRING = 8,
-    ONNX_TENSOR_ELEMENT_DATA_TYPE_BOOL = 9,
-    ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16 = 10,
-    ONNX_TENSOR_ELEMENT_DATA_TYPE_DOUBLE = 11,
-    ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT32 = 12,
-    ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT64 = 13,
-} ONNXTensorElementDataType;
-
-typedef enum {
-    ONNX_TYPE_UNKNOWN = 0,
-    ONNX_TYPE_TENSOR = 1,
-    ONNX_TYPE_SEQUENCE = 2,
-    ONNX_TYPE_MAP = 3,
-    ONNX_TYPE_OPAQUE = 4,
-    ONNX_TYPE_SPARSETENSOR = 5,
-    ONNX_TYPE_OPTIONAL = 6
-} ONNXType;
-
-typedef enum {
-    ORT_LOGGING_LEVEL_VERBOSE = 0,
-    ORT_LOGGING_LEVEL_INFO = 1,
-    ORT_LOGGING_LEVEL_WARNING = 2,
-    ORT_LOGGING_LEVEL_ERROR = 3,
-    ORT_LOGGING_LEVEL_FATAL = 4,
-} OrtLoggingLevel;
-
-typedef enum {
-    ORT_OK = 0,
-    ORT_FAIL = 1,
-    ORT_INVALID_ARGUMENT = 2,
-    ORT_NO_SUCHFILE = 3,
-    ORT_NO_MODEL = 4,
-    ORT_ENGINE_ERROR = 5,
-    ORT_RUNTIME_EXCEPTION = 6,
-    ORT_INVALID_PROTOBUF = 7,
-    ORT_MODEL_LOADED = 8,
-    ORT_NOT_IMPLEMENTED = 9,
-    ORT_INVALID_GRAPH = 10,
-    ORT_EP_FAIL = 11,
-} OrtErrorCode;
-
-typedef enum {
-    OrtInvalidAllocator = -1,
-    OrtDeviceAllocator = 0,
-    OrtArenaAllocator = 1
-} OrtAllocatorType;
-
-typedef enum {
-    OrtMemTypeCPUInput = -2,
-    OrtMemTypeCPUOutput = -1,
-    OrtMemTypeCPU = OrtMemTypeCPUOutput,
-    OrtMemTypeDefault = 0,
-} OrtMemType;
-
-typedef enum {
-    ORT_DISABLE_ALL = 0,
-    ORT_ENABLE_BASIC = 1,
-    ORT_ENABLE_EXTENDED = 2,
-    ORT_ENABLE_ALL = 99
-} GraphOptimizationLevel;
-
-// OrtApi struct - function pointer table
-// The order MUST match the official ONNX Runtime header exactly!
-struct OrtApi {
-    // Index 0-2: OrtStatus functions
-    OrtStatus* (*CreateStatus)(OrtErrorCode code, const char* msg);
-    OrtErrorCode (*GetErrorCode)(const OrtStatus* status);
-    const char* (*GetErrorMessage)(const OrtStatus* status);
-    
-    // Index 3-4: OrtEnv creation
-    OrtStatus* (*CreateEnv)(OrtLoggingLevel log_severity_level, const char* logid, OrtEnv** out);
-    OrtStatus* (*CreateEnvWithCustomLogger)(void* logging_function, void* logger_param, 
-                                            OrtLoggingLevel log_severity_level, const char* logid, OrtEnv** out);
-    
-    // Index 5-6: Telemetry
-    OrtStatus* (*EnableTelemetryEvents)(const OrtEnv* env);
-    OrtStatus* (*DisableTelemetryEvents)(const OrtEnv* env);
-    
-    // Index 7-8: Session creation
-    OrtStatus* (*CreateSession)(const OrtEnv* env, const char* model_path,
-                                const OrtSessionOptions* options, OrtSession** out);
-    OrtStatus* (*CreateSessionFromArray)(const OrtEnv* env, const void* model_data, size_t model_data_length,
-                                         const OrtSessionOptions* options, OrtSession** out);
-    
-    // Index 9: Run
-    OrtStatus* (*Run)(OrtSession* session, const OrtRunOptions* run_options,
-                      const char* const* input_names, const OrtValue* const* inputs, size_t input_len,
-                      const char* const* output_names, size_t output_names_len, OrtValue** outputs);
-    
-    // Index 10-26: SessionOptions functions
-    OrtStatus* (*CreateSessionOptions)(OrtSessionOptions** options);
-    OrtStatus* (*SetOptimizedModelFilePath)(OrtSessionOptions* options, const char* optimized_model_filepath);
-    OrtStatus* (*CloneSessionOptions)(const OrtSessionOptions* in_options, OrtSessionOptions** out_options);
-    OrtStatus* (*SetSessionExecutionMode)(OrtSessionOptions* options, int execution_mode);
-    OrtStatus* (*EnableProfiling)(OrtSessionOptions* options, const char* profile_file_prefix);
-    OrtStatus* (*DisableProfiling)(OrtSessionOptions* options);
-    OrtStatus* (*EnableMemPattern)(OrtSessionOptions* options);
-    OrtStatus* (*DisableMemPattern)(OrtSessionOptions* options);
-    OrtStatus* (*EnableCpuMemArena)(OrtSessionOptions* options);
-    OrtStatus* (*DisableCpuMemArena)(OrtSessionOptions* options);
-    OrtStatus* (*SetSessionLogId)(OrtSessionOptions* options, const char* logid);
-    OrtStatus* (*SetSessionLogVerbosityLevel)(OrtSessionOptions* options, int session_log_verbosity_level);
-    OrtStatus* (*SetSessionLogSeverityLevel)(OrtSessionOptions* options, int session_log_severity_level);
-    OrtStatus* (*SetSessionGraphOptimizationLevel)(OrtSessionOptions* options, GraphOptimizationLevel graph_optimization_level);
-    OrtStatus* (*SetIntraOpNumThreads)(OrtSessionOptions* options, int intra_op_num_threads);
-    OrtStatus* (*SetInterOpNumThreads)(OrtSessionOptions* options, int inter_op_num_threads);
-    
-    // Index 27-28: CustomOpDomain
-    OrtStatus* (*CreateCustomOpDomain)(const char* domain, OrtCustomOpDomain** out);
-    OrtStatus* (*CustomOpDomain_Add)(OrtCustomOpDomain* custom_op_domain, const void* op);
-    
-    // Index 29-30: SessionOptions continued
-    OrtStatus* (*AddCustomOpDomain)(OrtSessionOptions* options, OrtCustomOpDomain* custom_op_domain);
-    OrtStatus* (*RegisterCustomOpsLibrary)(OrtSessionOptions* options, const char* library_path, void** library_handle);
-    
-    // Index 31-36: Session info
-    OrtStatus* (*SessionGetInputCount)(const OrtSession* session, size_t* out);
-    OrtStatus* (*SessionGetOutputCount)(const OrtSession* session, size_t* out);
-    OrtStatus* (*SessionGetOverridableInitializerCount)(const OrtSession* session, size_t* out);
-    OrtStatus* (*SessionGetInputTypeInfo)(const OrtSession* session, size_t index, OrtTypeInfo** type_info);
-    OrtStatus* (*SessionGetOutputTypeInfo)(const OrtSession* session, size_t index, OrtTypeInfo** type_info);
-    OrtStatus* (*SessionGetOverridableInitializerTypeInfo)(const OrtSession* session, size_t index, OrtTypeInfo** type_info);
-    
-    // Index 37-39: Session names
-    OrtStatus* (*SessionGetInputName)(const OrtSession* session, size_t index, OrtAllocator* allocator, char** value);
-    OrtStatus* (*SessionGetOutputName)(const OrtSession* session, size_t index, OrtAllocator* allocator, char** value);
-    OrtStatus* (*SessionGetOverridableInitializerName)(const OrtSession* session, size_t index, OrtAllocator* allocator, char** value);
-    
-    // Index 40-49: RunOptions
-    OrtStatus* (*CreateRunOptions)(OrtRunOptions** out);
-    OrtStatus* (*RunOptionsSetRunLogVerbosityLevel)(OrtRunOptions* options, int log_verbosity_level);
-    OrtStatus* (*RunOptionsSetRunLogSeverityLevel)(OrtRunOptions* options, int log_severity_level);
-    OrtStatus* (*RunOptionsSetRunTag)(OrtRunOptions* options, const char* run_tag);
-    OrtStatus* (*RunOptionsGetRunLogVerbosityLevel)(const OrtRunOptions* options, int* log_verbosity_level);
-    OrtStatus* (*RunOptionsGetRunLogSeverityLevel)(const OrtRunOptions* options, int* log_severity_level);
-    OrtStatus* (*RunOptionsGetRunTag)(const OrtRunOptions* options, const char** run_tag);
-    OrtStatus* (*RunOptionsSetTerminate)(OrtRunOptions* options);
-    OrtStatus* (*RunOptionsUnsetTerminate)(OrtRunOptions* options);
-    
-    // Index 50-55: OrtValue/Tensor creation
-    OrtStatus* (*CreateTensorAsOrtValue)(OrtAllocator* allocator, const int64_t* shape, size_t shape_len,
-                                         ONNXTensorElementDataType type, OrtValue** out);
-    OrtStatus* (*CreateTensorWithDataAsOrtValue)(const OrtMemoryInfo* info, void* p_data, size_t p_data_len,
-                                                  const int64_t* shape, size_t shape_len,
-                                                  ONNXTensorElementDataType type, OrtValue** out);
-    OrtStatus* (*IsTensor)(const OrtValue* value, int* out);
-    OrtStatus* (*GetTensorMutableData)(OrtValue* value, void** out);
-    OrtStatus* (*FillStringTensor)(OrtValue* value, const char* const* s, size_t s_len);
-    OrtStatus* (*GetStringTensorDataLength)(const OrtValue* value, size_t* len);
-    
-    // Index 56: GetStringTensorContent
-    OrtStatus* (*GetStringTensorContent)(const OrtValue* value, void* s, size_t s_len, size_t* offsets, size_t offsets_len);
-    
-    // Index 57-58: TypeInfo
-    OrtStatus* (*CastTypeInfoToTensorInfo)(const OrtTypeInfo* type_info, const OrtTensorTypeAndShapeInfo** out);
-    OrtStatus* (*GetOnnxTypeFromTypeInfo)(const OrtTypeInfo* type_info, ONNXType* out);
-    
-    // Index 59-66: TensorTypeAndShapeInfo
-    OrtStatus* (*CreateTensorTypeAndShapeInfo)(OrtTensorTypeAndShapeInfo** out);
-    OrtStatus* (*SetTensorElementType)(OrtTensorTypeAndShapeInfo* info, ONNXTensorElementDataType type);
-    OrtStatus* (*SetDimensions)(OrtTensorTypeAndShapeInfo* info, const int64_t* dim_values, size_t dim_count);
-    OrtStatus* (*GetTensorElementType)(const OrtTensorTypeAndShapeInfo* info, ONNXTensorElementDataType* out);
-    OrtStatus* (*GetDimensionsCount)(const OrtTensorTypeAndShapeInfo* info, size_t* out);
-    OrtStatus* (*GetDimensions)(const OrtTensorTypeAndShapeInfo* info, int64_t* dim_values, size_t dim_values_length);
-    OrtStatus* (*GetSymbolicDimensions)(const OrtTensorTypeAndShapeInfo* info, const char** dim_params, size_t dim_params_length);
-    OrtStatus* (*GetTensorShapeElementCount)(const OrtTensorTypeAndShapeInfo* info, size_t* out);
-    
-    // Index 67-69: OrtValue info
-    OrtStatus* (*GetTensorTypeAndShape)(const OrtValue* value, OrtTensorTypeAndShapeInfo** out);
-    OrtStatus* (*GetTypeInfo)(const OrtValue* value, OrtTypeInfo** out);
-    OrtStatus* (*GetValueType)(const OrtValue* value, ONNXType* out);
-    
-    // Index 70-78: MemoryInfo
-    OrtStatus* (*CreateMemoryInfo)(const char* name, OrtAllocatorType type, int id,
-                                   OrtMemType mem_type, OrtMemoryInfo** out);
-    OrtStatus* (*CreateCpuMemoryInfo)(OrtAllocatorType type, OrtMemType mem_type, OrtMemoryInfo** out);
-    OrtStatus* (*CompareMemoryInfo)(const OrtMemoryInfo* info1, const OrtMemoryInfo* info2, int* out);
-    OrtStatus* (*MemoryInfoGetName)(const OrtMemoryInfo* ptr, const char** out);
-    OrtStatus* (*MemoryInfoGetId)(const OrtMemoryInfo* ptr, int* out);
-    OrtStatus* (*MemoryInfoGetMemType)(const OrtMemoryInfo* ptr, OrtMemType* out);
-    OrtStatus* (*MemoryInfoGetType)(const OrtMemoryInfo* ptr, OrtAllocatorType* out);
-    OrtStatus* (*AllocatorAlloc)(OrtAllocator* ort_allocator, size_t size, void** out);
-    OrtStatus* (*AllocatorFree)(OrtAllocator* ort_allocator, void* p);
-    
-    // Index 79-80: Allocator
-    OrtStatus* (*AllocatorGetInfo)(const OrtAllocator* ort_allocator, const OrtMemoryInfo** out);
-    OrtStatus* (*GetAllocatorWithDefaultOptions)(OrtAllocator** out);
-    
-    // Index 81: AddFreeDimensionOverride
-    OrtStatus* (*AddFreeDimensionOverride)(OrtSessionOptions* options, const char* dim_denotation, int64_t dim_value);
-    
-    // Index 82-84: Non-tensor values
-    OrtStatus* (*GetValue)(const OrtValue* value, int index, OrtAllocator* allocator, OrtValue** out);
-    OrtStatus* (*GetValueCount)(const OrtValue* value, size_t* out);
-    OrtStatus* (*CreateValue)(const OrtValue* const* in, size_t num_values, ONNXType value_type, OrtValue** out);
-    
-    // Index 85-86: Opaque values
-    OrtStatus* (*CreateOpaqueValue)(const char* domain_name, const char* type_name,
-                                    const void* data_container, size_t data_container_size, OrtValue** out);
-    OrtStatus* (*GetOpaqueValue)(const char* domain_name, const char* type_name, const OrtValue* in,
-                                 void* data_container, size_t data_container_size);
-    
-    // Index 87-89: KernelInfo
-    OrtStatus* (*KernelInfoGetAttribute_float)(const OrtKernelInfo* info, const char* name, float* out);
-    OrtStatus* (*KernelInfoGetAttribute_int64)(const OrtKernelInfo* info, const char* name, int64_t* out);
-    OrtStatus* (*KernelInfoGetAttribute_string)(const OrtKernelInfo* info, const char* name, char* out, size_t* size);
-    
-    // Index 90-93: KernelContext
-    OrtStatus* (*KernelContext_GetInputCount)(const OrtKernelContext* context, size_t* out);
-    OrtStatus* (*KernelContext_GetOutputCount)(const OrtKernelContext* context, size_t* out);
-    OrtStatus* (*KernelContext_GetInput)(const OrtKernelContext* context, size_t index, const OrtValue** out);
-    OrtStatus* (*KernelContext_GetOutput)(OrtKernelContext* context, size_t index, const int64_t* dim_values, size_t dim_count, OrtValue** out);
-    
-    // Index 94-104: Release functions
-    void (*ReleaseEnv)(OrtEnv* input);
-    void (*ReleaseStatus)(OrtStatus* input);
-    void (*ReleaseMemoryInfo)(OrtMemoryInfo* input);
-    void (*ReleaseSession)(OrtSession* input);
-    void (*ReleaseValue)(OrtValue* input);
-    void (*ReleaseRunOptions)(OrtRunOptions* input);
-    void (*ReleaseTypeInfo)(OrtTypeInfo* input);
-    void (*ReleaseTensorTypeAndShapeInfo)(OrtTensorTypeAndShapeInfo* input);
-    void (*ReleaseSessionOptions)(OrtSessionOptions* input);
-    void (*ReleaseCustomOpDomain)(OrtCustomOpDomain* input);
-    
-    // More functions follow but we don't need them for basic inference
-    // Using void* padding to allow safe struct extension
-    void* _padding[200];  // Reserve space for additional API functions
-};
 
-// OrtApiBase struct - entry point
-struct OrtApiBase {
-    const OrtApi* (*GetApi)(uint32_t version);
-    const char* (*GetVersionString)(void);
-};
+#include "core/log.h"
+#include "core/supertonic.h"
 
 // Global state
-static bool g_initialized = false;
-static void* g_ortLibHandle = nullptr;
-static const OrtApi* g_ortApi = nullptr;
-static OrtEnv* g_ortEnv = nullptr;
-static OrtMemoryInfo* g_memoryInfo = nullptr;
-static OrtAllocator* g_allocator = nullptr;
-
-// Session pointers for Supertonic models
-static OrtSession* g_textEncoder = nullptr;
-static OrtSession* g_durationPredictor = nullptr;
-static OrtSession* g_vectorEstimator = nullptr;
-static OrtSession* g_vocoder = nullptr;
-static OrtSessionOptions* g_sessionOptions = nullptr;
-
-// Unicode indexer for text tokenization
-static std::map<int32_t, int64_t> g_unicodeIndexer;
-static std::string g_modelBasePath;
-
-// Voice style cache: speaker_id -> {style_ttl, style_dp}
-struct VoiceStyle {
-    std::vector<float> style_ttl;  // [50 * 256] flattened
-    std::vector<float> style_dp;   // [8 * 16] flattened
-    bool loaded = false;
-};
-static std::map<int, VoiceStyle> g_voiceStyles;
+static SupertonicEngine* g_engine = nullptr;
 
-// Constants from tts.json
-static constexpr int SAMPLE_RATE = 44100;           // ae.sample_rate
-static constexpr int BASE_CHUNK_SIZE = 512;         // ae.base_chunk_size  
-static constexpr int CHUNK_COMPRESS_FACTOR = 6;     // ttl.chunk_compress_factor
-static constexpr int LATENT_DIM = 24;               // ttl.latent_dim
-static constexpr int LATENT_CHANNELS = LATENT_DIM * CHUNK_COMPRESS_FACTOR;  // 24 * 6 = 144
-static constexpr int CHUNK_SIZE = BASE_CHUNK_SIZE * CHUNK_COMPRESS_FACTOR;  // 512 * 6 = 3072
+// Synthesis holds a shared lock so dispose() cannot free sessions mid-run
+static std::shared_timed_mutex g_engineMutex;
+
+// SupertonicNative.onJobComplete(), resolved by the first submitAsync()
+static std::once_flag g_callbackOnce;
+static JavaVM* g_javaVm = nullptr;
+static jclass g_nativeClass = nullptr;
+static jmethodID g_onJobComplete = nullptr;
 
 /**
- * Initialize ONNX Runtime by dynamically loading the library
+ * Flat DoubleArray layout of SupertonicSynthesisStats handed to Kotlin.
+ * Must stay in sync with SupertonicStats.fromArray().
  */
-static bool initOrtApi() {
-    if (g_ortApi != nullptr) {
-        return true;
-    }
+enum StatsIndex {
+    STAT_REQUEST_ID = 0,
+    STAT_STATUS,
+    STAT_TOKENIZE_MS,
+    STAT_TEXT_ENCODER_MS,
+    STAT_DURATION_PREDICTOR_MS,
+    STAT_NOISE_MS,
+    STAT_VECTOR_ESTIMATOR_MS,
+    STAT_VOCODER_MS,
+    STAT_TOTAL_MS,
+    STAT_NUM_STEPS,
+    STAT_TOKEN_COUNT,
+    STAT_LATENT_LEN,
+    STAT_NUM_SAMPLES,
+    STAT_AUDIO_SECONDS,
+    STAT_RTF,
+    STAT_INTRA_OP_THREADS,
+    STAT_CPU_THREAD_USER_MS,
+    STAT_CPU_THREAD_SYSTEM_MS,
+    STAT_CPU_PROCESS_MS,
+    STAT_TEXT_EMB_BYTES,
+    STAT_LATENT_BYTES,
+    STAT_AUDIO_BYTES,
+    STAT_TENSOR_BYTES_ALLOCATED,
+    STAT_STEP_MS_BASE,
+    STAT_TEXT_CACHE_HIT = STAT_STEP_MS_BASE + SUPERTONIC_MAX_DIFFUSION_STEPS,
+    STAT_NUM_CHUNKS,
+    STAT_MODEL_VARIANT_BASE,
+    STAT_XNNPACK_MODELS = STAT_MODEL_VARIANT_BASE + SUPERTONIC_NUM_MODELS,
+    STAT_STEPS_RUN,
+    STAT_QUEUE_MS,
+    STAT_SHARED_REQUESTS,
+    STAT_PREEMPTIONS,
+    STAT_SUSPENDED_MS,
+    STAT_EXECUTION_CLASS,
+    STAT_CALLER_CPUS,
+    STAT_CALLER_CPU,
+    STAT_POOL_CPUS,
+    STAT_PERF_COUNTERS,
+    STAT_PERF_THREADS,
+    // Four stages (see writeStatsArray) of SUPERTONIC_NUM_PERF_COUNTERS values each
+    STAT_PERF_BASE,
+    STATS_ARRAY_SIZE = STAT_PERF_BASE + 4 * SUPERTONIC_NUM_PERF_COUNTERS,
+};
 
-    // Try to get handle to already-loaded libonnxruntime.so
-    g_ortLibHandle = dlopen("libonnxruntime.so", RTLD_NOLOAD);
-    if (g_ortLibHandle == nullptr) {
-        // Try loading it explicitly
-        g_ortLibHandle = dlopen("libonnxruntime.so", RTLD_NOW);
-    }
-    
-    if (g_ortLibHandle == nullptr) {
-        LOGE("Failed to load libonnxruntime.so: %s", dlerror());
-        return false;
-    }
-    
-    LOGI("Successfully loaded libonnxruntime.so");
-    
-    // Get OrtGetApiBase function
-    typedef const OrtApiBase* (*OrtGetApiBaseFunc)();
-    auto getApiBase = (OrtGetApiBaseFunc)dlsym(g_ortLibHandle, "OrtGetApiBase");
-    if (getApiBase == nullptr) {
-        LOGE("Failed to find OrtGetApiBase: %s", dlerror());
+/**
+ * Copy stats into a Kotlin DoubleArray of at least STATS_ARRAY_SIZE.
+ */
+static bool writeStatsArray(JNIEnv* env, jdoubleArray out, const SupertonicSynthesisStats& stats) {
+    if (out == nullptr || env->GetArrayLength(out) < STATS_ARRAY_SIZE) {
+        LOGE("Stats array must hold %d values", (int)STATS_ARRAY_SIZE);
         return false;
     }
-    
-    // Get API base and then the API
-    const OrtApiBase* apiBase = getApiBase();
-    if (apiBase == nullptr) {
-        LOGE("OrtGetApiBase returned null");
-        return false;
+
+    jdouble values[STATS_ARRAY_SIZE] = {};
+    values[STAT_REQUEST_ID] = (jdouble)stats.request_id;
+    values[STAT_STATUS] = stats.status;
+    values[STAT_TOKENIZE_MS] = stats.tokenize_ms;
+    values[STAT_TEXT_ENCODER_MS] = stats.text_encoder_ms;
+    values[STAT_DURATION_PREDICTOR_MS] = stats.duration_predictor_ms;
+    values[STAT_NOISE_MS] = stats.noise_ms;
+    values[STAT_VECTOR_ESTIMATOR_MS] = stats.vector_estimator_ms;
+    values[STAT_VOCODER_MS] = stats.vocoder_ms;
+    values[STAT_TOTAL_MS] = stats.total_ms;
+    values[STAT_NUM_STEPS] = stats.num_steps;
+    values[STAT_TOKEN_COUNT] = (jdouble)stats.token_count;
+    values[STAT_LATENT_LEN] = (jdouble)stats.latent_len;
+    values[STAT_NUM_SAMPLES] = (jdouble)stats.num_samples;
+    values[STAT_AUDIO_SECONDS] = stats.audio_seconds;
+    values[STAT_RTF] = stats.rtf;
+    values[STAT_INTRA_OP_THREADS] = stats.intra_op_threads;
+    values[STAT_CPU_THREAD_USER_MS] = stats.cpu_thread_user_ms;
+    values[STAT_CPU_THREAD_SYSTEM_MS] = stats.cpu_thread_system_ms;
+    values[STAT_CPU_PROCESS_MS] = stats.cpu_process_ms;
+    values[STAT_TEXT_EMB_BYTES] = (jdouble)stats.text_emb_bytes;
+    values[STAT_LATENT_BYTES] = (jdouble)stats.latent_bytes;
+    values[STAT_AUDIO_BYTES] = (jdouble)stats.audio_bytes;
+    values[STAT_TENSOR_BYTES_ALLOCATED] = (jdouble)stats.tensor_bytes_allocated;
+    values[STAT_TEXT_CACHE_HIT] = stats.text_cache_hit;
+    values[STAT_NUM_CHUNKS] = stats.num_chunks;
+    for (int i = 0; i < stats.num_steps && i < SUPERTONIC_MAX_DIFFUSION_STEPS; i++) {
+        values[STAT_STEP_MS_BASE + i] = stats.step_ms[i];
+    }
+    for (int m = 0; m < SUPERTONIC_NUM_MODELS; m++) {
+        values[STAT_MODEL_VARIANT_BASE + m] = stats.model_variant[m];
+    }
+    values[STAT_XNNPACK_MODELS] = stats.xnnpack_models;
+    values[STAT_STEPS_RUN] = stats.steps_run;
+    values[STAT_QUEUE_MS] = stats.queue_ms;
+    values[STAT_SHARED_REQUESTS] = stats.shared_requests;
+    values[STAT_PREEMPTIONS] = stats.preemptions;
+    values[STAT_SUSPENDED_MS] = stats.suspended_ms;
+    values[STAT_EXECUTION_CLASS] = stats.execution_class;
+    // CPU masks stay exact in a double up to CPU 52
+    values[STAT_CALLER_CPUS] = (jdouble)stats.caller_cpus;
+    values[STAT_CALLER_CPU] = stats.caller_cpu;
+    values[STAT_POOL_CPUS] = (jdouble)stats.pool_cpus;
+    values[STAT_PERF_COUNTERS] = stats.perf_counters;
+    values[STAT_PERF_THREADS] = stats.perf_threads;
+    // Text encoder, duration predictor, diffusion summed over steps, vocoder
+    SupertonicPerfCounts diffusion = {};
+    for (int i = 0; i < SUPERTONIC_MAX_DIFFUSION_STEPS; i++) {
+        for (int c = 0; c < SUPERTONIC_NUM_PERF_COUNTERS; c++) {
+            diffusion.count[c] += stats.perf_step[i].count[c];
+        }
     }
-    
-    // Log version for debugging
-    const char* version = apiBase->GetVersionString();
-    LOGI("ONNX Runtime version: %s", version);
-    
-    // Get API version 17 (matches sherpa-onnx bundled version)
-    g_ortApi = apiBase->GetApi(17);
-    
-    if (g_ortApi == nullptr) {
-        LOGE("Failed to get ORT API v17");
-        return false;
+    const SupertonicPerfCounts* stages[] = {&stats.perf_text_encoder, &stats.perf_duration_predictor, &diffusion,
+                                            &stats.perf_vocoder};
+    for (int s = 0; s < 4; s++) {
+        for (int c = 0; c < SUPERTONIC_NUM_PERF_COUNTERS; c++) {
+            values[STAT_PERF_BASE + s * SUPERTONIC_NUM_PERF_COUNTERS + c] = (jdouble)stages[s]->count[c];
+        }
     }
-    
-    LOGI("ONNX Runtime API v17 initialized successfully");
+
+    env->SetDoubleArrayRegion(out, 0, STATS_ARRAY_SIZE, values);
     return true;
 }
 
 /**
- * Check if a status indicates an error, log it, and free the status.
- * Returns true if there was an error.
+ * Flat IntArray layout of SupertonicTimestamps handed to Kotlin: a header
+ * followed by one record per token, with text positions in UTF-16 units.
+ * Must stay in sync with SupertonicTimestamps.fromArray().
  */
-static bool checkStatus(OrtStatus* status, const char* operation) {
-    if (status != nullptr) {
-        const char* msg = g_ortApi->GetErrorMessage(status);
-        LOGE("ONNX Runtime error during %s: %s", operation, msg);
-        g_ortApi->ReleaseStatus(status);
-        return true;
-    }
-    return false;
-}
+enum TimestampIndex {
+    TS_APPROXIMATE = 0,
+    TS_NUM_TOKENS,
+    TS_HEADER_SIZE,
+};
+
+/** Offsets within one token record. */
+enum TimestampRecordIndex {
+    TS_CHAR_START = 0,
+    TS_CHAR_END,
+    TS_START_SAMPLE,
+    TS_END_SAMPLE,
+    TS_RECORD_SIZE,
+};
 
 /**
- * Load unicode_indexer.json for text tokenization
- * 
- * The file is a JSON array where:
- * - Array index = Unicode codepoint
- * - Array value = token index (-1 means invalid/unknown)
- * 
- * Example: [−1, −1, ..., 0, 1, 2, ...] where index 32 (space) might map to token 0
+ * Convert token timings to the flat layout. text is the modified UTF-8
+ * the tokens were cut from, where every 1-3 byte sequence is one UTF-16
+ * unit of the Java string.
  */
-static bool loadUnicodeIndexer(const std::string& path) {
-    std::ifstream file(path);
-    if (!file.is_open()) {
-        LOGE("Failed to open unicode_indexer.json: %s", path.c_str());
-        return false;
+static jintArray timestampsToArray(JNIEnv* env, const std::string& text, const SupertonicTimestamps& timestamps) {
+    std::vector<jint> utf16At(text.size() + 1, 0);
+    jint units = 0;
+    for (size_t b = 0; b < text.size(); b++) {
+        utf16At[b] = units;
+        if (((unsigned char)text[b] & 0xC0) != 0x80) {
+            units++;
+        }
     }
-    
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string content = buffer.str();
-    
-    g_unicodeIndexer.clear();
-    
-    // Parse JSON array: [val0, val1, val2, ...]
-    // Find the opening bracket
-    size_t start = content.find('[');
-    if (start == std::string::npos) {
-        LOGE("Invalid unicode_indexer.json: no opening bracket");
-        return false;
+    utf16At[text.size()] = units;
+
+    std::vector<jint> values(TS_HEADER_SIZE + timestamps.num_tokens * TS_RECORD_SIZE);
+    values[TS_APPROXIMATE] = timestamps.approximate;
+    values[TS_NUM_TOKENS] = (jint)timestamps.num_tokens;
+    for (size_t i = 0; i < timestamps.num_tokens; i++) {
+        const SupertonicTokenTiming& token = timestamps.tokens[i];
+        const size_t end = std::min<size_t>(token.text_offset + token.text_length, text.size());
+        jint* record = values.data() + TS_HEADER_SIZE + i * TS_RECORD_SIZE;
+        record[TS_CHAR_START] = utf16At[std::min<size_t>(token.text_offset, text.size())];
+        record[TS_CHAR_END] = utf16At[end];
+        record[TS_START_SAMPLE] = (jint)token.start_sample;
+        record[TS_END_SAMPLE] = (jint)token.end_sample;
     }
-    
-    size_t pos = start + 1;
-    int32_t codepoint = 0;
-    int validCount = 0;
-    
-    while (pos < content.size()) {
-        // Skip whitespace and commas
-        while (pos < content.size() && (content[pos] == ' ' || content[pos] == '\t' || 
-               content[pos] == '\n' || content[pos] == '\r' || content[pos] == ',')) {
-            pos++;
-        }
-        
-        if (pos >= content.size() || content[pos] == ']') {
-            break;  // End of array
-        }
-        
-        // Parse the integer value (may be negative)
-        size_t valueStart = pos;
-        if (content[pos] == '-') {
-            pos++;
-        }
-        while (pos < content.size() && isdigit(content[pos])) {
-            pos++;
-        }
-        
-        if (pos > valueStart) {
-            try {
-                int64_t tokenIndex = std::stoll(content.substr(valueStart, pos - valueStart));
-                // Only store valid mappings (token index >= 0)
-                if (tokenIndex >= 0) {
-                    g_unicodeIndexer[codepoint] = tokenIndex;
-                    validCount++;
-                }
-            } catch (...) {
-                // Skip invalid entries
-            }
-        }
-        
-        codepoint++;
+
+    jintArray result = env->NewIntArray((jsize)values.size());
+    if (result != nullptr) {
+        env->SetIntArrayRegion(result, 0, (jsize)values.size(), values.data());
     }
-    
-    LOGI("Loaded unicode_indexer.json: %d codepoints scanned, %d valid mappings", 
-         codepoint, validCount);
-    return validCount > 0;
+    return result;
 }
 
 /**
- * Parse a nested float array from JSON: [[[ ... ]]] 
- * Extracts all float values into a flattened vector
+ * Hand a finished call's audio to Kotlin as a FloatArray (null on error),
+ * its stats to statsOut and, if timestampsOut is given, its token timings
+ * cut from timedText to timestampsOut[0]. Frees audio and timestamps.
  */
-static std::vector<float> parseNestedFloatArray(const std::string& json, const std::string& key) {
-    std::vector<float> result;
-    
-    // Find the key
-    std::string searchKey = "\"" + key + "\"";
-    size_t keyPos = json.find(searchKey);
-    if (keyPos == std::string::npos) {
-        return result;
-    }
-    
-    // Find "data" under this key
-    size_t dataPos = json.find("\"data\"", keyPos);
-    if (dataPos == std::string::npos) {
-        return result;
+static jfloatArray resultToArray(JNIEnv* env, SupertonicStatus status, SupertonicAudio& audio,
+                                 const SupertonicSynthesisStats& stats, jdoubleArray statsOut,
+                                 const std::string& timedText, SupertonicTimestamps& timestamps,
+                                 jobjectArray timestampsOut) {
+    if (statsOut != nullptr) {
+        writeStatsArray(env, statsOut, stats);
     }
-    
-    // Find the opening bracket of the array
-    size_t start = json.find('[', dataPos);
-    if (start == std::string::npos) {
-        return result;
+
+    if (status != SUPERTONIC_OK) {
+        LOGE("Synthesis failed: %s", supertonic_status_string(status));
+        return nullptr;
     }
-    
-    // Count nested brackets to find all floats
-    size_t pos = start;
-    while (pos < json.size()) {
-        char c = json[pos];
-        
-        if (c == ']') {
-            // Check if we're done with this array
-            size_t nextBracket = json.find_first_of("[]", pos + 1);
-            if (nextBracket == std::string::npos || json[nextBracket] == '[') {
-                // We might be at a new key, check if there's a colon before the bracket
-                size_t colonPos = json.find(':', pos + 1);
-                if (colonPos != std::string::npos && colonPos < nextBracket) {
-                    break;  // New key found, stop parsing
-                }
-            }
-            pos++;
-        } else if (c == '-' || isdigit(c)) {
-            // Parse a number
-            size_t numStart = pos;
-            while (pos < json.size() && (isdigit(json[pos]) || json[pos] == '.' || 
-                   json[pos] == '-' || json[pos] == 'e' || json[pos] == 'E' || json[pos] == '+')) {
-                pos++;
-            }
-            try {
-                float val = std::stof(json.substr(numStart, pos - numStart));
-                result.push_back(val);
-            } catch (...) {
-                // Skip invalid numbers
-            }
-        } else {
-            pos++;
+
+    // Create Java float array
+    supertonic_trace_begin("to_java", stats.request_id);
+    jfloatArray result = env->NewFloatArray((jsize)audio.num_samples);
+    if (result != nullptr) {
+        env->SetFloatArrayRegion(result, 0, (jsize)audio.num_samples, audio.samples);
+    }
+    supertonic_audio_free(&audio);
+
+    if (timestampsOut != nullptr) {
+        jintArray timings = timestampsToArray(env, timedText, timestamps);
+        if (timings != nullptr) {
+            env->SetObjectArrayElement(timestampsOut, 0, timings);
+            env->DeleteLocalRef(timings);
         }
+        supertonic_timestamps_free(&timestamps);
     }
-    
+    supertonic_trace_end();
+
     return result;
 }
 
 /**
- * Load voice style from JSON file
- * Format: {"style_ttl": {"data": [[[...]]]}, "style_dp": {"data": [[[...]]]}}
+ * Run a synthesis request and convert the audio to a Java float array.
+ * statsOut may be null. If timestampsOut is given, its first element
+ * receives the token timings. A deadlineMs of 0 or more goes through the
+ * engine's deadline scheduler instead of running on the calling thread,
+ * in executionClass (a SupertonicExecutionClass).
  */
-static bool loadVoiceStyle(int speakerId) {
-    if (g_voiceStyles.count(speakerId) > 0 && g_voiceStyles[speakerId].loaded) {
-        return true;  // Already loaded
+static jfloatArray synthesizeToArray(JNIEnv* env, jstring text, jint speakerId, jfloat speed,
+                                     jdoubleArray statsOut, jobjectArray timestampsOut = nullptr,
+                                     jlong deadlineMs = -1,
+                                     jint executionClass = SUPERTONIC_CLASS_FOREGROUND) {
+    std::shared_lock<std::shared_timed_mutex> lock(g_engineMutex);
+    if (g_engine == nullptr) {
+        LOGE("Supertonic not initialized");
+        return nullptr;
     }
-    
-    // Map speaker ID to voice file name
-    // M1-M5 = 0-4, F1-F5 = 5-9
-    const char* voiceNames[] = {"M1", "M2", "M3", "M4", "M5", "F1", "F2", "F3", "F4", "F5"};
-    if (speakerId < 0 || speakerId >= 10) {
-        LOGE("Invalid speaker ID: %d", speakerId);
-        return false;
+
+    const char* textStr = env->GetStringUTFChars(text, nullptr);
+    if (textStr == nullptr) {
+        return nullptr;
     }
-    
-    std::string path = g_modelBasePath + "/voice_styles/" + voiceNames[speakerId] + ".json";
-    
-    std::ifstream file(path);
-    if (!file.is_open()) {
-        LOGE("Failed to open voice style file: %s", path.c_str());
-        return false;
+
+    SupertonicSynthesisRequest request;
+    supertonic_request_init(&request);
+    request.text = textStr;
+    request.speaker_id = speakerId;
+    request.speed = speed;
+    request.execution_class = executionClass;
+
+    SupertonicAudio audio;
+    SupertonicSynthesisStats stats;
+    supertonic_stats_init(&stats);
+    SupertonicTimestamps timestamps;
+    supertonic_timestamps_init(&timestamps);
+    std::string timedText;
+    SupertonicStatus status;
+    if (timestampsOut != nullptr) {
+        timedText = textStr;
+    }
+    if (deadlineMs >= 0) {
+        // The request is copied on submission
+        uint64_t job = 0;
+        status = supertonic_submit(g_engine, &request, deadlineMs, &job);
+        env->ReleaseStringUTFChars(text, textStr);
+        textStr = nullptr;
+        if (status == SUPERTONIC_OK) {
+            status = supertonic_job_wait(g_engine, job, &audio, &stats,
+                                         timestampsOut != nullptr ? &timestamps : nullptr);
+        }
+    } else if (timestampsOut != nullptr) {
+        status = supertonic_synthesize_with_timestamps(g_engine, &request, &audio, &stats, &timestamps);
+    } else {
+        status = supertonic_synthesize_with_stats(g_engine, &request, &audio, &stats);
     }
-    
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string content = buffer.str();
-    file.close();
-    
-    VoiceStyle style;
-    
-    // Parse style_ttl [1, 50, 256] = 12800 floats
-    style.style_ttl = parseNestedFloatArray(content, "style_ttl");
-    if (style.style_ttl.size() != 50 * 256) {
-        LOGE("Invalid style_ttl size: %zu (expected %d)", style.style_ttl.size(), 50 * 256);
-        return false;
+    if (textStr != nullptr) {
+        env->ReleaseStringUTFChars(text, textStr);
     }
-    
-    // Parse style_dp [1, 8, 16] = 128 floats
-    style.style_dp = parseNestedFloatArray(content, "style_dp");
-    if (style.style_dp.size() != 8 * 16) {
-        LOGE("Invalid style_dp size: %zu (expected %d)", style.style_dp.size(), 8 * 16);
-        return false;
+    return resultToArray(env, status, audio, stats, statsOut, timedText, timestamps, timestampsOut);
+}
+
+/**
+ * Flat LongArray layout of SupertonicMemoryReport handed to Kotlin.
+ * Must stay in sync with SupertonicMemoryReport.fromArray().
+ */
+enum MemoryIndex {
+    MEM_SESSIONS_LOADED = 0,
+    MEM_STYLE_CACHE_BYTES,
+    MEM_CACHED_STYLES,
+    MEM_SCRATCH_PEAK_BYTES,
+    MEM_NATIVE_HEAP_BYTES,
+    MEM_ARENA_ESTIMATE_BYTES,
+    MEM_PROCESS_RSS_BYTES,
+    MEM_SESSION_BYTES_BASE,
+    MEM_MODEL_FILE_BYTES_BASE = MEM_SESSION_BYTES_BASE + SUPERTONIC_NUM_MODELS,
+    MEM_TEXT_CACHE_BYTES = MEM_MODEL_FILE_BYTES_BASE + SUPERTONIC_NUM_MODELS,
+    MEM_CACHED_TEXTS,
+    MEM_SHARED_WEIGHT_BYTES_BASE,
+    MEM_SESSION_INSTANCES_BASE = MEM_SHARED_WEIGHT_BYTES_BASE + SUPERTONIC_NUM_MODELS,
+    MEMORY_ARRAY_SIZE = MEM_SESSION_INSTANCES_BASE + SUPERTONIC_NUM_MODELS,
+};
+
+// Create g_engine unless it exists; threadBudget 0 = one thread per big core
+static jboolean createEngine(JNIEnv* env, jstring corePath, jint threadBudget) {
+    std::unique_lock<std::shared_timed_mutex> lock(g_engineMutex);
+    if (g_engine != nullptr) {
+        LOGI("Supertonic already initialized");
+        return JNI_TRUE;
     }
-    
-    style.loaded = true;
-    g_voiceStyles[speakerId] = std::move(style);
-    
-    LOGD("Loaded voice style for speaker %d (%s)", speakerId, voiceNames[speakerId]);
-    return true;
+
+    const char* path = env->GetStringUTFChars(corePath, nullptr);
+    if (path == nullptr) {
+        LOGE("Failed to get core path string");
+        return JNI_FALSE;
+    }
+
+    SupertonicEngineConfig config;
+    supertonic_engine_config_init(&config);
+    config.thread_budget = threadBudget > 0 ? threadBudget : 0;
+    // Prefetch goes to the background class, so the foreground pool has the
+    // big cores to itself and may spin between operators
+    config.spin_wait = 1;
+    SupertonicStatus status = supertonic_engine_create_with_config(path, &config, &g_engine);
+    env->ReleaseStringUTFChars(corePath, path);
+
+    if (status != SUPERTONIC_OK) {
+        LOGE("Failed to initialize Supertonic: %s", supertonic_status_string(status));
+        return JNI_FALSE;
+    }
+    return JNI_TRUE;
 }
 
+extern "C" {
+
 /**
- * Tokenize text using unicode indexer
+ * Initialize the Supertonic engine with models from the given path.
  */
-static std::vector<int64_t> tokenizeText(const std::string& text) {
-    std::vector<int64_t> tokens;
-    
-    // Decode UTF-8 and look up each codepoint
-    const unsigned char* s = (const unsigned char*)text.c_str();
-    size_t len = text.length();
-    size_t i = 0;
-    
-    while (i < len) {
-        int32_t codepoint = 0;
-        
-        if ((s[i] & 0x80) == 0) {
-            codepoint = s[i];
-            i += 1;
-        } else if ((s[i] & 0xE0) == 0xC0 && i + 1 < len) {
-            codepoint = ((s[i] & 0x1F) << 6) | (s[i+1] & 0x3F);
-            i += 2;
-        } else if ((s[i] & 0xF0) == 0xE0 && i + 2 < len) {
-            codepoint = ((s[i] & 0x0F) << 12) | ((s[i+1] & 0x3F) << 6) | (s[i+2] & 0x3F);
-            i += 3;
-        } else if ((s[i] & 0xF8) == 0xF0 && i + 3 < len) {
-            codepoint = ((s[i] & 0x07) << 18) | ((s[i+1] & 0x3F) << 12) | ((s[i+2] & 0x3F) << 6) | (s[i+3] & 0x3F);
-            i += 4;
-        } else {
-            i += 1;  // Skip invalid byte
-            continue;
-        }
-        
-        auto it = g_unicodeIndexer.find(codepoint);
-        if (it != g_unicodeIndexer.end()) {
-            tokens.push_back(it->second);
-        } else {
-            // Unknown character - use 0 (usually <unk>)
-            tokens.push_back(0);
+JNIEXPORT jboolean JNICALL
+Java_com_example_platform_1android_1tts_onnx_SupertonicNative_initialize(
+    JNIEnv* env, jobject thiz, jstring corePath) {
+    return createEngine(env, corePath, 0);
+}
+
+/**
+ * Initialize the engine with at most threadBudget inference threads in
+ * total (0 = one per big core).
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_platform_1android_1tts_onnx_SupertonicNative_initializeWithThreadBudget(
+    JNIEnv* env, jobject thiz, jstring corePath, jint threadBudget) {
+    return createEngine(env, corePath, threadBudget);
+}
+
+/**
+ * Number of physical big cores, the engine's default thread budget; 0 if
+ * the topology is unreadable. Needs no engine.
+ */
+JNIEXPORT jint JNICALL
+Java_com_example_platform_1android_1tts_onnx_SupertonicNative_getBigCoreCount(
+    JNIEnv* env, jobject thiz) {
+    SupertonicCpuTopology topology;
+    supertonic_cpu_topology_init(&topology);
+    if (supertonic_get_cpu_topology(&topology) != SUPERTONIC_OK) {
+        return 0;
+    }
+    jint count = 0;
+    for (int i = 0; i < topology.num_cores; i++) {
+        const int cpu = topology.cpu[i];
+        if (cpu < 64 && (topology.foreground_cpus & (1ull << cpu)) != 0) {
+            count++;
         }
     }
-    
-    return tokens;
+    return count;
 }
 
 /**
- * Load an ONNX model and log its input/output info
+ * Synthesize text to audio samples.
  */
-static OrtSession* loadModel(const std::string& path) {
-    OrtSession* session = nullptr;
-    OrtStatus* status = g_ortApi->CreateSession(g_ortEnv, path.c_str(), g_sessionOptions, &session);
-    
-    if (checkStatus(status, "CreateSession")) {
-        LOGE("Failed to load model: %s", path.c_str());
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_platform_1android_1tts_onnx_SupertonicNative_synthesize(
+    JNIEnv* env, jobject thiz, jstring text, jint speakerId, jfloat speed) {
+    return synthesizeToArray(env, text, speakerId, speed, nullptr);
+}
+
+/**
+ * Synthesize text and fill statsOut with the per-call statistics.
+ */
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_platform_1android_1tts_onnx_SupertonicNative_synthesizeWithStats(
+    JNIEnv* env, jobject thiz, jstring text, jint speakerId, jfloat speed, jdoubleArray statsOut) {
+    return synthesizeToArray(env, text, speakerId, speed, statsOut);
+}
+
+/**
+ * Synthesize text, fill statsOut and store the token timings in
+ * timestampsOut[0].
+ */
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_platform_1android_1tts_onnx_SupertonicNative_synthesizeWithTimestamps(
+    JNIEnv* env, jobject thiz, jstring text, jint speakerId, jfloat speed, jdoubleArray statsOut,
+    jobjectArray timestampsOut) {
+    if (timestampsOut == nullptr || env->GetArrayLength(timestampsOut) < 1) {
+        LOGE("synthesizeWithTimestamps: timestampsOut needs one element");
         return nullptr;
     }
-    
-    // Log input info
-    size_t numInputs = 0;
-    status = g_ortApi->SessionGetInputCount(session, &numInputs);
-    if (status == nullptr) {
-        LOGI("Model %s has %zu inputs:", path.c_str(), numInputs);
-        for (size_t i = 0; i < numInputs; i++) {
-            char* name = nullptr;
-            status = g_ortApi->SessionGetInputName(session, i, g_allocator, &name);
-            if (status == nullptr && name != nullptr) {
-                LOGI("  Input %zu: %s", i, name);
-                g_ortApi->AllocatorFree(g_allocator, name);
-            }
-        }
+    return synthesizeToArray(env, text, speakerId, speed, statsOut, timestampsOut);
+}
+
+/**
+ * Synthesize text through the engine's deadline scheduler: the call waits
+ * behind jobs due earlier than deadlineMs from now and shares the result
+ * of an identical request already in flight. executionClass 1 runs it as
+ * background work on the little cores. statsOut and timestampsOut may be
+ * null.
+ */
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_platform_1android_1tts_onnx_SupertonicNative_synthesizeScheduled(
+    JNIEnv* env, jobject thiz, jstring text, jint speakerId, jfloat speed, jlong deadlineMs,
+    jint executionClass, jdoubleArray statsOut, jobjectArray timestampsOut) {
+    if (timestampsOut != nullptr && env->GetArrayLength(timestampsOut) < 1) {
+        LOGE("synthesizeScheduled: timestampsOut needs one element");
+        return nullptr;
+    }
+    if (executionClass < 0 || executionClass >= SUPERTONIC_NUM_EXECUTION_CLASSES) {
+        LOGE("synthesizeScheduled: unknown execution class %d", (int)executionClass);
+        return nullptr;
     }
-    
-    // Log output info
-    size_t numOutputs = 0;
-    status = g_ortApi->SessionGetOutputCount(session, &numOutputs);
-    if (status == nullptr) {
-        LOGI("Model %s has %zu outputs:", path.c_str(), numOutputs);
-        for (size_t i = 0; i < numOutputs; i++) {
-            char* name = nullptr;
-            status = g_ortApi->SessionGetOutputName(session, i, g_allocator, &name);
-            if (status == nullptr && name != nullptr) {
-                LOGI("  Output %zu: %s", i, name);
-                g_ortApi->AllocatorFree(g_allocator, name);
+    return synthesizeToArray(env, text, speakerId, speed, statsOut, timestampsOut, std::max<jlong>(deadlineMs, 0),
+                             executionClass);
+}
+
+/**
+ * JNIEnv of the calling thread. A scheduler thread is attached as a daemon
+ * on its first callback and stays attached until it exits, so callbacks
+ * after the first cost no attach.
+ */
+static JNIEnv* callbackEnv() {
+    JNIEnv* env = nullptr;
+    if (g_javaVm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) == JNI_OK) {
+        return env;
+    }
+    struct Attachment {
+        bool attached = false;
+        ~Attachment() {
+            if (attached) {
+                g_javaVm->DetachCurrentThread();
             }
         }
+    };
+    thread_local Attachment attachment;
+    if (g_javaVm->AttachCurrentThreadAsDaemon(&env, nullptr) != JNI_OK) {
+        return nullptr;
     }
-    
-    LOGI("Loaded model: %s", path.c_str());
-    return session;
+    attachment.attached = true;
+    return env;
 }
 
-extern "C" {
+// Runs on a scheduler thread, or on the thread calling cancel(); must not
+// take g_engineMutex, which dispose() holds while the scheduler stops
+static void onJobComplete(void* /* userData */, uint64_t job, SupertonicStatus status) {
+    JNIEnv* env = callbackEnv();
+    if (env == nullptr) {
+        LOGE("Could not attach a scheduler thread, job %llu completion lost", (unsigned long long)job);
+        return;
+    }
+    env->CallStaticVoidMethod(g_nativeClass, g_onJobComplete, (jlong)job, (jint)status);
+    if (env->ExceptionCheck()) {
+        env->ExceptionDescribe();
+        env->ExceptionClear();
+    }
+}
 
 /**
- * Initialize the Supertonic engine with models from the given path.
+ * Queue text on the engine's scheduler and return its job id at once, 0
+ * on error. SupertonicNative.onJobComplete(job, status) is called when it
+ * is done; collect() then takes the audio without blocking.
  */
-JNIEXPORT jboolean JNICALL
-Java_com_example_platform_1android_1tts_onnx_SupertonicNative_initialize(
-    JNIEnv* env, jobject thiz, jstring corePath) {
-    
-    if (g_initialized) {
-        LOGI("Supertonic already initialized");
-        return JNI_TRUE;
+JNIEXPORT jlong JNICALL
+Java_com_example_platform_1android_1tts_onnx_SupertonicNative_submitAsync(
+    JNIEnv* env, jobject thiz, jstring text, jint speakerId, jfloat speed, jlong deadlineMs,
+    jint executionClass) {
+    if (executionClass < 0 || executionClass >= SUPERTONIC_NUM_EXECUTION_CLASSES) {
+        LOGE("submitAsync: unknown execution class %d", (int)executionClass);
+        return 0;
+    }
+    std::call_once(g_callbackOnce, [&]() {
+        jclass nativeClass = env->GetObjectClass(thiz);
+        if (env->GetJavaVM(&g_javaVm) != JNI_OK || nativeClass == nullptr) {
+            return;
+        }
+        g_onJobComplete = env->GetStaticMethodID(nativeClass, "onJobComplete", "(JI)V");
+        if (g_onJobComplete == nullptr) {
+            env->ExceptionClear();
+        } else {
+            g_nativeClass = static_cast<jclass>(env->NewGlobalRef(nativeClass));
+        }
+        env->DeleteLocalRef(nativeClass);
+    });
+    if (g_nativeClass == nullptr) {
+        LOGE("submitAsync: SupertonicNative.onJobComplete not found");
+        return 0;
     }
-    
-    // Initialize ONNX Runtime API
-    if (!initOrtApi()) {
-        return JNI_FALSE;
+
+    std::shared_lock<std::shared_timed_mutex> lock(g_engineMutex);
+    if (g_engine == nullptr) {
+        LOGE("Supertonic not initialized");
+        return 0;
     }
-    
-    const char* path = env->GetStringUTFChars(corePath, nullptr);
-    if (path == nullptr) {
-        LOGE("Failed to get core path string");
-        return JNI_FALSE;
+    const char* textStr = env->GetStringUTFChars(text, nullptr);
+    if (textStr == nullptr) {
+        return 0;
+    }
+    SupertonicSynthesisRequest request;
+    supertonic_request_init(&request);
+    request.text = textStr;
+    request.speaker_id = speakerId;
+    request.speed = speed;
+    request.execution_class = executionClass;
+
+    uint64_t job = 0;
+    SupertonicStatus status = supertonic_submit_async(g_engine, &request, std::max<jlong>(deadlineMs, 0),
+                                                      onJobComplete, nullptr, &job);
+    env->ReleaseStringUTFChars(text, textStr);
+    if (status != SUPERTONIC_OK) {
+        LOGE("submitAsync failed: %s", supertonic_status_string(status));
+        return 0;
     }
-    
-    std::string basePath(path);
-    g_modelBasePath = basePath;
-    env->ReleaseStringUTFChars(corePath, path);
-    
-    // Verify model files exist
-    std::vector<std::string> requiredFiles = {
-        basePath + "/onnx/text_encoder.onnx",
-        basePath + "/onnx/duration_predictor.onnx",
-        basePath + "/onnx/vector_estimator.onnx",
-        basePath + "/onnx/vocoder.onnx",
-        basePath + "/onnx/unicode_indexer.json",
-    };
-    
-    for (const auto& file : requiredFiles) {
-        FILE* f = fopen(file.c_str(), "r");
-        if (f == nullptr) {
-            LOGE("Required file not found: %s", file.c_str());
-            return JNI_FALSE;
+    return (jlong)job;
+}
+
+/**
+ * Take the audio of a job from submitAsync(); blocks only if it is not
+ * done yet. text is the submitted text, for the token timings. Every job
+ * must be collected once, cancelled ones included (they return null).
+ */
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_platform_1android_1tts_onnx_SupertonicNative_collect(
+    JNIEnv* env, jobject thiz, jlong job, jstring text, jdoubleArray statsOut, jobjectArray timestampsOut) {
+    if (timestampsOut != nullptr && env->GetArrayLength(timestampsOut) < 1) {
+        LOGE("collect: timestampsOut needs one element");
+        return nullptr;
+    }
+    std::string timedText;
+    if (timestampsOut != nullptr) {
+        const char* textStr = env->GetStringUTFChars(text, nullptr);
+        if (textStr == nullptr) {
+            return nullptr;
         }
-        fclose(f);
-        LOGD("Found: %s", file.c_str());
+        timedText = textStr;
+        env->ReleaseStringUTFChars(text, textStr);
     }
-    
-    // Load unicode indexer
-    if (!loadUnicodeIndexer(basePath + "/onnx/unicode_indexer.json")) {
-        LOGE("Failed to load unicode indexer");
-        return JNI_FALSE;
+
+    std::shared_lock<std::shared_timed_mutex> lock(g_engineMutex);
+    if (g_engine == nullptr) {
+        LOGE("Supertonic not initialized");
+        return nullptr;
     }
-    
-    // Create ONNX Runtime environment
-    OrtStatus* status = g_ortApi->CreateEnv(ORT_LOGGING_LEVEL_WARNING, "supertonic", &g_ortEnv);
-    if (checkStatus(status, "CreateEnv")) {
+    SupertonicAudio audio;
+    SupertonicSynthesisStats stats;
+    supertonic_stats_init(&stats);
+    SupertonicTimestamps timestamps;
+    supertonic_timestamps_init(&timestamps);
+    SupertonicStatus status = supertonic_job_wait(g_engine, (uint64_t)job, &audio, &stats,
+                                                  timestampsOut != nullptr ? &timestamps : nullptr);
+    return resultToArray(env, status, audio, stats, statsOut, timedText, timestamps, timestampsOut);
+}
+
+/**
+ * Cancel a job from submitAsync(); onJobComplete reports it with the
+ * cancelled status before this returns. False if it was already done.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_platform_1android_1tts_onnx_SupertonicNative_cancel(
+    JNIEnv* env, jobject thiz, jlong job) {
+    std::shared_lock<std::shared_timed_mutex> lock(g_engineMutex);
+    if (g_engine == nullptr) {
         return JNI_FALSE;
     }
-    
-    // Create session options
-    status = g_ortApi->CreateSessionOptions(&g_sessionOptions);
-    if (checkStatus(status, "CreateSessionOptions")) {
+    return supertonic_cancel(g_engine, (uint64_t)job) == SUPERTONIC_OK ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Look up the statistics of a recent request by its native request id.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_platform_1android_1tts_onnx_SupertonicNative_getStats(
+    JNIEnv* env, jobject thiz, jlong requestId, jdoubleArray statsOut) {
+
+    std::shared_lock<std::shared_timed_mutex> lock(g_engineMutex);
+    if (g_engine == nullptr) {
         return JNI_FALSE;
     }
-    
-    // Set optimization level
-    status = g_ortApi->SetSessionGraphOptimizationLevel(g_sessionOptions, ORT_ENABLE_ALL);
-    if (checkStatus(status, "SetSessionGraphOptimizationLevel")) {
+
+    SupertonicSynthesisStats stats;
+    supertonic_stats_init(&stats);
+    if (supertonic_get_stats(g_engine, (uint64_t)requestId, &stats) != SUPERTONIC_OK) {
         return JNI_FALSE;
     }
-    
-    // Use 2 threads for inference
-    status = g_ortApi->SetIntraOpNumThreads(g_sessionOptions, 2);
-    if (checkStatus(status, "SetIntraOpNumThreads")) {
+    return writeStatsArray(env, statsOut, stats) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Reload the sessions with ONNX Runtime profiling writing into outputDir.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_platform_1android_1tts_onnx_SupertonicNative_startProfiling(
+    JNIEnv* env, jobject thiz, jstring outputDir) {
+
+    std::shared_lock<std::shared_timed_mutex> lock(g_engineMutex);
+    if (g_engine == nullptr) {
+        LOGE("Supertonic not initialized");
         return JNI_FALSE;
     }
-    
-    // Get default allocator
-    status = g_ortApi->GetAllocatorWithDefaultOptions(&g_allocator);
-    if (checkStatus(status, "GetAllocatorWithDefaultOptions")) {
+
+    const char* dir = env->GetStringUTFChars(outputDir, nullptr);
+    if (dir == nullptr) {
         return JNI_FALSE;
     }
-    
-    // Create CPU memory info
-    status = g_ortApi->CreateCpuMemoryInfo(OrtArenaAllocator, OrtMemTypeDefault, &g_memoryInfo);
-    if (checkStatus(status, "CreateCpuMemoryInfo")) {
+    SupertonicStatus status = supertonic_profiling_start(g_engine, dir);
+    env->ReleaseStringUTFChars(outputDir, dir);
+
+    if (status != SUPERTONIC_OK) {
+        LOGE("Failed to start profiling: %s", supertonic_status_string(status));
         return JNI_FALSE;
     }
-    
-    // Load all 4 models
-    LOGI("Loading Supertonic models...");
-    
-    g_textEncoder = loadModel(basePath + "/onnx/text_encoder.onnx");
-    if (g_textEncoder == nullptr) return JNI_FALSE;
-    
-    g_durationPredictor = loadModel(basePath + "/onnx/duration_predictor.onnx");
-    if (g_durationPredictor == nullptr) return JNI_FALSE;
-    
-    g_vectorEstimator = loadModel(basePath + "/onnx/vector_estimator.onnx");
-    if (g_vectorEstimator == nullptr) return JNI_FALSE;
-    
-    g_vocoder = loadModel(basePath + "/onnx/vocoder.onnx");
-    if (g_vocoder == nullptr) return JNI_FALSE;
-    
-    LOGI("Supertonic initialized successfully at %s", basePath.c_str());
-    g_initialized = true;
-    
     return JNI_TRUE;
 }
 
 /**
- * Create an OrtValue tensor from data using the default allocator
- * This lets ONNX Runtime manage the memory automatically
+ * Stop profiling and return the path of the merged Chrome trace.
  */
-static OrtValue* createTensor(const void* data, size_t dataSize, 
-                              const int64_t* shape, size_t shapeLen,
-                              ONNXTensorElementDataType type) {
-    OrtValue* tensor = nullptr;
-    
-    // Create tensor using allocator (ORT manages memory)
-    OrtStatus* status = g_ortApi->CreateTensorAsOrtValue(
-        g_allocator, shape, shapeLen, type, &tensor);
-    
-    if (checkStatus(status, "CreateTensorAsOrtValue")) {
+JNIEXPORT jstring JNICALL
+Java_com_example_platform_1android_1tts_onnx_SupertonicNative_stopProfiling(
+    JNIEnv* env, jobject thiz) {
+
+    std::shared_lock<std::shared_timed_mutex> lock(g_engineMutex);
+    if (g_engine == nullptr) {
         return nullptr;
     }
-    
-    // Copy data into the tensor
-    void* tensorData = nullptr;
-    status = g_ortApi->GetTensorMutableData(tensor, &tensorData);
-    if (checkStatus(status, "GetTensorMutableData")) {
-        g_ortApi->ReleaseValue(tensor);
+
+    char tracePath[1024];
+    SupertonicStatus status = supertonic_profiling_stop(g_engine, tracePath, sizeof(tracePath));
+    if (status != SUPERTONIC_OK) {
+        LOGE("Failed to stop profiling: %s", supertonic_status_string(status));
         return nullptr;
     }
-    
-    memcpy(tensorData, data, dataSize);
-    
-    return tensor;
+    return env->NewStringUTF(tracePath);
 }
 
 /**
- * Run a single model and get the output tensor
+ * Fill out with the native memory report; see MemoryIndex.
  */
-static OrtValue* runModel(OrtSession* session, 
-                          const char* const* inputNames, OrtValue** inputs, size_t numInputs,
-                          const char* const* outputNames, size_t numOutputs) {
-    std::vector<OrtValue*> outputs(numOutputs, nullptr);
-    
-    OrtStatus* status = g_ortApi->Run(session, nullptr, 
-                                       inputNames, (const OrtValue* const*)inputs, numInputs,
-                                       outputNames, numOutputs, outputs.data());
-    
-    if (checkStatus(status, "Run")) {
-        return nullptr;
+JNIEXPORT jboolean JNICALL
+Java_com_example_platform_1android_1tts_onnx_SupertonicNative_getMemoryReport(
+    JNIEnv* env, jobject thiz, jlongArray out) {
+
+    if (out == nullptr || env->GetArrayLength(out) < MEMORY_ARRAY_SIZE) {
+        LOGE("Memory report array must hold %d values", (int)MEMORY_ARRAY_SIZE);
+        return JNI_FALSE;
+    }
+
+    std::shared_lock<std::shared_timed_mutex> lock(g_engineMutex);
+    if (g_engine == nullptr) {
+        return JNI_FALSE;
     }
-    
-    return outputs[0];  // Return first output
+
+    SupertonicMemoryReport report;
+    supertonic_memory_report_init(&report);
+    if (supertonic_get_memory_report(g_engine, &report) != SUPERTONIC_OK) {
+        return JNI_FALSE;
+    }
+
+    jlong values[MEMORY_ARRAY_SIZE] = {};
+    values[MEM_SESSIONS_LOADED] = report.sessions_loaded;
+    values[MEM_STYLE_CACHE_BYTES] = (jlong)report.style_cache_bytes;
+    values[MEM_CACHED_STYLES] = report.cached_styles;
+    values[MEM_SCRATCH_PEAK_BYTES] = (jlong)report.scratch_peak_bytes;
+    values[MEM_NATIVE_HEAP_BYTES] = (jlong)report.native_heap_bytes;
+    values[MEM_ARENA_ESTIMATE_BYTES] = (jlong)report.arena_estimate_bytes;
+    values[MEM_PROCESS_RSS_BYTES] = (jlong)report.process_rss_bytes;
+    values[MEM_TEXT_CACHE_BYTES] = (jlong)report.text_cache_bytes;
+    values[MEM_CACHED_TEXTS] = report.cached_texts;
+    for (int m = 0; m < SUPERTONIC_NUM_MODELS; m++) {
+        values[MEM_SESSION_BYTES_BASE + m] = (jlong)report.session_bytes[m];
+        values[MEM_MODEL_FILE_BYTES_BASE + m] = (jlong)report.model_file_bytes[m];
+        values[MEM_SHARED_WEIGHT_BYTES_BASE + m] = (jlong)report.shared_weight_bytes[m];
+        values[MEM_SESSION_INSTANCES_BASE + m] = report.session_instances[m];
+    }
+    env->SetLongArrayRegion(out, 0, MEMORY_ARRAY_SIZE, values);
+    return JNI_TRUE;
 }
 
 /**
- * Synthesize text to audio samples.
+ * Shed native memory; level is a SupertonicTrimLevel (0-4).
  */
-JNIEXPORT jfloatArray JNICALL
-Java_com_example_platform_1android_1tts_onnx_SupertonicNative_synthesize(
-    JNIEnv* env, jobject thiz, jstring text, jint speakerId, jfloat speed) {
-    
-    if (!g_initialized) {
-        LOGE("Supertonic not initialized");
-        return nullptr;
-    }
-    
-    const char* textStr = env->GetStringUTFChars(text, nullptr);
-    if (textStr == nullptr) {
-        return nullptr;
+JNIEXPORT jboolean JNICALL
+Java_com_example_platform_1android_1tts_onnx_SupertonicNative_trim(
+    JNIEnv* env, jobject thiz, jint level) {
+
+    std::shared_lock<std::shared_timed_mutex> lock(g_engineMutex);
+    if (g_engine == nullptr) {
+        return JNI_FALSE;
     }
-    
-    std::string inputText(textStr);
-    env->ReleaseStringUTFChars(text, textStr);
-    
-    LOGD("Synthesizing: '%s' (speaker=%d, speed=%.2f)", inputText.c_str(), speakerId, speed);
-    
-    // Step 1: Tokenize text
-    std::vector<int64_t> tokens = tokenizeText(inputText);
-    if (tokens.empty()) {
-        LOGE("Failed to tokenize text");
-        return nullptr;
+
+    SupertonicStatus status = supertonic_trim(g_engine, (SupertonicTrimLevel)level);
+    if (status != SUPERTONIC_OK) {
+        LOGE("Trim failed: %s", supertonic_status_string(status));
+        return JNI_FALSE;
     }
-    LOGD("Tokenized %zu characters into %zu tokens", inputText.length(), tokens.size());
-    
-    // Create input tensors for text encoder
-    // Inputs: text_ids [batch, seq_len], style_ttl [batch, n_style, style_dim], text_mask [batch, seq_len]
-    int64_t seqLen = (int64_t)tokens.size();
-    int64_t textShape[] = {1, seqLen};
-    OrtValue* textInput = createTensor(tokens.data(), tokens.size() * sizeof(int64_t),
-                                        textShape, 2, ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64);
-    if (textInput == nullptr) {
+    return JNI_TRUE;
+}
+
+/**
+ * Run the models on throwaway input per bucket. tokenCounts may be null
+ * for the default buckets; latentLens may be null or hold 0 entries.
+ * Returns the milliseconds each bucket took, or null on failure.
+ */
+JNIEXPORT jdoubleArray JNICALL
+Java_com_example_platform_1android_1tts_onnx_SupertonicNative_warmup(
+    JNIEnv* env, jobject thiz, jint speakerId, jintArray tokenCounts, jintArray latentLens) {
+
+    const jsize numBuckets = tokenCounts != nullptr ? env->GetArrayLength(tokenCounts) : 0;
+    if (latentLens != nullptr && env->GetArrayLength(latentLens) != numBuckets) {
+        LOGE("Warmup latentLens must match tokenCounts");
         return nullptr;
     }
-    
-    // Create style_ttl embedding [1, 50, 256] - from voice_styles/*.json
-    // Load voice style if not already loaded
-    if (!loadVoiceStyle(speakerId)) {
-        LOGE("Failed to load voice style for speaker %d, using fallback", speakerId);
-    }
-    
-    const int N_STYLE_TTL = 50;
-    const int STYLE_TTL_DIM = 256;
-    std::vector<float> styleTtl(N_STYLE_TTL * STYLE_TTL_DIM, 0.0f);
-    
-    // Use loaded style if available, otherwise use zeros
-    if (g_voiceStyles.count(speakerId) > 0 && g_voiceStyles[speakerId].loaded) {
-        styleTtl = g_voiceStyles[speakerId].style_ttl;
+
+    std::vector<int32_t> tokens(numBuckets);
+    std::vector<int32_t> latents(numBuckets);
+    if (numBuckets > 0) {
+        env->GetIntArrayRegion(tokenCounts, 0, numBuckets, (jint*)tokens.data());
+        if (latentLens != nullptr) {
+            env->GetIntArrayRegion(latentLens, 0, numBuckets, (jint*)latents.data());
+        }
     }
-    
-    int64_t styleTtlShape[] = {1, N_STYLE_TTL, STYLE_TTL_DIM};
-    OrtValue* styleTensor = createTensor(styleTtl.data(), styleTtl.size() * sizeof(float),
-                                          styleTtlShape, 3, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT);
-    
-    // Create text mask (all ones = all tokens valid) - shape [1, 1, seq_len]
-    std::vector<float> textMaskData(seqLen, 1.0f);
-    int64_t textMaskShape[] = {1, 1, seqLen};
-    OrtValue* textMask = createTensor(textMaskData.data(), textMaskData.size() * sizeof(float),
-                                       textMaskShape, 3, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT);
-    
-    // Step 2: Run text encoder
-    // Inputs: text_ids, style_ttl, text_mask -> Output: text_emb
-    OrtValue* textEncoderInputTensors[] = {textInput, styleTensor, textMask};
-    const char* textEncoderInputs[] = {"text_ids", "style_ttl", "text_mask"};
-    const char* textEncoderOutputs[] = {"text_emb"};
-    
-    std::vector<OrtValue*> textEncoderOutputTensors(1, nullptr);
-    OrtStatus* runStatus = g_ortApi->Run(g_textEncoder, nullptr,
-                                          textEncoderInputs, (const OrtValue* const*)textEncoderInputTensors, 3,
-                                          textEncoderOutputs, 1, textEncoderOutputTensors.data());
-    
-    g_ortApi->ReleaseValue(textInput);
-    
-    if (checkStatus(runStatus, "TextEncoder Run")) {
-        g_ortApi->ReleaseValue(styleTensor);
-        g_ortApi->ReleaseValue(textMask);
-        LOGE("Text encoder failed");
+    const jsize numResults = numBuckets > 0 ? numBuckets : SUPERTONIC_WARMUP_DEFAULT_BUCKETS;
+    std::vector<double> bucketMs(numResults);
+
+    std::shared_lock<std::shared_timed_mutex> lock(g_engineMutex);
+    if (g_engine == nullptr) {
+        LOGE("Supertonic not initialized");
         return nullptr;
     }
-    OrtValue* textEmb = textEncoderOutputTensors[0];
-    LOGD("Text encoder completed");
-    
-    // Step 3: Run duration predictor
-    // Inputs: text_ids, style_dp [1, 8, 16], text_mask -> Output: duration
-    // Reuse text_ids token tensor, need fresh one since we released it
-    OrtValue* textInput2 = createTensor(tokens.data(), tokens.size() * sizeof(int64_t),
-                                         textShape, 2, ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64);
-    
-    // style_dp has shape [1, 8, 16] - different from style_ttl
-    const int N_STYLE_DP = 8;
-    const int STYLE_DP_DIM = 16;
-    std::vector<float> styleDp(N_STYLE_DP * STYLE_DP_DIM, 0.0f);
-    
-    // Use loaded style if available
-    if (g_voiceStyles.count(speakerId) > 0 && g_voiceStyles[speakerId].loaded) {
-        styleDp = g_voiceStyles[speakerId].style_dp;
-    }
-    
-    int64_t styleDpShape[] = {1, N_STYLE_DP, STYLE_DP_DIM};
-    OrtValue* styleDpTensor = createTensor(styleDp.data(), styleDp.size() * sizeof(float),
-                                            styleDpShape, 3, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT);
-    
-    // Recreate text mask with 3D shape [1, 1, seq_len]
-    OrtValue* textMask2 = createTensor(textMaskData.data(), textMaskData.size() * sizeof(float),
-                                        textMaskShape, 3, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT);
-    
-    OrtValue* durPredInputTensors[] = {textInput2, styleDpTensor, textMask2};
-    const char* durPredInputs[] = {"text_ids", "style_dp", "text_mask"};
-    const char* durPredOutputs[] = {"duration"};
-    
-    std::vector<OrtValue*> durPredOutputTensors(1, nullptr);
-    runStatus = g_ortApi->Run(g_durationPredictor, nullptr,
-                               durPredInputs, (const OrtValue* const*)durPredInputTensors, 3,
-                               durPredOutputs, 1, durPredOutputTensors.data());
-    
-    g_ortApi->ReleaseValue(textInput2);
-    g_ortApi->ReleaseValue(styleDpTensor);
-    g_ortApi->ReleaseValue(textMask2);
-    
-    if (checkStatus(runStatus, "DurationPredictor Run")) {
-        g_ortApi->ReleaseValue(textEmb);
-        g_ortApi->ReleaseValue(styleTensor);
-        g_ortApi->ReleaseValue(textMask);
-        LOGE("Duration predictor failed");
+
+    SupertonicStatus status = supertonic_warmup(g_engine, speakerId,
+                                                numBuckets > 0 ? tokens.data() : nullptr,
+                                                latentLens != nullptr ? latents.data() : nullptr,
+                                                (size_t)numBuckets, bucketMs.data());
+    if (status != SUPERTONIC_OK) {
+        LOGE("Warmup failed: %s", supertonic_status_string(status));
         return nullptr;
     }
-    OrtValue* durations = durPredOutputTensors[0];
-    LOGD("Duration predictor completed");
-    
-    // Get duration tensor info to compute latent length
-    OrtTensorTypeAndShapeInfo* durShapeInfo = nullptr;
-    g_ortApi->GetTensorTypeAndShape(durations, &durShapeInfo);
-    size_t durDimCount = 0;
-    g_ortApi->GetDimensionsCount(durShapeInfo, &durDimCount);
-    std::vector<int64_t> durDims(durDimCount);
-    g_ortApi->GetDimensions(durShapeInfo, durDims.data(), durDimCount);
-    
-    // Log duration tensor shape for debugging
-    std::string dimStr = "";
-    for (size_t i = 0; i < durDimCount; i++) {
-        if (i > 0) dimStr += "x";
-        dimStr += std::to_string(durDims[i]);
-    }
-    LOGD("Duration tensor shape: [%s]", dimStr.c_str());
-    g_ortApi->ReleaseTensorTypeAndShapeInfo(durShapeInfo);
-    
-    // Get durations data and sum to get latent length
-    float* durData = nullptr;
-    g_ortApi->GetTensorMutableData(durations, (void**)&durData);
-    
-    // The duration output may have multiple dimensions, use the total element count
-    size_t durTotalElements = 1;
-    for (size_t i = 0; i < durDimCount; i++) {
-        durTotalElements *= durDims[i];
-    }
-    
-    float durSum = 0.0f;
-    for (size_t i = 0; i < durTotalElements; i++) {
-        durSum += durData[i];
-    }
-    LOGD("Duration sum: %.2f (from %zu elements)", durSum, durTotalElements);
-    
-    // Scale duration by speed (reference implementation uses speed = 1.05)
-    const float DEFAULT_SPEED = 1.05f;
-    float scaledDurSum = durSum / DEFAULT_SPEED;
-    
-    // Duration is in seconds (from the Supertonic model)
-    // Latent length = ceil(scaledDurSum * SAMPLE_RATE / CHUNK_SIZE)
-    // where CHUNK_SIZE = BASE_CHUNK_SIZE * CHUNK_COMPRESS_FACTOR = 512 * 6 = 3072
-    float wavLen = scaledDurSum * SAMPLE_RATE;  // audio samples
-    int64_t latentLen = (int64_t)((wavLen + CHUNK_SIZE - 1) / CHUNK_SIZE);  // ceil division
-    
-    // Ensure minimum latent length of 1
-    if (latentLen < 1) {
-        LOGD("Adjusting latent length from %lld to minimum 1", (long long)latentLen);
-        latentLen = 1;
-    }
-    LOGD("Computed latent length: %lld (scaledDur=%.2f, wavLen=%.0f samples, chunkSize=%d)", (long long)latentLen, scaledDurSum, wavLen, CHUNK_SIZE);
-    
-    // Step 4: Run vector estimator (flow-matching denoiser)
-    // This is a diffusion model that iteratively denoises
-    // Inputs: noisy_latent, text_emb, style_ttl, latent_mask, text_mask, current_step, total_step
-    // Output: denoised_latent
-    
-    const int NUM_STEPS = 5;  // Number of diffusion steps (5 is default in reference implementation)
-    
-    // noisy_latent shape: [batch, LATENT_CHANNELS (144), latent_length]
-    // Generate Gaussian noise using Box-Muller transform (matching reference implementation)
-    std::vector<float> latentData(LATENT_CHANNELS * latentLen, 0.0f);
-    
-    // Use deterministic seed for reproducibility (based on text hash)
-    unsigned int seed = 0;
-    for (size_t i = 0; i < inputText.length(); i++) {
-        seed = seed * 31 + inputText[i];
-    }
-    srand(seed);
-    
-    // Generate Gaussian noise using Box-Muller transform
-    for (size_t i = 0; i < latentData.size(); i += 2) {
-        double u1 = std::max(1e-10, (double)rand() / RAND_MAX);
-        double u2 = (double)rand() / RAND_MAX;
-        double z0 = sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
-        double z1 = sqrt(-2.0 * log(u1)) * sin(2.0 * M_PI * u2);
-        latentData[i] = (float)z0;
-        if (i + 1 < latentData.size()) {
-            latentData[i + 1] = (float)z1;
-        }
+
+    jdoubleArray result = env->NewDoubleArray(numResults);
+    if (result != nullptr) {
+        env->SetDoubleArrayRegion(result, 0, numResults, bucketMs.data());
     }
-    int64_t latentShape[] = {1, LATENT_CHANNELS, latentLen};
-    
-    // Create latent mask (all ones) - shape [1, 1, latent_len]
-    std::vector<float> latentMaskData(latentLen, 1.0f);
-    int64_t latentMaskShape[] = {1, 1, latentLen};
-    
-    // Recreate text mask for vector estimator with 3D shape [1, 1, seq_len]
-    OrtValue* textMask3 = createTensor(textMaskData.data(), textMaskData.size() * sizeof(float),
-                                        textMaskShape, 3, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT);
-    
-    // Run diffusion steps
-    for (int step = 0; step < NUM_STEPS; step++) {
-        OrtValue* noisyLatent = createTensor(latentData.data(), latentData.size() * sizeof(float),
-                                              latentShape, 3, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT);
-        OrtValue* latentMask = createTensor(latentMaskData.data(), latentMaskData.size() * sizeof(float),
-                                             latentMaskShape, 3, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT);
-        
-        // Step tensors - model expects float32, not int64
-        int64_t stepShape[] = {1};
-        float currentStepVal = static_cast<float>(step);
-        float totalStepVal = static_cast<float>(NUM_STEPS);
-        OrtValue* currentStepTensor = createTensor(&currentStepVal, sizeof(float),
-                                                    stepShape, 1, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT);
-        OrtValue* totalStepTensor = createTensor(&totalStepVal, sizeof(float),
-                                                  stepShape, 1, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT);
-        
-        OrtValue* vecEstInputTensors[] = {noisyLatent, textEmb, styleTensor, latentMask, textMask3, currentStepTensor, totalStepTensor};
-        const char* vecEstInputNames[] = {"noisy_latent", "text_emb", "style_ttl", "latent_mask", "text_mask", "current_step", "total_step"};
-        const char* vecEstOutputs[] = {"denoised_latent"};
-        
-        std::vector<OrtValue*> vecEstOutputTensors(1, nullptr);
-        runStatus = g_ortApi->Run(g_vectorEstimator, nullptr,
-                                   vecEstInputNames, (const OrtValue* const*)vecEstInputTensors, 7,
-                                   vecEstOutputs, 1, vecEstOutputTensors.data());
-        
-        g_ortApi->ReleaseValue(noisyLatent);
-        g_ortApi->ReleaseValue(latentMask);
-        g_ortApi->ReleaseValue(currentStepTensor);
-        g_ortApi->ReleaseValue(totalStepTensor);
-        
-        if (checkStatus(runStatus, "VectorEstimator Run")) {
-            g_ortApi->ReleaseValue(textEmb);
-            g_ortApi->ReleaseValue(styleTensor);
-            g_ortApi->ReleaseValue(textMask);
-            g_ortApi->ReleaseValue(textMask3);
-            g_ortApi->ReleaseValue(durations);
-            LOGE("Vector estimator failed at step %d", step);
+    return result;
+}
+
+/**
+ * Predict the audio length in seconds of each text from the duration
+ * predictor alone. Returns null on failure.
+ */
+JNIEXPORT jdoubleArray JNICALL
+Java_com_example_platform_1android_1tts_onnx_SupertonicNative_estimateDurations(
+    JNIEnv* env, jobject thiz, jobjectArray texts, jint speakerId, jfloat speed) {
+
+    const jsize numTexts = env->GetArrayLength(texts);
+    std::vector<std::string> textList;
+    textList.reserve(numTexts);
+    for (jsize i = 0; i < numTexts; i++) {
+        jstring text = (jstring)env->GetObjectArrayElement(texts, i);
+        const char* textStr = text != nullptr ? env->GetStringUTFChars(text, nullptr) : nullptr;
+        if (textStr == nullptr) {
+            LOGE("estimateDurations: text %d is null", (int)i);
             return nullptr;
         }
-        
-        // Copy denoised output back to latentData for next step
-        float* denoisedData = nullptr;
-        g_ortApi->GetTensorMutableData(vecEstOutputTensors[0], (void**)&denoisedData);
-        memcpy(latentData.data(), denoisedData, latentData.size() * sizeof(float));
-        g_ortApi->ReleaseValue(vecEstOutputTensors[0]);
-    }
-    
-    g_ortApi->ReleaseValue(textEmb);
-    g_ortApi->ReleaseValue(styleTensor);
-    g_ortApi->ReleaseValue(textMask);
-    g_ortApi->ReleaseValue(textMask3);
-    g_ortApi->ReleaseValue(durations);
-    LOGD("Vector estimator completed (%d steps)", NUM_STEPS);
-    
-    // Step 5: Run vocoder
-    // Input: latent [batch, 144, latent_length] -> Output: wav_tts
-    OrtValue* finalLatent = createTensor(latentData.data(), latentData.size() * sizeof(float),
-                                          latentShape, 3, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT);
-    
-    const char* vocoderInputs[] = {"latent"};
-    const char* vocoderOutputs[] = {"wav_tts"};
-    
-    std::vector<OrtValue*> vocoderOutputTensors(1, nullptr);
-    runStatus = g_ortApi->Run(g_vocoder, nullptr,
-                               vocoderInputs, (const OrtValue* const*)&finalLatent, 1,
-                               vocoderOutputs, 1, vocoderOutputTensors.data());
-    
-    g_ortApi->ReleaseValue(finalLatent);
-    
-    if (checkStatus(runStatus, "Vocoder Run") || vocoderOutputTensors[0] == nullptr) {
-        LOGE("Vocoder failed");
-        return nullptr;
+        textList.emplace_back(textStr);
+        env->ReleaseStringUTFChars(text, textStr);
+        env->DeleteLocalRef(text);
     }
-    OrtValue* audioTensor = vocoderOutputTensors[0];
-    LOGD("Vocoder completed");
-    
-    // Get audio data from tensor
-    float* audioData = nullptr;
-    OrtStatus* status = g_ortApi->GetTensorMutableData(audioTensor, (void**)&audioData);
-    if (checkStatus(status, "GetTensorMutableData") || audioData == nullptr) {
-        g_ortApi->ReleaseValue(audioTensor);
-        return nullptr;
+    std::vector<const char*> textPtrs;
+    for (const auto& text : textList) {
+        textPtrs.push_back(text.c_str());
     }
-    
-    // Get tensor shape to determine audio length
-    OrtTensorTypeAndShapeInfo* shapeInfo = nullptr;
-    status = g_ortApi->GetTensorTypeAndShape(audioTensor, &shapeInfo);
-    if (checkStatus(status, "GetTensorTypeAndShape")) {
-        g_ortApi->ReleaseValue(audioTensor);
+    std::vector<double> seconds(numTexts);
+
+    std::shared_lock<std::shared_timed_mutex> lock(g_engineMutex);
+    if (g_engine == nullptr) {
+        LOGE("Supertonic not initialized");
         return nullptr;
     }
-    
-    size_t numSamples = 0;
-    status = g_ortApi->GetTensorShapeElementCount(shapeInfo, &numSamples);
-    g_ortApi->ReleaseTensorTypeAndShapeInfo(shapeInfo);
-    
-    if (checkStatus(status, "GetTensorShapeElementCount") || numSamples == 0) {
-        g_ortApi->ReleaseValue(audioTensor);
+
+    SupertonicStatus status = supertonic_estimate_durations(g_engine, textPtrs.data(), textPtrs.size(),
+                                                            speakerId, speed, seconds.data());
+    if (status != SUPERTONIC_OK) {
+        LOGE("Duration estimation failed: %s", supertonic_status_string(status));
         return nullptr;
     }
-    
-    LOGD("Generated %zu audio samples", numSamples);
-    
-    // Create Java float array
-    jfloatArray result = env->NewFloatArray(numSamples);
-    if (result == nullptr) {
-        g_ortApi->ReleaseValue(audioTensor);
-        return nullptr;
+
+    jdoubleArray result = env->NewDoubleArray(numTexts);
+    if (result != nullptr) {
+        env->SetDoubleArrayRegion(result, 0, numTexts, seconds.data());
     }
-    
-    env->SetFloatArrayRegion(result, 0, numSamples, audioData);
-    g_ortApi->ReleaseValue(audioTensor);
-    
     return result;
 }
 
@@ -1197,7 +842,7 @@ Java_com_example_platform_1android_1tts_onnx_SupertonicNative_synthesize(
 JNIEXPORT jint JNICALL
 Java_com_example_platform_1android_1tts_onnx_SupertonicNative_getSampleRate(
     JNIEnv* env, jobject thiz) {
-    return SAMPLE_RATE;
+    return supertonic_sample_rate();
 }
 
 /**
@@ -1206,7 +851,8 @@ Java_com_example_platform_1android_1tts_onnx_SupertonicNative_getSampleRate(
 JNIEXPORT jboolean JNICALL
 Java_com_example_platform_1android_1tts_onnx_SupertonicNative_isReady(
     JNIEnv* env, jobject thiz) {
-    return g_initialized ? JNI_TRUE : JNI_FALSE;
+    std::shared_lock<std::shared_timed_mutex> lock(g_engineMutex);
+    return g_engine != nullptr ? JNI_TRUE : JNI_FALSE;
 }
 
 /**
@@ -1215,44 +861,12 @@ Java_com_example_platform_1android_1tts_onnx_SupertonicNative_isReady(
 JNIEXPORT void JNICALL
 Java_com_example_platform_1android_1tts_onnx_SupertonicNative_dispose(
     JNIEnv* env, jobject thiz) {
-    
+
     LOGI("Disposing Supertonic engine");
-    
-    if (g_textEncoder != nullptr) {
-        g_ortApi->ReleaseSession(g_textEncoder);
-        g_textEncoder = nullptr;
-    }
-    if (g_durationPredictor != nullptr) {
-        g_ortApi->ReleaseSession(g_durationPredictor);
-        g_durationPredictor = nullptr;
-    }
-    if (g_vectorEstimator != nullptr) {
-        g_ortApi->ReleaseSession(g_vectorEstimator);
-        g_vectorEstimator = nullptr;
-    }
-    if (g_vocoder != nullptr) {
-        g_ortApi->ReleaseSession(g_vocoder);
-        g_vocoder = nullptr;
-    }
-    
-    if (g_sessionOptions != nullptr) {
-        g_ortApi->ReleaseSessionOptions(g_sessionOptions);
-        g_sessionOptions = nullptr;
-    }
-    
-    if (g_memoryInfo != nullptr) {
-        g_ortApi->ReleaseMemoryInfo(g_memoryInfo);
-        g_memoryInfo = nullptr;
-    }
-    
-    if (g_ortEnv != nullptr) {
-        g_ortApi->ReleaseEnv(g_ortEnv);
-        g_ortEnv = nullptr;
-    }
-    
-    g_unicodeIndexer.clear();
-    g_modelBasePath.clear();
-    g_initialized = false;
+
+    std::unique_lock<std::shared_timed_mutex> lock(g_engineMutex);
+    supertonic_engine_destroy(g_engine);
+    g_engine = nullptr;
 }
 
 } // extern "C"
@@ -0,0 +1,440 @@
+/*
+ * scheduler_test.cpp - Order, merging, cancellation, preemption and
+ * promotion of supertonic_submit() jobs
+ *
+ * Runs the real scheduler (core/scheduler.cpp) against a stub engine: the
+ * synthesize() below takes num_steps "diffusion steps" of a couple of
+ * milliseconds, asks Preemption::yield between them like the engine does
+ * and records every start, pause and finish. Texts starting with "gate"
+ * block without yielding until openGate(), which keeps a scheduler thread
+ * busy while a test lines up the queue behind it.
+ */
+
+#include "engine.h"
+#include "scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace supertonic {
+
+/** Progress of a paused stub run. */
+struct SuspendedSynthesis {
+    int nextStep = 0;
+    std::vector<float> audio;
+};
+
+} // namespace supertonic
+
+namespace {
+
+using namespace supertonic;
+
+constexpr auto kStep = std::chrono::milliseconds(2);
+constexpr auto kTimeout = std::chrono::seconds(5);
+constexpr int kRunSlots = 2;
+
+enum EventKind { EVENT_START, EVENT_RESUME, EVENT_PAUSE, EVENT_FINISH };
+
+struct Event {
+    std::string text;
+    EventKind kind;
+    int executionClass;
+    int step;  // steps done when it happened
+};
+
+std::mutex g_mutex;
+std::condition_variable g_changed;
+std::vector<Event> g_events;
+bool g_gateOpen = false;
+
+int g_failures = 0;
+
+void check(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAILED: %s\n", what);
+        g_failures++;
+    }
+}
+
+void record(const std::string& text, EventKind kind, int executionClass, int step) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_events.push_back(Event{text, kind, executionClass, step});
+    g_changed.notify_all();
+}
+
+void openGate() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_gateOpen = true;
+    g_changed.notify_all();
+}
+
+/** Wait until predicate holds for the events so far; false on timeout. */
+bool waitFor(const std::function<bool(const std::vector<Event>&)>& predicate) {
+    std::unique_lock<std::mutex> lock(g_mutex);
+    return g_changed.wait_for(lock, kTimeout, [&]() { return predicate(g_events); });
+}
+
+bool happened(const std::vector<Event>& events, const std::string& text, EventKind kind) {
+    for (const Event& event : events) {
+        if (event.text == text && event.kind == kind) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool waitForEvent(const std::string& text, EventKind kind) {
+    return waitFor([&](const std::vector<Event>& events) { return happened(events, text, kind); });
+}
+
+std::vector<Event> events() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_events;
+}
+
+/** Texts of the events of kind, in order. */
+std::vector<std::string> texts(EventKind kind) {
+    std::vector<std::string> out;
+    for (const Event& event : events()) {
+        if (event.kind == kind) {
+            out.push_back(event.text);
+        }
+    }
+    return out;
+}
+
+int count(const std::string& text, EventKind kind) {
+    int n = 0;
+    for (const Event& event : events()) {
+        n += event.text == text && event.kind == kind;
+    }
+    return n;
+}
+
+/** Fresh engine and event log; the scheduler starts with the first submission. */
+std::unique_ptr<SupertonicEngine> newEngine(bool preempt) {
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_events.clear();
+        g_gateOpen = false;
+    }
+    std::unique_ptr<SupertonicEngine> engine(new SupertonicEngine());
+    engine->config.scheduler_threads = 1;
+    engine->config.preempt_jobs = preempt ? 1 : 0;
+    engine->config.background_nice = 0;
+    return engine;
+}
+
+void finish(SupertonicEngine* engine) {
+    openGate();
+    stopScheduler(engine);
+}
+
+uint64_t submit(SupertonicEngine* engine, const std::string& text, int64_t deadlineMs, int numSteps = 3,
+                SupertonicExecutionClass executionClass = SUPERTONIC_CLASS_FOREGROUND,
+                SupertonicJobCallback callback = nullptr, void* userData = nullptr) {
+    SupertonicSynthesisRequest request = {};
+    request.struct_size = sizeof(request);
+    request.text = text.c_str();
+    request.speed = 1.0f;
+    request.num_steps = numSteps;
+    request.execution_class = executionClass;
+    uint64_t handle = 0;
+    const SupertonicStatus status = submitJob(engine, request, deadlineMs, handle, callback, userData);
+    check(status == SUPERTONIC_OK, "submitJob failed");
+    return handle;
+}
+
+SupertonicStatus take(SupertonicEngine* engine, uint64_t handle, std::vector<float>* audio = nullptr,
+                      SupertonicSynthesisStats* stats = nullptr) {
+    std::vector<float> samples;
+    const SupertonicStatus status = waitJob(engine, handle, samples, stats, nullptr);
+    if (audio != nullptr) {
+        *audio = std::move(samples);
+    }
+    return status;
+}
+
+void testEarliestDeadlineFirst() {
+    auto engine = newEngine(true);
+    const uint64_t gate = submit(engine.get(), "gate", 0);
+    check(waitForEvent("gate", EVENT_START), "gate job did not start");
+
+    // Queued behind the gate in submission order; equal deadlines keep it
+    const uint64_t a = submit(engine.get(), "a", 3000);
+    const uint64_t b = submit(engine.get(), "b", 1000);
+    const uint64_t c = submit(engine.get(), "c", 2000);
+    const uint64_t d = submit(engine.get(), "d", 1000);
+    openGate();
+    for (uint64_t handle : {gate, a, b, c, d}) {
+        check(take(engine.get(), handle) == SUPERTONIC_OK, "EDF: job failed");
+    }
+    check(texts(EVENT_START) == std::vector<std::string>({"gate", "b", "d", "c", "a"}),
+          "jobs did not start earliest deadline first");
+    finish(engine.get());
+}
+
+void testMerging() {
+    auto engine = newEngine(true);
+    const uint64_t gate = submit(engine.get(), "gate", 0);
+    check(waitForEvent("gate", EVENT_START), "gate job did not start");
+
+    // Identical to a queued job, and to the running one
+    const uint64_t first = submit(engine.get(), "same", 3000);
+    const uint64_t second = submit(engine.get(), "same", 1000);
+    const uint64_t joined = submit(engine.get(), "gate", 500);
+    openGate();
+
+    std::vector<float> audioFirst, audioSecond;
+    SupertonicSynthesisStats statsFirst = {}, statsSecond = {};
+    check(take(engine.get(), first, &audioFirst, &statsFirst) == SUPERTONIC_OK, "merged job failed");
+    check(take(engine.get(), second, &audioSecond, &statsSecond) == SUPERTONIC_OK, "merged job failed");
+    check(take(engine.get(), gate) == SUPERTONIC_OK && take(engine.get(), joined) == SUPERTONIC_OK,
+          "job joined while running failed");
+    check(count("same", EVENT_START) == 1, "identical queued requests ran twice");
+    check(count("gate", EVENT_START) == 1, "request identical to a running job ran again");
+    check(audioFirst.size() == 3 && audioFirst == audioSecond, "merged requests got different audio");
+    check(statsFirst.shared_requests == 2 && statsSecond.shared_requests == 2,
+          "merged requests do not report sharing");
+
+    // Different steps make a different job
+    const uint64_t other = submit(engine.get(), "same", 0, 4);
+    check(take(engine.get(), other) == SUPERTONIC_OK && count("same", EVENT_START) == 2,
+          "request with other steps was merged");
+    finish(engine.get());
+}
+
+struct CallbackResult {
+    std::mutex mutex;
+    std::vector<SupertonicStatus> statuses;
+};
+
+void onJobDone(void* userData, uint64_t, SupertonicStatus status) {
+    auto* result = static_cast<CallbackResult*>(userData);
+    std::lock_guard<std::mutex> lock(result->mutex);
+    result->statuses.push_back(status);
+}
+
+void testCancellation() {
+    auto engine = newEngine(true);
+    const uint64_t gate = submit(engine.get(), "gate", 0);
+    check(waitForEvent("gate", EVENT_START), "gate job did not start");
+
+    // A queued job nobody else shares is dropped and never runs
+    CallbackResult result;
+    const uint64_t queued = submit(engine.get(), "queued", 100, 3, SUPERTONIC_CLASS_FOREGROUND, onJobDone, &result);
+    check(cancelJob(engine.get(), queued) == SUPERTONIC_OK, "cancel of a queued job failed");
+    check(cancelJob(engine.get(), queued) == SUPERTONIC_ERROR_NOT_FOUND, "second cancel was accepted");
+    check(result.statuses == std::vector<SupertonicStatus>({SUPERTONIC_ERROR_CANCELLED}),
+          "callback of a cancelled job did not report it once");
+    check(take(engine.get(), queued) == SUPERTONIC_ERROR_CANCELLED, "cancelled handle did not say so");
+
+    // A shared job goes on for the submission that is still waiting
+    const uint64_t kept = submit(engine.get(), "shared", 200);
+    const uint64_t dropped = submit(engine.get(), "shared", 200);
+    check(cancelJob(engine.get(), dropped) == SUPERTONIC_OK, "cancel of a shared job failed");
+    openGate();
+    std::vector<float> audio;
+    check(take(engine.get(), kept, &audio) == SUPERTONIC_OK && audio.size() == 3,
+          "cancelling one submission stopped a shared job");
+    check(take(engine.get(), gate) == SUPERTONIC_OK, "gate job failed");
+
+    // A running job stops at its next step
+    const uint64_t running = submit(engine.get(), "long", 0, 1000);
+    check(waitForEvent("long", EVENT_START), "long job did not start");
+    check(cancelJob(engine.get(), running) == SUPERTONIC_OK, "cancel of a running job failed");
+    const uint64_t next = submit(engine.get(), "next", 5000);
+    check(take(engine.get(), next) == SUPERTONIC_OK, "job after a cancelled one failed");
+    check(count("queued", EVENT_START) == 0, "cancelled queued job ran");
+    check(count("long", EVENT_FINISH) == 0 && count("long", EVENT_RESUME) == 0,
+          "cancelled running job went on");
+    finish(engine.get());
+}
+
+void testPreemption() {
+    auto engine = newEngine(true);
+    const uint64_t slow = submit(engine.get(), "slow", 5000, 200);
+    check(waitForEvent("slow", EVENT_START), "slow job did not start");
+    const uint64_t urgent = submit(engine.get(), "urgent", 10);
+    std::vector<float> audio;
+    check(take(engine.get(), urgent) == SUPERTONIC_OK, "urgent job failed");
+    check(take(engine.get(), slow, &audio) == SUPERTONIC_OK, "preempted job failed");
+    check(audio.size() == 200, "resumed job lost or repeated steps");
+
+    // The slow job paused for the urgent one and then continued
+    std::vector<std::string> order;
+    for (const Event& event : events()) {
+        order.push_back(event.text + (event.kind == EVENT_START    ? ":start"
+                                      : event.kind == EVENT_RESUME ? ":resume"
+                                      : event.kind == EVENT_PAUSE  ? ":pause"
+                                                                   : ":finish"));
+    }
+    check(order == std::vector<std::string>(
+                       {"slow:start", "slow:pause", "urgent:start", "urgent:finish", "slow:resume", "slow:finish"}),
+          "urgent job did not preempt the running one");
+    finish(engine.get());
+
+    // Without preempt_jobs the urgent job waits for the running one
+    engine = newEngine(false);
+    const uint64_t first = submit(engine.get(), "slow", 5000, 20);
+    check(waitForEvent("slow", EVENT_START), "slow job did not start");
+    const uint64_t second = submit(engine.get(), "urgent", 10);
+    check(take(engine.get(), second) == SUPERTONIC_OK && take(engine.get(), first) == SUPERTONIC_OK,
+          "jobs failed without preemption");
+    check(texts(EVENT_FINISH) == std::vector<std::string>({"slow", "urgent"}) && count("slow", EVENT_PAUSE) == 0,
+          "job paused with preempt_jobs off");
+    finish(engine.get());
+}
+
+int classOf(const std::string& text, EventKind kind) {
+    for (const Event& event : events()) {
+        if (event.text == text && event.kind == kind) {
+            return event.executionClass;
+        }
+    }
+    return -1;
+}
+
+void testPromotion() {
+    auto engine = newEngine(true);
+    // Keeps the one background thread busy
+    const uint64_t gate = submit(engine.get(), "gate", 60000, 3, SUPERTONIC_CLASS_BACKGROUND);
+    check(waitForEvent("gate", EVENT_START), "background gate did not start");
+
+    // A foreground request joining a queued background job moves it over
+    const uint64_t prefetch = submit(engine.get(), "joined", 60000, 3, SUPERTONIC_CLASS_BACKGROUND);
+    const uint64_t playback = submit(engine.get(), "joined", 1000);
+    check(take(engine.get(), playback) == SUPERTONIC_OK && take(engine.get(), prefetch) == SUPERTONIC_OK,
+          "joined background job failed");
+    check(classOf("joined", EVENT_START) == SUPERTONIC_CLASS_FOREGROUND,
+          "background job joined by a foreground request stayed in the background");
+
+    // A background job due within SUPERTONIC_PROMOTE_MS runs as foreground
+    const uint64_t due = submit(engine.get(), "due", SUPERTONIC_PROMOTE_MS / 4, 3, SUPERTONIC_CLASS_BACKGROUND);
+    check(take(engine.get(), due) == SUPERTONIC_OK, "due background job failed");
+    check(classOf("due", EVENT_START) == SUPERTONIC_CLASS_FOREGROUND, "due background job was not promoted");
+
+    openGate();
+    check(take(engine.get(), gate) == SUPERTONIC_OK, "background gate failed");
+    check(classOf("gate", EVENT_FINISH) == SUPERTONIC_CLASS_BACKGROUND, "far background job left the background");
+
+    // A running background job pauses and resumes in the foreground once a
+    // foreground request joins it
+    const uint64_t background = submit(engine.get(), "moving", 60000, 200, SUPERTONIC_CLASS_BACKGROUND);
+    check(waitForEvent("moving", EVENT_START), "background job did not start");
+    const uint64_t foreground = submit(engine.get(), "moving", 1000, 200);
+    std::vector<float> audio;
+    check(take(engine.get(), foreground, &audio) == SUPERTONIC_OK && audio.size() == 200,
+          "promoted running job failed");
+    check(take(engine.get(), background) == SUPERTONIC_OK, "promoted running job failed");
+    check(classOf("moving", EVENT_START) == SUPERTONIC_CLASS_BACKGROUND &&
+              classOf("moving", EVENT_RESUME) == SUPERTONIC_CLASS_FOREGROUND,
+          "running background job was not moved to the foreground");
+    finish(engine.get());
+}
+
+} // namespace
+
+// Stub engine: just what scheduler.cpp calls
+
+namespace supertonic {
+
+int parallelRuns(const SupertonicEngine*) {
+    return kRunSlots;
+}
+
+RunSlots::RunSlots(SupertonicEngine* engine) : engine_(engine) {
+    std::unique_lock<std::mutex> lock(engine->runSlotMutex);
+    engine->runSlotReleased.wait(lock, [engine]() { return engine->runSlotsUsed < kRunSlots; });
+    engine->runSlotsUsed++;
+    count_ = 1;
+}
+
+RunSlots::RunSlots(SupertonicEngine* engine, size_t wanted) : engine_(engine) {
+    std::lock_guard<std::mutex> lock(engine->runSlotMutex);
+    count_ = std::min((int)wanted, kRunSlots - engine->runSlotsUsed);
+    engine->runSlotsUsed += count_;
+}
+
+RunSlots::~RunSlots() {
+    if (count_ == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(engine_->runSlotMutex);
+        engine_->runSlotsUsed -= count_;
+    }
+    engine_->runSlotReleased.notify_all();
+    notifyRunSlotReleased(engine_);
+}
+
+bool runSlotFree(SupertonicEngine* engine) {
+    std::lock_guard<std::mutex> lock(engine->runSlotMutex);
+    return engine->runSlotsUsed < kRunSlots;
+}
+
+SupertonicStatus synthesize(SupertonicEngine* engine, const SupertonicSynthesisRequest& request,
+                            std::vector<float>& audio, SupertonicSynthesisStats* stats, TokenTimings*,
+                            Preemption* preemption, bool holdsRunSlot) {
+    std::unique_ptr<RunSlots> runSlot;
+    if (request.execution_class == SUPERTONIC_CLASS_FOREGROUND && !holdsRunSlot) {
+        runSlot.reset(new RunSlots(engine));
+    }
+    const std::string text = request.text;
+    std::shared_ptr<SuspendedSynthesis> state;
+    if (preemption != nullptr && preemption->suspended != nullptr) {
+        state = std::move(preemption->suspended);
+    } else {
+        state = std::make_shared<SuspendedSynthesis>();
+    }
+    record(text, state->nextStep > 0 ? EVENT_RESUME : EVENT_START, request.execution_class, state->nextStep);
+
+    if (text.compare(0, 4, "gate") == 0) {
+        std::unique_lock<std::mutex> lock(g_mutex);
+        g_changed.wait(lock, []() { return g_gateOpen; });
+    }
+    const int numSteps = request.num_steps > 0 ? request.num_steps : DEFAULT_NUM_STEPS;
+    while (state->nextStep < numSteps) {
+        std::this_thread::sleep_for(kStep);
+        state->audio.push_back((float)text.size() + state->nextStep);
+        state->nextStep++;
+        if (state->nextStep < numSteps && preemption != nullptr && preemption->yield && preemption->yield()) {
+            record(text, EVENT_PAUSE, request.execution_class, state->nextStep);
+            preemption->suspended = std::move(state);
+            return SUPERTONIC_OK;
+        }
+    }
+    audio = std::move(state->audio);
+    if (stats != nullptr) {
+        *stats = {};
+        stats->status = SUPERTONIC_OK;
+        stats->num_steps = numSteps;
+        stats->execution_class = request.execution_class;
+    }
+    record(text, EVENT_FINISH, request.execution_class, numSteps);
+    return SUPERTONIC_OK;
+}
+
+} // namespace supertonic
+
+int main() {
+    testEarliestDeadlineFirst();
+    testMerging();
+    testCancellation();
+    testPreemption();
+    testPromotion();
+
+    if (g_failures == 0) {
+        std::printf("scheduler_test: OK\n");
+    }
+    return g_failures == 0 ? 0 : 1;
+}
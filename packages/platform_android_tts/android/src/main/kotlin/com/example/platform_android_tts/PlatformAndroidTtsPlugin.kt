@@ -1,5 +1,8 @@
 package com.example.platform_android_tts
 
+import android.content.ComponentCallbacks2
+import android.content.Context
+import android.content.res.Configuration
 import io.flutter.embedding.engine.plugins.FlutterPlugin
 import io.flutter.plugin.common.BinaryMessenger
 import io.flutter.plugin.common.MethodCall
@@ -25,6 +28,21 @@ class PlatformAndroidTtsPlugin :
     private val kokoroService = KokoroTtsService()
     private val piperService = PiperTtsService()
     private val supertonicService = SupertonicTtsService()
+    
+    // The services are not attached as real Services, so forward memory
+    // pressure from the application context ourselves
+    private var applicationContext: Context? = null
+    private val memoryCallbacks = object : ComponentCallbacks2 {
+        override fun onTrimMemory(level: Int) {
+            supertonicService.onTrimMemory(level)
+        }
+        
+        override fun onLowMemory() {
+            supertonicService.onTrimMemory(ComponentCallbacks2.TRIM_MEMORY_COMPLETE)
+        }
+        
+        override fun onConfigurationChanged(newConfig: Configuration) {}
+    }
 
     override fun onAttachedToEngine(flutterPluginBinding: FlutterPlugin.FlutterPluginBinding) {
         channel = MethodChannel(flutterPluginBinding.binaryMessenger, "platform_android_tts")
@@ -41,6 +59,14 @@ class PlatformAndroidTtsPlugin :
             flutterApi = flutterApi!!
         )
         TtsNativeApi.setUp(flutterPluginBinding.binaryMessenger, ttsApiImpl)
+        
+        // All three engines share this process and its cores
+        supertonicService.sherpaThreads = {
+            maxOf(kokoroService.inferenceThreads(), piperService.inferenceThreads())
+        }
+        
+        applicationContext = flutterPluginBinding.applicationContext
+        applicationContext?.registerComponentCallbacks(memoryCallbacks)
     }
 
     override fun onMethodCall(
@@ -57,6 +83,8 @@ class PlatformAndroidTtsPlugin :
     override fun onDetachedFromEngine(binding: FlutterPlugin.FlutterPluginBinding) {
         channel.setMethodCallHandler(null)
         TtsNativeApi.setUp(binding.binaryMessenger, null)
+        applicationContext?.unregisterComponentCallbacks(memoryCallbacks)
+        applicationContext = null
         ttsApiImpl?.cleanup()
         ttsApiImpl = null
         flutterApi = null
@@ -84,7 +84,8 @@ class TtsNativeApiImpl(
                         outputPath = request.outputPath,
                         requestId = request.requestId,
                         speakerId = request.speakerId?.toInt() ?: 0,
-                        speed = request.speed.toFloat()
+                        speed = request.speed.toFloat(),
+                        deadlineMs = request.deadlineMs
                     )
                 }
                 
@@ -116,6 +117,21 @@ class TtsNativeApiImpl(
         callback(Result.success(Unit))
     }
     
+    override fun warmUpVoice(
+        engineType: NativeEngineType,
+        voiceId: String,
+        callback: (Result<Unit>) -> Unit
+    ) {
+        scope.launch {
+            val result = when (engineType) {
+                // sherpa engines have no separate warmup step
+                NativeEngineType.KOKORO, NativeEngineType.PIPER -> Result.success(Unit)
+                NativeEngineType.SUPERTONIC -> supertonicService.warmUpVoice(voiceId)
+            }
+            callback(result)
+        }
+    }
+
     override fun unloadVoice(
         engineType: NativeEngineType,
         voiceId: String,
@@ -227,7 +227,12 @@ data class SynthesizeRequest (
   val outputPath: String,
   val requestId: String,
   val speakerId: Long? = null,
-  val speed: Double
+  val speed: Double,
+  /**
+   * When playback needs the audio, in milliseconds from now. Engines with
+   * a native request queue run earlier deadlines first; null = unknown.
+   */
+  val deadlineMs: Long? = null
 )
  {
   companion object {
@@ -239,7 +244,8 @@ data class SynthesizeRequest (
       val requestId = pigeonVar_list[4] as String
       val speakerId = pigeonVar_list[5] as Long?
       val speed = pigeonVar_list[6] as Double
-      return SynthesizeRequest(engineType, voiceId, text, outputPath, requestId, speakerId, speed)
+      val deadlineMs = pigeonVar_list[7] as Long?
+      return SynthesizeRequest(engineType, voiceId, text, outputPath, requestId, speakerId, speed, deadlineMs)
     }
   }
   fun toList(): List<Any?> {
@@ -251,6 +257,7 @@ data class SynthesizeRequest (
       requestId,
       speakerId,
       speed,
+      deadlineMs,
     )
   }
   override fun equals(other: Any?): Boolean {
@@ -496,6 +503,12 @@ interface TtsNativeApi {
   fun synthesize(request: SynthesizeRequest, callback: (Result<SynthesizeResult>) -> Unit)
   /** Cancel an in-flight synthesis operation. */
   fun cancelSynthesis(requestId: String, callback: (Result<Unit>) -> Unit)
+  /**
+   * Run a loaded voice's first inference ahead of playback.
+   *
+   * Made during idle warmup; a no-op for engines without a warmup step.
+   */
+  fun warmUpVoice(engineType: NativeEngineType, voiceId: String, callback: (Result<Unit>) -> Unit)
   /** Unload a voice to free memory. */
   fun unloadVoice(engineType: NativeEngineType, voiceId: String, callback: (Result<Unit>) -> Unit)
   /** Unload all voices for an engine. */
@@ -595,6 +608,26 @@ interface TtsNativeApi {
           channel.setMessageHandler(null)
         }
       }
+      run {
+        val channel = BasicMessageChannel<Any?>(binaryMessenger, "dev.flutter.pigeon.platform_android_tts.TtsNativeApi.warmUpVoice$separatedMessageChannelSuffix", codec)
+        if (api != null) {
+          channel.setMessageHandler { message, reply ->
+            val args = message as List<Any?>
+            val engineTypeArg = args[0] as NativeEngineType
+            val voiceIdArg = args[1] as String
+            api.warmUpVoice(engineTypeArg, voiceIdArg) { result: Result<Unit> ->
+              val error = result.exceptionOrNull()
+              if (error != null) {
+                reply.reply(TtsApiPigeonUtils.wrapError(error))
+              } else {
+                reply.reply(TtsApiPigeonUtils.wrapResult(null))
+              }
+            }
+          }
+        } else {
+          channel.setMessageHandler(null)
+        }
+      }
       run {
         val channel = BasicMessageChannel<Any?>(binaryMessenger, "dev.flutter.pigeon.platform_android_tts.TtsNativeApi.unloadVoice$separatedMessageChannelSuffix", codec)
         if (api != null) {
@@ -0,0 +1,86 @@
+package com.example.platform_android_tts.onnx
+
+/**
+ * Native memory owned by the Supertonic engine.
+ *
+ * Decoded from the flat LongArray filled by [SupertonicNative.getMemoryReport].
+ * Per-model lists are ordered text_encoder, duration_predictor,
+ * vector_estimator, vocoder.
+ */
+data class SupertonicMemoryReport(
+    val sessionsLoaded: Int,
+    val styleCacheBytes: Long,
+    val cachedStyles: Int,
+    val scratchPeakBytes: Long,
+    val nativeHeapBytes: Long,
+    val arenaEstimateBytes: Long,
+    val processRssBytes: Long,
+    val sessionBytes: List<Long>,
+    val modelFileBytes: List<Long>,
+    val textCacheBytes: Long = 0,
+    val cachedTexts: Int = 0,
+    /** Weights every session of the model shares, not part of [sessionBytes]. */
+    val sharedWeightBytes: List<Long> = List(NUM_MODELS) { 0L },
+    /** Foreground sessions per model that parallel calls take turns on. */
+    val sessionInstances: List<Int> = List(NUM_MODELS) { 0 }
+) {
+    /** Bytes attributable to loaded sessions, their shared weights and caches. */
+    val engineBytes: Long get() = sessionBytes.sum() + sharedWeightBytes.sum() + styleCacheBytes + textCacheBytes
+
+    fun isSessionLoaded(model: Int): Boolean = sessionsLoaded and (1 shl model) != 0
+
+    companion object {
+        const val MODEL_TEXT_ENCODER = 0
+        const val MODEL_DURATION_PREDICTOR = 1
+        const val MODEL_VECTOR_ESTIMATOR = 2
+        const val MODEL_VOCODER = 3
+        const val NUM_MODELS = 4
+
+        // SupertonicTrimLevel in core/supertonic.h
+        const val TRIM_NONE = 0
+        const val TRIM_ARENAS = 1
+        const val TRIM_CACHES = 2
+        const val TRIM_LARGE_SESSIONS = 3
+        const val TRIM_ALL_SESSIONS = 4
+
+        // Must stay in sync with MemoryIndex in supertonic_native.cpp
+        private const val SESSIONS_LOADED = 0
+        private const val STYLE_CACHE_BYTES = 1
+        private const val CACHED_STYLES = 2
+        private const val SCRATCH_PEAK_BYTES = 3
+        private const val NATIVE_HEAP_BYTES = 4
+        private const val ARENA_ESTIMATE_BYTES = 5
+        private const val PROCESS_RSS_BYTES = 6
+        private const val SESSION_BYTES_BASE = 7
+        private const val MODEL_FILE_BYTES_BASE = SESSION_BYTES_BASE + NUM_MODELS
+
+        private const val TEXT_CACHE_BYTES = MODEL_FILE_BYTES_BASE + NUM_MODELS
+        private const val CACHED_TEXTS = TEXT_CACHE_BYTES + 1
+        private const val SHARED_WEIGHT_BYTES_BASE = CACHED_TEXTS + 1
+        private const val SESSION_INSTANCES_BASE = SHARED_WEIGHT_BYTES_BASE + NUM_MODELS
+
+        /** Required size of the array passed to [SupertonicNative.getMemoryReport]. */
+        const val ARRAY_SIZE = SESSION_INSTANCES_BASE + NUM_MODELS
+
+        fun fromArray(values: LongArray): SupertonicMemoryReport? {
+            if (values.size < ARRAY_SIZE) {
+                return null
+            }
+            return SupertonicMemoryReport(
+                sessionsLoaded = values[SESSIONS_LOADED].toInt(),
+                styleCacheBytes = values[STYLE_CACHE_BYTES],
+                cachedStyles = values[CACHED_STYLES].toInt(),
+                scratchPeakBytes = values[SCRATCH_PEAK_BYTES],
+                nativeHeapBytes = values[NATIVE_HEAP_BYTES],
+                arenaEstimateBytes = values[ARENA_ESTIMATE_BYTES],
+                processRssBytes = values[PROCESS_RSS_BYTES],
+                sessionBytes = (0 until NUM_MODELS).map { values[SESSION_BYTES_BASE + it] },
+                modelFileBytes = (0 until NUM_MODELS).map { values[MODEL_FILE_BYTES_BASE + it] },
+                textCacheBytes = values[TEXT_CACHE_BYTES],
+                cachedTexts = values[CACHED_TEXTS].toInt(),
+                sharedWeightBytes = (0 until NUM_MODELS).map { values[SHARED_WEIGHT_BYTES_BASE + it] },
+                sessionInstances = (0 until NUM_MODELS).map { values[SESSION_INSTANCES_BASE + it].toInt() }
+            )
+        }
+    }
+}
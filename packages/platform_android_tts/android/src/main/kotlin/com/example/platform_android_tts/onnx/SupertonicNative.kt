@@ -1,5 +1,9 @@
 package com.example.platform_android_tts.onnx
 
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.CompletableDeferred
+import java.util.concurrent.ConcurrentHashMap
+
 /**
  * JNI wrapper for Supertonic TTS native implementation.
  * 
@@ -17,6 +21,9 @@ object SupertonicNative {
     
     private var nativeLibLoaded = false
     
+    // Native status of finished submitAsync() jobs, until awaited
+    private val completions = ConcurrentHashMap<Long, CompletableDeferred<Int>>()
+    
     init {
         try {
             System.loadLibrary("supertonic_native")
@@ -48,17 +55,233 @@ object SupertonicNative {
      * @return true if initialization succeeded
      */
     external fun initialize(corePath: String): Boolean
+
+    /**
+     * Like [initialize], with at most [threadBudget] inference threads in
+     * total, for processes that run other ONNX engines (sherpa-onnx) at the
+     * same time. 0 = one thread per big core, the [initialize] default.
+     */
+    external fun initializeWithThreadBudget(corePath: String, threadBudget: Int): Boolean
+    
+    /**
+     * Physical big cores of the device, the thread budget [initialize]
+     * uses; 0 if the CPU topology is unreadable. Needs no engine.
+     */
+    external fun getBigCoreCount(): Int
     
     /**
      * Synthesize text to audio samples.
      * 
      * @param text The text to synthesize (Unicode, will be NFKD normalized)
      * @param speakerId Speaker ID for multi-speaker support
-     * @param speed Speech rate multiplier (1.0 = normal)
+     * @param speed Speech rate multiplier (1.0 = normal). Re-rendering a
+     *              recent text at another speed skips the text encoder and
+     *              duration predictor
      * @return FloatArray of audio samples at 24kHz, or null on error
      */
     external fun synthesize(text: String, speakerId: Int, speed: Float): FloatArray?
     
+    /**
+     * Synthesize text and report per-stage statistics.
+     * 
+     * @param statsOut Array of [SupertonicStats.ARRAY_SIZE] values, decoded
+     *                 with [SupertonicStats.fromArray]; filled on failure too
+     * @return FloatArray of audio samples, or null on error
+     */
+    external fun synthesizeWithStats(
+        text: String,
+        speakerId: Int,
+        speed: Float,
+        statsOut: DoubleArray
+    ): FloatArray?
+    
+    /**
+     * Synthesize text and report statistics and where each character plays.
+     * 
+     * @param statsOut Array of [SupertonicStats.ARRAY_SIZE] values
+     * @param timestampsOut One-element array (see [SupertonicTimestamps.newOut])
+     *                      whose element receives the token timings, decoded
+     *                      with [SupertonicTimestamps.fromArray]
+     * @return FloatArray of audio samples, or null on error
+     */
+    external fun synthesizeWithTimestamps(
+        text: String,
+        speakerId: Int,
+        speed: Float,
+        statsOut: DoubleArray,
+        timestampsOut: Array<IntArray?>
+    ): FloatArray?
+    
+    /**
+     * Synthesize text through the native deadline scheduler instead of on
+     * the calling thread. Queued requests run earliest deadline first, so
+     * the segment playback needs next never waits behind a prefetch due
+     * later; a request identical to one already queued or running (same
+     * text, speaker and speed) shares its result instead of running again.
+     * Blocks until the audio is ready.
+     * 
+     * @param deadlineMs When the audio is needed, in milliseconds from now
+     *                   (0 = as soon as possible)
+     * @param executionClass [SupertonicStats.CLASS_FOREGROUND], or
+     *                   [SupertonicStats.CLASS_BACKGROUND] to run on one niced
+     *                   little-core thread until the deadline draws near
+     * @param statsOut Array of [SupertonicStats.ARRAY_SIZE] values, or null;
+     *                 includes the time spent queued
+     * @param timestampsOut One-element array for the token timings, or null
+     * @return FloatArray of audio samples, or null on error
+     */
+    external fun synthesizeScheduled(
+        text: String,
+        speakerId: Int,
+        speed: Float,
+        deadlineMs: Long,
+        executionClass: Int,
+        statsOut: DoubleArray?,
+        timestampsOut: Array<IntArray?>?
+    ): FloatArray?
+    
+    /**
+     * Queue text on the native deadline scheduler like [synthesizeScheduled],
+     * but return at once: engine-owned native threads run it, so no JVM
+     * thread blocks for the inference. Wait with [awaitJob], then take the
+     * audio with [collect].
+     * 
+     * @return Native job id, or 0 on error
+     */
+    external fun submitAsync(
+        text: String,
+        speakerId: Int,
+        speed: Float,
+        deadlineMs: Long,
+        executionClass: Int
+    ): Long
+    
+    /**
+     * Take the audio of a job from [submitAsync]; blocks only if it is not
+     * done yet. Every job must be collected exactly once, cancelled ones
+     * included, to free it.
+     * 
+     * @param text The submitted text, to map token timings to characters
+     * @return FloatArray of audio samples, or null on error or cancellation
+     */
+    external fun collect(
+        job: Long,
+        text: String,
+        statsOut: DoubleArray?,
+        timestampsOut: Array<IntArray?>?
+    ): FloatArray?
+    
+    /**
+     * Cancel a job from [submitAsync]. It is dropped from the queue, or
+     * stopped after its current diffusion step (chunked input: after the
+     * chunks then running), unless an identical request shares it. [onJobComplete] reports it before this returns.
+     * 
+     * @return false if the job was unknown or already done
+     */
+    external fun cancel(job: Long): Boolean
+    
+    /**
+     * Called by the native scheduler threads when a job from [submitAsync]
+     * is done, possibly before [submitAsync] has returned its id.
+     */
+    @JvmStatic
+    fun onJobComplete(job: Long, status: Int) {
+        completions.computeIfAbsent(job) { CompletableDeferred() }.complete(status)
+    }
+    
+    /**
+     * Suspend until a job from [submitAsync] is done and return its native
+     * status (0 = ok). Cancelling the coroutine cancels the job; it must be
+     * [collect]ed either way.
+     */
+    suspend fun awaitJob(job: Long): Int {
+        val done = completions.computeIfAbsent(job) { CompletableDeferred() }
+        try {
+            return done.await()
+        } catch (e: CancellationException) {
+            cancel(job)
+            throw e
+        } finally {
+            completions.remove(job)
+        }
+    }
+    
+    /**
+     * Look up the statistics of one of the last 64 native calls.
+     * 
+     * @param requestId Native request id from [SupertonicStats.requestId]
+     * @param statsOut Array of [SupertonicStats.ARRAY_SIZE] values
+     * @return false if the request is unknown or was evicted
+     */
+    external fun getStats(requestId: Long, statsOut: DoubleArray): Boolean
+    
+    /**
+     * Reload the sessions with ONNX Runtime profiling enabled.
+     * 
+     * Waits for in-flight synthesis and reloads all models; for diagnosis
+     * only, not during playback.
+     * 
+     * @param outputDir Existing writable directory for the profile files
+     * @return true if profiling started
+     */
+    external fun startProfiling(outputDir: String): Boolean
+    
+    /**
+     * Stop profiling and write a Chrome trace (chrome://tracing, Perfetto)
+     * merging engine stages and ORT operator events of all four models.
+     * 
+     * @return Path of the trace file, or null if profiling was not running
+     */
+    external fun stopProfiling(): String?
+    
+    /**
+     * Snapshot native memory (sessions, ORT arenas, caches).
+     * 
+     * @param out Array of [SupertonicMemoryReport.ARRAY_SIZE] values,
+     *            decoded with [SupertonicMemoryReport.fromArray]
+     * @return false if the engine is not initialized
+     */
+    external fun getMemoryReport(out: LongArray): Boolean
+    
+    /**
+     * Shed native memory under pressure.
+     * 
+     * Levels from [SupertonicMemoryReport.TRIM_ARENAS] upwards also shrink
+     * ORT arenas, drop cached voice styles, and release the estimator /
+     * vocoder or all sessions; released sessions reload on the next
+     * synthesis call.
+     * 
+     * @param level One of the SupertonicMemoryReport.TRIM_* constants
+     */
+    external fun trim(level: Int): Boolean
+    
+    /**
+     * Run all four models on throwaway input of representative shapes so
+     * the first real request runs at steady-state latency.
+     * 
+     * Blocks for roughly one short synthesis per bucket; call it off the
+     * main thread while nothing is playing.
+     * 
+     * @param speakerId Speaker whose voice style is loaded and used
+     * @param tokenCounts Token count per bucket, or null for the native
+     *                    defaults (16, 64, 160 and the chunk length, 192;
+     *                    0 ms is reported for buckets left out)
+     * @param latentLens Latent frames per bucket (0 = as predicted), or null
+     * @return Milliseconds each bucket took, or null on failure
+     */
+    external fun warmup(speakerId: Int, tokenCounts: IntArray?, latentLens: IntArray?): DoubleArray?
+    
+    /**
+     * Predict how long each text plays without synthesizing it: only
+     * tokenization and the duration predictor run, batched by length.
+     * 
+     * @param texts Segments, e.g. the sentences of a chapter
+     * @param speakerId Speaker the audio will use
+     * @param speed Speech speed the audio will use
+     * @return Seconds per text (0 for texts without speech), or null on failure
+     */
+    external fun estimateDurations(texts: Array<String>, speakerId: Int, speed: Float): DoubleArray?
+    
     /**
      * Get the sample rate of generated audio.
      * @return Sample rate in Hz (24000)
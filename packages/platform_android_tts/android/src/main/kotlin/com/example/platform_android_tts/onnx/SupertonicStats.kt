@@ -0,0 +1,318 @@
+package com.example.platform_android_tts.onnx
+
+/**
+ * Per-call statistics reported by the Supertonic native engine.
+ *
+ * Timings are measured with a monotonic clock in milliseconds; stages
+ * that did not run are zero. Decoded from the flat DoubleArray filled by
+ * [SupertonicNative.synthesizeWithStats] / [SupertonicNative.synthesizeScheduled] /
+ * [SupertonicNative.getStats].
+ */
+data class SupertonicStats(
+    val requestId: Long,
+    val status: Int,
+    val tokenizeMs: Double,
+    val textEncoderMs: Double,
+    val durationPredictorMs: Double,
+    val noiseMs: Double,
+    val vectorEstimatorMs: Double,
+    val vocoderMs: Double,
+    val totalMs: Double,
+    val numSteps: Int,
+    /** Time of each diffusion step that ran; shorter than [numSteps] after an early exit. */
+    val stepMs: List<Double>,
+    val tokenCount: Long,
+    val latentLen: Long,
+    val numSamples: Long,
+    val audioSeconds: Double,
+    val rtf: Double,
+    val intraOpThreads: Int,
+    val cpuThreadUserMs: Double,
+    val cpuThreadSystemMs: Double,
+    val cpuProcessMs: Double,
+    val textEmbBytes: Long,
+    val latentBytes: Long,
+    val audioBytes: Long,
+    val tensorBytesAllocated: Long,
+    /** Text encoder and duration predictor results were reused (speed-only re-render). */
+    val textCacheHit: Boolean = false,
+    /** Sub-utterances a long input was split into; stage times are summed over them. */
+    val numChunks: Int = 1,
+    /** File variant (VARIANT_*) of each model, in pipeline order. */
+    val modelVariants: List<Int> = List(NUM_MODELS) { VARIANT_DEFAULT },
+    /** Bit i set = model i runs on the XNNPACK execution provider. */
+    val xnnpackModels: Int = 0,
+    /** Diffusion steps actually run; below [numSteps] when the latent converged early. */
+    val stepsRun: Int = numSteps,
+    /** Time spent in the native deadline queue before synthesis started. */
+    val queueMs: Double = 0.0,
+    /** Requests served by this one synthesis; above 1 when identical requests were merged. */
+    val sharedRequests: Int = 1,
+    /** Times the job paused between diffusion steps (or chunks) for a request due sooner. */
+    val preemptions: Int = 0,
+    /** Time spent paused; not part of [totalMs]. */
+    val suspendedMs: Double = 0.0,
+    /** CLASS_* the synthesis finished in; background work may have been promoted. */
+    val executionClass: Int = CLASS_FOREGROUND,
+    /** Bit i set = the native calling thread could run on CPU i. */
+    val callerCpus: Long = 0,
+    /** CPU the native calling thread finished on, -1 if unknown. */
+    val callerCpu: Int = -1,
+    /** CPUs the intra-op pool threads were confined to; 0 = not placed. */
+    val poolCpus: Long = 0,
+    /** Bit i set = perf counter i (PERF_*) was counted; 0 = counters off or refused. */
+    val perfCounters: Int = 0,
+    /** Threads the counters were read on: the caller plus the intra-op pool. */
+    val perfThreads: Int = 0,
+    val perfTextEncoder: PerfCounts = PerfCounts(),
+    val perfDurationPredictor: PerfCounts = PerfCounts(),
+    /** Summed over all diffusion steps. */
+    val perfVectorEstimator: PerfCounts = PerfCounts(),
+    val perfVocoder: PerfCounts = PerfCounts()
+) {
+    /** Hardware and scheduler events of one stage's model runs; see [perfCounters]. */
+    data class PerfCounts(
+        val cycles: Long = 0,
+        val instructions: Long = 0,
+        val cacheMisses: Long = 0,
+        val branchMisses: Long = 0,
+        val contextSwitches: Long = 0
+    ) {
+        /** Instructions per cycle, 0 when cycles were not counted. */
+        val ipc: Double get() = if (cycles > 0) instructions.toDouble() / cycles else 0.0
+
+        fun toMap(): Map<String, Any> = mapOf(
+            "cycles" to cycles,
+            "instructions" to instructions,
+            "cacheMisses" to cacheMisses,
+            "branchMisses" to branchMisses,
+            "contextSwitches" to contextSwitches
+        )
+    }
+
+    /** True if the native call returned SUPERTONIC_OK. */
+    val isSuccess: Boolean get() = status == 0
+
+    /** Variants as "te/dp/ve/voc" names, e.g. "fp32/fp32/int8_qdq/fp16". */
+    val modelVariantSummary: String get() = modelVariants.withIndex().joinToString("/") { (model, variant) ->
+        variantName(variant) + if (xnnpackModels and (1 shl model) != 0) "+xnnpack" else ""
+    }
+
+    /** Flat map for logging and the platform channel. */
+    fun toMap(): Map<String, Any> = mapOf(
+        "requestId" to requestId,
+        "status" to status,
+        "tokenizeMs" to tokenizeMs,
+        "textEncoderMs" to textEncoderMs,
+        "durationPredictorMs" to durationPredictorMs,
+        "noiseMs" to noiseMs,
+        "vectorEstimatorMs" to vectorEstimatorMs,
+        "vocoderMs" to vocoderMs,
+        "totalMs" to totalMs,
+        "numSteps" to numSteps,
+        "stepMs" to stepMs,
+        "tokenCount" to tokenCount,
+        "latentLen" to latentLen,
+        "numSamples" to numSamples,
+        "audioSeconds" to audioSeconds,
+        "rtf" to rtf,
+        "intraOpThreads" to intraOpThreads,
+        "cpuThreadUserMs" to cpuThreadUserMs,
+        "cpuThreadSystemMs" to cpuThreadSystemMs,
+        "cpuProcessMs" to cpuProcessMs,
+        "textEmbBytes" to textEmbBytes,
+        "latentBytes" to latentBytes,
+        "audioBytes" to audioBytes,
+        "tensorBytesAllocated" to tensorBytesAllocated,
+        "textCacheHit" to textCacheHit,
+        "numChunks" to numChunks,
+        "modelVariants" to modelVariantSummary,
+        "xnnpackModels" to xnnpackModels,
+        "stepsRun" to stepsRun,
+        "queueMs" to queueMs,
+        "sharedRequests" to sharedRequests,
+        "preemptions" to preemptions,
+        "suspendedMs" to suspendedMs,
+        "executionClass" to executionClass,
+        "callerCpus" to callerCpus,
+        "callerCpu" to callerCpu,
+        "poolCpus" to poolCpus,
+        "perfCounters" to perfCounters,
+        "perfThreads" to perfThreads,
+        "perfTextEncoder" to perfTextEncoder.toMap(),
+        "perfDurationPredictor" to perfDurationPredictor.toMap(),
+        "perfVectorEstimator" to perfVectorEstimator.toMap(),
+        "perfVocoder" to perfVocoder.toMap()
+    )
+
+    companion object {
+        // Must stay in sync with StatsIndex in supertonic_native.cpp; internal
+        // so the tests fill arrays by name
+        internal const val REQUEST_ID = 0
+        internal const val STATUS = 1
+        internal const val TOKENIZE_MS = 2
+        internal const val TEXT_ENCODER_MS = 3
+        internal const val DURATION_PREDICTOR_MS = 4
+        internal const val NOISE_MS = 5
+        internal const val VECTOR_ESTIMATOR_MS = 6
+        internal const val VOCODER_MS = 7
+        internal const val TOTAL_MS = 8
+        internal const val NUM_STEPS = 9
+        internal const val TOKEN_COUNT = 10
+        internal const val LATENT_LEN = 11
+        internal const val NUM_SAMPLES = 12
+        internal const val AUDIO_SECONDS = 13
+        internal const val RTF = 14
+        internal const val INTRA_OP_THREADS = 15
+        internal const val CPU_THREAD_USER_MS = 16
+        internal const val CPU_THREAD_SYSTEM_MS = 17
+        internal const val CPU_PROCESS_MS = 18
+        internal const val TEXT_EMB_BYTES = 19
+        internal const val LATENT_BYTES = 20
+        internal const val AUDIO_BYTES = 21
+        internal const val TENSOR_BYTES_ALLOCATED = 22
+        internal const val STEP_MS_BASE = 23
+
+        /** SUPERTONIC_MAX_DIFFUSION_STEPS in core/supertonic.h. */
+        const val MAX_DIFFUSION_STEPS = 32
+
+        internal const val TEXT_CACHE_HIT = STEP_MS_BASE + MAX_DIFFUSION_STEPS
+        internal const val NUM_CHUNKS = TEXT_CACHE_HIT + 1
+        internal const val MODEL_VARIANT_BASE = NUM_CHUNKS + 1
+
+        /** SUPERTONIC_NUM_MODELS in core/supertonic.h. */
+        const val NUM_MODELS = 4
+
+        internal const val XNNPACK_MODELS = MODEL_VARIANT_BASE + NUM_MODELS
+
+        internal const val STEPS_RUN = XNNPACK_MODELS + 1
+        internal const val QUEUE_MS = STEPS_RUN + 1
+        internal const val SHARED_REQUESTS = QUEUE_MS + 1
+        internal const val PREEMPTIONS = SHARED_REQUESTS + 1
+        internal const val SUSPENDED_MS = PREEMPTIONS + 1
+        internal const val EXECUTION_CLASS = SUSPENDED_MS + 1
+        internal const val CALLER_CPUS = EXECUTION_CLASS + 1
+        internal const val CALLER_CPU = CALLER_CPUS + 1
+        internal const val POOL_CPUS = CALLER_CPU + 1
+
+        internal const val PERF_COUNTERS = POOL_CPUS + 1
+        internal const val PERF_THREADS = PERF_COUNTERS + 1
+        // Text encoder, duration predictor, diffusion, vocoder; NUM_PERF_COUNTERS each
+        internal const val PERF_BASE = PERF_THREADS + 1
+
+        /** SUPERTONIC_NUM_PERF_COUNTERS in core/supertonic.h. */
+        const val NUM_PERF_COUNTERS = 5
+
+        /** Required size of the array passed to the native stats calls. */
+        const val ARRAY_SIZE = PERF_BASE + 4 * NUM_PERF_COUNTERS
+
+        // SupertonicPerfCounter in core/supertonic.h
+        const val PERF_CYCLES = 0
+        const val PERF_INSTRUCTIONS = 1
+        const val PERF_CACHE_MISSES = 2
+        const val PERF_BRANCH_MISSES = 3
+        const val PERF_CONTEXT_SWITCHES = 4
+
+        // SupertonicExecutionClass in core/supertonic.h
+        const val CLASS_FOREGROUND = 0
+        const val CLASS_BACKGROUND = 1
+
+        // SupertonicModelVariant in core/supertonic.h
+        const val VARIANT_DEFAULT = 0
+        const val VARIANT_FP32 = 1
+        const val VARIANT_FP16 = 2
+        const val VARIANT_INT8_DYNAMIC = 3
+        const val VARIANT_INT8_QDQ = 4
+
+        fun variantName(variant: Int): String = when (variant) {
+            VARIANT_DEFAULT -> "default"
+            VARIANT_FP32 -> "fp32"
+            VARIANT_FP16 -> "fp16"
+            VARIANT_INT8_DYNAMIC -> "int8_dynamic"
+            VARIANT_INT8_QDQ -> "int8_qdq"
+            else -> "unknown"
+        }
+
+        fun newArray(): DoubleArray = DoubleArray(ARRAY_SIZE)
+
+        // Stages of the perf counter block, in model order
+        internal const val STAGE_TEXT_ENCODER = 0
+        internal const val STAGE_DURATION_PREDICTOR = 1
+        internal const val STAGE_VECTOR_ESTIMATOR = 2
+        internal const val STAGE_VOCODER = 3
+
+        /** Index of [counter] (PERF_*) of [stage] (STAGE_*). */
+        internal fun perfIndex(stage: Int, counter: Int): Int =
+            PERF_BASE + stage * NUM_PERF_COUNTERS + counter
+
+        private fun perfCounts(values: DoubleArray, stage: Int): PerfCounts {
+            val base = perfIndex(stage, 0)
+            return PerfCounts(
+                cycles = values[base + PERF_CYCLES].toLong(),
+                instructions = values[base + PERF_INSTRUCTIONS].toLong(),
+                cacheMisses = values[base + PERF_CACHE_MISSES].toLong(),
+                branchMisses = values[base + PERF_BRANCH_MISSES].toLong(),
+                contextSwitches = values[base + PERF_CONTEXT_SWITCHES].toLong()
+            )
+        }
+
+        /**
+         * Decode an array filled by the native layer.
+         * Returns null if the array is too short or was never written.
+         */
+        fun fromArray(values: DoubleArray): SupertonicStats? {
+            if (values.size < ARRAY_SIZE || values[REQUEST_ID] == 0.0) {
+                return null
+            }
+            val numSteps = values[NUM_STEPS].toInt().coerceIn(0, MAX_DIFFUSION_STEPS)
+            // Older engines leave steps run at 0: every step ran
+            val stepsRun = values[STEPS_RUN].toInt().takeIf { it > 0 }?.coerceAtMost(numSteps) ?: numSteps
+            return SupertonicStats(
+                requestId = values[REQUEST_ID].toLong(),
+                status = values[STATUS].toInt(),
+                tokenizeMs = values[TOKENIZE_MS],
+                textEncoderMs = values[TEXT_ENCODER_MS],
+                durationPredictorMs = values[DURATION_PREDICTOR_MS],
+                noiseMs = values[NOISE_MS],
+                vectorEstimatorMs = values[VECTOR_ESTIMATOR_MS],
+                vocoderMs = values[VOCODER_MS],
+                totalMs = values[TOTAL_MS],
+                numSteps = numSteps,
+                stepMs = (0 until stepsRun).map { values[STEP_MS_BASE + it] },
+                tokenCount = values[TOKEN_COUNT].toLong(),
+                latentLen = values[LATENT_LEN].toLong(),
+                numSamples = values[NUM_SAMPLES].toLong(),
+                audioSeconds = values[AUDIO_SECONDS],
+                rtf = values[RTF],
+                intraOpThreads = values[INTRA_OP_THREADS].toInt(),
+                cpuThreadUserMs = values[CPU_THREAD_USER_MS],
+                cpuThreadSystemMs = values[CPU_THREAD_SYSTEM_MS],
+                cpuProcessMs = values[CPU_PROCESS_MS],
+                textEmbBytes = values[TEXT_EMB_BYTES].toLong(),
+                latentBytes = values[LATENT_BYTES].toLong(),
+                audioBytes = values[AUDIO_BYTES].toLong(),
+                tensorBytesAllocated = values[TENSOR_BYTES_ALLOCATED].toLong(),
+                textCacheHit = values[TEXT_CACHE_HIT] != 0.0,
+                numChunks = values[NUM_CHUNKS].toInt(),
+                modelVariants = List(NUM_MODELS) { values[MODEL_VARIANT_BASE + it].toInt() },
+                xnnpackModels = values[XNNPACK_MODELS].toInt(),
+                stepsRun = stepsRun,
+                queueMs = values[QUEUE_MS],
+                // Calls that bypass the scheduler leave it at 0
+                sharedRequests = values[SHARED_REQUESTS].toInt().coerceAtLeast(1),
+                preemptions = values[PREEMPTIONS].toInt(),
+                suspendedMs = values[SUSPENDED_MS],
+                executionClass = values[EXECUTION_CLASS].toInt(),
+                callerCpus = values[CALLER_CPUS].toLong(),
+                callerCpu = values[CALLER_CPU].toInt(),
+                poolCpus = values[POOL_CPUS].toLong(),
+                perfCounters = values[PERF_COUNTERS].toInt(),
+                perfThreads = values[PERF_THREADS].toInt(),
+                perfTextEncoder = perfCounts(values, STAGE_TEXT_ENCODER),
+                perfDurationPredictor = perfCounts(values, STAGE_DURATION_PREDICTOR),
+                perfVectorEstimator = perfCounts(values, STAGE_VECTOR_ESTIMATOR),
+                perfVocoder = perfCounts(values, STAGE_VOCODER)
+            )
+        }
+    }
+}
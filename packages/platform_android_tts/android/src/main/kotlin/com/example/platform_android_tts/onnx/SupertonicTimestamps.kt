@@ -0,0 +1,52 @@
+package com.example.platform_android_tts.onnx
+
+/**
+ * Where each token of a synthesized utterance plays. Tokens are the
+ * characters of the input text; positions are UTF-16 indices into it and
+ * sample offsets into the returned audio.
+ *
+ * Decoded from the IntArray filled by [SupertonicNative.synthesizeWithTimestamps].
+ */
+class SupertonicTimestamps(
+    /** The model only predicted a total, spread evenly over the tokens. */
+    val approximate: Boolean,
+    val charStarts: IntArray,
+    val charEnds: IntArray,
+    val startSamples: IntArray,
+    val endSamples: IntArray
+) {
+    val size: Int get() = charStarts.size
+
+    companion object {
+        // Must stay in sync with TimestampIndex in supertonic_native.cpp
+        private const val APPROXIMATE = 0
+        private const val NUM_TOKENS = 1
+        private const val HEADER_SIZE = 2
+        private const val CHAR_START = 0
+        private const val CHAR_END = 1
+        private const val START_SAMPLE = 2
+        private const val END_SAMPLE = 3
+        private const val RECORD_SIZE = 4
+
+        /** Out parameter for [SupertonicNative.synthesizeWithTimestamps]. */
+        fun newOut(): Array<IntArray?> = arrayOfNulls(1)
+
+        fun fromArray(values: IntArray?): SupertonicTimestamps? {
+            if (values == null || values.size < HEADER_SIZE) {
+                return null
+            }
+            val count = values[NUM_TOKENS]
+            if (count < 0 || values.size < HEADER_SIZE + count * RECORD_SIZE) {
+                return null
+            }
+            fun field(i: Int, offset: Int) = values[HEADER_SIZE + i * RECORD_SIZE + offset]
+            return SupertonicTimestamps(
+                approximate = values[APPROXIMATE] != 0,
+                charStarts = IntArray(count) { field(it, CHAR_START) },
+                charEnds = IntArray(count) { field(it, CHAR_END) },
+                startSamples = IntArray(count) { field(it, START_SAMPLE) },
+                endSamples = IntArray(count) { field(it, END_SAMPLE) }
+            )
+        }
+    }
+}
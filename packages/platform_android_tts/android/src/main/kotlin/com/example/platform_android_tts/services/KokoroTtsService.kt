@@ -327,6 +327,11 @@ class KokoroTtsService : Service() {
      */
     fun isReady(): Boolean = isInitialized && inference?.isReady() == true
     
+    /**
+     * ONNX Runtime threads the loaded engine runs on; 0 when none is loaded.
+     */
+    fun inferenceThreads(): Int = if (isReady()) KokoroSherpaInference.getOptimalThreadCount() else 0
+    
     /**
      * Check if a voice is loaded.
      */
@@ -423,7 +428,9 @@ data class SynthesisResult(
 data class ServiceMemoryInfo(
     val availableMB: Int,
     val totalMB: Int,
-    val loadedModelCount: Int
+    val loadedModelCount: Int,
+    /** Native memory owned by the engine, where it can report it. */
+    val nativeMB: Int = 0
 )
 
 /**
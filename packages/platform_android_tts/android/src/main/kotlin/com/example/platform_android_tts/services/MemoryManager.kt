@@ -1,7 +1,9 @@
 package com.example.platform_android_tts.services
 
 import android.app.ActivityManager
+import android.content.ComponentCallbacks2
 import android.content.Context
+import com.example.platform_android_tts.onnx.SupertonicMemoryReport
 
 /**
  * Memory manager for TTS services.
@@ -117,6 +119,28 @@ object MemoryManager {
         return true
     }
     
+    /**
+     * Map an Android onTrimMemory() level to a native engine trim level.
+     * 
+     * While running (foreground playback) only arenas and caches are shed
+     * until the system reports critical pressure; once backgrounded the
+     * large sessions go first since they reload on the next synthesis.
+     * 
+     * @param trimLevel ComponentCallbacks2.TRIM_MEMORY_* level
+     * @return SupertonicMemoryReport.TRIM_* level
+     */
+    @Suppress("DEPRECATION")
+    fun nativeTrimLevel(trimLevel: Int): Int = when {
+        trimLevel >= ComponentCallbacks2.TRIM_MEMORY_COMPLETE -> SupertonicMemoryReport.TRIM_ALL_SESSIONS
+        trimLevel >= ComponentCallbacks2.TRIM_MEMORY_MODERATE -> SupertonicMemoryReport.TRIM_LARGE_SESSIONS
+        trimLevel >= ComponentCallbacks2.TRIM_MEMORY_BACKGROUND -> SupertonicMemoryReport.TRIM_CACHES
+        trimLevel >= ComponentCallbacks2.TRIM_MEMORY_UI_HIDDEN -> SupertonicMemoryReport.TRIM_ARENAS
+        trimLevel >= ComponentCallbacks2.TRIM_MEMORY_RUNNING_CRITICAL -> SupertonicMemoryReport.TRIM_LARGE_SESSIONS
+        trimLevel >= ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW -> SupertonicMemoryReport.TRIM_CACHES
+        trimLevel >= ComponentCallbacks2.TRIM_MEMORY_RUNNING_MODERATE -> SupertonicMemoryReport.TRIM_ARENAS
+        else -> SupertonicMemoryReport.TRIM_NONE
+    }
+    
     /**
      * Log current memory state for debugging.
      * 
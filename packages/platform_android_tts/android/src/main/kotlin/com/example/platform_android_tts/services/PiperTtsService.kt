@@ -278,6 +278,12 @@ class PiperTtsService : Service() {
     }
     
     fun isReady(): Boolean = isInitialized
+    
+    /**
+     * ONNX Runtime threads a loaded voice runs on; 0 when none is loaded.
+     */
+    fun inferenceThreads(): Int =
+        if (inferenceEngines.isEmpty()) 0 else PiperSherpaInference.getOptimalThreadCount()
     fun isVoiceLoaded(voiceId: String): Boolean = loadedModels.containsKey(voiceId)
     
     /**
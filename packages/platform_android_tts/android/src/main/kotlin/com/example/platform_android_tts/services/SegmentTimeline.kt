@@ -0,0 +1,106 @@
+package com.example.platform_android_tts.services
+
+import java.io.File
+import java.io.IOException
+
+/**
+ * Timeline index of a chapter: where each segment starts and how long it
+ * plays, before any of it has been synthesized.
+ *
+ * Built from [SupertonicTtsService.estimateDurations]. Durations depend on
+ * the voice and speed, so both are stored with the index and [matches]
+ * tells whether a persisted timeline is still valid.
+ *
+ * File format (UTF-8 text):
+ * ```
+ * supertonic-timeline 1
+ * speaker 3
+ * speed 1.0
+ * 1.904762
+ * 0.626939
+ * ...
+ * ```
+ */
+class SegmentTimeline(
+    val speakerId: Int,
+    val speed: Float,
+    durations: DoubleArray
+) {
+    /** Seconds each segment plays. */
+    val durations: DoubleArray = durations.copyOf()
+
+    /** Seconds from the chapter start to each segment. */
+    val startOffsets: DoubleArray = DoubleArray(durations.size).also { starts ->
+        var total = 0.0
+        for (i in durations.indices) {
+            starts[i] = total
+            total += durations[i]
+        }
+    }
+
+    /** Seconds the whole chapter plays. */
+    val totalSeconds: Double =
+        if (durations.isEmpty()) 0.0 else startOffsets.last() + durations.last()
+
+    val size: Int get() = durations.size
+
+    /** Whether this timeline was estimated for the given voice and speed. */
+    fun matches(speakerId: Int, speed: Float): Boolean =
+        this.speakerId == speakerId && this.speed == speed
+
+    /**
+     * Segment playing at [seconds] from the chapter start, clamped to the
+     * first and last segment; -1 if the timeline is empty.
+     */
+    fun segmentAt(seconds: Double): Int {
+        if (durations.isEmpty()) return -1
+        var low = 0
+        var high = durations.size - 1
+        while (low < high) {
+            val mid = (low + high + 1) ushr 1
+            if (startOffsets[mid] <= seconds) low = mid else high = mid - 1
+        }
+        return low
+    }
+
+    /** Write the index to [file], replacing it atomically. */
+    @Throws(IOException::class)
+    fun writeTo(file: File) {
+        val text = buildString {
+            append(HEADER).append('\n')
+            append("speaker ").append(speakerId).append('\n')
+            append("speed ").append(speed).append('\n')
+            for (duration in durations) {
+                append(duration).append('\n')
+            }
+        }
+        val tmp = File(file.path + ".tmp")
+        tmp.writeText(text)
+        if (!tmp.renameTo(file)) {
+            tmp.delete()
+            throw IOException("Failed to write timeline: $file")
+        }
+    }
+
+    companion object {
+        private const val HEADER = "supertonic-timeline 1"
+
+        /** Read an index written by [writeTo], or null if missing or malformed. */
+        fun readFrom(file: File): SegmentTimeline? {
+            if (!file.exists()) return null
+            val lines = try {
+                file.readLines().filter { it.isNotBlank() }
+            } catch (e: IOException) {
+                return null
+            }
+            if (lines.size < 3 || lines[0] != HEADER) return null
+            val speakerId = lines[1].removePrefix("speaker ").toIntOrNull() ?: return null
+            val speed = lines[2].removePrefix("speed ").toFloatOrNull() ?: return null
+            val durations = DoubleArray(lines.size - 3)
+            for (i in durations.indices) {
+                durations[i] = lines[i + 3].toDoubleOrNull() ?: return null
+            }
+            return SegmentTimeline(speakerId, speed, durations)
+        }
+    }
+}
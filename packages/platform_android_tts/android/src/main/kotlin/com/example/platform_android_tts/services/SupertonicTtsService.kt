@@ -2,8 +2,13 @@ package com.example.platform_android_tts.services
 
 import android.app.Service
 import android.content.Intent
+import android.os.Build
 import android.os.IBinder
+import android.os.Trace
+import com.example.platform_android_tts.onnx.SupertonicMemoryReport
 import com.example.platform_android_tts.onnx.SupertonicNative
+import com.example.platform_android_tts.onnx.SupertonicStats
+import com.example.platform_android_tts.onnx.SupertonicTimestamps
 import kotlinx.coroutines.*
 import java.io.File
 import java.io.IOException
@@ -31,12 +36,22 @@ class SupertonicTtsService : Service() {
     @Volatile private var isInitialized = false
     private val loadedSpeakers = ConcurrentHashMap<String, SupertonicSpeaker>()
     
+    // Set once the native sessions have run the warmup shapes; cleared when
+    // they are released
+    @Volatile private var shapesWarmed = false
+    
     // Active synthesis jobs for cancellation (thread-safe)
     private val activeJobs = ConcurrentHashMap<String, Job>()
     
     // Limit concurrent synthesis to prevent resource exhaustion
     private val synthesisPermits = Semaphore(4)
     
+    // Native stats of recent requests, keyed by caller request id (insertion ordered)
+    private val recentStats = object : LinkedHashMap<String, SupertonicStats>() {
+        override fun removeEldestEntry(eldest: MutableMap.MutableEntry<String, SupertonicStats>): Boolean =
+            size > MAX_RECENT_STATS
+    }
+    
     override fun onBind(intent: Intent?): IBinder? = null
     
     override fun onDestroy() {
@@ -80,7 +95,7 @@ class SupertonicTtsService : Service() {
         }
         
         // Initialize native engine
-        val success = SupertonicNative.initialize(corePath)
+        val success = SupertonicNative.initializeWithThreadBudget(corePath, threadBudget())
         if (!success) {
             throw IllegalStateException("Failed to initialize Supertonic native engine at: $corePath")
         }
@@ -90,6 +105,27 @@ class SupertonicTtsService : Service() {
         android.util.Log.i("SupertonicTtsService", "Engine initialized at: $corePath")
     }
     
+    /**
+     * Inference threads of the sherpa engines (Kokoro, Piper) loaded in this
+     * process right now; set by the plugin that owns all three services.
+     */
+    var sherpaThreads: () -> Int = { 0 }
+    
+    /**
+     * Inference threads for the native engine: the default (one per big
+     * core) unless a sherpa engine is already loaded, whose threads are then
+     * left their cores. Never below the engine's 2 intra-op threads, so
+     * chunks and pooled sessions still run side by side where cores allow.
+     */
+    private fun threadBudget(): Int {
+        val sherpa = sherpaThreads()
+        val bigCores = SupertonicNative.getBigCoreCount()
+        if (sherpa <= 0 || bigCores <= 0) {
+            return 0
+        }
+        return (bigCores - sherpa).coerceAtLeast(minOf(2, bigCores))
+    }
+    
     /**
      * Load a speaker with optional embedding.
      */
@@ -111,8 +147,74 @@ class SupertonicTtsService : Service() {
         )
     }
     
+    /**
+     * Pay ORT's first-run cost for a loaded voice ahead of playback.
+     * 
+     * Called by VoiceWarmupController during idle warmup; loading a voice on
+     * the play path skips it. A no-op once the shapes are warm.
+     */
+    suspend fun warmUpVoice(voiceId: String): Result<Unit> = runCatching {
+        val speaker = loadedSpeakers[voiceId]
+            ?: throw IllegalStateException("Voice not loaded: $voiceId")
+        if (!shapesWarmed) {
+            warmup(speaker.speakerId)
+        }
+    }
+    
+    /**
+     * Run the native models on representative input shapes.
+     * 
+     * Failures are logged only: a cold engine still synthesizes correctly.
+     * 
+     * @param tokenCounts Token count per bucket, or null for the defaults
+     * @return Milliseconds per bucket, or null if warmup failed
+     */
+    suspend fun warmup(speakerId: Int, tokenCounts: IntArray? = null): List<Double>? {
+        if (!isInitialized) return null
+        val bucketMs = withContext(Dispatchers.IO) {
+            SupertonicNative.warmup(speakerId, tokenCounts, null)
+        }
+        if (bucketMs == null) {
+            android.util.Log.w("SupertonicTtsService", "Shape warmup failed")
+            return null
+        }
+        shapesWarmed = true
+        android.util.Log.i(
+            "SupertonicTtsService",
+            "Shape warmup: ${bucketMs.joinToString { "%.1f".format(it) }} ms " +
+                "(tokens ${tokenCounts?.joinToString() ?: "default"})"
+        )
+        return bucketMs.toList()
+    }
+    
+    /**
+     * Predict the playing time of each segment from the duration predictor,
+     * for seek bars and chapter lengths before anything is synthesized.
+     * A chapter takes a few tens of milliseconds; wrap the result in a
+     * [SegmentTimeline] to persist it.
+     */
+    suspend fun estimateDurations(
+        segments: List<String>,
+        speakerId: Int,
+        speed: Float = 1.0f
+    ): Result<DoubleArray> = runCatching {
+        if (!isInitialized) {
+            throw IllegalStateException("Engine not initialized")
+        }
+        withContext(Dispatchers.IO) {
+            SupertonicNative.estimateDurations(segments.toTypedArray(), speakerId, speed)
+        } ?: throw IllegalStateException("Duration estimation failed")
+    }
+    
     /**
      * Synthesize text to a WAV file using Supertonic native engine.
+     * 
+     * Requests go through the native deadline queue: [deadlineMs] is when
+     * playback needs the audio, in milliseconds from now, and earlier
+     * deadlines run first. Without one the request queues behind everything
+     * that has a deadline within [UNSCHEDULED_DEADLINE_MS]. A deadline
+     * further out than [BACKGROUND_DEADLINE_MS] marks prefetch, which runs as
+     * native background work on one thread on the little cores.
      */
     suspend fun synthesize(
         voiceId: String,
@@ -120,7 +222,8 @@ class SupertonicTtsService : Service() {
         outputPath: String,
         requestId: String,
         speakerId: Int = 0,
-        speed: Float = 1.0f
+        speed: Float = 1.0f,
+        deadlineMs: Long? = null
     ): SynthesisResult {
         if (!isInitialized || !SupertonicNative.isReady()) {
             return SynthesisResult(
@@ -166,7 +269,28 @@ class SupertonicTtsService : Service() {
         val job = scope.launch {
             try {
                 // Run native ONNX inference
-                audioSamples = SupertonicNative.synthesize(text, speaker.speakerId, speed)
+                val statsArray = SupertonicStats.newArray()
+                val timestampsOut = SupertonicTimestamps.newOut()
+                val executionClass = if (deadlineMs != null && deadlineMs > BACKGROUND_DEADLINE_MS)
+                    SupertonicStats.CLASS_BACKGROUND else SupertonicStats.CLASS_FOREGROUND
+                val nativeJob = SupertonicNative.submitAsync(
+                    text, speaker.speakerId, speed, (deadlineMs ?: UNSCHEDULED_DEADLINE_MS).coerceAtLeast(0),
+                    executionClass
+                )
+                if (nativeJob == 0L) {
+                    synthError = IllegalStateException("Native submit failed")
+                    return@launch
+                }
+                // Suspends rather than blocking a Default thread; cancelling
+                // this coroutine cancels the native job
+                try {
+                    SupertonicNative.awaitJob(nativeJob)
+                } finally {
+                    audioSamples = SupertonicNative.collect(nativeJob, text, statsArray, timestampsOut)
+                }
+                val stats = SupertonicStats.fromArray(statsArray)
+                stats?.let { recordStats(requestId, it) }
+                val nativeRequestId = stats?.requestId ?: 0L
                 
                 if (audioSamples == null) {
                     synthError = IllegalStateException("Native synthesis returned null")
@@ -177,14 +301,14 @@ class SupertonicTtsService : Service() {
                 
                 // Convert float samples to 16-bit PCM and write WAV
                 val sampleRate = SupertonicNative.getSampleRate()
-                val pcmData = floatToPcm16(audioSamples!!)
+                val pcmData = traced("to_pcm16", nativeRequestId) { floatToPcm16(audioSamples!!) }
                 
                 val tmpFile = File("$outputPath.tmp")
                 val parentDir = tmpFile.parentFile
                 if (parentDir != null && !parentDir.exists() && !parentDir.mkdirs()) {
                     throw IOException("Failed to create output directory: $parentDir")
                 }
-                writeWavFile(tmpFile, pcmData, sampleRate)
+                traced("write_wav", nativeRequestId) { writeWavFile(tmpFile, pcmData, sampleRate) }
                 
                 ensureActive()
                 val finalFile = File(outputPath)
@@ -194,6 +318,21 @@ class SupertonicTtsService : Service() {
                     tmpFile.delete()
                 }
                 
+                // Word timings next to the audio; highlighting is optional
+                val wordsFile = File(WordTimeline.pathFor(outputPath))
+                val timestamps = SupertonicTimestamps.fromArray(timestampsOut[0])
+                try {
+                    if (timestamps != null) {
+                        traced("write_words", nativeRequestId) {
+                            WordTimeline.fromTokens(timestamps, text, sampleRate).writeTo(wordsFile)
+                        }
+                    } else {
+                        wordsFile.delete()  // stale timings of an earlier render
+                    }
+                } catch (e: IOException) {
+                    android.util.Log.w("SupertonicTtsService", "Failed to write word timings", e)
+                }
+                
             } catch (e: CancellationException) {
                 File("$outputPath.tmp").delete()
                 throw e
@@ -250,6 +389,50 @@ class SupertonicTtsService : Service() {
         }
     }
     
+    /**
+     * Word timings stored next to the audio written by [synthesize], or null
+     * if there are none (older files, other engines). Follows the audio when
+     * the cache has compressed it to M4A.
+     */
+    fun getWordTimeline(outputPath: String): WordTimeline? =
+        WordTimeline.find(outputPath)?.let { WordTimeline.readFrom(it) }
+    
+    /**
+     * Native statistics of a recent synthesis, or null if unknown/evicted.
+     */
+    fun getSynthesisStats(requestId: String): SupertonicStats? =
+        synchronized(recentStats) { recentStats[requestId] }
+    
+    /**
+     * Start ONNX Runtime profiling; traces go to [outputDir] or the app's
+     * temp dir (java.io.tmpdir is the cache dir on Android). The service
+     * may run unattached, so Context.cacheDir is not available here.
+     */
+    suspend fun startProfiling(outputDir: String? = null): Result<String> = runCatching {
+        if (!isInitialized) {
+            throw IllegalStateException("Engine not initialized")
+        }
+        val dir = File(outputDir ?: File(System.getProperty("java.io.tmpdir"), "supertonic_profiles").path)
+        if (!dir.exists() && !dir.mkdirs()) {
+            throw IOException("Failed to create profile directory: $dir")
+        }
+        val started = withContext(Dispatchers.IO) { SupertonicNative.startProfiling(dir.path) }
+        if (!started) {
+            throw IllegalStateException("Failed to start profiling")
+        }
+        dir.path
+    }
+    
+    /**
+     * Stop profiling and return the merged Chrome trace path.
+     */
+    suspend fun stopProfiling(): Result<String> = runCatching {
+        val tracePath = withContext(Dispatchers.IO) { SupertonicNative.stopProfiling() }
+            ?: throw IllegalStateException("Profiling not running")
+        android.util.Log.i("SupertonicTtsService", "Profile trace written: $tracePath")
+        tracePath
+    }
+    
     /**
      * Cancel an in-flight synthesis.
      */
@@ -289,9 +472,11 @@ class SupertonicTtsService : Service() {
         
         isInitialized = false
         modelPath = null
+        shapesWarmed = false
         
         activeJobs.values.forEach { it.cancel() }
         activeJobs.clear()
+        synchronized(recentStats) { recentStats.clear() }
     }
     
     /**
@@ -312,14 +497,67 @@ class SupertonicTtsService : Service() {
         val runtime = Runtime.getRuntime()
         val availableMB = ((runtime.maxMemory() - runtime.totalMemory()) / (1024 * 1024)).toInt()
         val totalMB = (runtime.maxMemory() / (1024 * 1024)).toInt()
+        val nativeMB = getNativeMemoryReport()?.let { (it.engineBytes / (1024 * 1024)).toInt() } ?: 0
         
         return ServiceMemoryInfo(
             availableMB = availableMB,
             totalMB = totalMB,
-            loadedModelCount = loadedSpeakers.size
+            loadedModelCount = loadedSpeakers.size,
+            nativeMB = nativeMB
         )
     }
     
+    /**
+     * Native memory held by the engine (sessions, ORT arenas, caches).
+     * The JVM heap numbers in [getMemoryInfo] cannot see any of it.
+     */
+    fun getNativeMemoryReport(): SupertonicMemoryReport? {
+        if (!isInitialized) return null
+        val values = LongArray(SupertonicMemoryReport.ARRAY_SIZE)
+        return if (SupertonicNative.getMemoryReport(values)) {
+            SupertonicMemoryReport.fromArray(values)
+        } else {
+            null
+        }
+    }
+    
+    /**
+     * Shed native memory at a SupertonicMemoryReport.TRIM_* level.
+     * 
+     * Runs off the caller's thread: levels that release sessions wait for
+     * in-flight synthesis to finish.
+     */
+    fun trimNativeMemory(level: Int) {
+        if (!isInitialized || level <= SupertonicMemoryReport.TRIM_NONE) return
+        if (level >= SupertonicMemoryReport.TRIM_LARGE_SESSIONS) {
+            shapesWarmed = false
+        }
+        scope.launch(Dispatchers.IO) {
+            val before = getNativeMemoryReport()
+            if (!SupertonicNative.trim(level)) {
+                android.util.Log.w("SupertonicTtsService", "Native trim level $level failed")
+                return@launch
+            }
+            val after = getNativeMemoryReport()
+            if (before != null && after != null) {
+                android.util.Log.i(
+                    "SupertonicTtsService",
+                    "Trim level $level: native heap ${before.nativeHeapBytes / (1024 * 1024)}MB -> " +
+                        "${after.nativeHeapBytes / (1024 * 1024)}MB, sessions 0x${after.sessionsLoaded.toString(16)}"
+                )
+            }
+        }
+    }
+    
+    /**
+     * Forwarded from the plugin's ComponentCallbacks2 registration, since
+     * this service is not attached to the system as a real Service.
+     */
+    override fun onTrimMemory(level: Int) {
+        super.onTrimMemory(level)
+        trimNativeMemory(MemoryManager.nativeTrimLevel(level))
+    }
+    
     fun isReady(): Boolean = isInitialized && SupertonicNative.isReady()
     fun isVoiceLoaded(voiceId: String): Boolean = loadedSpeakers.containsKey(voiceId)
     
@@ -330,6 +568,46 @@ class SupertonicTtsService : Service() {
     
     // Private helpers
     
+    private fun recordStats(requestId: String, stats: SupertonicStats) {
+        synchronized(recentStats) { recentStats[requestId] = stats }
+        android.util.Log.d(
+            "SupertonicTtsService",
+            "Stats $requestId: total=${"%.1f".format(stats.totalMs)}ms " +
+                "te=${"%.1f".format(stats.textEncoderMs)} dp=${"%.1f".format(stats.durationPredictorMs)} " +
+                "ve=${"%.1f".format(stats.vectorEstimatorMs)}/${stats.stepsRun}" +
+                (if (stats.stepsRun < stats.numSteps) " of ${stats.numSteps} " else " ") +
+                "voc=${"%.1f".format(stats.vocoderMs)} rtf=${"%.3f".format(stats.rtf)} " +
+                "cpu=${"%.1f".format(stats.cpuThreadUserMs + stats.cpuThreadSystemMs)}ms" +
+                (if (stats.numChunks > 1) " chunks=${stats.numChunks}" else "") +
+                " queued=${"%.1f".format(stats.queueMs)}ms" +
+                (if (stats.sharedRequests > 1) " shared=${stats.sharedRequests}" else "") +
+                (if (stats.preemptions > 0)
+                    " paused=${stats.preemptions}x/${"%.1f".format(stats.suspendedMs)}ms" else "") +
+                (if (stats.executionClass == SupertonicStats.CLASS_BACKGROUND) " background" else "") +
+                (if (stats.callerCpu >= 0) " on cpu${stats.callerCpu}" else "") +
+                " models=${stats.modelVariantSummary}" +
+                if (stats.textCacheHit) " (text cached)" else ""
+        )
+    }
+    
+    /**
+     * Runs block in a systrace section named like the native engine's
+     * markers ("supertonic <name> req=<id>"), so the file work of a request
+     * lines up with its stages in Perfetto. The name is only built while
+     * tracing on API 29+, where that can be checked.
+     */
+    private inline fun <T> traced(name: String, nativeRequestId: Long, block: () -> T): T {
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.Q && !Trace.isEnabled()) {
+            return block()
+        }
+        Trace.beginSection("supertonic $name req=$nativeRequestId")
+        try {
+            return block()
+        } finally {
+            Trace.endSection()
+        }
+    }
+    
     /**
      * Convert float audio samples [-1.0, 1.0] to 16-bit PCM.
      */
@@ -340,15 +618,6 @@ class SupertonicTtsService : Service() {
         }
     }
     
-    private fun estimateDuration(text: String): Float {
-        val words = text.length / 5.0f
-        return words / 2.5f
-    }
-    
-    private fun estimateDurationMs(text: String): Int {
-        return (estimateDuration(text) * 1000).toInt()
-    }
-    
     private fun writeWavFile(file: File, samples: ShortArray, sampleRate: Int) {
         val numChannels = 1
         val bitsPerSample = 16
@@ -400,6 +669,14 @@ class SupertonicTtsService : Service() {
     }
 }
 
+private const val MAX_RECENT_STATS = 64
+
+/** Native queue deadline of requests whose caller gave none. */
+private const val UNSCHEDULED_DEADLINE_MS = 30_000L
+
+/** Requests due later than this are prefetch and run in the native background class. */
+private const val BACKGROUND_DEADLINE_MS = 10_000L
+
 /**
  * Supertonic speaker state.
  */
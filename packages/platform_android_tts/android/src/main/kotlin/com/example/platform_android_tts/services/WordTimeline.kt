@@ -0,0 +1,133 @@
+package com.example.platform_android_tts.services
+
+import com.example.platform_android_tts.onnx.SupertonicTimestamps
+import java.io.File
+import java.io.IOException
+
+/** One word of a segment: its UTF-16 range in the text and when it plays. */
+data class WordTiming(
+    val charStart: Int,
+    val charEnd: Int,
+    val startMs: Int,
+    val endMs: Int
+)
+
+/**
+ * Word-level timing of one synthesized segment, for highlighting the word
+ * being spoken and seeking within the segment.
+ *
+ * Stored next to the segment's audio file (see [pathFor]) in UTF-8 text:
+ * ```
+ * supertonic-words 1
+ * approximate 0
+ * 0 5 0 412
+ * 6 11 412 870
+ * ...
+ * ```
+ * with one `charStart charEnd startMs endMs` line per word.
+ */
+class WordTimeline(
+    /** Timings were spread evenly; the model gave no per-token durations. */
+    val approximate: Boolean,
+    val words: List<WordTiming>
+) {
+    /**
+     * Word playing at [ms] into the segment, clamped to the first and last
+     * word; -1 if there are no words.
+     */
+    fun wordAt(ms: Int): Int {
+        if (words.isEmpty()) return -1
+        var low = 0
+        var high = words.size - 1
+        while (low < high) {
+            val mid = (low + high + 1) ushr 1
+            if (words[mid].startMs <= ms) low = mid else high = mid - 1
+        }
+        return low
+    }
+
+    /** Write the timeline to [file], replacing it atomically. */
+    @Throws(IOException::class)
+    fun writeTo(file: File) {
+        val text = buildString {
+            append(HEADER).append('\n')
+            append("approximate ").append(if (approximate) 1 else 0).append('\n')
+            for (word in words) {
+                append(word.charStart).append(' ').append(word.charEnd).append(' ')
+                append(word.startMs).append(' ').append(word.endMs).append('\n')
+            }
+        }
+        val tmp = File(file.path + ".tmp")
+        tmp.writeText(text)
+        if (!tmp.renameTo(file)) {
+            tmp.delete()
+            throw IOException("Failed to write word timeline: $file")
+        }
+    }
+
+    companion object {
+        private const val HEADER = "supertonic-words 1"
+
+        /** Sidecar file of the audio at [audioPath]. */
+        fun pathFor(audioPath: String): String = "$audioPath.words"
+
+        /**
+         * Sidecar holding the timings of [audioPath], or null if there is
+         * none. The app cache compresses `x.wav` to `x.m4a` and moves the
+         * sidecar along, so a WAV path also finds the compressed file's.
+         */
+        fun find(audioPath: String): File? {
+            val candidates = listOf(audioPath) +
+                if (audioPath.endsWith(".wav")) listOf(audioPath.removeSuffix(".wav") + ".m4a") else emptyList()
+            return candidates.map { File(pathFor(it)) }.firstOrNull { it.exists() }
+        }
+
+        /**
+         * Group token timings into whitespace-separated words of [text],
+         * the string that was synthesized.
+         */
+        fun fromTokens(timestamps: SupertonicTimestamps, text: String, sampleRate: Int): WordTimeline {
+            fun ms(sample: Int) = (sample.toLong() * 1000 / sampleRate).toInt()
+            val words = mutableListOf<WordTiming>()
+            var first = -1
+            for (i in 0..timestamps.size) {
+                val isSpace = i == timestamps.size ||
+                    text.getOrNull(timestamps.charStarts[i])?.isWhitespace() != false
+                if (!isSpace && first < 0) {
+                    first = i
+                } else if (isSpace && first >= 0) {
+                    words += WordTiming(
+                        charStart = timestamps.charStarts[first],
+                        charEnd = timestamps.charEnds[i - 1],
+                        startMs = ms(timestamps.startSamples[first]),
+                        endMs = ms(timestamps.endSamples[i - 1])
+                    )
+                    first = -1
+                }
+            }
+            return WordTimeline(timestamps.approximate, words)
+        }
+
+        /** Read a timeline written by [writeTo], or null if missing or malformed. */
+        fun readFrom(file: File): WordTimeline? {
+            if (!file.exists()) return null
+            val lines = try {
+                file.readLines().filter { it.isNotBlank() }
+            } catch (e: IOException) {
+                return null
+            }
+            if (lines.size < 2 || lines[0] != HEADER) return null
+            val approximate = when (lines[1]) {
+                "approximate 0" -> false
+                "approximate 1" -> true
+                else -> return null
+            }
+            val words = lines.drop(2).map { line ->
+                val fields = line.split(' ').mapNotNull { it.toIntOrNull() }
+                if (fields.size != 4) return null
+                WordTiming(fields[0], fields[1], fields[2], fields[3])
+            }
+            return WordTimeline(approximate, words)
+        }
+    }
+}
@@ -0,0 +1,177 @@
+package com.example.platform_android_tts.onnx
+
+import com.example.platform_android_tts.onnx.SupertonicStats.Companion.CALLER_CPU
+import com.example.platform_android_tts.onnx.SupertonicStats.Companion.CALLER_CPUS
+import com.example.platform_android_tts.onnx.SupertonicStats.Companion.EXECUTION_CLASS
+import com.example.platform_android_tts.onnx.SupertonicStats.Companion.MODEL_VARIANT_BASE
+import com.example.platform_android_tts.onnx.SupertonicStats.Companion.NUM_CHUNKS
+import com.example.platform_android_tts.onnx.SupertonicStats.Companion.NUM_STEPS
+import com.example.platform_android_tts.onnx.SupertonicStats.Companion.PERF_COUNTERS
+import com.example.platform_android_tts.onnx.SupertonicStats.Companion.PERF_THREADS
+import com.example.platform_android_tts.onnx.SupertonicStats.Companion.POOL_CPUS
+import com.example.platform_android_tts.onnx.SupertonicStats.Companion.PREEMPTIONS
+import com.example.platform_android_tts.onnx.SupertonicStats.Companion.QUEUE_MS
+import com.example.platform_android_tts.onnx.SupertonicStats.Companion.REQUEST_ID
+import com.example.platform_android_tts.onnx.SupertonicStats.Companion.RTF
+import com.example.platform_android_tts.onnx.SupertonicStats.Companion.SHARED_REQUESTS
+import com.example.platform_android_tts.onnx.SupertonicStats.Companion.STEPS_RUN
+import com.example.platform_android_tts.onnx.SupertonicStats.Companion.STEP_MS_BASE
+import com.example.platform_android_tts.onnx.SupertonicStats.Companion.SUSPENDED_MS
+import com.example.platform_android_tts.onnx.SupertonicStats.Companion.TEXT_CACHE_HIT
+import com.example.platform_android_tts.onnx.SupertonicStats.Companion.TOTAL_MS
+import com.example.platform_android_tts.onnx.SupertonicStats.Companion.XNNPACK_MODELS
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+/**
+ * Unit tests for SupertonicStats.
+ * Tests decoding of the flat array filled by the JNI layer.
+ */
+internal class SupertonicStatsTest {
+
+    /** A written stats array: [fields] by StatsIndex, the rest zero. */
+    private fun statsArray(vararg fields: Pair<Int, Double>): DoubleArray {
+        val values = SupertonicStats.newArray()
+        values[REQUEST_ID] = 7.0
+        for ((index, value) in fields) {
+            values[index] = value
+        }
+        return values
+    }
+
+    private fun decode(vararg fields: Pair<Int, Double>): SupertonicStats =
+        SupertonicStats.fromArray(statsArray(*fields))!!
+
+    @Test
+    fun `fromArray decodes fields and used steps only`() {
+        val stats = decode(
+            REQUEST_ID to 42.0,
+            TOTAL_MS to 180.5,
+            NUM_STEPS to 3.0,
+            RTF to 0.25,
+            STEP_MS_BASE to 10.0,
+            STEP_MS_BASE + 1 to 11.0,
+            STEP_MS_BASE + 2 to 12.0,
+            STEP_MS_BASE + 3 to 99.0    // beyond num steps
+        )
+
+        assertEquals(42L, stats.requestId)
+        assertTrue(stats.isSuccess)
+        assertEquals(180.5, stats.totalMs)
+        assertEquals(0.25, stats.rtf)
+        assertEquals(listOf(10.0, 11.0, 12.0), stats.stepMs)
+    }
+
+    @Test
+    fun `fromArray decodes text cache hit and chunk count`() {
+        assertTrue(decode(TEXT_CACHE_HIT to 1.0).textCacheHit)
+
+        val stats = decode(NUM_CHUNKS to 3.0)
+        assertEquals(3, stats.numChunks)
+        assertFalse(stats.textCacheHit)
+    }
+
+    @Test
+    fun `fromArray decodes model variants and the xnnpack mask`() {
+        val stats = decode(
+            MODEL_VARIANT_BASE to SupertonicStats.VARIANT_FP32.toDouble(),
+            MODEL_VARIANT_BASE + 2 to SupertonicStats.VARIANT_INT8_QDQ.toDouble(),
+            MODEL_VARIANT_BASE + 3 to SupertonicStats.VARIANT_FP16.toDouble()
+        )
+        assertEquals(listOf(1, 0, 4, 2), stats.modelVariants)
+        assertEquals("fp32/default/int8_qdq/fp16", stats.modelVariantSummary)
+
+        val xnnpack = decode(XNNPACK_MODELS to 0b0100.toDouble())    // vector estimator
+        assertEquals(4, xnnpack.xnnpackModels)
+        assertEquals("default/default/default+xnnpack/default", xnnpack.modelVariantSummary)
+    }
+
+    @Test
+    fun `fromArray limits step times to the steps run after an early exit`() {
+        val stats = decode(
+            NUM_STEPS to 5.0,
+            STEP_MS_BASE to 10.0,
+            STEP_MS_BASE + 1 to 11.0,
+            STEP_MS_BASE + 2 to 12.0,
+            STEPS_RUN to 3.0
+        )
+        assertEquals(5, stats.numSteps)
+        assertEquals(3, stats.stepsRun)
+        assertEquals(listOf(10.0, 11.0, 12.0), stats.stepMs)
+    }
+
+    @Test
+    fun `fromArray decodes scheduling fields`() {
+        val stats = decode(
+            QUEUE_MS to 250.5,
+            SHARED_REQUESTS to 2.0,
+            PREEMPTIONS to 2.0,
+            SUSPENDED_MS to 480.25,
+            EXECUTION_CLASS to SupertonicStats.CLASS_BACKGROUND.toDouble()
+        )
+        assertEquals(250.5, stats.queueMs, 0.0)
+        assertEquals(2, stats.sharedRequests)
+        assertEquals(2, stats.preemptions)
+        assertEquals(480.25, stats.suspendedMs, 0.0)
+        assertEquals(SupertonicStats.CLASS_BACKGROUND, stats.executionClass)
+    }
+
+    @Test
+    fun `fromArray treats unscheduled calls as unshared foreground work`() {
+        val stats = decode()
+        assertEquals(0.0, stats.queueMs, 0.0)
+        assertEquals(1, stats.sharedRequests)
+        assertEquals(0, stats.preemptions)
+        assertEquals(SupertonicStats.CLASS_FOREGROUND, stats.executionClass)
+    }
+
+    @Test
+    fun `fromArray decodes thread placement masks`() {
+        val stats = decode(
+            CALLER_CPUS to 0xf0.toDouble(),
+            CALLER_CPU to 6.0,
+            POOL_CPUS to 0xc0.toDouble()
+        )
+        assertEquals(0xf0L, stats.callerCpus)
+        assertEquals(6, stats.callerCpu)
+        assertEquals(0xc0L, stats.poolCpus)
+    }
+
+    @Test
+    fun `fromArray decodes perf counters per stage`() {
+        val perf = SupertonicStats.Companion::perfIndex
+        val stats = decode(
+            PERF_COUNTERS to (1 shl SupertonicStats.PERF_CONTEXT_SWITCHES).toDouble(),
+            PERF_THREADS to 3.0,
+            perf(SupertonicStats.STAGE_TEXT_ENCODER, SupertonicStats.PERF_CONTEXT_SWITCHES) to 4.0,
+            perf(SupertonicStats.STAGE_VECTOR_ESTIMATOR, SupertonicStats.PERF_CYCLES) to 2000.0,
+            perf(SupertonicStats.STAGE_VECTOR_ESTIMATOR, SupertonicStats.PERF_INSTRUCTIONS) to 5000.0,
+            perf(SupertonicStats.STAGE_VOCODER, SupertonicStats.PERF_CONTEXT_SWITCHES) to 9.0
+        )
+        assertEquals(1 shl SupertonicStats.PERF_CONTEXT_SWITCHES, stats.perfCounters)
+        assertEquals(3, stats.perfThreads)
+        assertEquals(4L, stats.perfTextEncoder.contextSwitches)
+        assertEquals(2.5, stats.perfVectorEstimator.ipc)
+        assertEquals(9L, stats.perfVocoder.contextSwitches)
+        assertEquals(0.0, stats.perfDurationPredictor.ipc)
+    }
+
+    @Test
+    fun `array layout matches the native stats size`() {
+        // STATS_ARRAY_SIZE in supertonic_native.cpp; fields are appended at the end
+        assertEquals(93, SupertonicStats.ARRAY_SIZE)
+        assertEquals(
+            SupertonicStats.ARRAY_SIZE,
+            SupertonicStats.perfIndex(SupertonicStats.STAGE_VOCODER + 1, 0)
+        )
+    }
+
+    @Test
+    fun `fromArray rejects short or unwritten arrays`() {
+        assertNull(SupertonicStats.fromArray(DoubleArray(10)))
+        assertNull(SupertonicStats.fromArray(SupertonicStats.newArray()))
+    }
+}
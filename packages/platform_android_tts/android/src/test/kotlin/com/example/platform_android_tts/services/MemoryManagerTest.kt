@@ -0,0 +1,36 @@
+package com.example.platform_android_tts.services
+
+import android.content.ComponentCallbacks2
+import com.example.platform_android_tts.onnx.SupertonicMemoryReport
+import kotlin.test.Test
+import kotlin.test.assertEquals
+
+/**
+ * Unit tests for MemoryManager.
+ * Tests the mapping from memory pressure to native trim levels.
+ */
+@Suppress("DEPRECATION")
+internal class MemoryManagerTest {
+
+    @Test
+    fun `running pressure escalates from arenas to large sessions`() {
+        assertEquals(SupertonicMemoryReport.TRIM_ARENAS,
+            MemoryManager.nativeTrimLevel(ComponentCallbacks2.TRIM_MEMORY_RUNNING_MODERATE))
+        assertEquals(SupertonicMemoryReport.TRIM_CACHES,
+            MemoryManager.nativeTrimLevel(ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW))
+        assertEquals(SupertonicMemoryReport.TRIM_LARGE_SESSIONS,
+            MemoryManager.nativeTrimLevel(ComponentCallbacks2.TRIM_MEMORY_RUNNING_CRITICAL))
+    }
+
+    @Test
+    fun `background pressure escalates to releasing all sessions`() {
+        assertEquals(SupertonicMemoryReport.TRIM_ARENAS,
+            MemoryManager.nativeTrimLevel(ComponentCallbacks2.TRIM_MEMORY_UI_HIDDEN))
+        assertEquals(SupertonicMemoryReport.TRIM_CACHES,
+            MemoryManager.nativeTrimLevel(ComponentCallbacks2.TRIM_MEMORY_BACKGROUND))
+        assertEquals(SupertonicMemoryReport.TRIM_LARGE_SESSIONS,
+            MemoryManager.nativeTrimLevel(ComponentCallbacks2.TRIM_MEMORY_MODERATE))
+        assertEquals(SupertonicMemoryReport.TRIM_ALL_SESSIONS,
+            MemoryManager.nativeTrimLevel(ComponentCallbacks2.TRIM_MEMORY_COMPLETE))
+    }
+}
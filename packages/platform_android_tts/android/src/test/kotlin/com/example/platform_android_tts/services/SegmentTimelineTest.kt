@@ -0,0 +1,67 @@
+package com.example.platform_android_tts.services
+
+import java.io.File
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertNotNull
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+/**
+ * Unit tests for SegmentTimeline.
+ * Tests offsets, seeking and persistence.
+ */
+internal class SegmentTimelineTest {
+
+    @Test
+    fun `start offsets accumulate durations`() {
+        val timeline = SegmentTimeline(0, 1.0f, doubleArrayOf(1.5, 0.5, 2.0))
+
+        assertContentEquals(doubleArrayOf(0.0, 1.5, 2.0), timeline.startOffsets)
+        assertEquals(4.0, timeline.totalSeconds)
+    }
+
+    @Test
+    fun `segmentAt finds the playing segment and clamps`() {
+        val timeline = SegmentTimeline(0, 1.0f, doubleArrayOf(1.5, 0.5, 2.0))
+
+        assertEquals(0, timeline.segmentAt(-1.0))
+        assertEquals(0, timeline.segmentAt(1.49))
+        assertEquals(1, timeline.segmentAt(1.5))
+        assertEquals(2, timeline.segmentAt(3.0))
+        assertEquals(2, timeline.segmentAt(10.0))
+        assertEquals(-1, SegmentTimeline(0, 1.0f, DoubleArray(0)).segmentAt(0.0))
+    }
+
+    @Test
+    fun `timeline survives a write and read`() {
+        val file = File.createTempFile("timeline", ".txt")
+        try {
+            val timeline = SegmentTimeline(3, 1.25f, doubleArrayOf(1.904762, 0.0, 0.626939))
+            timeline.writeTo(file)
+
+            val restored = assertNotNull(SegmentTimeline.readFrom(file))
+            assertTrue(restored.matches(3, 1.25f))
+            assertFalse(restored.matches(3, 1.0f))
+            assertContentEquals(timeline.durations, restored.durations)
+        } finally {
+            file.delete()
+        }
+    }
+
+    @Test
+    fun `readFrom rejects malformed files`() {
+        val file = File.createTempFile("timeline", ".txt")
+        try {
+            file.writeText("not a timeline\n")
+            assertNull(SegmentTimeline.readFrom(file))
+
+            file.writeText("supertonic-timeline 1\nspeaker 0\nspeed 1.0\nabc\n")
+            assertNull(SegmentTimeline.readFrom(file))
+        } finally {
+            file.delete()
+        }
+    }
+}
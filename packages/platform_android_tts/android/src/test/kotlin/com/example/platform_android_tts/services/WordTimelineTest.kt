@@ -0,0 +1,94 @@
+package com.example.platform_android_tts.services
+
+import com.example.platform_android_tts.onnx.SupertonicTimestamps
+import java.io.File
+import java.nio.file.Files
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertNotNull
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+/**
+ * Unit tests for WordTimeline.
+ * Tests decoding native token timings, word grouping and persistence.
+ */
+internal class WordTimelineTest {
+
+    // "Hi, yo" at 1000 Hz: one record per character, 100 samples each
+    private fun nativeArray(approximate: Boolean = false): IntArray {
+        val text = "Hi, yo"
+        val values = mutableListOf(if (approximate) 1 else 0, text.length)
+        for (i in text.indices) {
+            values += listOf(i, i + 1, i * 100, (i + 1) * 100)
+        }
+        return values.toIntArray()
+    }
+
+    @Test
+    fun `fromArray decodes token records`() {
+        val timestamps = assertNotNull(SupertonicTimestamps.fromArray(nativeArray(approximate = true)))
+
+        assertTrue(timestamps.approximate)
+        assertEquals(6, timestamps.size)
+        assertEquals(3, timestamps.charStarts[3])
+        assertEquals(400, timestamps.endSamples[3])
+    }
+
+    @Test
+    fun `fromArray rejects truncated arrays`() {
+        assertNull(SupertonicTimestamps.fromArray(null))
+        assertNull(SupertonicTimestamps.fromArray(intArrayOf(0, 2, 0, 1, 0, 100)))
+    }
+
+    @Test
+    fun `tokens group into whitespace separated words`() {
+        val timestamps = assertNotNull(SupertonicTimestamps.fromArray(nativeArray()))
+        val timeline = WordTimeline.fromTokens(timestamps, "Hi, yo", 1000)
+
+        assertEquals(
+            listOf(WordTiming(0, 3, 0, 300), WordTiming(4, 6, 400, 600)),
+            timeline.words
+        )
+        assertEquals(0, timeline.wordAt(350))
+        assertEquals(1, timeline.wordAt(400))
+        assertEquals(1, timeline.wordAt(10_000))
+    }
+
+    @Test
+    fun `timeline survives a write and read`() {
+        val file = File.createTempFile("segment", ".wav.words")
+        try {
+            val timestamps = assertNotNull(SupertonicTimestamps.fromArray(nativeArray(approximate = true)))
+            val timeline = WordTimeline.fromTokens(timestamps, "Hi, yo", 1000)
+            timeline.writeTo(file)
+
+            val restored = assertNotNull(WordTimeline.readFrom(file))
+            assertTrue(restored.approximate)
+            assertEquals(timeline.words, restored.words)
+
+            file.writeText("supertonic-words 1\napproximate 0\n1 2 3\n")
+            assertNull(WordTimeline.readFrom(file))
+        } finally {
+            file.delete()
+        }
+    }
+
+    @Test
+    fun `find follows the audio to its compressed file`() {
+        val dir = Files.createTempDirectory("words").toFile()
+        try {
+            val wavPath = File(dir, "segment.wav").path
+            assertNull(WordTimeline.find(wavPath))
+
+            val m4aWords = File(dir, "segment.m4a.words").apply { writeText("") }
+            assertEquals(m4aWords, WordTimeline.find(wavPath))
+
+            val wavWords = File(dir, "segment.wav.words").apply { writeText("") }
+            assertEquals(wavWords, WordTimeline.find(wavPath))
+            assertEquals(m4aWords, WordTimeline.find(File(dir, "segment.m4a").path))
+        } finally {
+            dir.deleteRecursively()
+        }
+    }
+}
@@ -197,6 +197,7 @@ class SynthesizeRequest {
     required this.requestId,
     this.speakerId,
     this.speed = 1.0,
+    this.deadlineMs,
   });
 
   NativeEngineType engineType;
@@ -213,6 +214,10 @@ class SynthesizeRequest {
 
   double speed;
 
+  /// When playback needs the audio, in milliseconds from now. Engines with
+  /// a native request queue run earlier deadlines first; null = unknown.
+  int? deadlineMs;
+
   List<Object?> _toList() {
     return <Object?>[
       engineType,
@@ -222,6 +227,7 @@ class SynthesizeRequest {
       requestId,
       speakerId,
       speed,
+      deadlineMs,
     ];
   }
 
@@ -238,6 +244,7 @@ class SynthesizeRequest {
       requestId: result[4]! as String,
       speakerId: result[5] as int?,
       speed: result[6]! as double,
+      deadlineMs: result[7] as int?,
     );
   }
 
@@ -615,6 +622,32 @@ class TtsNativeApi {
     }
   }
 
+  /// Run a loaded voice's first inference ahead of playback.
+  ///
+  /// Made during idle warmup; a no-op for engines without a warmup step.
+  Future<void> warmUpVoice(NativeEngineType engineType, String voiceId) async {
+    final String pigeonVar_channelName = 'dev.flutter.pigeon.platform_android_tts.TtsNativeApi.warmUpVoice$pigeonVar_messageChannelSuffix';
+    final BasicMessageChannel<Object?> pigeonVar_channel = BasicMessageChannel<Object?>(
+      pigeonVar_channelName,
+      pigeonChannelCodec,
+      binaryMessenger: pigeonVar_binaryMessenger,
+    );
+    final Future<Object?> pigeonVar_sendFuture = pigeonVar_channel.send(<Object?>[engineType, voiceId]);
+    final List<Object?>? pigeonVar_replyList =
+        await pigeonVar_sendFuture as List<Object?>?;
+    if (pigeonVar_replyList == null) {
+      throw _createConnectionError(pigeonVar_channelName);
+    } else if (pigeonVar_replyList.length > 1) {
+      throw PlatformException(
+        code: pigeonVar_replyList[0]! as String,
+        message: pigeonVar_replyList[1] as String?,
+        details: pigeonVar_replyList[2],
+      );
+    } else {
+      return;
+    }
+  }
+
   /// Unload a voice to free memory.
   Future<void> unloadVoice(NativeEngineType engineType, String voiceId) async {
     final String pigeonVar_channelName = 'dev.flutter.pigeon.platform_android_tts.TtsNativeApi.unloadVoice$pigeonVar_messageChannelSuffix';
@@ -86,6 +86,7 @@ class SynthesizeRequest {
     required this.requestId,
     this.speakerId,
     this.speed = 1.0,
+    this.deadlineMs,
   });
 
   final NativeEngineType engineType;
@@ -95,6 +96,10 @@ class SynthesizeRequest {
   final String requestId;
   final int? speakerId;
   final double speed;
+
+  /// When playback needs the audio, in milliseconds from now. Engines with
+  /// a native request queue run earlier deadlines first; null = unknown.
+  final int? deadlineMs;
 }
 
 /// Result of a synthesis operation.
@@ -161,6 +166,12 @@ abstract class TtsNativeApi {
   @async
   void cancelSynthesis(String requestId);
 
+  /// Run a loaded voice's first inference ahead of playback.
+  ///
+  /// Made during idle warmup; a no-op for engines without a warmup step.
+  @async
+  void warmUpVoice(NativeEngineType engineType, String voiceId);
+
   /// Unload a voice to free memory.
   @async
   void unloadVoice(NativeEngineType engineType, String voiceId);
@@ -759,6 +759,7 @@ class AudiobookPlaybackController implements PlaybackController {
         bookId: currentTrack.bookId ?? 'unknown',
         chapterIndex: currentTrack.chapterIndex,
         priority: SynthesisPriority.prefetch,
+        playingIndex: currentIdx,
       ));
     }
   }
@@ -863,6 +864,7 @@ class AudiobookPlaybackController implements PlaybackController {
             bookId: track.bookId ?? 'unknown',
             chapterIndex: track.chapterIndex,
             priority: SynthesisPriority.immediate,
+            playingIndex: _state.currentIndex,
           );
         }
       }
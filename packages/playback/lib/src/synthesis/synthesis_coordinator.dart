@@ -246,6 +246,10 @@ class SynthesisCoordinator {
   /// - Skips segments already queued or in-flight (upgrades priority if higher)
   /// - Adds new segments to the priority queue
   ///
+  /// Each segment gets a playback deadline from the estimated duration of
+  /// the text between [playingIndex] (default [startIndex]) and it, which
+  /// the engine's native queue uses to run the most urgent work first.
+  ///
   /// Returns immediately - synthesis happens asynchronously.
   Future<void> queueRange({
     required List<AudioTrack> tracks,
@@ -256,6 +260,7 @@ class SynthesisCoordinator {
     required String bookId,
     required int chapterIndex,
     SynthesisPriority priority = SynthesisPriority.prefetch,
+    int? playingIndex,
   }) async {
     if (_disposed) return;
     if (tracks.isEmpty) return;
@@ -275,8 +280,17 @@ class SynthesisCoordinator {
     var skippedCached = 0;
     var skippedDuplicate = 0;
 
+    // Audio that plays before segment i, from the playing segment's start
+    final queuedAt = DateTime.now();
+    var aheadMs = 0;
+    for (var j = (playingIndex ?? startIndex).clamp(0, startIndex); j < startIndex; j++) {
+      aheadMs += estimateDurationMs(tracks[j].text, playbackRate: playbackRate);
+    }
+
     for (var i = startIndex; i <= effectiveEnd; i++) {
       final track = tracks[i];
+      final dueAt = queuedAt.add(Duration(milliseconds: aheadMs));
+      aheadMs += estimateDurationMs(track.text, playbackRate: playbackRate);
       final cacheKey = CacheKeyGenerator.generate(
         voiceId: voiceId,
         text: track.text,
@@ -317,6 +331,7 @@ class SynthesisCoordinator {
         if (existing != null) {
           // Upgrade priority if the new request has higher priority
           existing.upgradePriority(priority);
+          existing.advanceDueAt(dueAt);
           skippedDuplicate++;
           _logger.info('[DEDUP] seg $i: QUEUED (skip), key=$dedupeKey, upgraded to ${existing.priority.name}');
           continue;
@@ -337,6 +352,7 @@ class SynthesisCoordinator {
           cacheKey: cacheKey,
           bookId: bookId,
           chapterIndex: chapterIndex,
+          dueAt: dueAt,
         );
 
         _queue.add(request);
@@ -626,6 +642,7 @@ class SynthesisCoordinator {
             voiceId: request.voiceId,
             text: request.track.text,
             playbackRate: request.playbackRate,
+            deadline: request.deadline,
           )
           .timeout(
             PlaybackConfig.synthesisTimeout,
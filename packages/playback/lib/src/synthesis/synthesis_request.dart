@@ -35,6 +35,7 @@ class SynthesisRequest implements Comparable<SynthesisRequest> {
     required this.cacheKey,
     required this.bookId,
     required this.chapterIndex,
+    this.dueAt,
     DateTime? createdAt,
   }) : createdAt = createdAt ?? DateTime.now();
 
@@ -65,6 +66,18 @@ class SynthesisRequest implements Comparable<SynthesisRequest> {
   /// When this request was created (for FIFO within same priority).
   final DateTime createdAt;
 
+  /// When playback is expected to reach this segment, estimated from the
+  /// text ahead of it; null if unknown.
+  DateTime? dueAt;
+
+  /// Time left until [dueAt], never negative; null if unknown.
+  Duration? get deadline {
+    final due = dueAt;
+    if (due == null) return null;
+    final left = due.difference(DateTime.now());
+    return left.isNegative ? Duration.zero : left;
+  }
+
   /// Unique key for deduplication (based on cache key).
   String get deduplicationKey => cacheKey.toFilename();
 
@@ -86,6 +99,14 @@ class SynthesisRequest implements Comparable<SynthesisRequest> {
     }
   }
 
+  /// Move [dueAt] earlier if playback now needs the segment sooner.
+  void advanceDueAt(DateTime? newDueAt) {
+    final due = dueAt;
+    if (newDueAt != null && (due == null || newDueAt.isBefore(due))) {
+      dueAt = newDueAt;
+    }
+  }
+
   @override
   String toString() =>
       'SynthesisRequest(book: $bookId, chapter: $chapterIndex, segment: $segmentIndex, priority: ${priority.name}, voice: $voiceId)';
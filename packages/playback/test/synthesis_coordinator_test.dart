@@ -95,6 +95,48 @@ void main() {
       req.upgradePriority(SynthesisPriority.background);
       expect(req.priority, SynthesisPriority.immediate);
     });
+
+    test('advanceDueAt only moves the deadline earlier', () {
+      final due = DateTime.now().add(const Duration(seconds: 60));
+      final req = SynthesisRequest(
+        track: _createTrack(0),
+        voiceId: 'voice1',
+        playbackRate: 1.0,
+        segmentIndex: 0,
+        priority: SynthesisPriority.prefetch,
+        cacheKey: _createCacheKey('text0'),
+        bookId: 'book1',
+        chapterIndex: 0,
+        dueAt: due,
+      );
+
+      // Should not move later or forget the deadline
+      req.advanceDueAt(due.add(const Duration(seconds: 10)));
+      req.advanceDueAt(null);
+      expect(req.dueAt, due);
+
+      // Should move earlier
+      final sooner = due.subtract(const Duration(seconds: 58));
+      req.advanceDueAt(sooner);
+      expect(req.dueAt, sooner);
+    });
+
+    test('deadline is never negative and null without a due time', () {
+      final req = SynthesisRequest(
+        track: _createTrack(0),
+        voiceId: 'voice1',
+        playbackRate: 1.0,
+        segmentIndex: 0,
+        priority: SynthesisPriority.immediate,
+        cacheKey: _createCacheKey('text0'),
+        bookId: 'book1',
+        chapterIndex: 0,
+      );
+      expect(req.deadline, isNull);
+
+      req.dueAt = DateTime.now().subtract(const Duration(seconds: 1));
+      expect(req.deadline, Duration.zero);
+    });
   });
 
   group('SynthesisPriority', () {
@@ -231,6 +231,7 @@ class RoutingEngine implements AiVoiceEngine {
       playbackRate: request.playbackRate,
       outFile: outFile,
       tuning: request.tuning,
+      deadline: request.deadline,
     );
 
     // Synthesize
@@ -469,11 +470,13 @@ class RoutingEngine implements AiVoiceEngine {
 
   /// Synthesize with caching support (convenience method).
   ///
-  /// This is the primary method for playback integration.
+  /// This is the primary method for playback integration. [deadline] is
+  /// how soon playback needs the audio, if known.
   Future<SynthResult> synthesizeToWavFile({
     required String voiceId,
     required String text,
     required double playbackRate,
+    Duration? deadline,
   }) async {
     // Use rate-independent synthesis
     final synthRate = CacheKeyGenerator.getSynthesisRate(playbackRate);
@@ -491,6 +494,7 @@ class RoutingEngine implements AiVoiceEngine {
       text: text,
       playbackRate: synthRate,
       outFile: outFile,
+      deadline: deadline,
     ));
   }
 }
@@ -151,6 +151,10 @@ class SupertonicAdapter implements AiVoiceEngine {
         debugPrint('[SupertonicAdapter] ${DateTime.now().toIso8601String()} warmUp: voice loaded');
       }
 
+      // Pay ORT's first-run cost now, while idle; synthesizeSegment loads
+      // voices without it so playback never waits on the warmup runs
+      await _warmUpVoice(voiceId);
+
       final totalDuration = DateTime.now().difference(warmUpStartTime);
       debugPrint('[SupertonicAdapter] ${DateTime.now().toIso8601String()} warmUp complete for $voiceId in ${totalDuration.inMilliseconds}ms');
       _warmUpCompleter!.complete(true);
@@ -238,6 +242,7 @@ class SupertonicAdapter implements AiVoiceEngine {
       outputFile: request.outFile,
       playbackRate: request.playbackRate,
       speakerId: _getSpeakerId(request.voiceId),
+      deadline: request.deadline,
     );
 
     final result = await synthesizeSegment(segment);
@@ -306,6 +311,7 @@ class SupertonicAdapter implements AiVoiceEngine {
         requestId: request.opId,
         speakerId: request.speakerId ?? _getSpeakerId(request.voiceId),
         speed: request.playbackRate,
+        deadlineMs: request.deadline?.inMilliseconds,
       );
 
       final synthStartTime = DateTime.now();
@@ -480,6 +486,13 @@ class SupertonicAdapter implements AiVoiceEngine {
     debugPrint('[SupertonicAdapter] ${DateTime.now().toIso8601String()} _loadVoice completed for $voiceId in ${duration.inMilliseconds}ms');
   }
 
+  Future<void> _warmUpVoice(String voiceId) async {
+    final startTime = DateTime.now();
+    await _nativeApi.warmUpVoice(NativeEngineType.supertonic, voiceId);
+    final duration = DateTime.now().difference(startTime);
+    debugPrint('[SupertonicAdapter] ${DateTime.now().toIso8601String()} _warmUpVoice completed for $voiceId in ${duration.inMilliseconds}ms');
+  }
+
   int _getSpeakerId(String voiceId) {
     // Supertonic voice IDs: supertonic_m1, supertonic_f1, etc.
     // Map to speaker index
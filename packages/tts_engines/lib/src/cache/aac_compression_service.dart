@@ -3,6 +3,7 @@ import 'dart:developer' as developer;
 
 import 'package:flutter_audio_toolkit/flutter_audio_toolkit.dart';
 
+import 'audio_cache.dart';
 import 'cache_entry_metadata.dart';
 import 'cache_metadata_storage.dart';
 
@@ -95,7 +96,8 @@ class AacCompressionService {
   /// Compress a single WAV file to M4A using native codecs.
   ///
   /// Returns the compressed file, or null if compression failed.
-  /// The original WAV file is deleted on success.
+  /// The original WAV file is deleted on success, and its word-timing
+  /// sidecar moves to the M4A.
   Future<File?> compressFile(
     File wavFile, {
     bool deleteOriginal = true,
@@ -139,6 +141,10 @@ class AacCompressionService {
           // Success - delete original if requested
           if (deleteOriginal) {
             await wavFile.delete();
+            final words = wordTimelineFileFor(wavFile);
+            if (await words.exists()) {
+              await words.rename(wordTimelineFileFor(m4aFile).path);
+            }
           }
 
           developer.log(
@@ -6,6 +6,14 @@ import 'package:core_domain/core_domain.dart';
 /// Used for checking if audio files are complete (must be > header size).
 const kWavHeaderSize = 44;
 
+/// Suffix of the word-timing sidecar an engine may write next to a segment
+/// (`<audio>.words`). It is part of the audio's cache entry: it moves when
+/// the audio is compressed and is deleted with it.
+const kWordTimelineSuffix = '.words';
+
+/// Word-timing sidecar of [audio] (may not exist).
+File wordTimelineFileFor(File audio) => File('${audio.path}$kWordTimelineSuffix');
+
 /// Budget configuration for audio cache.
 class CacheBudget {
   const CacheBudget({
@@ -228,6 +236,8 @@ class FileAudioCache implements AudioCache {
     for (final file in toDelete) {
       try {
         await file.delete();
+        final words = wordTimelineFileFor(file);
+        if (await words.exists()) await words.delete();
         _usageTimes.remove(file.uri.pathSegments.last);
       } catch (_) {
         // Best effort deletion
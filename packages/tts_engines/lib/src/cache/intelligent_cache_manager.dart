@@ -333,6 +333,7 @@ class IntelligentCacheManager implements AudioCache {
         if (await file.exists()) {
           await file.delete();
           currentSize -= entry.metadata.sizeBytes;
+          currentSize -= await _deleteWordTimeline(file);
           evictedKeys.add(entry.metadata.key);
           evicted++;
 
@@ -648,6 +649,22 @@ class IntelligentCacheManager implements AudioCache {
       }
     }
 
+    // Word-timing sidecars belong to their audio's entry, not one of their
+    // own; drop the ones whose audio is gone (evicted before sidecars were
+    // tracked)
+    final sidecars = existingFiles.keys
+        .where((name) => name.endsWith(kWordTimelineSuffix))
+        .toList();
+    for (final name in sidecars) {
+      final sidecar = existingFiles.remove(name)!;
+      final audioName = name.substring(0, name.length - kWordTimelineSuffix.length);
+      if (!existingFiles.containsKey(audioName)) {
+        try {
+          await sidecar.delete();
+        } catch (_) {}
+      }
+    }
+
     // Get all entries from DB to compare with filesystem
     final dbEntries = await _storage.getAllEntries();
     final dbKeys = dbEntries.map((e) => e.key).toSet();
@@ -716,6 +733,20 @@ class IntelligentCacheManager implements AudioCache {
     }
   }
 
+  /// Delete the word-timing sidecar of [audio], if any.
+  /// Returns the bytes freed.
+  Future<int> _deleteWordTimeline(File audio) async {
+    final words = wordTimelineFileFor(audio);
+    try {
+      if (!await words.exists()) return 0;
+      final size = await words.length();
+      await words.delete();
+      return size;
+    } catch (_) {
+      return 0;
+    }
+  }
+
   /// Parse voice ID from cache filename.
   String _parseVoiceIdFromFilename(String filename) {
     // Filename format: voiceId_hash.wav
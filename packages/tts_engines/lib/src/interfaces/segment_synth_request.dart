@@ -15,6 +15,7 @@ class SegmentSynthRequest {
     this.maxRetries = 1,
     this.speakerId,
     this.playbackRate = 1.0,
+    this.deadline,
   }) : opId = opId ?? _generateOpId();
 
   /// Unique operation ID for cancellation.
@@ -44,6 +45,9 @@ class SegmentSynthRequest {
   /// Playback rate (1.0 = normal).
   final double playbackRate;
 
+  /// Time until playback needs this audio, if known.
+  final Duration? deadline;
+
   /// Current retry attempt (mutable for retry logic).
   int retryAttempt = 0;
 
@@ -8,6 +8,7 @@ class SynthRequest {
     required this.playbackRate,
     required this.outFile,
     this.tuning = const {},
+    this.deadline,
   });
 
   /// Voice identifier (e.g., 'kokoro_af', 'supertonic_m1').
@@ -25,6 +26,10 @@ class SynthRequest {
   /// Optional engine-specific tuning parameters.
   final Map<String, Object?> tuning;
 
+  /// Time until playback needs this audio, if known. Engines with a native
+  /// request queue run the nearest deadlines first.
+  final Duration? deadline;
+
   @override
   String toString() =>
       'SynthRequest(voice: $voiceId, textLen: ${text.length}, rate: $playbackRate)';
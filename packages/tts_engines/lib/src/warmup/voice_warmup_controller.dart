@@ -13,6 +13,9 @@ typedef EngineInitCallback = Future<void> Function(String corePath);
 /// Returns true if loading succeeded.
 typedef VoiceLoadCallback = Future<void> Function(String voiceId, String modelPath);
 
+/// Callback signature for warming up a loaded voice.
+typedef VoiceWarmUpCallback = Future<void> Function(String voiceId);
+
 /// Controller for managing progressive voice warmup.
 ///
 /// This controller manages the warmup state machine for TTS voice engines,
@@ -20,7 +23,8 @@ typedef VoiceLoadCallback = Future<void> Function(String voiceId, String modelPa
 /// slow CoreML compilation on iOS.
 ///
 /// Key features:
-/// - Progressive phase tracking (file validation → engine init → voice loading)
+/// - Progressive phase tracking (file validation → engine init → voice loading
+///   → voice warming)
 /// - Serialized warmup calls (prevents duplicate concurrent compilations)
 /// - Observable state via streams for reactive UI
 /// - Cancellation support
@@ -31,6 +35,7 @@ class VoiceWarmupController {
     required this.coreDir,
     required this.onInitEngine,
     required this.onLoadVoice,
+    this.onWarmUpVoice,
     this.getCorePathForVoice,
     this.getModelPathForVoice,
     this.isEngineReady,
@@ -49,6 +54,10 @@ class VoiceWarmupController {
   /// Callback to load a voice.
   final VoiceLoadCallback onLoadVoice;
 
+  /// Optional callback to run a loaded voice's first inference, so the
+  /// engine's first-run cost is paid here rather than during playback.
+  final VoiceWarmUpCallback? onWarmUpVoice;
+
   /// Optional function to get core path for a voice.
   final String Function(String voiceId)? getCorePathForVoice;
 
@@ -186,6 +195,24 @@ class VoiceWarmupController {
         debugPrint('[VoiceWarmupController] $engineId: voice loaded');
       }
 
+      if (_isCancelled(voiceId)) {
+        throw WarmupCancelledException(voiceId);
+      }
+
+      // Phase 4: Voice warming
+      if (onWarmUpVoice != null) {
+        _updateState(voiceId, VoiceWarmupState(
+          voiceId: voiceId,
+          phase: WarmupPhase.voiceWarming,
+          startTime: startTime,
+          phaseStartTime: DateTime.now(),
+        ));
+
+        debugPrint('[VoiceWarmupController] $engineId: warming up voice $voiceId...');
+        await onWarmUpVoice!(voiceId);
+        debugPrint('[VoiceWarmupController] $engineId: voice warmed up');
+      }
+
       // Complete
       final finalState = VoiceWarmupState.ready(voiceId, startTime);
       _updateState(voiceId, finalState);
@@ -20,6 +20,10 @@ enum WarmupPhase {
   /// Typically fast (<500ms).
   voiceLoading,
 
+  /// Running the loaded voice once so the first audible segment does not
+  /// pay the engine's first-run cost. Skipped by engines without it.
+  voiceWarming,
+
   /// Warmup complete, voice is ready for synthesis.
   ready,
 
@@ -74,7 +78,8 @@ class VoiceWarmupState {
   bool get isActive =>
       phase == WarmupPhase.fileValidation ||
       phase == WarmupPhase.coreInitializing ||
-      phase == WarmupPhase.voiceLoading;
+      phase == WarmupPhase.voiceLoading ||
+      phase == WarmupPhase.voiceWarming;
 
   /// Elapsed time since warmup started.
   Duration get elapsed =>
@@ -93,6 +98,7 @@ class VoiceWarmupState {
       WarmupPhase.fileValidation => 'Checking files...',
       WarmupPhase.coreInitializing => message ?? 'Initializing engine...',
       WarmupPhase.voiceLoading => 'Loading voice...',
+      WarmupPhase.voiceWarming => 'Warming up voice...',
       WarmupPhase.ready => 'Ready',
       WarmupPhase.failed => errorMessage ?? 'Warmup failed',
     };
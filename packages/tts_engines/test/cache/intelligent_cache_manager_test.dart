@@ -2,6 +2,7 @@ import 'dart:io';
 
 import 'package:flutter_test/flutter_test.dart';
 import 'package:core_domain/core_domain.dart';
+import 'package:tts_engines/src/cache/audio_cache.dart';
 import 'package:tts_engines/src/cache/intelligent_cache_manager.dart';
 import 'package:tts_engines/src/cache/cache_metadata_storage.dart';
 import 'mock_cache_metadata_storage.dart';
@@ -264,6 +265,70 @@ void main() {
       expect(stats.totalSizeBytes, lessThanOrEqualTo(4500));
     });
 
+    test('eviction deletes word-timing sidecars with their audio', () async {
+      await manager.setQuotaSettings(CacheQuotaSettings(maxSizeBytes: 5000));
+
+      for (int i = 0; i < 10; i++) {
+        final cacheKey = CacheKeyGenerator.generate(
+          voiceId: 'supertonic_m1',
+          text: 'Test $i',
+          playbackRate: 1.0,
+        );
+
+        final file = await manager.fileFor(cacheKey);
+        await file.writeAsBytes(List.filled(1000, 0));
+        await wordTimelineFileFor(file).writeAsString('supertonic-words 1');
+        await manager.registerEntry(
+          key: cacheKey,
+          sizeBytes: 1000,
+          bookId: 'book1',
+          segmentIndex: i,
+          chapterIndex: 0,
+          engineType: 'supertonic',
+          audioDurationMs: 3000,
+        );
+      }
+
+      final names = tempDir
+          .listSync()
+          .map((e) => e.uri.pathSegments.last)
+          .toSet();
+      final sidecars = names.where((n) => n.endsWith(kWordTimelineSuffix));
+      expect(sidecars, isNotEmpty);
+      for (final sidecar in sidecars) {
+        expect(
+          names,
+          contains(sidecar.substring(0, sidecar.length - kWordTimelineSuffix.length)),
+        );
+      }
+    });
+
+    test('sync drops orphaned sidecars without registering them', () async {
+      await File('${tempDir.path}/supertonic_m1_abc123.wav')
+          .writeAsBytes(List.filled(2000, 0));
+      await File('${tempDir.path}/supertonic_m1_abc123.wav.words')
+          .writeAsString('supertonic-words 1');
+      final orphan = File('${tempDir.path}/supertonic_m1_def456.wav.words');
+      await orphan.writeAsString('supertonic-words 1');
+
+      final newManager = IntelligentCacheManager(
+        cacheDir: tempDir,
+        storage: storage,
+        quotaSettings: CacheQuotaSettings.fromGB(1.0),
+      );
+      await newManager.initialize();
+
+      final metadata = await newManager.getAllMetadata();
+      expect(metadata.keys, equals({'supertonic_m1_abc123.wav'}));
+      expect(await orphan.exists(), isFalse);
+      expect(
+        await File('${tempDir.path}/supertonic_m1_abc123.wav.words').exists(),
+        isTrue,
+      );
+
+      newManager.dispose();
+    });
+
     test('metadata persists across restarts', () async {
       final cacheKey = CacheKeyGenerator.generate(
         voiceId: 'piper:en_US-lessac-medium',